@@ -190,6 +190,16 @@ function App() {
             setNnError(null);
             setWsError(null);
             break;
+          case "cost_estimate":
+            // Pre-flight estimate from the C++ cost model (sent before training starts)
+            if (message.budget_adjusted) {
+              console.warn(
+                `NN job adjusted to fit the server budget: epochs=${message.adjusted_epochs}, samples=${message.adjusted_samples}`
+              );
+            } else {
+              console.info(`Estimated NN training time: ${message.estimated_time_ms} ms`);
+            }
+            break;
           case "error":
             // Flush and clear queue on error too
             scheduleProcessLossBatch.flush(); // <-- MODIFIED
@@ -0,0 +1,128 @@
+#include "arena.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#define MLAPP_HAVE_MMAP 1
+#endif
+
+namespace {
+
+size_t roundUp(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+} // namespace
+
+Arena::Arena(size_t region_bytes)
+    : region_bytes_(roundUp(region_bytes == 0 ? kHugePageSize : region_bytes, kHugePageSize)),
+      bytes_allocated_(0) {}
+
+Arena::~Arena() {
+    reset();
+}
+
+void* Arena::allocate(size_t bytes, size_t alignment) {
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+        throw std::invalid_argument("Arena alignment must be a power of two.");
+    }
+    if (alignment < kAlignment) {
+        alignment = kAlignment;
+    }
+    if (bytes == 0) {
+        bytes = 1; // Distinct, valid pointers for empty requests
+    }
+    if (!regions_.empty()) {
+        Region& region = regions_.back();
+        const size_t offset = roundUp(region.used, alignment);
+        if (offset <= region.size && bytes <= region.size - offset) {
+            region.used = offset + bytes;
+            bytes_allocated_ += bytes;
+            return region.base + offset;
+        }
+    }
+    // Regions start 2MB aligned, so any power-of-two alignment up to that is free
+    regions_.push_back(map_region(bytes + (alignment > kHugePageSize ? alignment : 0)));
+    Region& region = regions_.back();
+    const size_t offset = roundUp(reinterpret_cast<uintptr_t>(region.base), alignment) -
+                          reinterpret_cast<uintptr_t>(region.base);
+    region.used = offset + bytes;
+    bytes_allocated_ += bytes;
+    return region.base + offset;
+}
+
+void Arena::reset() {
+    for (const Region& region : regions_) {
+        unmap_region(region);
+    }
+    regions_.clear();
+    bytes_allocated_ = 0;
+}
+
+size_t Arena::bytes_reserved() const {
+    size_t total = 0;
+    for (const Region& region : regions_) {
+        total += region.size;
+    }
+    return total;
+}
+
+size_t Arena::huge_page_regions() const {
+    size_t count = 0;
+    for (const Region& region : regions_) {
+        count += region.huge_pages ? 1 : 0;
+    }
+    return count;
+}
+
+Arena::Region Arena::map_region(size_t min_bytes) {
+    Region region;
+    region.size = roundUp(min_bytes > region_bytes_ ? min_bytes : region_bytes_, kHugePageSize);
+    region.used = 0;
+    region.huge_pages = false;
+#ifdef MLAPP_HAVE_MMAP
+    // Over-map by one huge page and trim both ends so the region starts on a
+    // 2MB boundary; the kernel can then back it with whole huge pages.
+    const size_t mapped = region.size + kHugePageSize;
+    void* raw = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+    if (raw == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    char* start = static_cast<char*>(raw);
+    char* aligned = reinterpret_cast<char*>(roundUp(reinterpret_cast<uintptr_t>(start), kHugePageSize));
+    if (aligned > start) {
+        munmap(start, aligned - start);
+    }
+    char* end = aligned + region.size;
+    char* mapped_end = start + mapped;
+    if (mapped_end > end) {
+        munmap(end, mapped_end - end);
+    }
+    region.base = aligned;
+#ifdef MADV_HUGEPAGE
+    region.huge_pages = madvise(region.base, region.size, MADV_HUGEPAGE) == 0;
+#endif
+#else
+    // No mmap: an over-allocated heap block aligned by hand (base pointer stashed before it)
+    void* raw = std::malloc(region.size + kAlignment + sizeof(void*));
+    if (!raw) {
+        throw std::bad_alloc();
+    }
+    uintptr_t aligned = roundUp(reinterpret_cast<uintptr_t>(raw) + sizeof(void*), kAlignment);
+    reinterpret_cast<void**>(aligned)[-1] = raw;
+    region.base = reinterpret_cast<char*>(aligned);
+#endif
+    return region;
+}
+
+void Arena::unmap_region(const Region& region) {
+#ifdef MLAPP_HAVE_MMAP
+    munmap(region.base, region.size);
+#else
+    std::free(reinterpret_cast<void**>(region.base)[-1]);
+#endif
+}
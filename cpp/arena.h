@@ -0,0 +1,90 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <vector>
+
+// Bump allocator over large anonymous mappings.
+//
+// Every block is at least 64-byte (cache line) aligned. Regions are 2MB
+// aligned and, where the kernel supports it, advised with MADV_HUGEPAGE so
+// transparent huge pages back them and random gathers over a large dataset
+// touch far fewer TLB entries than 4KB-paged heap memory. Individual blocks
+// are never freed; everything is released at once by reset() or the
+// destructor, which matches the lifetime of one request's data.
+//
+// Not thread-safe: allocate from one thread (typically while parsing), then
+// share the read-only data with workers.
+class Arena {
+public:
+    static const size_t kAlignment = 64;
+    static const size_t kHugePageSize = size_t(2) << 20;
+
+    // `region_bytes` is the default mapping size; larger requests get a region of their own
+    explicit Arena(size_t region_bytes = 8 * kHugePageSize);
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // `alignment` must be a power of two; values below kAlignment are raised to it
+    void* allocate(size_t bytes, size_t alignment = kAlignment);
+
+    template <typename T>
+    T* allocate_array(size_t count) {
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    // Unmaps every region; all pointers handed out become invalid
+    void reset();
+
+    size_t bytes_allocated() const { return bytes_allocated_; } // Requested bytes (without padding)
+    size_t bytes_reserved() const;                              // Mapped bytes
+    size_t region_count() const { return regions_.size(); }
+    size_t huge_page_regions() const;                           // Regions MADV_HUGEPAGE was accepted for
+
+private:
+    struct Region {
+        char* base;
+        size_t size;
+        size_t used;
+        bool huge_pages;
+    };
+
+    Region map_region(size_t min_bytes);
+    static void unmap_region(const Region& region);
+
+    size_t region_bytes_;
+    size_t bytes_allocated_;
+    std::vector<Region> regions_;
+};
+
+// STL allocator drawing from an Arena; deallocate is a no-op because the
+// arena frees in bulk. Containers using it must not outlive the arena.
+template <typename T>
+class ArenaAllocator {
+public:
+    typedef T value_type;
+
+    explicit ArenaAllocator(Arena& arena) : arena_(&arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.arena()) {}
+
+    T* allocate(size_t count) { return arena_->allocate_array<T>(count); }
+    void deallocate(T*, size_t) {}
+
+    Arena* arena() const { return arena_; }
+
+private:
+    Arena* arena_;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) { return a.arena() == b.arena(); }
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) { return a.arena() != b.arena(); }
+
+// Flat column of doubles stored in an arena
+using ArenaVector = std::vector<double, ArenaAllocator<double>>;
+
+#endif // ARENA_H
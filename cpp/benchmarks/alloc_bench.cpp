@@ -0,0 +1,128 @@
+// Heap allocations and latency per operation on the per-sample paths of the
+// common 1-5-1 network, comparing std::vector-based code with SampleVector
+// (InlineVector<8>). "legacy_predict" replays the pre-SampleVector predict
+// loop (one temporary per layer) on a standalone copy of the network shape.
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "../neural_network.h"
+
+static size_t g_allocations = 0;
+
+void* operator new(size_t size) {
+    ++g_allocations;
+    void* p = std::malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+double volatile g_sink = 0.0;
+
+template <typename Fn>
+void report(const std::string& name, int iterations, Fn fn) {
+    fn(); // Warm up buffers that are reused between calls
+    const size_t allocations_before = g_allocations;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        fn();
+    }
+    const double elapsed_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    const size_t allocations = g_allocations - allocations_before;
+    std::cout << name
+              << " allocs_per_op=" << static_cast<double>(allocations) / iterations
+              << " ns_per_op=" << elapsed_ns / iterations << std::endl;
+}
+
+// The predict loop as it was written with std::vector temporaries
+Vector legacyPredict(const std::vector<Matrix>& weights, const std::vector<Vector>& biases, const Vector& input) {
+    Vector current_output = input;
+    for (size_t i = 0; i < weights.size(); ++i) {
+        Vector z(weights[i].size(), 0.0);
+        for (size_t r = 0; r < z.size(); ++r) {
+            for (size_t c = 0; c < current_output.size(); ++c) {
+                z[r] += weights[i][r][c] * current_output[c];
+            }
+        }
+        Vector sum(z.size());
+        for (size_t r = 0; r < z.size(); ++r) {
+            sum[r] = z[r] + biases[i][r];
+        }
+        current_output.resize(sum.size());
+        for (size_t r = 0; r < sum.size(); ++r) {
+            current_output[r] = i + 1 < weights.size() ? NeuralNetwork::sigmoid(sum[r]) : sum[r];
+        }
+    }
+    return current_output;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const int scale = argc > 1 ? std::max(1, std::atoi(argv[1])) : 1;
+    const int iterations = 200000 * scale;
+    const std::vector<size_t> shape = {1, 5, 1};
+    NeuralNetwork nn(shape, 0.01);
+
+    std::vector<Matrix> weights = {Matrix(5, Vector(1, 0.3)), Matrix(1, Vector(5, -0.2))};
+    std::vector<Vector> biases = {Vector(5, 0.05), Vector(1, 0.1)};
+    double x = 0.0;
+
+    report("legacy_predict", iterations, [&]() {
+        x += 1e-6;
+        g_sink = legacyPredict(weights, biases, {x})[0];
+    });
+    report("predict_vector", iterations, [&]() {
+        x += 1e-6;
+        g_sink = nn.predict({x})[0];
+    });
+    SampleVector output;
+    report("predict_into", iterations, [&]() {
+        x += 1e-6;
+        nn.predict_into(&x, 1, output);
+        g_sink = output[0];
+    });
+
+    const Vector target = {0.25};
+    report("train_step", iterations, [&]() {
+        x += 1e-6;
+        nn.train({x}, target);
+    });
+
+    // main_server's conversion of the parsed flat columns into samples
+    const size_t rows = 1000;
+    Vector flat(rows);
+    for (size_t i = 0; i < rows; ++i) {
+        flat[i] = static_cast<double>(i) / rows;
+    }
+    report("convert_1000_rows_vector", iterations / 1000, [&]() {
+        std::vector<Vector> samples;
+        samples.reserve(rows);
+        for (size_t i = 0; i < rows; ++i) {
+            samples.push_back({flat[i]});
+        }
+        g_sink = samples.back()[0];
+    });
+    report("convert_1000_rows_sample_vector", iterations / 1000, [&]() {
+        std::vector<SampleVector> samples;
+        samples.reserve(rows);
+        for (size_t i = 0; i < rows; ++i) {
+            samples.push_back(SampleVector(&flat[i], 1));
+        }
+        g_sink = samples.back()[0];
+    });
+    return 0;
+}
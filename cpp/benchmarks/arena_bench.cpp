@@ -0,0 +1,80 @@
+// Random-access gathers over a large column stored in a std::vector (4KB
+// pages) versus an Arena (2MB-aligned, MADV_HUGEPAGE). Reports ns per gather
+// and, where perf counters are available, dTLB load misses per gather.
+// Usage: arena_bench [column_mb] [gathers_millions]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../arena.h"
+#include "../perf_counters.h"
+
+namespace {
+
+double volatile g_sink = 0.0;
+
+template <typename Column>
+void fill(Column& column, size_t count) {
+    column.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        column.push_back(static_cast<double>(i % 1024) * 0.5);
+    }
+}
+
+template <typename Column>
+void gather(const std::string& name, const Column& column, const std::vector<uint32_t>& indices) {
+    TlbMissCounter tlb;
+    double sum = 0.0;
+    const auto start = std::chrono::steady_clock::now();
+    tlb.start();
+    for (uint32_t index : indices) {
+        sum += column[index];
+    }
+    tlb.stop();
+    const double elapsed_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    g_sink = sum;
+    std::cout << name << " ns_per_gather=" << elapsed_ns / indices.size();
+    if (tlb.available()) {
+        std::cout << " dtlb_misses_per_gather=" << static_cast<double>(tlb.dtlb_load_misses()) / indices.size();
+    } else {
+        std::cout << " dtlb_misses_per_gather=unavailable";
+    }
+    std::cout << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t column_mb = argc > 1 ? std::max(1, std::atoi(argv[1])) : 512;
+    const size_t gathers = (argc > 2 ? std::max(1, std::atoi(argv[2])) : 20) * size_t(1000000);
+    const size_t count = column_mb * (size_t(1) << 20) / sizeof(double);
+
+    std::vector<uint32_t> indices(gathers);
+    uint64_t state = 88172645463325252ull; // xorshift64
+    for (size_t i = 0; i < gathers; ++i) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        indices[i] = static_cast<uint32_t>(state % count);
+    }
+
+    {
+        std::vector<double> column;
+        fill(column, count);
+        gather("std_vector column_mb=" + std::to_string(column_mb), column, indices);
+    }
+    {
+        Arena arena;
+        ArenaVector column{ArenaAllocator<double>(arena)};
+        fill(column, count);
+        gather("arena column_mb=" + std::to_string(column_mb) +
+               " huge_page_regions=" + std::to_string(arena.huge_page_regions()) + "/" +
+               std::to_string(arena.region_count()), column, indices);
+    }
+    return 0;
+}
@@ -0,0 +1,113 @@
+// Compares the available BLAS backends on the raw kernels and on NeuralNetwork
+// training steps. Backends that cannot be created on this host are skipped.
+// Usage: blas_bench [scale] [extra backend specs, e.g. dlopen:/opt/lib/libmkl_rt.so]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../blas_backend.h"
+#include "../neural_network.h"
+
+namespace {
+
+double volatile g_sink = 0.0; // Keeps results observable so loops are not optimized away
+
+// Best-of-three wall time per call, in microseconds
+template <typename Fn>
+double timeUs(int iterations, Fn fn) {
+    double best = 1e300;
+    for (int round = 0; round < 3; ++round) {
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            fn();
+        }
+        const double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        best = std::min(best, elapsed / iterations);
+    }
+    return best;
+}
+
+std::vector<double> filled(size_t n, double seed) {
+    std::vector<double> values(n);
+    for (size_t i = 0; i < n; ++i) {
+        values[i] = seed + 0.001 * static_cast<double>((i * 7919) % 1000);
+    }
+    return values;
+}
+
+void benchKernels(const BlasBackend& blas, int scale) {
+    const size_t sizes[] = {8, 64, 512};
+    for (size_t n : sizes) {
+        const std::vector<double> a = filled(n * n, 0.1);
+        const std::vector<double> b = filled(n * n, 0.2);
+        const std::vector<double> x = filled(n, 0.3);
+        std::vector<double> y(n, 0.0);
+        std::vector<double> c(n * n, 0.0);
+        const int reps = static_cast<int>(std::max<size_t>(1, (4000000 / (n * n)))) * scale;
+
+        const double dot_us = timeUs(reps * 4, [&]() { g_sink = blas.dot(n, x.data(), a.data()); });
+        const double gemv_us = timeUs(reps, [&]() {
+            blas.gemv(false, n, n, 1.0, a.data(), n, x.data(), 0.0, y.data());
+            g_sink = y[0];
+        });
+        const int gemm_reps = std::max(1, reps / static_cast<int>(n));
+        const double gemm_us = timeUs(gemm_reps, [&]() {
+            blas.gemm(false, false, n, n, n, 1.0, a.data(), n, b.data(), n, 0.0, c.data(), n);
+            g_sink = c[0];
+        });
+        const double n3 = static_cast<double>(n) * n * n;
+        std::cout << "backend=" << blas.name() << " n=" << n
+                  << " dot_us=" << dot_us
+                  << " gemv_us=" << gemv_us
+                  << " gemm_us=" << gemm_us
+                  << " gemm_gflops=" << (2.0 * n3 / gemm_us) * 1e-3 << std::endl;
+    }
+}
+
+// Per-sample SGD step time for the network shapes the UI uses and a wide one
+void benchNetworkTraining(int scale) {
+    const std::vector<std::vector<size_t>> shapes = {{1, 5, 1}, {1, 64, 64, 1}, {256, 256, 256, 1}};
+    for (const auto& shape : shapes) {
+        NeuralNetwork nn(shape, 0.001);
+        const Vector input = filled(shape.front(), 0.5);
+        const Vector target(shape.back(), 0.25);
+        const size_t width = *std::max_element(shape.begin(), shape.end());
+        const int reps = static_cast<int>(std::max<size_t>(20, 2000000 / (width * width))) * scale;
+        const double step_us = timeUs(reps, [&]() { nn.train(input, target); });
+        std::string name;
+        for (size_t i = 0; i < shape.size(); ++i) {
+            name += (i ? "-" : "") + std::to_string(shape[i]);
+        }
+        std::cout << "backend=" << activeBlasBackend().name() << " nn=" << name
+                  << " train_step_us=" << step_us << std::endl;
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const int scale = argc > 1 ? std::max(1, std::atoi(argv[1])) : 1;
+    std::vector<std::string> specs = {"builtin", "cblas", "dlopen"};
+    for (int i = 2; i < argc; ++i) {
+        specs.push_back(argv[i]);
+    }
+
+    for (const std::string& spec : specs) {
+        std::unique_ptr<BlasBackend> backend;
+        try {
+            backend = createBlasBackend(spec);
+        } catch (const std::exception& e) {
+            std::cout << "backend=" << spec << " skipped: " << e.what() << std::endl;
+            continue;
+        }
+        benchKernels(*backend, scale);
+        setActiveBlasBackend(std::move(backend));
+        benchNetworkTraining(scale);
+    }
+    return 0;
+}
@@ -0,0 +1,200 @@
+// Latency benchmark for the predict and train request paths.
+// Every stage (parse, compute, serialize, total) is recorded into a
+// LatencyHistogram from all OpenMP threads and reported as p50/p90/p99/p999.
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <omp.h>
+
+#include "../latency_histogram.h"
+#include "../linear_regression.h"
+#include "../neural_network.h"
+
+namespace {
+
+struct StageHistograms {
+    LatencyHistogram parse;
+    LatencyHistogram compute;
+    LatencyHistogram serialize;
+    LatencyHistogram total;
+
+    void report(const std::string& path) const {
+        printLatencySummary(std::cout, path + ".parse", parse.snapshot());
+        printLatencySummary(std::cout, path + ".compute", compute.snapshot());
+        printLatencySummary(std::cout, path + ".serialize", serialize.snapshot());
+        printLatencySummary(std::cout, path + ".total", total.snapshot());
+    }
+};
+
+std::string makeCsv(const std::vector<double>& values) {
+    std::ostringstream out;
+    for (size_t i = 0; i < values.size(); ++i) {
+        out << values[i] << (i + 1 == values.size() ? "" : ",");
+    }
+    return out.str();
+}
+
+std::vector<double> parseCsv(const std::string& text) {
+    std::vector<double> values;
+    const char* cursor = text.c_str();
+    char* end = nullptr;
+    while (*cursor) {
+        values.push_back(std::strtod(cursor, &end));
+        cursor = (*end == ',') ? end + 1 : end;
+    }
+    return values;
+}
+
+void benchLrPredict(int requests) {
+    StageHistograms stages;
+    LinearRegression model;
+    model.fit_analytical({1.0, 2.0, 3.0}, {2.0, 4.1, 5.9});
+
+    #pragma omp parallel for schedule(static)
+    for (int r = 0; r < requests; ++r) {
+        ScopedLatency total(stages.total);
+        std::string arg = std::to_string(r * 0.001);
+        double x;
+        {
+            ScopedLatency timer(stages.parse);
+            x = std::strtod(arg.c_str(), nullptr);
+        }
+        double prediction;
+        {
+            ScopedLatency timer(stages.compute);
+            prediction = model.predict(x);
+        }
+        {
+            ScopedLatency timer(stages.serialize);
+            std::ostringstream out;
+            out << "prediction=" << prediction << "\n";
+        }
+    }
+    stages.report("lr_predict");
+}
+
+void benchNnPredict(int requests) {
+    StageHistograms stages;
+    const NeuralNetwork prototype({1, 5, 1}, 0.05);
+
+    #pragma omp parallel
+    {
+        NeuralNetwork nn = prototype; // predict() is non-const; one copy per thread
+        #pragma omp for schedule(static)
+        for (int r = 0; r < requests; ++r) {
+            ScopedLatency total(stages.total);
+            std::string arg = std::to_string(r * 0.001);
+            Vector input;
+            {
+                ScopedLatency timer(stages.parse);
+                input = {std::strtod(arg.c_str(), nullptr)};
+            }
+            Vector output;
+            {
+                ScopedLatency timer(stages.compute);
+                output = nn.predict(input);
+            }
+            {
+                ScopedLatency timer(stages.serialize);
+                std::ostringstream out;
+                out << "prediction=" << output[0] << "\n";
+            }
+        }
+    }
+    stages.report("nn_predict");
+}
+
+void benchLrTrain(int requests, size_t n) {
+    StageHistograms stages;
+    std::vector<double> X(n);
+    std::vector<double> y(n);
+    for (size_t i = 0; i < n; ++i) {
+        X[i] = static_cast<double>(i) / n;
+        y[i] = 3.0 * X[i] + 0.5 + 0.01 * ((i * 7919) % 13);
+    }
+    const std::string x_csv = makeCsv(X);
+    const std::string y_csv = makeCsv(y);
+
+    for (int r = 0; r < requests; ++r) {
+        ScopedLatency total(stages.total);
+        std::vector<double> X_parsed;
+        std::vector<double> y_parsed;
+        {
+            ScopedLatency timer(stages.parse);
+            X_parsed = parseCsv(x_csv);
+            y_parsed = parseCsv(y_csv);
+        }
+        LinearRegression model;
+        {
+            ScopedLatency timer(stages.compute);
+            model.fit_analytical(X_parsed, y_parsed);
+        }
+        {
+            ScopedLatency timer(stages.serialize);
+            std::ostringstream out;
+            out << "slope=" << model.get_slope() << "\nintercept=" << model.get_intercept()
+                << "\nmse=" << model.get_mse(X_parsed, y_parsed) << "\n";
+        }
+    }
+    stages.report("lr_train");
+}
+
+void benchNnTrain(int requests, size_t n, int epochs) {
+    StageHistograms stages;
+    std::vector<double> X(n);
+    std::vector<double> y(n);
+    for (size_t i = 0; i < n; ++i) {
+        X[i] = static_cast<double>(i) / n;
+        y[i] = X[i] * X[i];
+    }
+    const std::string x_csv = makeCsv(X);
+    const std::string y_csv = makeCsv(y);
+
+    // train_for_epochs reports loss on stdout; keep the benchmark output readable
+    std::ostringstream discard;
+    for (int r = 0; r < requests; ++r) {
+        ScopedLatency total(stages.total);
+        std::vector<Vector> inputs;
+        std::vector<Vector> targets;
+        {
+            ScopedLatency timer(stages.parse);
+            std::vector<double> X_parsed = parseCsv(x_csv);
+            std::vector<double> y_parsed = parseCsv(y_csv);
+            for (size_t i = 0; i < X_parsed.size(); ++i) {
+                inputs.push_back({X_parsed[i]});
+                targets.push_back({y_parsed[i]});
+            }
+        }
+        NeuralNetwork nn({1, 5, 1}, 0.05);
+        Vector predictions;
+        {
+            ScopedLatency timer(stages.compute);
+            auto* original = std::cout.rdbuf(discard.rdbuf());
+            predictions = nn.train_for_epochs(inputs, targets, epochs, epochs);
+            std::cout.rdbuf(original);
+            discard.str("");
+        }
+        {
+            ScopedLatency timer(stages.serialize);
+            std::ostringstream out;
+            out << "nn_predictions=" << makeCsv(predictions) << "\n";
+        }
+    }
+    stages.report("nn_train_predict");
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const int scale = argc > 1 ? std::max(1, std::atoi(argv[1])) : 1;
+    std::cout << "threads=" << omp_get_max_threads() << std::endl;
+    benchLrPredict(200000 * scale);
+    benchNnPredict(200000 * scale);
+    benchLrTrain(50 * scale, 100000);
+    benchNnTrain(20 * scale, 1000, 20);
+    return 0;
+}
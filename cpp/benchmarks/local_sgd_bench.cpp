@@ -0,0 +1,81 @@
+// Scaling and time-to-accuracy of local SGD (trainLocalSgd) on a synthetic
+// two-input regression, from one replica up to the OpenMP thread count. Each
+// thread count runs with adaptive H and with H = 1 (an average after every
+// step, i.e. a synchronous reduction per sample), from the same initial weights.
+// Usage: local_sgd_bench [samples] [epochs] [target_mse] [max_threads]
+
+#include <omp.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../local_sgd.h"
+
+namespace {
+
+void run(const std::string& name, const NeuralNetwork& initial, const std::vector<SampleVector>& inputs,
+         const std::vector<SampleVector>& targets, int epochs, const LocalSgdOptions& options,
+         double baseline_samples_per_second) {
+    NeuralNetwork network = initial;
+    const LocalSgdResult result =
+        trainLocalSgd(network, inputs.data(), targets.data(), inputs.size(), epochs, options);
+    std::cout << name << " threads=" << result.threads << " samples_per_second=" << result.samples_per_second
+              << " speedup=" << result.samples_per_second / baseline_samples_per_second
+              << " mean_sync_steps=" << result.mean_sync_steps << " final_mse=" << result.final_mse;
+    if (result.time_to_target_seconds >= 0.0) {
+        std::cout << " time_to_target_ms=" << result.time_to_target_seconds * 1000.0
+                  << " epochs_to_target=" << result.epochs_to_target;
+    } else {
+        std::cout << " time_to_target_ms=unreached";
+    }
+    std::cout << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t samples = argc > 1 ? std::max(16, std::atoi(argv[1])) : 8192;
+    const int epochs = argc > 2 ? std::max(1, std::atoi(argv[2])) : 200;
+    const double target_mse = argc > 3 ? std::atof(argv[3]) : 2e-3;
+    const int max_threads = argc > 4 ? std::max(1, std::atoi(argv[4])) : omp_get_max_threads();
+
+    std::vector<SampleVector> inputs;
+    std::vector<SampleVector> targets;
+    for (size_t i = 0; i < samples; ++i) {
+        const double x[2] = {static_cast<double>((i * 7919) % samples) / samples,
+                             static_cast<double>((i * 104729) % samples) / samples};
+        const double y = 0.5 + 0.3 * std::sin(3.0 * x[0]) * std::cos(2.0 * x[1]);
+        inputs.push_back(SampleVector(x, 2));
+        targets.push_back(SampleVector(&y, 1));
+    }
+    const NeuralNetwork initial({2, 32, 1}, 0.05);
+
+    // Plain train_for_epochs as the reference throughput
+    NeuralNetwork sequential = initial;
+    const auto start = std::chrono::steady_clock::now();
+    sequential.train_for_epochs(inputs.data(), targets.data(), samples, epochs, epochs + 1);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const double baseline = static_cast<double>(samples) * epochs / seconds;
+    std::cout << "train_for_epochs samples_per_second=" << baseline << std::endl;
+
+    LocalSgdOptions options;
+    options.target_mse = target_mse;
+    options.report_every_n_epochs = 0;
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        options.threads = threads;
+        options.adaptive = true;
+        options.sync_steps = 8;
+        run("local_sgd sync=auto", initial, inputs, targets, epochs, options, baseline);
+        if (threads > 1) {
+            options.adaptive = false;
+            options.sync_steps = 1;
+            run("local_sgd sync=1", initial, inputs, targets, epochs, options, baseline);
+        }
+    }
+    return 0;
+}
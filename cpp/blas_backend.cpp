@@ -0,0 +1,330 @@
+#include "blas_backend.h"
+
+#include <atomic>
+#include <climits>
+#include <mutex>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <dlfcn.h>
+#define MLAPP_HAVE_DLOPEN 1
+#endif
+
+#ifdef MLAPP_HAVE_CBLAS
+#include <cblas.h>
+#endif
+
+namespace {
+
+// CBLAS enum values (identical in every implementation); passed as int so the
+// runtime-loaded symbols can be called without the library's header.
+const int kCblasRowMajor = 101;
+const int kCblasNoTrans = 111;
+const int kCblasTrans = 112;
+
+typedef double (*DdotFn)(int, const double*, int, const double*, int);
+typedef void (*DaxpyFn)(int, double, const double*, int, double*, int);
+typedef void (*DgemvFn)(int, int, int, int, double, const double*, int, const double*, int, double, double*, int);
+typedef void (*DgemmFn)(int, int, int, int, int, int, double, const double*, int, const double*, int,
+                        double, double*, int);
+
+struct CblasFunctions {
+    DdotFn ddot = nullptr;
+    DaxpyFn daxpy = nullptr;
+    DgemvFn dgemv = nullptr;
+    DgemmFn dgemm = nullptr;
+};
+
+int blasInt(size_t value) {
+    if (value > static_cast<size_t>(INT_MAX)) {
+        throw std::length_error("Dimension too large for a 32-bit BLAS interface.");
+    }
+    return static_cast<int>(value);
+}
+
+// Translates BlasBackend calls into CBLAS calls through a function table, so
+// the build-time and dlopen'ed libraries share one adapter. Degenerate shapes
+// are handled by the built-in loops because CBLAS rejects a leading dimension of 0.
+class CblasBackend : public BlasBackend {
+public:
+    CblasBackend(const std::string& name, const CblasFunctions& functions)
+        : name_(name), functions_(functions) {}
+
+    std::string name() const override { return name_; }
+
+    double dot(size_t n, const double* x, const double* y) const override {
+        return n == 0 ? 0.0 : functions_.ddot(blasInt(n), x, 1, y, 1);
+    }
+
+    void axpy(size_t n, double alpha, const double* x, double* y) const override {
+        if (n != 0) {
+            functions_.daxpy(blasInt(n), alpha, x, 1, y, 1);
+        }
+    }
+
+    void gemv(bool transpose, size_t rows, size_t cols, double alpha,
+              const double* a, size_t lda, const double* x,
+              double beta, double* y) const override {
+        if (rows == 0 || cols == 0) {
+            fallback_.gemv(transpose, rows, cols, alpha, a, lda, x, beta, y);
+            return;
+        }
+        functions_.dgemv(kCblasRowMajor, transpose ? kCblasTrans : kCblasNoTrans,
+                         blasInt(rows), blasInt(cols), alpha, a, blasInt(lda), x, 1, beta, y, 1);
+    }
+
+    void gemm(bool transpose_a, bool transpose_b, size_t m, size_t n, size_t k,
+              double alpha, const double* a, size_t lda, const double* b, size_t ldb,
+              double beta, double* c, size_t ldc) const override {
+        if (m == 0 || n == 0 || k == 0) {
+            fallback_.gemm(transpose_a, transpose_b, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+            return;
+        }
+        functions_.dgemm(kCblasRowMajor, transpose_a ? kCblasTrans : kCblasNoTrans,
+                         transpose_b ? kCblasTrans : kCblasNoTrans,
+                         blasInt(m), blasInt(n), blasInt(k), alpha, a, blasInt(lda), b, blasInt(ldb),
+                         beta, c, blasInt(ldc));
+    }
+
+private:
+    std::string name_;
+    CblasFunctions functions_;
+    BuiltinBlas fallback_;
+};
+
+#ifdef MLAPP_HAVE_CBLAS
+CblasFunctions linkedCblasFunctions() {
+    CblasFunctions functions;
+    functions.ddot = [](int n, const double* x, int incx, const double* y, int incy) {
+        return cblas_ddot(n, x, incx, y, incy);
+    };
+    functions.daxpy = [](int n, double alpha, const double* x, int incx, double* y, int incy) {
+        cblas_daxpy(n, alpha, x, incx, y, incy);
+    };
+    functions.dgemv = [](int order, int trans, int m, int n, double alpha, const double* a, int lda,
+                         const double* x, int incx, double beta, double* y, int incy) {
+        cblas_dgemv(static_cast<CBLAS_ORDER>(order), static_cast<CBLAS_TRANSPOSE>(trans),
+                    m, n, alpha, a, lda, x, incx, beta, y, incy);
+    };
+    functions.dgemm = [](int order, int trans_a, int trans_b, int m, int n, int k, double alpha,
+                         const double* a, int lda, const double* b, int ldb, double beta, double* c, int ldc) {
+        cblas_dgemm(static_cast<CBLAS_ORDER>(order), static_cast<CBLAS_TRANSPOSE>(trans_a),
+                    static_cast<CBLAS_TRANSPOSE>(trans_b), m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+    };
+    return functions;
+}
+#endif
+
+#ifdef MLAPP_HAVE_DLOPEN
+// Library names tried by a bare "dlopen" spec, most specific first
+const char* const kDefaultCblasLibraries[] = {
+#if defined(__APPLE__)
+    "/System/Library/Frameworks/Accelerate.framework/Accelerate",
+    "libopenblas.dylib",
+    "libcblas.dylib",
+#else
+    "libopenblas.so.0",
+    "libopenblas.so",
+    "libcblas.so.3",
+    "libcblas.so",
+    "libblas.so.3",
+    "libmkl_rt.so",
+#endif
+};
+
+// CBLAS loaded with dlopen; keeps the library mapped for its lifetime.
+class DlopenBlas : public CblasBackend {
+public:
+    DlopenBlas(const std::string& path, void* handle, const CblasFunctions& functions)
+        : CblasBackend("dlopen:" + path, functions), handle_(handle) {}
+    ~DlopenBlas() override { dlclose(handle_); }
+
+    DlopenBlas(const DlopenBlas&) = delete;
+    DlopenBlas& operator=(const DlopenBlas&) = delete;
+
+private:
+    void* handle_;
+};
+
+// Returns nullptr (with the reason in `error`) instead of throwing so that
+// callers can try several candidates.
+std::unique_ptr<BlasBackend> tryLoadCblas(const std::string& path, std::string& error) {
+    void* handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        const char* message = dlerror();
+        error = message ? message : "dlopen failed";
+        return nullptr;
+    }
+    CblasFunctions functions;
+    functions.ddot = reinterpret_cast<DdotFn>(dlsym(handle, "cblas_ddot"));
+    functions.daxpy = reinterpret_cast<DaxpyFn>(dlsym(handle, "cblas_daxpy"));
+    functions.dgemv = reinterpret_cast<DgemvFn>(dlsym(handle, "cblas_dgemv"));
+    functions.dgemm = reinterpret_cast<DgemmFn>(dlsym(handle, "cblas_dgemm"));
+    if (!functions.ddot || !functions.daxpy || !functions.dgemv || !functions.dgemm) {
+        dlclose(handle);
+        error = path + " does not export the CBLAS symbols (cblas_ddot, cblas_daxpy, cblas_dgemv, cblas_dgemm)";
+        return nullptr;
+    }
+    return std::unique_ptr<BlasBackend>(new DlopenBlas(path, handle, functions));
+}
+#endif
+
+std::unique_ptr<BlasBackend> loadDefaultCblas(std::string& error) {
+#ifdef MLAPP_HAVE_DLOPEN
+    for (const char* candidate : kDefaultCblasLibraries) {
+        std::unique_ptr<BlasBackend> backend = tryLoadCblas(candidate, error);
+        if (backend) {
+            return backend;
+        }
+    }
+    error = "no CBLAS library found (tried libopenblas, libcblas, libblas, libmkl_rt)";
+#else
+    error = "dlopen is not supported on this platform";
+#endif
+    return nullptr;
+}
+
+std::atomic<const BlasBackend*> g_active_backend(nullptr);
+
+std::mutex& backendsMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+// Every backend ever installed; never shrinks (see setActiveBlasBackend)
+std::vector<std::unique_ptr<BlasBackend>>& installedBackends() {
+    static std::vector<std::unique_ptr<BlasBackend>> backends;
+    return backends;
+}
+
+const BuiltinBlas& builtinBackend() {
+    static BuiltinBlas backend;
+    return backend;
+}
+
+} // namespace
+
+// --- BuiltinBlas ---
+
+double BuiltinBlas::dot(size_t n, const double* x, const double* y) const {
+    double sum = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        sum += x[i] * y[i];
+    }
+    return sum;
+}
+
+void BuiltinBlas::axpy(size_t n, double alpha, const double* x, double* y) const {
+    for (size_t i = 0; i < n; ++i) {
+        y[i] += alpha * x[i];
+    }
+}
+
+void BuiltinBlas::gemv(bool transpose, size_t rows, size_t cols, double alpha,
+                       const double* a, size_t lda, const double* x,
+                       double beta, double* y) const {
+    const size_t y_size = transpose ? cols : rows;
+    // beta == 0 overwrites y (BLAS convention: existing NaNs do not propagate)
+    for (size_t i = 0; i < y_size; ++i) {
+        y[i] = beta == 0.0 ? 0.0 : beta * y[i];
+    }
+    if (transpose) {
+        for (size_t r = 0; r < rows; ++r) {
+            axpy(cols, alpha * x[r], a + r * lda, y);
+        }
+    } else {
+        for (size_t r = 0; r < rows; ++r) {
+            y[r] += alpha * dot(cols, a + r * lda, x);
+        }
+    }
+}
+
+void BuiltinBlas::gemm(bool transpose_a, bool transpose_b, size_t m, size_t n, size_t k,
+                       double alpha, const double* a, size_t lda, const double* b, size_t ldb,
+                       double beta, double* c, size_t ldc) const {
+    for (size_t i = 0; i < m; ++i) {
+        double* c_row = c + i * ldc;
+        for (size_t j = 0; j < n; ++j) {
+            c_row[j] = beta == 0.0 ? 0.0 : beta * c_row[j];
+        }
+        // i-p-j order streams rows of B and C when B is not transposed
+        for (size_t p = 0; p < k; ++p) {
+            const double a_ip = alpha * (transpose_a ? a[p * lda + i] : a[i * lda + p]);
+            if (transpose_b) {
+                for (size_t j = 0; j < n; ++j) {
+                    c_row[j] += a_ip * b[j * ldb + p];
+                }
+            } else {
+                axpy(n, a_ip, b + p * ldb, c_row);
+            }
+        }
+    }
+}
+
+// --- Backend selection ---
+
+bool blasLinkedAtBuildTime() {
+#ifdef MLAPP_HAVE_CBLAS
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::unique_ptr<BlasBackend> createBlasBackend(const std::string& spec) {
+    if (spec == "builtin") {
+        return std::unique_ptr<BlasBackend>(new BuiltinBlas());
+    }
+    if (spec == "cblas") {
+#ifdef MLAPP_HAVE_CBLAS
+        return std::unique_ptr<BlasBackend>(new CblasBackend("cblas", linkedCblasFunctions()));
+#else
+        throw std::invalid_argument("BLAS backend 'cblas' is not available: this build was not linked against CBLAS "
+                                    "(use 'dlopen' or 'dlopen:<path>' instead).");
+#endif
+    }
+    std::string error;
+    if (spec == "dlopen") {
+        std::unique_ptr<BlasBackend> backend = loadDefaultCblas(error);
+        if (!backend) {
+            throw std::runtime_error("Cannot load a CBLAS library: " + error + ".");
+        }
+        return backend;
+    }
+    if (spec.compare(0, 7, "dlopen:") == 0 && spec.size() > 7) {
+#ifdef MLAPP_HAVE_DLOPEN
+        std::unique_ptr<BlasBackend> backend = tryLoadCblas(spec.substr(7), error);
+        if (!backend) {
+            throw std::runtime_error("Cannot load CBLAS from '" + spec.substr(7) + "': " + error + ".");
+        }
+        return backend;
+#else
+        throw std::runtime_error("dlopen is not supported on this platform.");
+#endif
+    }
+    if (spec == "auto") {
+        if (blasLinkedAtBuildTime()) {
+            return createBlasBackend("cblas");
+        }
+        std::unique_ptr<BlasBackend> backend = loadDefaultCblas(error);
+        if (backend) {
+            return backend;
+        }
+        return std::unique_ptr<BlasBackend>(new BuiltinBlas());
+    }
+    throw std::invalid_argument("Unknown BLAS backend '" + spec + "' (expected builtin, cblas, dlopen, dlopen:<path> or auto).");
+}
+
+const BlasBackend& activeBlasBackend() {
+    const BlasBackend* backend = g_active_backend.load(std::memory_order_acquire);
+    return backend ? *backend : builtinBackend();
+}
+
+void setActiveBlasBackend(std::unique_ptr<BlasBackend> backend) {
+    if (!backend) {
+        throw std::invalid_argument("BLAS backend cannot be null.");
+    }
+    std::lock_guard<std::mutex> lock(backendsMutex());
+    installedBackends().push_back(std::move(backend));
+    g_active_backend.store(installedBackends().back().get(), std::memory_order_release);
+}
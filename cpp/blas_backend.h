@@ -0,0 +1,72 @@
+#ifndef BLAS_BACKEND_H
+#define BLAS_BACKEND_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Dense kernels used by NeuralNetwork and the regression solvers.
+//
+// Matrices are row-major with an explicit leading dimension (elements between
+// the starts of consecutive rows), matching CBLAS' CblasRowMajor convention so
+// a CBLAS library can be plugged in without copying.
+class BlasBackend {
+public:
+    virtual ~BlasBackend() {}
+
+    // Short identifier reported in the stats output ("builtin", "cblas", ...)
+    virtual std::string name() const = 0;
+
+    // x . y
+    virtual double dot(size_t n, const double* x, const double* y) const = 0;
+
+    // y += alpha * x
+    virtual void axpy(size_t n, double alpha, const double* x, double* y) const = 0;
+
+    // y = alpha * op(A) * x + beta * y, where A is rows x cols and op(A) is A
+    // or A^T. With transpose, x has `rows` elements and y has `cols`.
+    virtual void gemv(bool transpose, size_t rows, size_t cols, double alpha,
+                      const double* a, size_t lda, const double* x,
+                      double beta, double* y) const = 0;
+
+    // C = alpha * op(A) * op(B) + beta * C, with op(A) m x k, op(B) k x n, C m x n
+    virtual void gemm(bool transpose_a, bool transpose_b, size_t m, size_t n, size_t k,
+                      double alpha, const double* a, size_t lda, const double* b, size_t ldb,
+                      double beta, double* c, size_t ldc) const = 0;
+};
+
+// Plain loops; always available and the default.
+class BuiltinBlas : public BlasBackend {
+public:
+    std::string name() const override { return "builtin"; }
+    double dot(size_t n, const double* x, const double* y) const override;
+    void axpy(size_t n, double alpha, const double* x, double* y) const override;
+    void gemv(bool transpose, size_t rows, size_t cols, double alpha,
+              const double* a, size_t lda, const double* x,
+              double beta, double* y) const override;
+    void gemm(bool transpose_a, bool transpose_b, size_t m, size_t n, size_t k,
+              double alpha, const double* a, size_t lda, const double* b, size_t ldb,
+              double beta, double* c, size_t ldc) const override;
+};
+
+// Backend names accepted by createBlasBackend:
+//   "builtin"        built-in loops
+//   "cblas"          CBLAS linked at build time (only when the Makefile found one)
+//   "dlopen"         first CBLAS library found among the usual system names
+//   "dlopen:<path>"  CBLAS symbols loaded from <path> at runtime
+//   "auto"           cblas if linked, else dlopen if a library loads, else builtin
+// Throws std::invalid_argument for unknown names and std::runtime_error when
+// the requested library cannot be loaded.
+std::unique_ptr<BlasBackend> createBlasBackend(const std::string& spec);
+
+// Whether this binary was built against a CBLAS library (MLAPP_HAVE_CBLAS)
+bool blasLinkedAtBuildTime();
+
+// Process-wide backend used by NeuralNetwork. Defaults to BuiltinBlas.
+// Switch it before starting worker threads; the previous backend stays alive
+// until the process exits so references handed out earlier remain valid.
+const BlasBackend& activeBlasBackend();
+void setActiveBlasBackend(std::unique_ptr<BlasBackend> backend);
+
+#endif // BLAS_BACKEND_H
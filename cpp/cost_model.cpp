@@ -0,0 +1,303 @@
+#include "cost_model.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+
+#include <omp.h>
+
+#include "neural_network.h"
+
+namespace {
+
+// Rough cost of std::exp plus the divide in sigmoid, in FLOP equivalents
+const double kSigmoidFlops = 20.0;
+// Parameter bytes touched per SGD step: forward read, W^T * delta read and
+// the in-place axpy update's read/write.
+const double kTrainWeightPasses = 4.0;
+// Evaluation passes skip backprop and most allocations
+const double kForwardOverheadFraction = 0.5;
+
+// Heap footprint of a std::vector<double> of `n` elements: the vector object
+// plus one malloc chunk (16-byte granularity, 32-byte minimum).
+double vectorBytes(size_t n) {
+    const double payload = 8.0 * n + 8.0; // + malloc header
+    return 24.0 + std::max(32.0, std::ceil(payload / 16.0) * 16.0);
+}
+
+double parameterCount(const std::vector<size_t>& layer_sizes) {
+    double params = 0.0;
+    for (size_t i = 0; i + 1 < layer_sizes.size(); ++i) {
+        params += static_cast<double>(layer_sizes[i]) * layer_sizes[i + 1] + layer_sizes[i + 1];
+    }
+    return params;
+}
+
+// Weights stored as one vector per row, plus one bias vector per layer
+double modelBytes(const std::vector<size_t>& layer_sizes) {
+    double bytes = 0.0;
+    for (size_t i = 0; i + 1 < layer_sizes.size(); ++i) {
+        bytes += layer_sizes[i + 1] * vectorBytes(layer_sizes[i]) + vectorBytes(layer_sizes[i + 1]);
+    }
+    return bytes;
+}
+
+// A SampleVector of `n` elements: the object with its inline buffer, plus a
+// malloc chunk once it spills past the inline capacity
+double sampleVectorBytes(size_t n) {
+    const double object = static_cast<double>(sizeof(SampleVector));
+    if (n <= SampleVector::kInlineCapacity) {
+        return object;
+    }
+    return object + std::max(32.0, std::ceil((8.0 * n + 8.0) / 16.0) * 16.0);
+}
+
+// Activations, pre-activations and deltas kept between SGD steps
+double scratchBytes(const std::vector<size_t>& layer_sizes) {
+    double bytes = 0.0;
+    for (size_t i = 0; i < layer_sizes.size(); ++i) {
+        bytes += (i == 0 ? 1.0 : 3.0) * sampleVectorBytes(layer_sizes[i]);
+    }
+    return bytes;
+}
+
+int evaluationPasses(int epochs, int report_every) {
+    if (epochs <= 0) {
+        return 1;
+    }
+    const int every = std::max(1, report_every);
+    return (epochs + every - 1) / every + 1; // Periodic MSE reports + final predictions
+}
+
+// Average per-sample time of `train` on a synthetic probe network
+double timeProbeMs(const std::vector<size_t>& layer_sizes, size_t max_samples, double budget_ms) {
+    NeuralNetwork probe(layer_sizes, 0.01);
+    Vector input(layer_sizes.front(), 0.5);
+    Vector target(layer_sizes.back(), 0.25);
+    for (int i = 0; i < 16; ++i) {
+        probe.train(input, target); // Warm up caches and the allocator
+    }
+    const auto start = std::chrono::steady_clock::now();
+    size_t done = 0;
+    double elapsed_ms = 0.0;
+    while (done < max_samples) {
+        for (int i = 0; i < 32; ++i) {
+            input[0] = 0.001 * static_cast<double>(done + i);
+            probe.train(input, target);
+        }
+        done += 32;
+        elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (elapsed_ms >= budget_ms) {
+            break;
+        }
+    }
+    return elapsed_ms / static_cast<double>(done);
+}
+
+} // namespace
+
+CostModel::CostModel(const MachineProfile& profile) : profile_(profile) {}
+
+double CostModel::forward_flops_per_sample(const std::vector<size_t>& layer_sizes) {
+    double flops = 0.0;
+    for (size_t i = 0; i + 1 < layer_sizes.size(); ++i) {
+        const double in = static_cast<double>(layer_sizes[i]);
+        const double out = static_cast<double>(layer_sizes[i + 1]);
+        flops += 2.0 * in * out + out; // W*a + b
+        if (i + 2 < layer_sizes.size()) {
+            flops += kSigmoidFlops * out; // Hidden activation
+        }
+    }
+    return flops;
+}
+
+double CostModel::train_flops_per_sample(const std::vector<size_t>& layer_sizes) {
+    double flops = forward_flops_per_sample(layer_sizes);
+    for (size_t i = 0; i + 1 < layer_sizes.size(); ++i) {
+        const double in = static_cast<double>(layer_sizes[i]);
+        const double out = static_cast<double>(layer_sizes[i + 1]);
+        flops += 2.0 * in * out + 2.0 * out; // In-place axpy per weight row; bias update
+        if (i > 0) {
+            flops += 2.0 * in * out + (kSigmoidFlops + 1.0) * in; // W^T * delta, sigmoid', hadamard
+        }
+    }
+    return flops;
+}
+
+CostEstimate CostModel::estimate(const TrainingJob& job) const {
+    const std::vector<size_t>& layers = job.layer_sizes;
+    if (layers.size() < 2) {
+        throw std::invalid_argument("Cost model needs at least an input and an output layer.");
+    }
+    const double n = static_cast<double>(job.samples);
+    const double weight_layers = static_cast<double>(layers.size() - 1);
+    const double params = parameterCount(layers);
+    const double runs = static_cast<double>(std::max<size_t>(1, job.runs));
+    const double train_samples = runs * n * std::max(0, job.epochs);
+    const double eval_samples = runs * n * evaluationPasses(job.epochs, job.report_every);
+
+    const double train_flops = train_flops_per_sample(layers);
+    const double forward_flops = forward_flops_per_sample(layers);
+
+    CostEstimate estimate;
+    estimate.flops = train_samples * train_flops + eval_samples * forward_flops;
+
+    const double sample_bytes = 8.0 * (layers.front() + layers.back());
+    estimate.bytes = train_samples * (kTrainWeightPasses * 8.0 * params + sample_bytes) +
+                     eval_samples * (8.0 * params + sample_bytes);
+
+    // Flat parsed columns + per-sample SampleVectors + shuffle indices + predictions
+    const double per_sample_memory = sample_bytes + sampleVectorBytes(layers.front()) +
+                                     sampleVectorBytes(layers.back()) + 8.0 + 8.0 * layers.back();
+    // Weights and biases plus the per-layer scratch; updates are in place, so
+    // no gradient matrix is ever materialized
+    const double model_memory = modelBytes(layers) + scratchBytes(layers);
+    // The samples are shared; every network copy has its own parameters and scratch
+    const double copies = static_cast<double>(std::max<size_t>(1, job.model_copies));
+    estimate.peak_memory_bytes = n * per_sample_memory + copies * model_memory;
+
+    const double train_ms_per_sample = profile_.overhead_ms_per_layer * weight_layers +
+                                       train_flops / profile_.flops_per_ms;
+    const double eval_ms_per_sample = kForwardOverheadFraction * profile_.overhead_ms_per_layer * weight_layers +
+                                      forward_flops / profile_.flops_per_ms;
+    const double parallelism = std::max(1, std::min(job.threads, profile_.cores));
+    estimate.time_ms = (train_samples * train_ms_per_sample + eval_samples * eval_ms_per_sample) / parallelism;
+    return estimate;
+}
+
+MachineProfile CostModel::calibrate() {
+    // Equal depth, very different width: the narrow probe measures overhead,
+    // the wide one arithmetic throughput.
+    const std::vector<size_t> narrow = {1, 2, 1};
+    const std::vector<size_t> wide = {64, 64, 64};
+    const double t_narrow = timeProbeMs(narrow, 4096, 2.0);
+    const double t_wide = timeProbeMs(wide, 1024, 4.0);
+    const double f_narrow = train_flops_per_sample(narrow);
+    const double f_wide = train_flops_per_sample(wide);
+    const double weight_layers = 2.0;
+
+    MachineProfile profile;
+    profile.cores = std::max(1, omp_get_num_procs());
+    if (t_wide > t_narrow) {
+        profile.flops_per_ms = (f_wide - f_narrow) / (t_wide - t_narrow);
+        profile.overhead_ms_per_layer = std::max(0.0, (t_narrow - f_narrow / profile.flops_per_ms) / weight_layers);
+    } else {
+        // Timer noise swamped the difference; attribute everything to arithmetic
+        profile.flops_per_ms = f_wide / std::max(t_wide, 1e-9);
+        profile.overhead_ms_per_layer = 0.0;
+    }
+    return profile;
+}
+
+BudgetDecision CostModel::fit_to_budget(const TrainingJob& job, double max_ms, double max_bytes) const {
+    BudgetDecision decision;
+    decision.job = job;
+    decision.estimate = estimate(job);
+    decision.original = decision.estimate;
+
+    auto fits_time = [&](const TrainingJob& candidate) {
+        return max_ms <= 0.0 || estimate(candidate).time_ms <= max_ms;
+    };
+    auto fits_memory = [&](const TrainingJob& candidate) {
+        return max_bytes <= 0.0 || estimate(candidate).peak_memory_bytes <= max_bytes;
+    };
+
+    if (fits_time(job) && fits_memory(job)) {
+        return decision;
+    }
+    decision.within_budget = false;
+
+    TrainingJob adjusted = job;
+    std::ostringstream reason;
+
+    // Memory only depends on the number of samples: subsample first.
+    if (!fits_memory(adjusted)) {
+        TrainingJob empty = adjusted;
+        empty.samples = 0;
+        if (!fits_memory(empty)) {
+            decision.feasible = false;
+            decision.reason = "model parameters alone exceed the memory budget";
+            return decision;
+        }
+        size_t lo = 0, hi = adjusted.samples; // Largest sample count that fits
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo + 1) / 2;
+            TrainingJob candidate = adjusted;
+            candidate.samples = mid;
+            if (fits_memory(candidate)) lo = mid; else hi = mid - 1;
+        }
+        if (lo == 0) {
+            decision.feasible = false;
+            decision.reason = "not even one sample fits the memory budget";
+            return decision;
+        }
+        reason << "samples " << adjusted.samples << "->" << lo << " (memory)";
+        adjusted.samples = lo;
+    }
+
+    // Then trade epochs for time, and only subsample further if one epoch is too slow.
+    if (!fits_time(adjusted)) {
+        int lo = 1, hi = adjusted.epochs;
+        TrainingJob one_epoch = adjusted;
+        one_epoch.epochs = 1;
+        if (fits_time(one_epoch)) {
+            while (lo < hi) {
+                int mid = lo + (hi - lo + 1) / 2;
+                TrainingJob candidate = adjusted;
+                candidate.epochs = mid;
+                if (fits_time(candidate)) lo = mid; else hi = mid - 1;
+            }
+            if (reason.tellp() > 0) reason << "; ";
+            reason << "epochs " << adjusted.epochs << "->" << lo << " (time)";
+            adjusted.epochs = lo;
+        } else {
+            size_t s_lo = 0, s_hi = adjusted.samples;
+            while (s_lo < s_hi) {
+                size_t mid = s_lo + (s_hi - s_lo + 1) / 2;
+                TrainingJob candidate = one_epoch;
+                candidate.samples = mid;
+                if (fits_time(candidate)) s_lo = mid; else s_hi = mid - 1;
+            }
+            if (s_lo == 0) {
+                decision.feasible = false;
+                decision.reason = "not even one epoch over one sample fits the time budget";
+                return decision;
+            }
+            if (reason.tellp() > 0) reason << "; ";
+            reason << "epochs " << adjusted.epochs << "->1, samples " << adjusted.samples << "->" << s_lo << " (time)";
+            adjusted.epochs = 1;
+            adjusted.samples = s_lo;
+        }
+    }
+
+    decision.job = adjusted;
+    decision.estimate = estimate(adjusted);
+    decision.reason = reason.str();
+    return decision;
+}
+
+double parseByteSize(const std::string& text) {
+    if (text.empty()) {
+        throw std::invalid_argument("Byte size cannot be empty.");
+    }
+    char* end;
+    double value = std::strtod(text.c_str(), &end);
+    std::string suffix(end);
+    double multiplier = 1.0;
+    if (suffix == "K" || suffix == "k") {
+        multiplier = 1024.0;
+    } else if (suffix == "M" || suffix == "m") {
+        multiplier = 1024.0 * 1024.0;
+    } else if (suffix == "G" || suffix == "g") {
+        multiplier = 1024.0 * 1024.0 * 1024.0;
+    } else if (!suffix.empty()) {
+        throw std::invalid_argument("Invalid byte size '" + text + "' (expected a number with optional K/M/G suffix).");
+    }
+    if (end == text.c_str() || !std::isfinite(value) || value < 0.0) {
+        throw std::invalid_argument("Invalid byte size '" + text + "'.");
+    }
+    return value * multiplier;
+}
@@ -0,0 +1,79 @@
+#ifndef COST_MODEL_H
+#define COST_MODEL_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Shape of a NeuralNetwork training request as main_server runs it:
+// `epochs` passes of per-sample SGD over `samples`, an MSE evaluation pass
+// every `report_every` epochs, and one final prediction pass. Parallel modes
+// repeat that work `runs` times side by side (race: one run per strategy),
+// keep `model_copies` networks in memory (local-sgd: one per replica plus
+// the average) and spread it over `threads` threads.
+struct TrainingJob {
+    std::vector<size_t> layer_sizes;
+    size_t samples = 0;
+    int epochs = 0;
+    int report_every = 10;
+    size_t runs = 1;
+    size_t model_copies = 1;
+    int threads = 1;
+};
+
+struct CostEstimate {
+    double flops = 0.0;              // Floating point operations for the whole job
+    double bytes = 0.0;              // Estimated memory traffic
+    double peak_memory_bytes = 0.0;  // Dataset + parameters + training temporaries
+    double time_ms = 0.0;            // flops and per-sample overhead scaled by the machine profile
+};
+
+// Machine throughput measured by CostModel::calibrate().
+// Per-sample time is modelled as
+//   overhead_ms_per_layer * weight_layers + flops_per_sample / flops_per_ms
+// which captures both the allocation/call overhead that dominates tiny
+// networks and the arithmetic that dominates wide ones.
+struct MachineProfile {
+    double overhead_ms_per_layer = 1e-4;
+    double flops_per_ms = 1e6;
+    int cores = 1; // Threads beyond this do not shorten a parallel job
+};
+
+// Outcome of fitting a job into --max-ms / --max-mem.
+struct BudgetDecision {
+    bool within_budget = true; // Original job already fits
+    bool feasible = true;      // Some adjusted job fits (false => reject)
+    TrainingJob job;           // Job to run (adjusted if needed)
+    CostEstimate estimate;     // Estimate for `job`
+    CostEstimate original;     // Estimate for the job as requested
+    std::string reason;        // Human readable explanation when adjusted or infeasible
+};
+
+class CostModel {
+public:
+    explicit CostModel(const MachineProfile& profile);
+
+    // Times two small probe networks of equal depth but different width and
+    // solves for the two MachineProfile coefficients. Takes a few milliseconds.
+    static MachineProfile calibrate();
+
+    CostEstimate estimate(const TrainingJob& job) const;
+
+    // Reduce epochs first, then subsample, until the job fits both limits.
+    // A limit <= 0 means "unlimited".
+    BudgetDecision fit_to_budget(const TrainingJob& job, double max_ms, double max_bytes) const;
+
+    const MachineProfile& profile() const { return profile_; }
+
+    // FLOPs of one SGD step (forward + backward + update) and of one forward pass
+    static double train_flops_per_sample(const std::vector<size_t>& layer_sizes);
+    static double forward_flops_per_sample(const std::vector<size_t>& layer_sizes);
+
+private:
+    MachineProfile profile_;
+};
+
+// Parses "1048576", "512K", "64M" or "2G" (binary multiples) into bytes.
+double parseByteSize(const std::string& text);
+
+#endif // COST_MODEL_H
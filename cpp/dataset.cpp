@@ -0,0 +1,787 @@
+#include "dataset.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MLAPP_HAVE_MMAP 1
+#endif
+
+namespace {
+
+// A sibling of `path` that no other writer uses: engine processes started for
+// concurrent requests on the same CSV must not write through one inode
+std::string uniqueTemporaryPath(const std::string& path) {
+    static std::atomic<unsigned long> counter(0);
+    unsigned long process = std::random_device()();
+#ifdef MLAPP_HAVE_MMAP
+    process = static_cast<unsigned long>(getpid());
+#endif
+    return path + "." + std::to_string(process) + "." + std::to_string(counter.fetch_add(1)) + ".tmp";
+}
+
+// Columns longer than this are gathered in parallel
+const size_t kParallelCopyRows = size_t(1) << 16;
+
+typedef std::pair<const char*, const char*> Field;
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Trims blanks and one pair of surrounding double quotes
+Field trimField(const char* begin, const char* end) {
+    while (begin < end && isSpace(*begin)) {
+        ++begin;
+    }
+    while (end > begin && isSpace(end[-1])) {
+        --end;
+    }
+    if (end - begin >= 2 && *begin == '"' && end[-1] == '"') {
+        ++begin;
+        --end;
+    }
+    return Field(begin, end);
+}
+
+void splitFields(const char* begin, const char* end, char delimiter, std::vector<Field>& fields) {
+    fields.clear();
+    const char* field_start = begin;
+    for (const char* p = begin; p < end; ++p) {
+        if (*p == delimiter) {
+            fields.push_back(trimField(field_start, p));
+            field_start = p + 1;
+        }
+    }
+    fields.push_back(trimField(field_start, end));
+}
+
+bool isBlankLine(const char* begin, const char* end) {
+    for (const char* p = begin; p < end; ++p) {
+        if (!isSpace(*p)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// strtod needs a terminated string; mapped files are not, so fields are copied
+// (on the stack for anything number-sized)
+bool parseField(const Field& field, double& value) {
+    const size_t length = static_cast<size_t>(field.second - field.first);
+    if (length == 0) {
+        return false;
+    }
+    char small[64];
+    std::string large;
+    const char* text = small;
+    if (length < sizeof(small)) {
+        std::memcpy(small, field.first, length);
+        small[length] = '\0';
+    } else {
+        large.assign(field.first, field.second);
+        text = large.c_str();
+    }
+    char* parsed_end;
+    errno = 0;
+    value = std::strtod(text, &parsed_end);
+    return parsed_end == text + length && errno != ERANGE && std::isfinite(value);
+}
+
+struct CsvChunk {
+    std::vector<double> values; // Row-major
+    size_t rows = 0;
+    size_t lines = 0;           // Lines consumed, to turn chunk positions into file line numbers
+    std::string error;          // First error in the chunk ("" if none)
+    size_t error_line = 0;      // 1-based line within the chunk
+};
+
+void parseCsvChunk(const char* begin, const char* end, size_t cols, char delimiter, CsvChunk& chunk) {
+    std::vector<Field> fields;
+    const char* line = begin;
+    while (line < end) {
+        const char* newline = static_cast<const char*>(std::memchr(line, '\n', end - line));
+        const char* line_end = newline ? newline : end;
+        ++chunk.lines;
+        if (!isBlankLine(line, line_end)) {
+            splitFields(line, line_end, delimiter, fields);
+            if (fields.size() != cols) {
+                chunk.error = "has " + std::to_string(fields.size()) + " fields, expected " + std::to_string(cols);
+                chunk.error_line = chunk.lines;
+                return;
+            }
+            for (const Field& field : fields) {
+                double value;
+                if (!parseField(field, value)) {
+                    chunk.error = "has an invalid value '" + std::string(field.first, field.second) + "'";
+                    chunk.error_line = chunk.lines;
+                    return;
+                }
+                chunk.values.push_back(value);
+            }
+            ++chunk.rows;
+        }
+        line = newline ? newline + 1 : end;
+    }
+}
+
+// Text of `key` in a .npy header dict: a quoted string, a tuple (with its
+// parentheses) or a bare word
+std::string npyHeaderField(const std::string& header, const std::string& key) {
+    const size_t key_pos = header.find("'" + key + "'");
+    const size_t colon = key_pos == std::string::npos ? key_pos : header.find(':', key_pos);
+    if (colon == std::string::npos) {
+        throw std::invalid_argument(".npy header has no '" + key + "' entry");
+    }
+    size_t begin = header.find_first_not_of(' ', colon + 1);
+    if (begin == std::string::npos) {
+        throw std::invalid_argument(".npy header entry '" + key + "' is malformed");
+    }
+    size_t end;
+    if (header[begin] == '\'') {
+        ++begin;
+        end = header.find('\'', begin);
+    } else if (header[begin] == '(') {
+        end = header.find(')', begin);
+        end = end == std::string::npos ? end : end + 1;
+    } else {
+        end = header.find_first_of(",}", begin);
+    }
+    if (end == std::string::npos) {
+        throw std::invalid_argument(".npy header entry '" + key + "' is malformed");
+    }
+    return header.substr(begin, end - begin);
+}
+
+std::string extensionOf(const std::string& path) {
+    const size_t dot = path.find_last_of('.');
+    const size_t slash = path.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return "";
+    }
+    std::string extension = path.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension;
+}
+
+// --- Cache sidecar ---
+// Layout: CacheHeader; the source path and each column name as a uint64
+// length plus bytes; `cols` ColumnStats at stats_offset (8-byte aligned); the
+// values, column-major float64, at data_offset (64-byte aligned).
+const char kCacheMagic[8] = {'M', 'L', 'D', 'S', 'C', 'A', 'C', 'H'};
+const uint32_t kCacheVersion = 1;
+const uint32_t kByteOrderMark = 0x01020304; // Sidecars are only read on hosts of the writer's byte order
+
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t source_size;
+    int64_t source_mtime_ns;
+    uint64_t content_hash;
+    uint64_t options_key; // Parse options that change the result
+    uint64_t rows;
+    uint64_t cols;
+    uint64_t stats_offset;
+    uint64_t data_offset;
+    uint64_t file_size;
+};
+
+size_t roundUp(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+uint64_t optionsKey(const DatasetOptions& options) {
+    return static_cast<unsigned char>(options.delimiter) | static_cast<uint64_t>(options.header + 1) << 8;
+}
+
+// Modification time in nanoseconds, or -1 when it cannot be read
+int64_t modificationTimeNs(const std::string& path) {
+#ifdef MLAPP_HAVE_MMAP
+    struct stat info;
+    if (::stat(path.c_str(), &info) != 0) {
+        return -1;
+    }
+#ifdef __APPLE__
+    return static_cast<int64_t>(info.st_mtimespec.tv_sec) * 1000000000 + info.st_mtimespec.tv_nsec;
+#else
+    return static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+#endif
+#else
+    (void)path;
+    return -1;
+#endif
+}
+
+std::string canonicalPath(const std::string& path) {
+#ifdef MLAPP_HAVE_MMAP
+    char* resolved = ::realpath(path.c_str(), nullptr);
+    if (resolved) {
+        const std::string result(resolved);
+        std::free(resolved);
+        return result;
+    }
+#endif
+    return path;
+}
+
+void appendString(std::string& out, const std::string& value) {
+    const uint64_t length = value.size();
+    out.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    out += value;
+}
+
+bool readString(const char*& cursor, const char* limit, std::string& value) {
+    uint64_t length;
+    if (limit - cursor < static_cast<ptrdiff_t>(sizeof(length))) {
+        return false;
+    }
+    std::memcpy(&length, cursor, sizeof(length));
+    cursor += sizeof(length);
+    if (length > static_cast<uint64_t>(limit - cursor)) {
+        return false;
+    }
+    value.assign(cursor, static_cast<size_t>(length));
+    cursor += length;
+    return true;
+}
+
+uint64_t mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+uint64_t hashBlock(const char* data, size_t size) {
+    // One multiply-rotate round per 8 bytes (the xxHash64 round)
+    const uint64_t prime1 = 0x9e3779b185ebca87ULL;
+    const uint64_t prime2 = 0xc2b2ae3d27d4eb4fULL;
+    uint64_t h = prime1 ^ size;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        h += word * prime2;
+        h = ((h << 31) | (h >> 33)) * prime1;
+    }
+    uint64_t tail = 0;
+    std::memcpy(&tail, data + i, size - i);
+    return mix64(h ^ tail);
+}
+
+uint32_t readLittleEndian(const unsigned char* p, size_t bytes) {
+    uint32_t value = 0;
+    for (size_t i = bytes; i-- > 0;) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+} // namespace
+
+// --- MappedFile ---
+MappedFile::MappedFile(const std::string& path) : data_(""), size_(0), mapped_(false) {
+#ifdef MLAPP_HAVE_MMAP
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open '" + path + "'");
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot stat '" + path + "'");
+    }
+    size_ = static_cast<size_t>(info.st_size);
+    if (size_ > 0) {
+        void* mapping = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Cannot map '" + path + "'");
+        }
+        data_ = static_cast<const char*>(mapping);
+        mapped_ = true;
+    }
+    ::close(fd); // The mapping keeps the file alive
+#else
+    std::ifstream in(path.c_str(), std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Cannot open '" + path + "'");
+    }
+    buffer_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    size_ = buffer_.size();
+    if (size_ > 0) {
+        data_ = buffer_.data();
+    }
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifdef MLAPP_HAVE_MMAP
+    if (mapped_) {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+}
+
+// --- ColumnView ---
+const double* ColumnView::contiguous() const {
+    if (type_ != ColumnType::Float64 || stride_ != sizeof(double) ||
+        reinterpret_cast<uintptr_t>(base_) % alignof(double) != 0) {
+        return nullptr;
+    }
+    return reinterpret_cast<const double*>(base_);
+}
+
+void ColumnView::copy_to(double* out, size_t out_stride) const {
+    const long n = static_cast<long>(rows_);
+    #pragma omp parallel for schedule(static) if (rows_ >= kParallelCopyRows)
+    for (long i = 0; i < n; ++i) {
+        out[i * out_stride] = (*this)[static_cast<size_t>(i)];
+    }
+}
+
+ColumnStats computeColumnStats(const ColumnView& column) {
+    ColumnStats total;
+    const long n = static_cast<long>(column.size());
+    if (n == 0) {
+        return total;
+    }
+    total.min = std::numeric_limits<double>::infinity();
+    total.max = -std::numeric_limits<double>::infinity();
+    double total_count = 0.0;
+    double total_m2 = 0.0;
+    #pragma omp parallel if (column.size() >= kParallelCopyRows)
+    {
+        // Welford per thread, merged with Chan's pairwise update
+        double local_min = std::numeric_limits<double>::infinity();
+        double local_max = -std::numeric_limits<double>::infinity();
+        double count = 0.0;
+        double mean = 0.0;
+        double m2 = 0.0;
+        #pragma omp for schedule(static) nowait
+        for (long i = 0; i < n; ++i) {
+            const double value = column[static_cast<size_t>(i)];
+            local_min = std::min(local_min, value);
+            local_max = std::max(local_max, value);
+            count += 1.0;
+            const double delta = value - mean;
+            mean += delta / count;
+            m2 += delta * (value - mean);
+        }
+        #pragma omp critical
+        {
+            if (count > 0.0) {
+                total.min = std::min(total.min, local_min);
+                total.max = std::max(total.max, local_max);
+                const double merged = total_count + count;
+                const double delta = mean - total.mean;
+                total.mean += delta * count / merged;
+                total_m2 += m2 + delta * delta * total_count * count / merged;
+                total_count = merged;
+            }
+        }
+    }
+    total.variance = total_m2 / total_count;
+    return total;
+}
+
+uint64_t contentHash(const char* data, size_t size) {
+    const size_t block = size_t(1) << 20;
+    const long blocks = static_cast<long>((size + block - 1) / block);
+    std::vector<uint64_t> hashes(blocks);
+    #pragma omp parallel for schedule(static)
+    for (long b = 0; b < blocks; ++b) {
+        const size_t begin = static_cast<size_t>(b) * block;
+        hashes[b] = hashBlock(data + begin, std::min(block, size - begin));
+    }
+    uint64_t h = mix64(size);
+    for (uint64_t value : hashes) {
+        h = mix64(h ^ value) + 0x9e3779b97f4a7c15ULL;
+    }
+    return h;
+}
+
+// --- Dataset ---
+const char* Dataset::base() const {
+    return (file_ ? file_->data() : reinterpret_cast<const char*>(values_.data())) + offset_;
+}
+
+ColumnStats Dataset::column_stats(size_t j) const {
+    if (stats_.size() == cols_ && j < cols_) {
+        return stats_[j];
+    }
+    return computeColumnStats(column(j));
+}
+
+ColumnView Dataset::column(size_t j) const {
+    if (j >= cols_) {
+        throw std::out_of_range("Dataset column index out of range");
+    }
+    return ColumnView(base() + j * column_stride_, rows_, row_stride_, type_);
+}
+
+size_t Dataset::column_index(const std::string& spec) const {
+    const std::vector<std::string>::const_iterator named = std::find(names_.begin(), names_.end(), spec);
+    if (named != names_.end()) {
+        return static_cast<size_t>(named - names_.begin());
+    }
+    if (!spec.empty() && spec.find_first_not_of("0123456789") == std::string::npos) {
+        const unsigned long index = std::strtoul(spec.c_str(), nullptr, 10);
+        if (index < cols_) {
+            return index;
+        }
+    }
+    throw std::invalid_argument("Unknown column '" + spec + "' (dataset has " + std::to_string(cols_) + " columns)");
+}
+
+std::vector<size_t> Dataset::select_columns(const std::string& specs) const {
+    std::vector<size_t> selected;
+    size_t start = 0;
+    while (start <= specs.size()) {
+        size_t comma = specs.find(',', start);
+        if (comma == std::string::npos) {
+            comma = specs.size();
+        }
+        const Field field = trimField(specs.data() + start, specs.data() + comma);
+        if (field.first == field.second) {
+            throw std::invalid_argument("Empty column name in '" + specs + "'");
+        }
+        selected.push_back(column_index(std::string(field.first, field.second)));
+        start = comma + 1;
+    }
+    return selected;
+}
+
+Dataset Dataset::parse_csv(const char* begin, const char* end, const DatasetOptions& options) {
+    // The first non-blank line fixes the column count and may be a header
+    const char* line = begin;
+    size_t lines_before_data = 0;
+    const char* first_end = end;
+    while (line < end) {
+        const char* newline = static_cast<const char*>(std::memchr(line, '\n', end - line));
+        first_end = newline ? newline : end;
+        if (!isBlankLine(line, first_end)) {
+            break;
+        }
+        ++lines_before_data;
+        line = newline ? newline + 1 : end;
+    }
+    if (line >= end) {
+        throw std::invalid_argument("CSV input has no rows");
+    }
+    std::vector<Field> fields;
+    splitFields(line, first_end, options.delimiter, fields);
+    bool header = options.header == 1;
+    if (options.header < 0) {
+        double ignored;
+        for (const Field& field : fields) {
+            header = header || !parseField(field, ignored);
+        }
+    }
+
+    Dataset dataset;
+    dataset.format_ = "csv";
+    dataset.cols_ = fields.size();
+    for (size_t j = 0; j < fields.size(); ++j) {
+        dataset.names_.push_back(header ? std::string(fields[j].first, fields[j].second) : std::to_string(j));
+    }
+    const char* data_begin = line;
+    if (header) {
+        data_begin = first_end < end ? first_end + 1 : end;
+        ++lines_before_data;
+    }
+
+    // Chunk boundaries sit just after a newline, so no line is split
+    const size_t chunk_bytes = std::max<size_t>(1, options.chunk_bytes);
+    std::vector<const char*> bounds(1, data_begin);
+    while (bounds.back() < end) {
+        const char* cut = bounds.back() + std::min<size_t>(chunk_bytes, end - bounds.back());
+        if (cut < end) {
+            const char* newline = static_cast<const char*>(std::memchr(cut, '\n', end - cut));
+            cut = newline ? newline + 1 : end;
+        }
+        bounds.push_back(cut);
+    }
+    const long chunk_count = static_cast<long>(bounds.size() - 1);
+    std::vector<CsvChunk> chunks(chunk_count);
+    #pragma omp parallel for schedule(dynamic)
+    for (long c = 0; c < chunk_count; ++c) {
+        parseCsvChunk(bounds[c], bounds[c + 1], dataset.cols_, options.delimiter, chunks[c]);
+    }
+
+    std::vector<size_t> first_row(chunk_count + 1, 0);
+    size_t line_number = lines_before_data;
+    for (long c = 0; c < chunk_count; ++c) {
+        if (!chunks[c].error.empty()) {
+            throw std::invalid_argument("CSV line " + std::to_string(line_number + chunks[c].error_line) + " " +
+                                        chunks[c].error);
+        }
+        line_number += chunks[c].lines;
+        first_row[c + 1] = first_row[c] + chunks[c].rows;
+    }
+
+    dataset.rows_ = first_row[chunk_count];
+    dataset.values_.resize(dataset.rows_ * dataset.cols_);
+    const size_t rows = dataset.rows_;
+    const size_t cols = dataset.cols_;
+    #pragma omp parallel for schedule(dynamic)
+    for (long c = 0; c < chunk_count; ++c) {
+        const CsvChunk& chunk = chunks[c];
+        for (size_t r = 0; r < chunk.rows; ++r) {
+            for (size_t j = 0; j < cols; ++j) {
+                dataset.values_[j * rows + first_row[c] + r] = chunk.values[r * cols + j];
+            }
+        }
+        std::vector<double>().swap(chunks[c].values);
+    }
+    dataset.row_stride_ = sizeof(double);
+    dataset.column_stride_ = rows * sizeof(double);
+    return dataset;
+}
+
+Dataset Dataset::load(const std::string& path, const DatasetOptions& options) {
+    std::string format = options.format;
+    DatasetOptions csv_options = options;
+    if (format == "auto") {
+        const std::string extension = extensionOf(path);
+        if (extension == "csv" || extension == "txt") {
+            format = "csv";
+        } else if (extension == "tsv") {
+            format = "csv";
+            csv_options.delimiter = '\t';
+        } else if (extension == "npy") {
+            format = "npy";
+        } else if (extension == "bin" || extension == "raw" || extension == "f64") {
+            format = "raw";
+        } else {
+            throw std::invalid_argument("Cannot infer the format of '" + path + "'; use csv, npy or raw explicitly");
+        }
+    }
+
+    std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>(path);
+    if (format == "csv") {
+        if (!options.cache_path.empty()) {
+            Dataset cached;
+            if (open_cache(path, *file, csv_options, cached)) {
+                return cached;
+            }
+        }
+        Dataset dataset = parse_csv(file->data(), file->data() + file->size(), csv_options);
+        if (!options.cache_path.empty()) {
+            dataset.write_cache(path, *file, csv_options);
+        }
+        return dataset;
+    }
+
+    Dataset dataset;
+    dataset.format_ = format;
+    dataset.file_ = file;
+    if (format == "raw") {
+        if (options.raw_columns == 0 || file->size() % (options.raw_columns * sizeof(double)) != 0) {
+            throw std::invalid_argument("Raw file '" + path + "' is not a whole number of rows of " +
+                                        std::to_string(options.raw_columns) + " float64 values");
+        }
+        dataset.cols_ = options.raw_columns;
+        dataset.rows_ = file->size() / (dataset.cols_ * sizeof(double));
+        dataset.row_stride_ = dataset.cols_ * sizeof(double);
+        dataset.column_stride_ = sizeof(double);
+    } else if (format == "npy") {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(file->data());
+        if (file->size() < 10 || std::memcmp(bytes, "\x93NUMPY", 6) != 0) {
+            throw std::invalid_argument("'" + path + "' is not a .npy file");
+        }
+        const unsigned major = bytes[6];
+        if (major < 1 || major > 3 || (major > 1 && file->size() < 12)) {
+            throw std::invalid_argument("Unsupported .npy format version " + std::to_string(major));
+        }
+        const size_t header_start = major == 1 ? 10 : 12;
+        const size_t header_length = readLittleEndian(bytes + 8, major == 1 ? 2 : 4);
+        if (header_start + header_length > file->size()) {
+            throw std::invalid_argument(".npy header of '" + path + "' is truncated");
+        }
+        const std::string header(file->data() + header_start, header_length);
+
+        const std::string descr = npyHeaderField(header, "descr");
+        size_t element_bytes;
+        if (descr == "<f8") {
+            dataset.type_ = ColumnType::Float64;
+            element_bytes = 8;
+        } else if (descr == "<f4") {
+            dataset.type_ = ColumnType::Float32;
+            element_bytes = 4;
+        } else {
+            throw std::invalid_argument(".npy dtype '" + descr + "' is not supported (use little-endian f8 or f4)");
+        }
+        const bool fortran_order = npyHeaderField(header, "fortran_order") == "True";
+        const std::string shape = npyHeaderField(header, "shape");
+        std::vector<size_t> dims;
+        for (size_t p = 1; p < shape.size();) {
+            const size_t digit = shape.find_first_of("0123456789", p);
+            if (digit == std::string::npos) {
+                break;
+            }
+            size_t stop = shape.find_first_not_of("0123456789", digit);
+            dims.push_back(std::strtoull(shape.c_str() + digit, nullptr, 10));
+            p = stop == std::string::npos ? shape.size() : stop;
+        }
+        if (dims.empty() || dims.size() > 2) {
+            throw std::invalid_argument(".npy shape " + shape + " is not supported (need 1-D or 2-D)");
+        }
+        dataset.rows_ = dims[0];
+        dataset.cols_ = dims.size() == 2 ? dims[1] : 1;
+        dataset.offset_ = header_start + header_length;
+        if (dataset.offset_ + dataset.rows_ * dataset.cols_ * element_bytes > file->size()) {
+            throw std::invalid_argument(".npy data of '" + path + "' is truncated");
+        }
+        dataset.row_stride_ = fortran_order ? element_bytes : dataset.cols_ * element_bytes;
+        dataset.column_stride_ = fortran_order ? dataset.rows_ * element_bytes : element_bytes;
+    } else {
+        throw std::invalid_argument("Unknown dataset format '" + format + "' (use auto, csv, npy or raw)");
+    }
+    for (size_t j = 0; j < dataset.cols_; ++j) {
+        dataset.names_.push_back(std::to_string(j));
+    }
+    return dataset;
+}
+
+bool Dataset::open_cache(const std::string& source, const MappedFile& text, const DatasetOptions& options,
+                         Dataset& dataset) {
+    std::shared_ptr<MappedFile> cache;
+    try {
+        cache = std::make_shared<MappedFile>(options.cache_path);
+    } catch (const std::runtime_error&) {
+        return false; // No sidecar yet
+    }
+    // Anything unexpected means a stale or foreign file: parse and rewrite it
+    CacheHeader header;
+    if (cache->size() < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, cache->data(), sizeof(header));
+    if (std::memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) != 0 || header.version != kCacheVersion ||
+        header.byte_order != kByteOrderMark || header.file_size != cache->size() ||
+        header.options_key != optionsKey(options) || header.source_size != text.size()) {
+        return false;
+    }
+    if (header.cols == 0 || header.stats_offset + header.cols * sizeof(ColumnStats) > header.data_offset ||
+        header.data_offset % 64 != 0 || header.rows > (cache->size() - header.data_offset) / sizeof(double) / header.cols ||
+        header.data_offset + header.rows * header.cols * sizeof(double) != cache->size()) {
+        return false;
+    }
+    const char* cursor = cache->data() + sizeof(header);
+    const char* limit = cache->data() + header.stats_offset;
+    std::string recorded_source;
+    if (!readString(cursor, limit, recorded_source) || recorded_source != canonicalPath(source)) {
+        return false;
+    }
+    std::vector<std::string> names(header.cols);
+    for (std::string& name : names) {
+        if (!readString(cursor, limit, name)) {
+            return false;
+        }
+    }
+
+    std::string status = "hit";
+    const int64_t mtime = modificationTimeNs(source);
+    if (header.source_mtime_ns != mtime) {
+        // Touched or copied but maybe unchanged: hashing is far cheaper than parsing
+        if (contentHash(text.data(), text.size()) != header.content_hash) {
+            return false;
+        }
+        status = "rehashed";
+        std::fstream update(options.cache_path.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+        if (update) {
+            update.seekp(offsetof(CacheHeader, source_mtime_ns));
+            update.write(reinterpret_cast<const char*>(&mtime), sizeof(mtime));
+        }
+    }
+
+    dataset.format_ = "csv";
+    dataset.rows_ = header.rows;
+    dataset.cols_ = header.cols;
+    dataset.names_.swap(names);
+    dataset.stats_.resize(header.cols);
+    std::memcpy(&dataset.stats_[0], cache->data() + header.stats_offset, header.cols * sizeof(ColumnStats));
+    dataset.file_ = cache;
+    dataset.offset_ = header.data_offset;
+    dataset.row_stride_ = sizeof(double);
+    dataset.column_stride_ = header.rows * sizeof(double);
+    dataset.type_ = ColumnType::Float64;
+    dataset.cache_status_ = status;
+    return true;
+}
+
+void Dataset::write_cache(const std::string& source, const MappedFile& text, const DatasetOptions& options) {
+    // Written under a temporary name of its own and renamed, so readers never
+    // see half a file and concurrent writers never share one
+    const std::string temporary = uniqueTemporaryPath(options.cache_path);
+    try {
+        stats_.resize(cols_);
+        for (size_t j = 0; j < cols_; ++j) {
+            stats_[j] = computeColumnStats(column(j));
+        }
+        std::string metadata;
+        appendString(metadata, canonicalPath(source));
+        for (const std::string& name : names_) {
+            appendString(metadata, name);
+        }
+
+        CacheHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+        header.version = kCacheVersion;
+        header.byte_order = kByteOrderMark;
+        header.source_size = text.size();
+        header.source_mtime_ns = modificationTimeNs(source);
+        header.content_hash = contentHash(text.data(), text.size());
+        header.options_key = optionsKey(options);
+        header.rows = rows_;
+        header.cols = cols_;
+        header.stats_offset = roundUp(sizeof(header) + metadata.size(), sizeof(double));
+        header.data_offset = roundUp(header.stats_offset + cols_ * sizeof(ColumnStats), 64);
+        header.file_size = header.data_offset + values_.size() * sizeof(double);
+
+        std::ofstream out(temporary.c_str(), std::ios::binary | std::ios::trunc);
+        const std::string padding(64, '\0');
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(metadata.data(), static_cast<std::streamsize>(metadata.size()));
+        out.write(padding.data(), static_cast<std::streamsize>(header.stats_offset - sizeof(header) - metadata.size()));
+        out.write(reinterpret_cast<const char*>(stats_.data()), static_cast<std::streamsize>(cols_ * sizeof(ColumnStats)));
+        out.write(padding.data(),
+                  static_cast<std::streamsize>(header.data_offset - header.stats_offset - cols_ * sizeof(ColumnStats)));
+        out.write(reinterpret_cast<const char*>(values_.data()),
+                  static_cast<std::streamsize>(values_.size() * sizeof(double)));
+        out.close();
+        if (!out) {
+            throw std::runtime_error("cannot write '" + temporary + "'");
+        }
+#ifdef _WIN32
+        std::remove(options.cache_path.c_str()); // rename does not replace on Windows
+#endif
+        if (std::rename(temporary.c_str(), options.cache_path.c_str()) != 0) {
+            throw std::runtime_error("cannot rename '" + temporary + "' to '" + options.cache_path + "'");
+        }
+        cache_status_ = "written";
+    } catch (const std::exception& e) {
+        std::remove(temporary.c_str());
+        cache_status_ = std::string("failed: ") + e.what();
+    }
+}
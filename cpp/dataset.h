@@ -0,0 +1,156 @@
+#ifndef DATASET_H
+#define DATASET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Read-only contents of a whole file: mmap'ed where available (pages are
+// loaded on first touch and shared with the page cache), otherwise read into
+// memory. Throws std::runtime_error when the file cannot be opened or mapped.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const char* data_;
+    size_t size_;
+    bool mapped_;
+    std::vector<char> buffer_; // Fallback storage when mmap is unavailable
+};
+
+enum class ColumnType { Float64, Float32 };
+
+// One column of a Dataset, read in place: value i is the element at
+// base + i * stride bytes. Selecting columns never copies the data.
+class ColumnView {
+public:
+    ColumnView(const char* base, size_t rows, size_t stride, ColumnType type)
+        : base_(base), rows_(rows), stride_(stride), type_(type) {}
+
+    size_t size() const { return rows_; }
+
+    double operator[](size_t i) const {
+        // memcpy: rows of .npy/raw files need not be aligned for the element type
+        const char* p = base_ + i * stride_;
+        if (type_ == ColumnType::Float64) {
+            double value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+        float value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    // The values as one aligned float64 array (CSV columns, Fortran-order
+    // .npy), or nullptr when the column is strided or float32
+    const double* contiguous() const;
+
+    // Gathers the column into out[0], out[out_stride], ... (in parallel for long columns)
+    void copy_to(double* out, size_t out_stride = 1) const;
+
+private:
+    const char* base_;
+    size_t rows_;
+    size_t stride_;
+    ColumnType type_;
+};
+
+// Summary of one column (variance is the population variance)
+struct ColumnStats {
+    double min = 0.0;
+    double max = 0.0;
+    double mean = 0.0;
+    double variance = 0.0;
+};
+
+// One parallel pass over the column
+ColumnStats computeColumnStats(const ColumnView& column);
+
+// 64-bit hash of a byte range, computed over fixed 1MB blocks in parallel
+// (the result does not depend on the thread count)
+uint64_t contentHash(const char* data, size_t size);
+
+struct DatasetOptions {
+    std::string format = "auto";          // auto (from the extension), csv, npy or raw
+    size_t raw_columns = 1;               // raw: float64 values per row
+    char delimiter = ',';                 // csv
+    int header = -1;                      // csv: 1 names on the first line, 0 none, -1 detect
+    size_t chunk_bytes = size_t(4) << 20; // csv: bytes per parallel parse chunk
+    // csv: binary sidecar to map instead of parsing ("" = no cache). It is
+    // (re)written when missing or stale, keyed by the source's path, size,
+    // mtime and content hash plus the parse options.
+    std::string cache_path;
+};
+
+// A table of numeric columns loaded from a file:
+//   csv  - parsed in parallel: the input is cut into chunk_bytes pieces at
+//          newline boundaries, every chunk parsed on its own thread, and the
+//          rows scattered into column-major storage
+//   npy  - NumPy .npy (format 1.0-3.0) with '<f8' or '<f4' data, 1-D or 2-D,
+//          C or Fortran order; mapped, not parsed
+//   raw  - native float64 rows of raw_columns values; mapped, not parsed
+// With a cache_path, a CSV whose sidecar is current is mapped from the
+// sidecar (column-major float64, 64-byte aligned) and not parsed at all.
+// Throws std::invalid_argument for malformed input (CSV errors name the line).
+class Dataset {
+public:
+    static Dataset load(const std::string& path, const DatasetOptions& options = DatasetOptions());
+    // CSV text already in memory
+    static Dataset parse_csv(const char* begin, const char* end, const DatasetOptions& options = DatasetOptions());
+
+    Dataset(Dataset&&) = default;
+    Dataset& operator=(Dataset&&) = default;
+
+    size_t rows() const { return rows_; }
+    size_t cols() const { return cols_; }
+    const std::string& format() const { return format_; }
+    // CSV header names; "0", "1", ... when the input has none
+    const std::vector<std::string>& column_names() const { return names_; }
+
+    ColumnView column(size_t j) const;
+    // Stored in the cache sidecar; computed on demand otherwise
+    ColumnStats column_stats(size_t j) const;
+    // What load() did with options.cache_path: "" (no cache), "hit", "rehashed"
+    // (mtime changed, content did not), "written", or "failed: <reason>"
+    const std::string& cache_status() const { return cache_status_; }
+    // Column by name, or by 0-based index when no column has that name
+    size_t column_index(const std::string& spec) const;
+    // Comma separated names/indices, e.g. "x1,x2,5"
+    std::vector<size_t> select_columns(const std::string& specs) const;
+
+private:
+    Dataset() : rows_(0), cols_(0), offset_(0), row_stride_(0), column_stride_(0), type_(ColumnType::Float64) {}
+    const char* base() const;
+
+    // Sidecar handling for CSV sources; see dataset.cpp for the file layout
+    static bool open_cache(const std::string& source, const MappedFile& text, const DatasetOptions& options,
+                           Dataset& dataset);
+    void write_cache(const std::string& source, const MappedFile& text, const DatasetOptions& options);
+
+    std::string format_;
+    size_t rows_;
+    size_t cols_;
+    std::vector<std::string> names_;
+    std::shared_ptr<MappedFile> file_; // npy/raw: columns point into the mapping
+    std::vector<double> values_;       // csv: parsed values, column-major
+    size_t offset_;                    // Bytes from the start of the storage to element (0, 0)
+    size_t row_stride_;                // Bytes between rows and between columns
+    size_t column_stride_;
+    ColumnType type_;
+    std::vector<ColumnStats> stats_; // From the sidecar, when mapped from one
+    std::string cache_status_;
+};
+
+#endif // DATASET_H
@@ -0,0 +1,103 @@
+#include "distillation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+// Mean over samples and outputs of the squared difference
+double meanSquaredError(NeuralNetwork& network, const SampleVector* inputs, const double* targets, size_t count,
+                        size_t outputs) {
+    double sum = 0.0;
+    SampleVector prediction;
+    for (size_t i = 0; i < count; ++i) {
+        network.predict_into(inputs[i].data(), inputs[i].size(), prediction);
+        for (size_t k = 0; k < outputs; ++k) {
+            const double error = prediction[k] - targets[i * outputs + k];
+            sum += error * error;
+        }
+    }
+    return sum / static_cast<double>(count * outputs);
+}
+
+// Nanoseconds per predict_into, repeating the pass over `inputs` for at least ~20 ms
+double predictNanoseconds(NeuralNetwork& network, const SampleVector* inputs, size_t count) {
+    SampleVector prediction;
+    double checksum = 0.0;
+    size_t calls = 0;
+    const auto start = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed(0.0);
+    while (calls == 0 || elapsed.count() < 0.02) {
+        for (size_t i = 0; i < count; ++i) {
+            network.predict_into(inputs[i].data(), inputs[i].size(), prediction);
+            checksum += prediction[0];
+        }
+        calls += count;
+        elapsed = std::chrono::steady_clock::now() - start;
+    }
+    volatile double sink = checksum; // Keeps the predictions observable
+    (void)sink;
+    return elapsed.count() * 1e9 / static_cast<double>(calls);
+}
+
+} // namespace
+
+DistillationResult distill(NeuralNetwork& teacher, NeuralNetwork& student, const double* X, const double* Y,
+                           size_t rows, const DistillationOptions& options) {
+    const auto start = std::chrono::steady_clock::now();
+    const size_t features = teacher.layer_sizes().front();
+    const size_t outputs = teacher.layer_sizes().back();
+    if (student.layer_sizes().front() != features || student.layer_sizes().back() != outputs) {
+        throw std::invalid_argument("Student and teacher must have the same input and output layer sizes.");
+    }
+    if (rows == 0) {
+        throw std::invalid_argument("Distillation needs at least one data row.");
+    }
+
+    std::vector<double> low(X, X + features);
+    std::vector<double> high(X, X + features);
+    std::vector<SampleVector> data_inputs(rows);
+    for (size_t i = 0; i < rows; ++i) {
+        data_inputs[i].assign(X + i * features, features);
+        for (size_t j = 0; j < features; ++j) {
+            low[j] = std::min(low[j], X[i * features + j]);
+            high[j] = std::max(high[j], X[i * features + j]);
+        }
+    }
+
+    // Teacher-labelled synthetic inputs covering the data's range
+    DistillationResult result;
+    result.samples = options.samples != 0 ? options.samples : std::max<size_t>(1000, 20 * rows);
+    std::vector<SampleVector> inputs(result.samples);
+    std::vector<SampleVector> targets(result.samples);
+    std::vector<double> teacher_outputs(result.samples * outputs);
+    std::mt19937 gen(options.seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    for (size_t s = 0; s < result.samples; ++s) {
+        inputs[s].resize(features);
+        for (size_t j = 0; j < features; ++j) {
+            const double t = features == 1 ? (result.samples == 1 ? 0.5 : static_cast<double>(s) / (result.samples - 1))
+                                           : unit(gen);
+            inputs[s][j] = low[j] + t * (high[j] - low[j]);
+        }
+        teacher.predict_into(inputs[s].data(), features, targets[s]);
+        std::copy(targets[s].data(), targets[s].data() + outputs, &teacher_outputs[s * outputs]);
+    }
+
+    student.train_for_epochs(inputs, targets, options.epochs, options.report_every_n_epochs);
+
+    result.teacher_mse_vs_truth = meanSquaredError(teacher, data_inputs.data(), Y, rows, outputs);
+    result.student_mse_vs_truth = meanSquaredError(student, data_inputs.data(), Y, rows, outputs);
+    result.student_mse_vs_teacher = meanSquaredError(student, inputs.data(), teacher_outputs.data(), result.samples,
+                                                     outputs);
+    result.teacher_parameters = teacher.parameter_count();
+    result.student_parameters = student.parameter_count();
+    result.teacher_predict_ns = predictNanoseconds(teacher, data_inputs.data(), rows);
+    result.student_predict_ns = predictNanoseconds(student, data_inputs.data(), rows);
+    result.speedup = result.teacher_predict_ns / result.student_predict_ns;
+    result.elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
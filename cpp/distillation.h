@@ -0,0 +1,39 @@
+#ifndef DISTILLATION_H
+#define DISTILLATION_H
+
+#include <cstddef>
+
+#include "neural_network.h"
+
+struct DistillationOptions {
+    // Synthetic inputs the student is trained on; 0 picks 20 per data row, at least 1000
+    size_t samples = 0;
+    int epochs = 100;
+    int report_every_n_epochs = 10;
+    unsigned seed = 42; // Several inputs: the uniform samples are drawn from this seed
+};
+
+struct DistillationResult {
+    size_t samples = 0;
+    double teacher_mse_vs_truth = 0.0;  // On the data rows
+    double student_mse_vs_truth = 0.0;  // On the data rows
+    double student_mse_vs_teacher = 0.0; // On the synthetic inputs
+    size_t teacher_parameters = 0;
+    size_t student_parameters = 0;
+    double teacher_predict_ns = 0.0; // Per sample, over the data rows
+    double student_predict_ns = 0.0;
+    double speedup = 0.0; // teacher_predict_ns / student_predict_ns
+    double elapsed_seconds = 0.0;
+};
+
+// Knowledge distillation: trains `student` (usually much smaller) to match a
+// trained `teacher` on dense synthetic inputs labelled by the teacher, so no
+// ground truth is needed beyond the data rows used for scoring. One input: an
+// even grid over the data's x range. Several inputs: uniform samples in the
+// data's bounding box. X and Y are sample-major rows of the networks' input
+// and output widths. Throws std::invalid_argument on mismatched networks or
+// empty data.
+DistillationResult distill(NeuralNetwork& teacher, NeuralNetwork& student, const double* X, const double* Y,
+                           size_t rows, const DistillationOptions& options = DistillationOptions());
+
+#endif // DISTILLATION_H
@@ -0,0 +1,149 @@
+#ifndef INLINE_VECTOR_H
+#define INLINE_VECTOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <vector>
+
+// Vector of doubles that stores up to N elements inside the object itself and
+// only touches the heap when it grows beyond that. Used for per-sample data
+// (single inputs, small layer activations) where a std::vector would cost one
+// malloc/free pair per sample. Once spilled to the heap, the buffer is kept
+// and reused by later resize() calls, like std::vector's capacity.
+template <size_t N>
+class InlineVector {
+public:
+    static const size_t kInlineCapacity = N;
+
+    InlineVector() : data_(inline_), size_(0), capacity_(N) {}
+
+    explicit InlineVector(size_t count, double value = 0.0) : InlineVector() {
+        resize(count, value);
+    }
+
+    InlineVector(std::initializer_list<double> values) : InlineVector() {
+        assign(values.begin(), values.size());
+    }
+
+    InlineVector(const double* values, size_t count) : InlineVector() {
+        assign(values, count);
+    }
+
+    explicit InlineVector(const std::vector<double>& values) : InlineVector() {
+        assign(values.data(), values.size());
+    }
+
+    InlineVector(const InlineVector& other) : InlineVector() {
+        assign(other.data_, other.size_);
+    }
+
+    InlineVector(InlineVector&& other) noexcept : InlineVector() {
+        steal(other);
+    }
+
+    InlineVector& operator=(const InlineVector& other) {
+        if (this != &other) {
+            assign(other.data_, other.size_);
+        }
+        return *this;
+    }
+
+    InlineVector& operator=(InlineVector&& other) noexcept {
+        if (this != &other) {
+            release();
+            steal(other);
+        }
+        return *this;
+    }
+
+    ~InlineVector() { release(); }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_t capacity() const { return capacity_; }
+    // True while the elements live in the object (no heap storage owned)
+    bool is_inline() const { return data_ == inline_; }
+
+    double* data() { return data_; }
+    const double* data() const { return data_; }
+    double& operator[](size_t i) { return data_[i]; }
+    double operator[](size_t i) const { return data_[i]; }
+    double* begin() { return data_; }
+    double* end() { return data_ + size_; }
+    const double* begin() const { return data_; }
+    const double* end() const { return data_ + size_; }
+    double front() const { return data_[0]; }
+    double back() const { return data_[size_ - 1]; }
+
+    void reserve(size_t count) {
+        if (count <= capacity_) {
+            return;
+        }
+        double* grown = new double[count];
+        std::copy(data_, data_ + size_, grown);
+        const size_t size = size_;
+        release();
+        data_ = grown;
+        size_ = size;
+        capacity_ = count;
+    }
+
+    // New elements are set to `value`; shrinking keeps the capacity
+    void resize(size_t count, double value = 0.0) {
+        reserve(count);
+        if (count > size_) {
+            std::fill(data_ + size_, data_ + count, value);
+        }
+        size_ = count;
+    }
+
+    void assign(const double* values, size_t count) {
+        reserve(count);
+        std::copy(values, values + count, data_);
+        size_ = count;
+    }
+
+    void push_back(double value) {
+        if (size_ == capacity_) {
+            reserve(capacity_ * 2);
+        }
+        data_[size_++] = value;
+    }
+
+    void clear() { size_ = 0; }
+
+    std::vector<double> to_vector() const { return std::vector<double>(data_, data_ + size_); }
+
+private:
+    void release() {
+        if (data_ != inline_) {
+            delete[] data_;
+        }
+        data_ = inline_;
+        capacity_ = N;
+        size_ = 0;
+    }
+
+    // Takes other's heap buffer, or copies its inline elements; leaves other empty
+    void steal(InlineVector& other) {
+        if (other.data_ != other.inline_) {
+            data_ = other.data_;
+            capacity_ = other.capacity_;
+            size_ = other.size_;
+            other.data_ = other.inline_;
+            other.capacity_ = N;
+        } else {
+            std::copy(other.data_, other.data_ + other.size_, inline_);
+            size_ = other.size_;
+        }
+        other.size_ = 0;
+    }
+
+    double* data_;
+    size_t size_;
+    size_t capacity_;
+    double inline_[N];
+};
+
+#endif // INLINE_VECTOR_H
@@ -0,0 +1,178 @@
+#include "iterative_solver.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
+#include "blas_backend.h"
+
+namespace {
+
+const size_t kBlockRows = 1024;
+
+double dotProduct(const std::vector<double>& a, const std::vector<double>& b) {
+    double sum = 0.0;
+    const long n = static_cast<long>(a.size());
+    #pragma omp parallel for reduction(+:sum) schedule(static)
+    for (long i = 0; i < n; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+// Products with the augmented design A = [1 | X]; index 0 is the intercept
+void multiplyAugmented(const DesignOperator& X, const std::vector<double>& v, std::vector<double>& out) {
+    X.multiply(v.data() + 1, out.data());
+    const long n = static_cast<long>(out.size());
+    #pragma omp parallel for schedule(static)
+    for (long i = 0; i < n; ++i) {
+        out[i] += v[0];
+    }
+}
+
+void multiplyAugmentedTransposed(const DesignOperator& X, const std::vector<double>& u, std::vector<double>& out) {
+    X.multiply_transposed(u.data(), out.data() + 1);
+    double sum = 0.0;
+    const long n = static_cast<long>(u.size());
+    #pragma omp parallel for reduction(+:sum) schedule(static)
+    for (long i = 0; i < n; ++i) {
+        sum += u[i];
+    }
+    out[0] = sum;
+}
+
+} // namespace
+
+DenseDesign::DenseDesign(const double* data, size_t rows, size_t cols) : data_(data), rows_(rows), cols_(cols) {}
+
+void DenseDesign::multiply(const double* v, double* out) const {
+    const BlasBackend& blas = activeBlasBackend();
+    const long blocks = static_cast<long>((rows_ + kBlockRows - 1) / kBlockRows);
+    #pragma omp parallel for schedule(static)
+    for (long block = 0; block < blocks; ++block) {
+        const size_t begin = static_cast<size_t>(block) * kBlockRows;
+        const size_t count = std::min(kBlockRows, rows_ - begin);
+        blas.gemv(false, count, cols_, 1.0, data_ + begin * cols_, cols_, v, 0.0, out + begin);
+    }
+}
+
+void DenseDesign::multiply_transposed(const double* u, double* out) const {
+    const BlasBackend& blas = activeBlasBackend();
+    const long blocks = static_cast<long>((rows_ + kBlockRows - 1) / kBlockRows);
+    std::fill(out, out + cols_, 0.0);
+    #pragma omp parallel
+    {
+        // Each thread sums its blocks' contributions, then the partials are added up
+        std::vector<double> partial(cols_, 0.0);
+        #pragma omp for schedule(static)
+        for (long block = 0; block < blocks; ++block) {
+            const size_t begin = static_cast<size_t>(block) * kBlockRows;
+            const size_t count = std::min(kBlockRows, rows_ - begin);
+            blas.gemv(true, count, cols_, 1.0, data_ + begin * cols_, cols_, u + begin, 1.0, partial.data());
+        }
+        #pragma omp critical
+        blas.axpy(cols_, 1.0, partial.data(), out);
+    }
+}
+
+void DenseDesign::column_squared_norms(double* out) const {
+    std::fill(out, out + cols_, 0.0);
+    for (size_t i = 0; i < rows_; ++i) {
+        const double* row = data_ + i * cols_;
+        for (size_t j = 0; j < cols_; ++j) {
+            out[j] += row[j] * row[j];
+        }
+    }
+}
+
+IterativeSolveResult solveLeastSquaresCg(const DesignOperator& X, const std::vector<double>& y,
+                                         const IterativeSolveOptions& options) {
+    const auto start = std::chrono::steady_clock::now();
+    if (X.rows() == 0 || y.size() != X.rows()) {
+        throw std::invalid_argument("y must have one value per row of a non-empty design matrix");
+    }
+    if (!options.initial_weights.empty() && options.initial_weights.size() != X.cols()) {
+        throw std::invalid_argument("Warm-start weights must have one value per column of X");
+    }
+    if (options.max_iterations < 0 || !(options.tolerance >= 0.0)) {
+        throw std::invalid_argument("max_iterations and tolerance must be non-negative");
+    }
+
+    const size_t n = X.rows();
+    const size_t c = X.cols() + 1;
+
+    // Jacobi preconditioner: scale every column of A to unit norm
+    std::vector<double> inverse_scale(c);
+    X.column_squared_norms(inverse_scale.data() + 1);
+    inverse_scale[0] = static_cast<double>(n);
+    for (double& value : inverse_scale) {
+        value = value > 0.0 ? 1.0 / std::sqrt(value) : 1.0;
+    }
+
+    std::vector<double> x(c, 0.0);
+    x[0] = options.initial_intercept;
+    std::copy(options.initial_weights.begin(), options.initial_weights.end(), x.begin() + 1);
+
+    std::vector<double> s(c);
+    multiplyAugmentedTransposed(X, y, s);
+    for (size_t j = 0; j < c; ++j) {
+        s[j] *= inverse_scale[j];
+    }
+    const double reference_norm = std::sqrt(dotProduct(s, s));
+    const double threshold = options.tolerance * reference_norm;
+
+    // r = y - A x; skipped products when there is no warm start
+    std::vector<double> r(y);
+    std::vector<double> q(n);
+    if (std::any_of(x.begin(), x.end(), [](double value) { return value != 0.0; })) {
+        multiplyAugmented(X, x, q);
+        for (size_t i = 0; i < n; ++i) {
+            r[i] -= q[i];
+        }
+        multiplyAugmentedTransposed(X, r, s);
+        for (size_t j = 0; j < c; ++j) {
+            s[j] *= inverse_scale[j];
+        }
+    }
+
+    std::vector<double> p(s);
+    std::vector<double> t(c);
+    double gamma = dotProduct(s, s);
+    IterativeSolveResult result;
+    while (result.iterations < options.max_iterations && std::sqrt(gamma) > threshold && gamma > 0.0) {
+        for (size_t j = 0; j < c; ++j) {
+            t[j] = inverse_scale[j] * p[j];
+        }
+        multiplyAugmented(X, t, q);
+        const double qq = dotProduct(q, q);
+        if (qq <= 0.0) {
+            break;
+        }
+        const double alpha = gamma / qq;
+        for (size_t j = 0; j < c; ++j) {
+            x[j] += alpha * t[j];
+        }
+        for (size_t i = 0; i < n; ++i) {
+            r[i] -= alpha * q[i];
+        }
+        multiplyAugmentedTransposed(X, r, s);
+        for (size_t j = 0; j < c; ++j) {
+            s[j] *= inverse_scale[j];
+        }
+        const double next_gamma = dotProduct(s, s);
+        const double beta = next_gamma / gamma;
+        for (size_t j = 0; j < c; ++j) {
+            p[j] = s[j] + beta * p[j];
+        }
+        gamma = next_gamma;
+        ++result.iterations;
+    }
+
+    result.intercept = x[0];
+    result.weights.assign(x.begin() + 1, x.end());
+    result.converged = std::sqrt(gamma) <= threshold;
+    result.relative_residual = reference_norm > 0.0 ? std::sqrt(gamma) / reference_norm : std::sqrt(gamma);
+    result.elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
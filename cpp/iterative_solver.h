@@ -0,0 +1,68 @@
+#ifndef ITERATIVE_SOLVER_H
+#define ITERATIVE_SOLVER_H
+
+#include <cstddef>
+#include <vector>
+
+// Matrix-free view of a regression design matrix: the iterative solver only
+// ever needs products with it and with its transpose, so implementations can
+// keep the data blocked, sparse or streamed instead of forming X^T X.
+class DesignOperator {
+public:
+    virtual ~DesignOperator() {}
+
+    virtual size_t rows() const = 0;
+    virtual size_t cols() const = 0;
+
+    // out = X v, with v of length cols() and out of length rows()
+    virtual void multiply(const double* v, double* out) const = 0;
+    // out = X^T u, with u of length rows() and out of length cols()
+    virtual void multiply_transposed(const double* u, double* out) const = 0;
+    // out[j] = ||column j||^2 (used as the Jacobi preconditioner)
+    virtual void column_squared_norms(double* out) const = 0;
+};
+
+// Row-major dense matrix, referenced (not copied). Products run over blocks
+// of rows in parallel, each block as one gemv on the active BlasBackend.
+class DenseDesign : public DesignOperator {
+public:
+    DenseDesign(const double* data, size_t rows, size_t cols);
+
+    size_t rows() const override { return rows_; }
+    size_t cols() const override { return cols_; }
+    void multiply(const double* v, double* out) const override;
+    void multiply_transposed(const double* u, double* out) const override;
+    void column_squared_norms(double* out) const override;
+
+private:
+    const double* data_;
+    size_t rows_;
+    size_t cols_;
+};
+
+struct IterativeSolveOptions {
+    int max_iterations = 1000;
+    // Stop once ||P^-1 A^T r|| <= tolerance * ||P^-1 A^T y|| (A = [1 | X], P = Jacobi)
+    double tolerance = 1e-10;
+    // Warm start; empty means start from zero weights
+    std::vector<double> initial_weights;
+    double initial_intercept = 0.0;
+};
+
+struct IterativeSolveResult {
+    std::vector<double> weights; // One per column of X
+    double intercept = 0.0;
+    int iterations = 0;
+    bool converged = false;
+    double relative_residual = 0.0; // Final normal-equation residual, relative as in the tolerance
+    double elapsed_seconds = 0.0;
+};
+
+// Least squares min ||y - X w - b||^2 by Jacobi-preconditioned CGLS (conjugate
+// gradients on the normal equations, never forming them). Each iteration costs
+// one X v and one X^T u product and O(rows + cols) extra memory. Throws
+// std::invalid_argument on size mismatches.
+IterativeSolveResult solveLeastSquaresCg(const DesignOperator& X, const std::vector<double>& y,
+                                         const IterativeSolveOptions& options = IterativeSolveOptions());
+
+#endif // ITERATIVE_SOLVER_H
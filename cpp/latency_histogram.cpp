@@ -0,0 +1,208 @@
+#include "latency_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <unordered_map>
+
+#include "metrics.h"
+
+namespace {
+
+std::atomic<uint64_t> g_next_histogram_id(1);
+
+int highestBit(uint64_t value) {
+    int bit = 63;
+    while (bit > 0 && !(value & (uint64_t(1) << bit))) {
+        --bit;
+    }
+    return bit;
+}
+
+std::string quantileLabel(double q) {
+    std::ostringstream out;
+    out << q;
+    return out.str();
+}
+
+const double kReportedQuantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+} // namespace
+
+// --- HistogramSnapshot ---
+
+HistogramSnapshot::HistogramSnapshot()
+    : buckets_(LatencyHistogram::kBucketCount, 0), count_(0),
+      min_(std::numeric_limits<uint64_t>::max()), max_(0), sum_(0.0) {}
+
+uint64_t HistogramSnapshot::percentile(double q) const {
+    if (count_ == 0) {
+        return 0;
+    }
+    q = std::min(1.0, std::max(0.0, q));
+    // Rank of the requested sample (1-based), at least the first sample
+    uint64_t rank = static_cast<uint64_t>(std::ceil(q * static_cast<double>(count_)));
+    rank = std::max<uint64_t>(rank, 1);
+    uint64_t seen = 0;
+    for (int i = 0; i < LatencyHistogram::kBucketCount; ++i) {
+        seen += buckets_[i];
+        if (seen >= rank) {
+            return std::min(LatencyHistogram::bucket_upper_bound(i), max_);
+        }
+    }
+    return max_;
+}
+
+void HistogramSnapshot::merge(const HistogramSnapshot& other) {
+    for (int i = 0; i < LatencyHistogram::kBucketCount; ++i) {
+        buckets_[i] += other.buckets_[i];
+    }
+    count_ += other.count_;
+    sum_ += other.sum_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+}
+
+// --- LatencyHistogram ---
+
+LatencyHistogram::Shard::Shard()
+    : buckets(new std::atomic<uint64_t>[kBucketCount]), count(0),
+      min(std::numeric_limits<uint64_t>::max()), max(0), sum(0.0) {
+    for (int i = 0; i < kBucketCount; ++i) {
+        buckets[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+LatencyHistogram::LatencyHistogram() : id_(g_next_histogram_id.fetch_add(1)) {}
+
+LatencyHistogram::~LatencyHistogram() {}
+
+int LatencyHistogram::bucket_index(uint64_t value) {
+    if (value < static_cast<uint64_t>(kSubBucketCount)) {
+        return static_cast<int>(value);
+    }
+    const int exponent = highestBit(value);
+    if (exponent >= kMaxExponent) {
+        return kBucketCount - 1;
+    }
+    const int shift = exponent - kSubBucketBits;
+    const int mantissa = static_cast<int>((value >> shift) & (kSubBucketCount - 1));
+    return kSubBucketCount + shift * kSubBucketCount + mantissa;
+}
+
+uint64_t LatencyHistogram::bucket_upper_bound(int index) {
+    if (index < kSubBucketCount) {
+        return static_cast<uint64_t>(index);
+    }
+    const int shift = (index - kSubBucketCount) / kSubBucketCount;
+    const uint64_t mantissa = static_cast<uint64_t>((index - kSubBucketCount) % kSubBucketCount);
+    return ((kSubBucketCount + mantissa + 1) << shift) - 1;
+}
+
+LatencyHistogram::Shard& LatencyHistogram::local_shard() {
+    // Ids are never reused, so entries left behind by destroyed histograms
+    // are simply never looked up again.
+    thread_local std::unordered_map<uint64_t, Shard*> cache;
+    auto it = cache.find(id_);
+    if (it != cache.end()) {
+        return *it->second;
+    }
+    std::lock_guard<std::mutex> lock(shards_mutex_);
+    shards_.push_back(std::unique_ptr<Shard>(new Shard()));
+    Shard* shard = shards_.back().get();
+    cache[id_] = shard;
+    return *shard;
+}
+
+void LatencyHistogram::record(uint64_t nanoseconds) {
+    Shard& shard = local_shard();
+    // Single writer per shard: plain load/store pairs are enough, readers only
+    // need each word to be untorn.
+    std::atomic<uint64_t>& bucket = shard.buckets[bucket_index(nanoseconds)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    shard.count.store(shard.count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    shard.sum.store(shard.sum.load(std::memory_order_relaxed) + static_cast<double>(nanoseconds),
+                    std::memory_order_relaxed);
+    if (nanoseconds < shard.min.load(std::memory_order_relaxed)) {
+        shard.min.store(nanoseconds, std::memory_order_relaxed);
+    }
+    if (nanoseconds > shard.max.load(std::memory_order_relaxed)) {
+        shard.max.store(nanoseconds, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::record(std::chrono::steady_clock::duration elapsed) {
+    const long long nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    record(static_cast<uint64_t>(std::max(0LL, nanos)));
+}
+
+HistogramSnapshot LatencyHistogram::snapshot() const {
+    HistogramSnapshot merged;
+    std::lock_guard<std::mutex> lock(shards_mutex_);
+    for (const auto& shard : shards_) {
+        for (int i = 0; i < kBucketCount; ++i) {
+            merged.buckets_[i] += shard->buckets[i].load(std::memory_order_relaxed);
+        }
+        merged.count_ += shard->count.load(std::memory_order_relaxed);
+        merged.sum_ += shard->sum.load(std::memory_order_relaxed);
+        merged.min_ = std::min(merged.min_, shard->min.load(std::memory_order_relaxed));
+        merged.max_ = std::max(merged.max_, shard->max.load(std::memory_order_relaxed));
+    }
+    return merged;
+}
+
+// --- RequestLatencies ---
+
+RequestLatencies& RequestLatencies::instance() {
+    static RequestLatencies latencies;
+    return latencies;
+}
+
+LatencyHistogram& RequestLatencies::histogram(const std::string& operation, const std::string& stage) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& slot = histograms_[std::make_pair(operation, stage)];
+    if (!slot) {
+        slot.reset(new LatencyHistogram());
+    }
+    return *slot;
+}
+
+std::map<std::pair<std::string, std::string>, HistogramSnapshot> RequestLatencies::snapshots() const {
+    std::map<std::pair<std::string, std::string>, HistogramSnapshot> result;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& entry : histograms_) {
+        result[entry.first] = entry.second->snapshot();
+    }
+    return result;
+}
+
+void RequestLatencies::write_metrics(std::ostream& out) const {
+    const auto all = snapshots();
+    if (all.empty()) {
+        return;
+    }
+    const std::string name = "mlapp_request_latency_seconds";
+    writeMetricHeader(out, name, "summary", "Request latency by operation and stage.");
+    for (const auto& entry : all) {
+        const std::string labels = "operation=\"" + entry.first.first + "\",stage=\"" + entry.first.second + "\"";
+        const HistogramSnapshot& snapshot = entry.second;
+        for (double q : kReportedQuantiles) {
+            writeMetricSample(out, name, snapshot.percentile(q) * 1e-9, labels + ",quantile=\"" + quantileLabel(q) + "\"");
+        }
+        writeMetricSample(out, name + "_sum", snapshot.sum() * 1e-9, labels);
+        writeMetricSample(out, name + "_count", static_cast<double>(snapshot.count()), labels);
+    }
+}
+
+void printLatencySummary(std::ostream& out, const std::string& label, const HistogramSnapshot& snapshot) {
+    out << label
+        << " count=" << snapshot.count()
+        << " mean_us=" << snapshot.mean() / 1000.0
+        << " p50_us=" << snapshot.percentile(0.5) / 1000.0
+        << " p90_us=" << snapshot.percentile(0.9) / 1000.0
+        << " p99_us=" << snapshot.percentile(0.99) / 1000.0
+        << " p999_us=" << snapshot.percentile(0.999) / 1000.0
+        << " max_us=" << snapshot.max() / 1000.0
+        << std::endl;
+}
@@ -0,0 +1,128 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Merged, immutable view of a LatencyHistogram. Values are nanoseconds.
+class HistogramSnapshot {
+public:
+    HistogramSnapshot();
+
+    uint64_t count() const { return count_; }
+    uint64_t min() const { return count_ ? min_ : 0; }
+    uint64_t max() const { return max_; }
+    double sum() const { return sum_; }
+    double mean() const { return count_ ? sum_ / count_ : 0.0; }
+
+    // Value at quantile q in [0, 1] (upper edge of the containing bucket,
+    // clamped to the observed max). Returns 0 for an empty snapshot.
+    uint64_t percentile(double q) const;
+
+    // Adds another snapshot's counts into this one
+    void merge(const HistogramSnapshot& other);
+
+private:
+    friend class LatencyHistogram;
+
+    std::vector<uint64_t> buckets_;
+    uint64_t count_;
+    uint64_t min_;
+    uint64_t max_;
+    double sum_;
+};
+
+// HDR-style log-linear histogram of latencies in nanoseconds.
+//
+// Each power-of-two range is split into 64 linear sub-buckets, bounding the
+// relative error at ~1.6% from 1ns up to ~73 minutes. Recording is lock-free:
+// every thread writes into its own shard (single writer, relaxed atomics), and
+// shards are only summed when a snapshot is requested.
+class LatencyHistogram {
+public:
+    static const int kSubBucketBits = 6;
+    static const int kSubBucketCount = 1 << kSubBucketBits;
+    static const int kMaxExponent = 42; // Values >= 2^42 ns are clamped into the last bucket
+    static const int kBucketCount = kSubBucketCount + (kMaxExponent - kSubBucketBits) * kSubBucketCount;
+
+    LatencyHistogram();
+    ~LatencyHistogram();
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void record(uint64_t nanoseconds);
+    void record(std::chrono::steady_clock::duration elapsed);
+
+    // Merge all per-thread shards
+    HistogramSnapshot snapshot() const;
+
+    // Bucket mapping, exposed for tests and for percentile reconstruction
+    static int bucket_index(uint64_t value);
+    static uint64_t bucket_upper_bound(int index);
+
+private:
+    struct Shard {
+        Shard();
+        std::unique_ptr<std::atomic<uint64_t>[]> buckets;
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> min;
+        std::atomic<uint64_t> max;
+        std::atomic<double> sum;
+    };
+
+    Shard& local_shard();
+
+    const uint64_t id_; // Unique per instance; keys the thread-local shard cache
+    mutable std::mutex shards_mutex_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+// Records the lifetime of the object into a histogram.
+class ScopedLatency {
+public:
+    explicit ScopedLatency(LatencyHistogram& histogram)
+        : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+    ~ScopedLatency() { histogram_.record(std::chrono::steady_clock::now() - start_); }
+
+    ScopedLatency(const ScopedLatency&) = delete;
+    ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+private:
+    LatencyHistogram& histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+// Histograms keyed by (operation, stage), e.g. ("lr_predict", "compute").
+// Stages used by the engine: queue_wait, parse, compute, serialize, total.
+class RequestLatencies {
+public:
+    // Process-wide set used by the CLI and the metrics exporter
+    static RequestLatencies& instance();
+
+    // Get or create; the returned reference stays valid for the set's lifetime
+    LatencyHistogram& histogram(const std::string& operation, const std::string& stage);
+
+    // Merged snapshots of every histogram, ordered by (operation, stage)
+    std::map<std::pair<std::string, std::string>, HistogramSnapshot> snapshots() const;
+
+    // Prometheus summary family with p50/p90/p99/p999, _sum and _count (seconds)
+    void write_metrics(std::ostream& out) const;
+
+private:
+    mutable std::mutex mutex_;
+    std::map<std::pair<std::string, std::string>, std::unique_ptr<LatencyHistogram>> histograms_;
+};
+
+// One line per histogram: "<label> count=.. mean_us=.. p50_us=.. p90_us=.. p99_us=.. p999_us=.. max_us=.."
+void printLatencySummary(std::ostream& out, const std::string& label, const HistogramSnapshot& snapshot);
+
+#endif // LATENCY_HISTOGRAM_H
@@ -1,4 +1,5 @@
 #include "linear_regression.h"
+#include "blas_backend.h"
 #include <iostream>
 #include <ostream>
 #include <algorithm>
@@ -97,12 +98,221 @@ void LinearRegression::fit(const std::vector<double>& X, const std::vector<doubl
     }
 }
 
+LrRangeTestResult LinearRegression::lr_find(const std::vector<double>& X, const std::vector<double>& y,
+                                            const LrRangeTestOptions& options) const {
+    if (X.size() != y.size()) {
+        throw std::invalid_argument("X and y must have the same length");
+    }
+    if (X.empty()) {
+        throw std::invalid_argument("Input vectors cannot be empty");
+    }
+    if (batch_size <= 0) {
+        throw std::invalid_argument("Batch size must be positive");
+    }
+    const std::vector<size_t> subsample = rangeTestSubsample(X.size(), options);
+    double probe_slope = slope;
+    double probe_intercept = intercept;
+    size_t next = 0;
+    // Same averaged mini-batch step as fit(); the loss is taken before the step
+    return runLrRangeTest([&](double lr) {
+        double loss = 0.0;
+        double slope_gradient = 0.0;
+        double intercept_gradient = 0.0;
+        for (int b = 0; b < batch_size; ++b) {
+            const size_t idx = subsample[next];
+            next = (next + 1) % subsample.size();
+            const double error = probe_slope * X[idx] + probe_intercept - y[idx];
+            loss += error * error;
+            slope_gradient += error * X[idx];
+            intercept_gradient += error;
+        }
+        const double batch_scale = 1.0 / batch_size;
+        probe_slope -= lr * slope_gradient * batch_scale;
+        probe_intercept -= lr * intercept_gradient * batch_scale;
+        return loss * batch_scale;
+    }, options);
+}
+
+void LinearRegression::set_learning_rate(double lr) {
+    learning_rate = lr;
+}
+
+double LinearRegression::get_learning_rate() const {
+    return learning_rate;
+}
+
 // --- Rest of the methods (predict, get_slope, get_intercept, mean, mean_squared_error) remain the same ---
 
 double LinearRegression::predict(double x) const {
     return slope * x + intercept;
 }
 
+void LinearRegression::fit(const CsrMatrix& X, const std::vector<double>& y) {
+    if (X.rows() != y.size()) {
+        throw std::invalid_argument("X and y must have the same length");
+    }
+    if (X.rows() == 0) {
+        throw std::invalid_argument("Input vectors cannot be empty");
+    }
+    if (batch_size <= 0) {
+        throw std::invalid_argument("Batch size must be positive");
+    }
+
+    const size_t n_samples = X.rows();
+    weights.assign(X.cols(), 0.0);
+    intercept = 0.0;
+    std::vector<size_t> indices(n_samples);
+    std::iota(indices.begin(), indices.end(), 0);
+
+    // Early stopping parameters (as in the dense fit)
+    const double tolerance = 1e-6;
+    const int patience = 5;
+    double best_mse = std::numeric_limits<double>::infinity();
+    int no_improvement_count = 0;
+
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    std::vector<double> batch_errors(batch_size);
+
+    for (int iter = 0; iter < max_iterations; ++iter) {
+        std::shuffle(indices.begin(), indices.end(), gen);
+
+        for (size_t batch_start = 0; batch_start < n_samples; batch_start += batch_size) {
+            const size_t current_batch_size = std::min(static_cast<size_t>(batch_size), n_samples - batch_start);
+
+            // Errors against the weights at the start of the batch, then one
+            // averaged step applied only to the columns the batch touches
+            double intercept_gradient = 0.0;
+            #pragma omp parallel for reduction(+:intercept_gradient) schedule(static)
+            for (size_t i = 0; i < current_batch_size; ++i) {
+                const SparseRow row = X.row(indices[batch_start + i]);
+                const double error = sparseDot(row, weights.data()) + intercept - y[indices[batch_start + i]];
+                batch_errors[i] = error;
+                intercept_gradient += error;
+            }
+
+            const double step = learning_rate / current_batch_size;
+            for (size_t i = 0; i < current_batch_size; ++i) {
+                sparseAxpy(-step * batch_errors[i], X.row(indices[batch_start + i]), weights.data());
+            }
+            intercept -= step * intercept_gradient;
+        }
+
+        double squared_error = 0.0;
+        #pragma omp parallel for reduction(+:squared_error) schedule(static)
+        for (size_t i = 0; i < n_samples; ++i) {
+            const double error = sparseDot(X.row(i), weights.data()) + intercept - y[i];
+            squared_error += error * error;
+        }
+        const double epoch_mse = squared_error / n_samples;
+
+        const double improvement = best_mse - epoch_mse;
+        const double relative_threshold = tolerance * std::max(1.0, best_mse);
+        if (!std::isfinite(best_mse) || improvement > relative_threshold) {
+            best_mse = epoch_mse;
+            no_improvement_count = 0;
+        } else {
+            no_improvement_count++;
+            if (no_improvement_count >= patience) {
+                break; // Early stopping
+            }
+        }
+    }
+}
+
+IterativeSolveResult LinearRegression::fit_iterative(const std::vector<double>& X, const std::vector<double>& y,
+                                                    int max_iterations, double tolerance) {
+    if (X.size() != y.size()) {
+        throw std::invalid_argument("X and y must have the same length");
+    }
+    if (X.empty()) {
+        throw std::invalid_argument("Input vectors cannot be empty");
+    }
+    IterativeSolveOptions options;
+    options.max_iterations = max_iterations;
+    options.tolerance = tolerance;
+    options.initial_weights.assign(1, slope);
+    options.initial_intercept = intercept;
+    const IterativeSolveResult result = solveLeastSquaresCg(DenseDesign(X.data(), X.size(), 1), y, options);
+    slope = result.weights[0];
+    intercept = result.intercept;
+    return result;
+}
+
+IterativeSolveResult LinearRegression::fit_iterative(const DesignOperator& X, const std::vector<double>& y,
+                                                    int max_iterations, double tolerance) {
+    if (X.rows() != y.size()) {
+        throw std::invalid_argument("X and y must have the same number of rows");
+    }
+    if (X.rows() == 0 || X.cols() == 0) {
+        throw std::invalid_argument("Input vectors cannot be empty");
+    }
+    IterativeSolveOptions options;
+    options.max_iterations = max_iterations;
+    options.tolerance = tolerance;
+    if (weights.size() == X.cols()) {
+        options.initial_weights = weights;
+        options.initial_intercept = intercept;
+    }
+    IterativeSolveResult result = solveLeastSquaresCg(X, y, options);
+    weights = result.weights;
+    intercept = result.intercept;
+    return result;
+}
+
+IterativeSolveResult LinearRegression::fit_iterative(const CsrMatrix& X, const std::vector<double>& y,
+                                                    int max_iterations, double tolerance) {
+    return fit_iterative(CsrDesign(X), y, max_iterations, tolerance);
+}
+
+// Below this many values an OpenMP team costs more than it saves
+static const size_t kParallelPredictThreshold = size_t(1) << 16;
+
+void LinearRegression::predict(const double* x, size_t n, double* out, bool allow_parallel) const {
+    const double m = slope;
+    const double b = intercept;
+    const long count = static_cast<long>(n);
+    // One multiply-add per element; compiled with FMA enabled (e.g. -march=native)
+    // the simd loop becomes packed fused multiply-adds.
+    #pragma omp parallel for simd schedule(static) if(allow_parallel && n >= kParallelPredictThreshold)
+    for (long i = 0; i < count; ++i) {
+        out[i] = m * x[i] + b;
+    }
+}
+
+std::vector<double> LinearRegression::predict(const std::vector<double>& X) const {
+    std::vector<double> predictions(X.size());
+    predict(X.data(), X.size(), predictions.data());
+    return predictions;
+}
+
+double LinearRegression::predict(const SparseRow& x) const {
+    if (weights.empty()) {
+        throw std::invalid_argument("No sparse model trained: fit on a CsrMatrix first");
+    }
+    return sparseDot(x, weights.data()) + intercept;
+}
+
+double LinearRegression::predict_row(const double* row, size_t features) const {
+    if (weights.size() != features) {
+        throw std::invalid_argument("Row width does not match the trained multi-feature model");
+    }
+    double sum = intercept;
+    for (size_t j = 0; j < features; ++j) {
+        sum += weights[j] * row[j];
+    }
+    return sum;
+}
+
+const std::vector<double>& LinearRegression::get_weights() const {
+    return weights;
+}
+
+void LinearRegression::set_parameters(double new_slope, double new_intercept) {
+    slope = new_slope;
+    intercept = new_intercept;
+}
+
 double LinearRegression::get_slope() const {
     return slope;
 }
@@ -205,3 +415,161 @@ void LinearRegression::fit_analytical(const std::vector<double>& X, const std::v
     // Calculate intercept (b) using the formula: b = mean_y - m * mean_x
     intercept = mean_y - slope * mean_x;
 }
+
+void MultiTargetFit::predict(const double* x, double* out) const {
+    for (size_t k = 0; k < targets; ++k) {
+        out[k] = intercepts[k];
+    }
+    for (size_t j = 0; j < features; ++j) {
+        const double* row = &weights[j * targets];
+        for (size_t k = 0; k < targets; ++k) {
+            out[k] += x[j] * row[k];
+        }
+    }
+}
+
+MultiTargetFit LinearRegression::fit_multi_target(const std::vector<double>& X, size_t features,
+                                                  const std::vector<double>& Y, size_t targets) {
+    if (features == 0 || targets == 0) {
+        throw std::invalid_argument("Multi-target regression needs at least one feature and one target");
+    }
+    if (X.empty() || X.size() % features != 0) {
+        throw std::invalid_argument("X must be a non-empty rows x features matrix");
+    }
+    const size_t rows = X.size() / features;
+    if (Y.size() != rows * targets) {
+        throw std::invalid_argument("Y must hold `targets` columns with one value per row of X");
+    }
+
+    // Augmented design [1 | x - x0] and responses y - y0, shifted by the first
+    // row so the one-pass normal equations do not cancel catastrophically when
+    // values sit far from zero. Shifts change only the intercepts.
+    const size_t a = features + 1;
+    std::vector<double> x_shift(X.begin(), X.begin() + features);
+    std::vector<double> y_shift(targets);
+    for (size_t k = 0; k < targets; ++k) {
+        y_shift[k] = Y[k * rows];
+    }
+
+    const size_t kBlockRows = 256;
+    const size_t blocks = (rows + kBlockRows - 1) / kBlockRows;
+    const BlasBackend& blas = activeBlasBackend();
+    std::vector<double> gram(a * a, 0.0);        // A^T A
+    std::vector<double> cross(a * targets, 0.0); // A^T Y
+    std::vector<double> yy(targets, 0.0);        // Per-target sum of squared (shifted) responses
+
+    #pragma omp parallel
+    {
+        std::vector<double> local_gram(a * a, 0.0);
+        std::vector<double> local_cross(a * targets, 0.0);
+        std::vector<double> local_yy(targets, 0.0);
+        std::vector<double> block_a(kBlockRows * a);
+        std::vector<double> block_y(kBlockRows * targets);
+
+        #pragma omp for schedule(static)
+        for (long block = 0; block < static_cast<long>(blocks); ++block) {
+            const size_t begin = static_cast<size_t>(block) * kBlockRows;
+            const size_t count = std::min(kBlockRows, rows - begin);
+            for (size_t r = 0; r < count; ++r) {
+                double* out = &block_a[r * a];
+                const double* in = &X[(begin + r) * features];
+                out[0] = 1.0;
+                for (size_t j = 0; j < features; ++j) {
+                    out[j + 1] = in[j] - x_shift[j];
+                }
+                for (size_t k = 0; k < targets; ++k) {
+                    const double y = Y[k * rows + begin + r] - y_shift[k];
+                    block_y[r * targets + k] = y;
+                    local_yy[k] += y * y;
+                }
+            }
+            blas.gemm(true, false, a, a, count, 1.0, block_a.data(), a, block_a.data(), a, 1.0, local_gram.data(), a);
+            blas.gemm(true, false, a, targets, count, 1.0, block_a.data(), a, block_y.data(), targets, 1.0,
+                      local_cross.data(), targets);
+        }
+
+        #pragma omp critical
+        {
+            for (size_t i = 0; i < gram.size(); ++i) gram[i] += local_gram[i];
+            for (size_t i = 0; i < cross.size(); ++i) cross[i] += local_cross[i];
+            for (size_t k = 0; k < targets; ++k) yy[k] += local_yy[k];
+        }
+    }
+
+    // Cholesky factorization gram = L L^T (lower triangle, in place), shared by every target
+    std::vector<double> chol = gram;
+    for (size_t j = 0; j < a; ++j) {
+        double diagonal = chol[j * a + j];
+        for (size_t m = 0; m < j; ++m) {
+            diagonal -= chol[j * a + m] * chol[j * a + m];
+        }
+        if (diagonal <= 1e-12 * std::max(1.0, gram[j * a + j])) {
+            throw std::invalid_argument("Design matrix is singular (constant or collinear features)");
+        }
+        chol[j * a + j] = std::sqrt(diagonal);
+        for (size_t i = j + 1; i < a; ++i) {
+            double value = chol[i * a + j];
+            for (size_t m = 0; m < j; ++m) {
+                value -= chol[i * a + m] * chol[j * a + m];
+            }
+            chol[i * a + j] = value / chol[j * a + j];
+        }
+    }
+
+    // Solve L L^T beta = cross for all targets at once (beta is a x targets)
+    std::vector<double> beta = cross;
+    for (size_t i = 0; i < a; ++i) {
+        for (size_t m = 0; m < i; ++m) {
+            for (size_t k = 0; k < targets; ++k) {
+                beta[i * targets + k] -= chol[i * a + m] * beta[m * targets + k];
+            }
+        }
+        for (size_t k = 0; k < targets; ++k) {
+            beta[i * targets + k] /= chol[i * a + i];
+        }
+    }
+    for (size_t i = a; i-- > 0;) {
+        for (size_t m = i + 1; m < a; ++m) {
+            for (size_t k = 0; k < targets; ++k) {
+                beta[i * targets + k] -= chol[m * a + i] * beta[m * targets + k];
+            }
+        }
+        for (size_t k = 0; k < targets; ++k) {
+            beta[i * targets + k] /= chol[i * a + i];
+        }
+    }
+
+    MultiTargetFit fit;
+    fit.features = features;
+    fit.targets = targets;
+    fit.weights.assign(beta.begin() + targets, beta.end());
+    fit.intercepts.resize(targets);
+    fit.mse.resize(targets);
+    fit.r_squared.resize(targets);
+    for (size_t k = 0; k < targets; ++k) {
+        double intercept = beta[k] + y_shift[k];
+        for (size_t j = 0; j < features; ++j) {
+            intercept -= fit.weight(j, k) * x_shift[j];
+        }
+        fit.intercepts[k] = intercept;
+
+        // RSS = y'y - 2 beta'A'y + beta'A'A beta, all from the accumulated statistics
+        double fitted = 0.0;    // beta' A'y
+        double quadratic = 0.0; // beta' A'A beta
+        for (size_t i = 0; i < a; ++i) {
+            const double b_i = beta[i * targets + k];
+            fitted += b_i * cross[i * targets + k];
+            double row = 0.0;
+            for (size_t m = 0; m < a; ++m) {
+                row += gram[i * a + m] * beta[m * targets + k];
+            }
+            quadratic += b_i * row;
+        }
+        const double rss = std::max(0.0, yy[k] - 2.0 * fitted + quadratic);
+        const double sum_y = cross[k]; // Row 0 of A'Y: sum of shifted responses
+        const double tss = yy[k] - sum_y * sum_y / static_cast<double>(rows);
+        fit.mse[k] = rss / static_cast<double>(rows);
+        fit.r_squared[k] = tss > 0.0 ? 1.0 - rss / tss : 1.0;
+    }
+    return fit;
+}
@@ -9,6 +9,26 @@
 #include <algorithm> // Required for std::min, std::shuffle
 #include <omp.h>     // Required for OpenMP
 
+#include "iterative_solver.h"
+#include "lr_finder.h"
+#include "sparse.h"
+
+// Least-squares fit of several response columns against the same inputs:
+// y_k ~ X * w_k + b_k for every target k.
+struct MultiTargetFit {
+    size_t features = 0;
+    size_t targets = 0;
+    std::vector<double> weights;    // features x targets, row-major: weights[j * targets + k]
+    std::vector<double> intercepts; // One per target
+    std::vector<double> mse;        // Training MSE per target
+    std::vector<double> r_squared;  // Training R^2 per target
+
+    double weight(size_t feature, size_t target) const { return weights[feature * targets + target]; }
+
+    // Every target's prediction for one input row of `features` values; out has `targets` slots
+    void predict(const double* x, double* out) const;
+};
+
 class LinearRegression {
 private:
     double slope;
@@ -16,6 +36,7 @@ private:
     double learning_rate;
     int max_iterations;
     int batch_size; // <-- Add batch size member
+    std::vector<double> weights; // Per-column weights of the multi-feature model (CsrMatrix or DesignOperator fits)
 
 public:
     // Constructor - updated signature
@@ -24,15 +45,66 @@ public:
     // Train the model using gradient descent
     void fit(const std::vector<double>& X, const std::vector<double>& y);
     
+    // Sparse variant: same mini-batch SGD and early stopping over CSR rows
+    // (e.g. hashed one-hot features). Gradients go through sparseDot and
+    // sparseAxpy, so an epoch costs O(nnz) rather than O(rows * cols). Learns
+    // one weight per column (get_weights) plus the intercept.
+    void fit(const CsrMatrix& X, const std::vector<double>& y);
+
+    // Learning-rate range test for fit(): mini-batches of this model's batch
+    // size, starting from its current slope and intercept, which are left
+    // untouched. Use the suggestion with set_learning_rate.
+    LrRangeTestResult lr_find(const std::vector<double>& X, const std::vector<double>& y,
+                              const LrRangeTestOptions& options = LrRangeTestOptions()) const;
+    void set_learning_rate(double lr);
+    double get_learning_rate() const;
+
     // Train the model using analytical solution (direct formula)
     void fit_analytical(const std::vector<double>& X, const std::vector<double>& y);
 
+    // Fit every response column against one design matrix in a single blocked
+    // pass: X^T X and all X^T y_k are accumulated together (as BLAS gemms on the
+    // active backend), then one Cholesky factorization solves every target.
+    // X is rows x features, row-major; Y holds the response columns one after
+    // another (targets x rows). MSE and R^2 come from the same sufficient
+    // statistics, so the data is read once. Throws std::invalid_argument on
+    // mismatched sizes or a singular design (e.g. a constant feature).
+    static MultiTargetFit fit_multi_target(const std::vector<double>& X, size_t features,
+                                           const std::vector<double>& Y, size_t targets);
+
+    // Train with the matrix-free CG solver (solveLeastSquaresCg), warm-started
+    // from the current slope and intercept; sets both and reports iterations/time
+    IterativeSolveResult fit_iterative(const std::vector<double>& X, const std::vector<double>& y,
+                                       int max_iterations = 1000, double tolerance = 1e-10);
+
+    // Multi-feature CG fit on any design (e.g. DenseDesign over a rows x
+    // features matrix). Learns one weight per column (get_weights) plus the
+    // intercept, warm-started from them when the previous fit had the same
+    // number of columns and from zero otherwise.
+    IterativeSolveResult fit_iterative(const DesignOperator& X, const std::vector<double>& y,
+                                       int max_iterations = 1000, double tolerance = 1e-10);
+    // Sparse rows through CsrDesign: O(nnz) per iteration, for hashed features
+    IterativeSolveResult fit_iterative(const CsrMatrix& X, const std::vector<double>& y,
+                                       int max_iterations = 1000, double tolerance = 1e-10);
+
     // Predict using the trained model
     double predict(double x) const;
 
+    // Batch prediction: out[i] = slope * x[i] + intercept for i < n. The loop is
+    // SIMD-vectorized; with allow_parallel, large batches are also split across
+    // OpenMP threads (pass false when the caller already runs one batch per thread).
+    void predict(const double* x, size_t n, double* out, bool allow_parallel = true) const;
+    std::vector<double> predict(const std::vector<double>& X) const;
+    double predict(const SparseRow& x) const; // Sparse model (after fit on a CsrMatrix)
+    double predict_row(const double* row, size_t features) const; // Dense row of a multi-feature model
+
+    // Use an already trained line (e.g. slope/intercept passed on the command line)
+    void set_parameters(double new_slope, double new_intercept);
+
     // Getters for slope and intercept
     double get_slope() const;
     double get_intercept() const;
+    const std::vector<double>& get_weights() const;
 
     // New public methods for metrics
     double get_mse(const std::vector<double>& X, const std::vector<double>& y) const;
@@ -0,0 +1,212 @@
+#include "local_sgd.h"
+
+#include <omp.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+LocalSgdResult trainLocalSgd(NeuralNetwork& network, const SampleVector* inputs, const SampleVector* targets,
+                             size_t count, int epochs, const LocalSgdOptions& options) {
+    const auto start = std::chrono::steady_clock::now();
+    if (count == 0) {
+        throw std::invalid_argument("Input and target datasets must be non-empty and have the same size.");
+    }
+    // Nothing may throw inside the parallel region, so the samples are checked here
+    const size_t features = network.layer_sizes().front();
+    const size_t outputs = network.layer_sizes().back();
+    for (size_t i = 0; i < count; ++i) {
+        if (inputs[i].size() != features || targets[i].size() != outputs) {
+            throw std::invalid_argument("Sample " + std::to_string(i) +
+                                        " does not match the network's input and output layer sizes.");
+        }
+    }
+    const int requested = options.threads > 0 ? options.threads : omp_get_max_threads();
+    const int threads = static_cast<int>(std::max<size_t>(1, std::min<size_t>(requested, count)));
+    const size_t min_steps = std::max<size_t>(1, options.min_sync_steps);
+    const size_t max_steps = std::max(min_steps, options.max_sync_steps);
+
+    LocalSgdResult result;
+
+    std::vector<size_t> order(count);
+    std::iota(order.begin(), order.end(), 0);
+    std::mt19937 gen(options.seed);
+    std::shuffle(order.begin(), order.end(), gen);
+
+    std::vector<NeuralNetwork> replicas(threads, network);
+    std::vector<Vector> parameters(threads);
+    Vector average;
+    network.get_parameters(average);
+    Vector next_average(average.size());
+    const long parameter_count = static_cast<long>(average.size());
+
+    // Shared state, written only inside `single` blocks (whose barriers publish it)
+    int team = threads;
+    size_t sync_steps = std::min(max_steps, std::max(min_steps, options.sync_steps));
+    size_t steps_total = 0;
+    double spread = 0.0;
+    double norm = 0.0;
+    double loss_sum = 0.0;
+    unsigned long long samples_trained = 0;
+    bool stop = false;
+    bool final_mse_current = false;
+
+    #pragma omp parallel num_threads(threads)
+    {
+        #pragma omp single
+        team = omp_get_num_threads();
+
+        const int t = omp_get_thread_num();
+        std::vector<size_t> shard(order.begin() + count * t / team, order.begin() + count * (t + 1) / team);
+        std::mt19937 shard_gen(options.seed + 1 + t);
+        NeuralNetwork& replica = replicas[t];
+        if (options.scale_learning_rate) {
+            replica.set_learning_rate(network.learning_rate() * team);
+        }
+        const size_t longest = (count + team - 1) / team;
+        SampleVector prediction;
+        unsigned long long trained = 0;
+
+        for (int epoch = 0; epoch < epochs && !stop; ++epoch) {
+            std::shuffle(shard.begin(), shard.end(), shard_gen);
+            // Every thread advances its own copy of the position by the same steps
+            for (size_t position = 0; position < longest;) {
+                // A lone replica has nothing to average with until the epoch ends
+                const size_t steps = team == 1 ? longest - position : std::min(sync_steps, longest - position);
+                const size_t end = std::min(position + steps, shard.size());
+                for (size_t i = position; i < end; ++i) {
+                    const size_t idx = shard[i];
+                    replica.train(inputs[idx].data(), features, targets[idx].data(), outputs);
+                }
+                trained += end > position ? end - position : 0;
+                replica.get_parameters(parameters[t]);
+                #pragma omp barrier
+
+                #pragma omp for schedule(static) reduction(+ : spread, norm)
+                for (long p = 0; p < parameter_count; ++p) {
+                    double sum = 0.0;
+                    for (int r = 0; r < team; ++r) {
+                        sum += parameters[r][p];
+                    }
+                    const double mean = sum / team;
+                    for (int r = 0; r < team; ++r) {
+                        const double difference = parameters[r][p] - mean;
+                        spread += difference * difference;
+                    }
+                    next_average[p] = mean;
+                    norm += mean * mean;
+                }
+
+                #pragma omp single
+                {
+                    ++result.rounds;
+                    steps_total += steps;
+                    final_mse_current = false;
+                    if (!std::isfinite(spread + norm)) {
+                        // Keep the last finite average
+                        stop = true;
+                        result.outcome.stopped_reason = "diverged";
+                        result.outcome.stopped_epoch = epoch + 1;
+                        result.outcome.divergence = "non-finite weights";
+                    } else {
+                        average.swap(next_average);
+                        if (options.cancel && options.cancel->load(std::memory_order_relaxed)) {
+                            stop = true;
+                            result.outcome.stopped_reason = "cancelled";
+                            result.outcome.stopped_epoch = epoch + 1;
+                        }
+                        result.replica_divergence = norm > 0.0 ? spread / team / norm : 0.0;
+                        // Replicas drift apart roughly in proportion to H: sync more
+                        // often when they disagree, less often when they agree
+                        if (options.adaptive && team > 1) {
+                            if (result.replica_divergence > 2.0 * options.divergence_target) {
+                                sync_steps = std::max(min_steps, sync_steps / 2);
+                            } else if (result.replica_divergence < 0.5 * options.divergence_target) {
+                                sync_steps = std::min(max_steps, sync_steps * 2);
+                            }
+                        }
+                    }
+                    spread = 0.0;
+                    norm = 0.0;
+                }
+                if (stop) {
+                    break;
+                }
+                replica.set_parameters(average);
+                position += steps;
+            }
+            if (stop) {
+                break;
+            }
+
+            // Every replica now holds the average; each scores its own shard
+            const bool report = options.report_every_n_epochs > 0 &&
+                                ((epoch + 1) % options.report_every_n_epochs == 0 || epoch == epochs - 1);
+            if (report || options.target_mse > 0.0 || epoch == epochs - 1) {
+                double local_loss = 0.0;
+                for (size_t idx : shard) {
+                    replica.predict_into(inputs[idx].data(), features, prediction);
+                    for (size_t k = 0; k < outputs; ++k) {
+                        const double error = prediction[k] - targets[idx][k];
+                        local_loss += error * error;
+                    }
+                }
+                #pragma omp atomic
+                loss_sum += local_loss;
+                #pragma omp barrier
+
+                #pragma omp single
+                {
+                    result.final_mse = loss_sum / static_cast<double>(count * outputs);
+                    final_mse_current = true;
+                    loss_sum = 0.0;
+                    if (report) {
+                        std::cout << "epoch=" << (epoch + 1) << ",mse=" << result.final_mse << std::endl;
+                    }
+                    if (options.target_mse > 0.0 && result.time_to_target_seconds < 0.0 &&
+                        result.final_mse <= options.target_mse) {
+                        result.time_to_target_seconds =
+                            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                        result.epochs_to_target = epoch + 1;
+                        if (options.stop_at_target) {
+                            stop = true;
+                            result.outcome.stopped_reason = "target reached";
+                        }
+                    }
+                }
+            }
+            #pragma omp master
+            result.epochs = epoch + 1;
+        }
+        #pragma omp atomic
+        samples_trained += trained;
+    }
+
+    network.set_parameters(average);
+    if (!final_mse_current) {
+        double loss = 0.0;
+        SampleVector prediction;
+        for (size_t i = 0; i < count; ++i) {
+            network.predict_into(inputs[i].data(), features, prediction);
+            for (size_t k = 0; k < outputs; ++k) {
+                const double error = prediction[k] - targets[i][k];
+                loss += error * error;
+            }
+        }
+        result.final_mse = loss / static_cast<double>(count * outputs);
+    }
+    result.threads = team;
+    result.outcome.learning_rate = replicas[0].learning_rate();
+    result.final_sync_steps = sync_steps;
+    result.mean_sync_steps = result.rounds > 0 ? static_cast<double>(steps_total) / result.rounds : 0.0;
+    result.elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.samples_per_second =
+        result.elapsed_seconds > 0.0 ? static_cast<double>(samples_trained) / result.elapsed_seconds : 0.0;
+    return result;
+}
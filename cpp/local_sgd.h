@@ -0,0 +1,61 @@
+#ifndef LOCAL_SGD_H
+#define LOCAL_SGD_H
+
+#include <cstddef>
+
+#include "neural_network.h"
+
+struct LocalSgdOptions {
+    int threads = 0;          // Replicas, one per thread; 0 = omp_get_max_threads()
+    size_t sync_steps = 8;    // H: local steps between averages (the starting H when adaptive)
+    bool adaptive = true;
+    size_t min_sync_steps = 1;
+    size_t max_sync_steps = 1024;
+    // Adaptive H aims the replicas' mean squared distance from their average,
+    // relative to the average's squared norm, at this value: H halves above
+    // twice the target and doubles below half of it
+    double divergence_target = 1e-4;
+    // Replicas step at learning_rate * threads (the linear scaling rule): an
+    // average of T replicas that each took n/T steps moves about as far as
+    // n/T sequential steps, so unscaled it needs ~T times the epochs
+    bool scale_learning_rate = true;
+    double target_mse = 0.0;  // > 0: record the time and epoch the training MSE first reaches it
+    bool stop_at_target = false;
+    int report_every_n_epochs = 10; // epoch=N,mse=... lines like train_for_epochs; 0 = none
+    // Cooperative cancellation: checked at every average, after which training
+    // stops with the averaged weights (null = never)
+    const std::atomic<bool>* cancel = nullptr;
+    unsigned seed = 42;       // Shard assignment and per-shard shuffles
+};
+
+struct LocalSgdResult {
+    int threads = 0;
+    size_t rounds = 0;               // Averaging rounds
+    size_t final_sync_steps = 0;     // H at the end of training
+    double mean_sync_steps = 0.0;    // Local steps per round, averaged over rounds
+    double replica_divergence = 0.0; // Relative divergence at the last average
+    double final_mse = 0.0;          // Of the averaged model after the last epoch
+    int epochs = 0;                  // Completed
+    double time_to_target_seconds = -1.0; // -1 when target_mse is unset or not reached
+    int epochs_to_target = 0;
+    // stopped_reason is "completed", "target reached", "cancelled" or
+    // "diverged" (the average went non-finite; the network keeps the last
+    // finite average)
+    TrainingOutcome outcome;
+    double samples_per_second = 0.0;
+    double elapsed_seconds = 0.0;
+};
+
+// Local SGD: the samples are dealt into one shard per thread, and every thread
+// runs plain per-sample SGD on its shard with a private copy of `network`.
+// Every H steps the copies are replaced by their parameter average, so threads
+// synchronize once per H samples instead of once per sample or mini-batch.
+// An epoch passes over every shard once and ends with an average, which is
+// written back to `network`. The MSE is evaluated on the averaged model in
+// parallel, at report epochs and, with a target_mse, after every epoch.
+// Throws std::invalid_argument for empty data or samples that do not match
+// the network's input/output sizes.
+LocalSgdResult trainLocalSgd(NeuralNetwork& network, const SampleVector* inputs, const SampleVector* targets,
+                             size_t count, int epochs, const LocalSgdOptions& options = LocalSgdOptions());
+
+#endif // LOCAL_SGD_H
@@ -0,0 +1,80 @@
+#include "lr_finder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <stdexcept>
+
+LrRangeTestResult runLrRangeTest(const std::function<double(double)>& step, const LrRangeTestOptions& options) {
+    if (!(options.min_learning_rate > 0.0) || !(options.max_learning_rate > options.min_learning_rate)) {
+        throw std::invalid_argument("Learning-rate range test needs 0 < min_learning_rate < max_learning_rate.");
+    }
+    if (options.steps < 3) {
+        throw std::invalid_argument("Learning-rate range test needs at least 3 steps.");
+    }
+    const auto start = std::chrono::steady_clock::now();
+    LrRangeTestResult result;
+    const double growth = std::pow(options.max_learning_rate / options.min_learning_rate, 1.0 / (options.steps - 1));
+    double average = 0.0;
+    double correction = 1.0;
+    size_t best = 0;
+    for (int k = 0; k < options.steps; ++k) {
+        const double learning_rate = options.min_learning_rate * std::pow(growth, k);
+        const double loss = step(learning_rate);
+        if (!std::isfinite(loss)) {
+            result.diverged = true;
+            break;
+        }
+        average = options.smoothing * average + (1.0 - options.smoothing) * loss;
+        correction *= options.smoothing;
+        const double smoothed = average / (1.0 - correction);
+        result.learning_rates.push_back(learning_rate);
+        result.losses.push_back(smoothed);
+        if (smoothed < result.losses[best]) {
+            best = result.losses.size() - 1;
+        }
+        if (smoothed > options.divergence_factor * result.losses[best]) {
+            result.diverged = true;
+            break;
+        }
+    }
+    if (result.losses.empty()) {
+        throw std::invalid_argument("Learning-rate range test diverged at the smallest learning rate.");
+    }
+    result.min_loss_learning_rate = result.learning_rates[best];
+
+    // Slope of log(loss) over log(learning rate): relative progress per step,
+    // so the large early losses do not dominate. Central differences over
+    // +-width steps keep single noisy batches from deciding.
+    const size_t width = std::max<size_t>(1, static_cast<size_t>(options.steps) / 40);
+    const double floor = std::numeric_limits<double>::min();
+    double steepest = 0.0;
+    result.suggested_learning_rate = result.min_loss_learning_rate / 10.0; // Fallback: no clear descent
+    for (size_t k = width; k + width <= best; ++k) {
+        const double slope = std::log(std::max(result.losses[k + width], floor) /
+                                      std::max(result.losses[k - width], floor)) /
+                             std::log(result.learning_rates[k + width] / result.learning_rates[k - width]);
+        if (slope < steepest) {
+            steepest = slope;
+            result.suggested_learning_rate = result.learning_rates[k];
+        }
+    }
+    // The smoothed loss lags the sweep, so its minimum can already lie past the
+    // stability limit; stay well below it
+    result.suggested_learning_rate = std::min(result.suggested_learning_rate, result.min_loss_learning_rate / 3.0);
+    result.elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+std::vector<size_t> rangeTestSubsample(size_t total, const LrRangeTestOptions& options) {
+    const size_t count = std::min(total, std::max<size_t>(1, options.max_samples));
+    std::vector<size_t> indices(count);
+    for (size_t i = 0; i < count; ++i) {
+        indices[i] = static_cast<size_t>(static_cast<double>(i) * total / count);
+    }
+    std::mt19937 gen(options.seed);
+    std::shuffle(indices.begin(), indices.end(), gen);
+    return indices;
+}
@@ -0,0 +1,47 @@
+#ifndef LR_FINDER_H
+#define LR_FINDER_H
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+struct LrRangeTestOptions {
+    // Learning rates swept geometrically from min to max, one mini-batch each
+    double min_learning_rate = 1e-6;
+    double max_learning_rate = 10.0;
+    int steps = 200;
+    // Exponential moving average of the batch losses (bias-corrected)
+    double smoothing = 0.9;
+    // The sweep stops once the smoothed loss exceeds this multiple of its minimum
+    double divergence_factor = 4.0;
+    // Model wrappers: samples per step (NeuralNetwork; LinearRegression uses its
+    // own batch size) and a strided subsample of at most max_samples rows,
+    // visited in a shuffled order from `seed`
+    size_t batch_size = 16;
+    size_t max_samples = 1024;
+    unsigned seed = 42;
+};
+
+struct LrRangeTestResult {
+    double suggested_learning_rate = 0.0; // Steepest descent of the smoothed loss
+    double min_loss_learning_rate = 0.0;  // Where the smoothed loss was lowest
+    std::vector<double> learning_rates;   // One per step run
+    std::vector<double> losses;           // Smoothed loss after each step
+    bool diverged = false;                // Stopped early on NaN/inf or divergence_factor
+    double elapsed_seconds = 0.0;
+};
+
+// Learning-rate range test: calls step(learning_rate) for exponentially
+// growing rates, where step trains one mini-batch at that rate and returns its
+// loss. The suggestion is the rate where log(smoothed loss) falls fastest per
+// unit of log(learning rate), looking only at rates below the loss minimum,
+// i.e. the steepest descent that is still stable, capped at a third of the
+// rate with the lowest loss. Throws
+// std::invalid_argument for an empty or inverted range or fewer than 3 steps.
+LrRangeTestResult runLrRangeTest(const std::function<double(double)>& step,
+                                 const LrRangeTestOptions& options = LrRangeTestOptions());
+
+// Up to options.max_samples evenly strided indices into [0, total), shuffled from options.seed
+std::vector<size_t> rangeTestSubsample(size_t total, const LrRangeTestOptions& options);
+
+#endif // LR_FINDER_H
@@ -12,20 +12,48 @@
 #include <algorithm>
 #include <cmath>
 #include <cstdlib>
+#include <map>
+#include <set>
+#include <memory>
+#include <cstring>
+#include <iterator>
+#include <atomic>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
 
 #include "linear_regression.h"
 #include "neural_network.h"
+#include "resource_usage.h"
+#include "metrics.h"
+#include "latency_histogram.h"
+#include "cost_model.h"
+#include "blas_backend.h"
+#include "arena.h"
+#include "perf_counters.h"
+#include "stream_pipeline.h"
+#include "range_index.h"
+#include "segmented_regression.h"
+#include "dataset.h"
+#include "lr_finder.h"
+#include "distillation.h"
+#include "local_sgd.h"
+#include "training_race.h"
 
 using Vector = std::vector<double>;
 using Matrix = std::vector<Vector>;
 
-// Helper function parseVector (no changes)
-std::vector<double> parseVector(const std::string& s) {
-    // ... (keep existing implementation) ...
-    std::vector<double> result;
+// Parses comma separated doubles into any container with reserve/push_back
+// (std::vector<double> or an arena-backed ArenaVector)
+template <typename Container>
+void parseVectorInto(const std::string& s, Container& result) {
     if (s.empty()) {
-        return result;
+        return;
     }
+    // Size the column once; arena memory from abandoned growth steps is not reclaimed
+    result.reserve(result.size() + std::count(s.begin(), s.end(), ',') + 1);
     std::stringstream ss(s);
     std::string item;
     while (std::getline(ss, item, ',')) {
@@ -44,6 +72,12 @@ std::vector<double> parseVector(const std::string& s) {
             throw;
         }
     }
+}
+
+// Helper function parseVector (no changes)
+std::vector<double> parseVector(const std::string& s) {
+    std::vector<double> result;
+    parseVectorInto(s, result);
     return result;
 }
 
@@ -80,24 +114,58 @@ std::vector<size_t> parseLayerSizes(const std::string& s) {
     return result;
 }
 
-// Helper function readAndParseVectorFromStdin (no changes)
-std::vector<double> readAndParseVectorFromStdin() {
-    // ... (keep existing implementation) ...
+// Reads one comma separated line from stdin into `result` (left empty at EOF)
+template <typename Container>
+void readAndParseVectorFromStdinInto(Container& result) {
      std::string line;
     if (std::getline(std::cin, line)) {
         line.erase(0, line.find_first_not_of(" \t\n\r\f\v"));
         line.erase(line.find_last_not_of(" \t\n\r\f\v") + 1);
-        return parseVector(line);
+        parseVectorInto(line, result);
     } else {
         if (std::cin.eof()) {
             // EOF is okay
         } else if (std::cin.fail()) {
             std::cerr << "Error: Failed to read data line from standard input." << std::endl;
         }
-        return {};
     }
 }
 
+// Helper function readAndParseVectorFromStdin (no changes)
+std::vector<double> readAndParseVectorFromStdin() {
+    std::vector<double> result;
+    readAndParseVectorFromStdinInto(result);
+    return result;
+}
+
+// Reads `in` to EOF as numbers: "text" is comma/whitespace separated, "binary"
+// is raw native-endian float64 values (8 bytes each)
+std::vector<double> readNumbersToEof(std::istream& in, const std::string& format) {
+    if (format != "text" && format != "binary") {
+        throw std::invalid_argument("--input-format must be 'text' or 'binary', got '" + format + "'.");
+    }
+    const std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::vector<double> values;
+    if (format == "text") {
+        parseNumberList(bytes.data(), bytes.data() + bytes.size(), values);
+        return values;
+    }
+    if (bytes.size() % sizeof(double) != 0) {
+        throw std::invalid_argument("Binary input must be a whole number of 8-byte doubles, got " +
+                                    std::to_string(bytes.size()) + " bytes.");
+    }
+    values.resize(bytes.size() / sizeof(double));
+    if (!values.empty()) {
+        std::memcpy(values.data(), bytes.data(), bytes.size());
+    }
+    for (double value : values) {
+        if (!std::isfinite(value)) {
+            throw std::invalid_argument("Invalid numeric value in binary input (NaN or infinity).");
+        }
+    }
+    return values;
+}
+
 // Helper to print a vector (no changes)
 void printVector(const Vector& vec) {
      // ... (keep existing implementation) ...
@@ -106,17 +174,386 @@ void printVector(const Vector& vec) {
     }
 }
 
+// Command line split into positional arguments (operation first) and
+// `--name value` / `--name=value` options. Single-dash tokens such as "-1.5"
+// stay positional so negative numbers keep working.
+struct CliArgs {
+    std::vector<std::string> positional;
+    std::map<std::string, std::string> options;
+
+    bool has(const std::string& name) const { return options.count(name) != 0; }
+};
+
+// Options understood by at least one operation; anything else is rejected so
+// typos do not silently fall back to defaults.
+const std::set<std::string>& knownOptions() {
+    static const std::set<std::string> known = {
+        "metrics-file", "metrics-interval-ms",
+        "max-ms", "max-mem", "budget-policy",
+        "blas",
+        "chunk-bytes", "workers", "queue-depth",
+        "input-format",
+        "solver", "max-iterations", "tolerance",
+        "penalty", "min-segment-size", "max-candidates",
+        "data", "data-format", "raw-cols", "x-cols", "y-cols", "data-cache",
+        "divergence-factor", "max-rollbacks", "learning-rate", "lr-find",
+        "distill-samples", "student-epochs", "student-learning-rate",
+        "train-mode", "threads", "sync-steps", "target-mse",
+        "race-strategies", "deadline-ms", "seed",
+        "validation-fraction", "validate-every", "patience", "keep-last",
+        "index-cache", "index-key"
+    };
+    return known;
+}
+
+// Options that take no value (presence means "true")
+const std::set<std::string>& flagOptions() {
+    static const std::set<std::string> flags = {"lr-find", "keep-last"};
+    return flags;
+}
+
+CliArgs parseCliArgs(int argc, char* argv[]) {
+    CliArgs args;
+    for (int i = 1; i < argc; ++i) {
+        std::string token = argv[i];
+        if (token.size() < 3 || token.compare(0, 2, "--") != 0) {
+            args.positional.push_back(token);
+            continue;
+        }
+        std::string name = token.substr(2);
+        std::string value;
+        size_t eq = name.find('=');
+        if (eq != std::string::npos) {
+            value = name.substr(eq + 1);
+            name = name.substr(0, eq);
+        } else if (flagOptions().count(name)) {
+            value = "true";
+        } else {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("Option '--" + name + "' requires a value.");
+            }
+            value = argv[++i];
+        }
+        if (!knownOptions().count(name)) {
+            throw std::invalid_argument("Unknown option '--" + name + "'.");
+        }
+        args.options[name] = value;
+    }
+    return args;
+}
+
+std::string optionString(const CliArgs& args, const std::string& name, const std::string& fallback) {
+    auto it = args.options.find(name);
+    return it == args.options.end() ? fallback : it->second;
+}
+
+long optionInt(const CliArgs& args, const std::string& name, long fallback) {
+    auto it = args.options.find(name);
+    if (it == args.options.end()) {
+        return fallback;
+    }
+    char* end;
+    long value = std::strtol(it->second.c_str(), &end, 10);
+    if (it->second.empty() || *end != '\0') {
+        throw std::invalid_argument("Option '--" + name + "' expects an integer, got '" + it->second + "'.");
+    }
+    return value;
+}
+
+double optionDouble(const CliArgs& args, const std::string& name, double fallback) {
+    auto it = args.options.find(name);
+    if (it == args.options.end()) {
+        return fallback;
+    }
+    char* end;
+    double value = std::strtod(it->second.c_str(), &end);
+    if (it->second.empty() || *end != '\0' || !std::isfinite(value)) {
+        throw std::invalid_argument("Option '--" + name + "' expects a number, got '" + it->second + "'.");
+    }
+    return value;
+}
+
+// Prometheus families describing a NeuralNetwork training run
+void writeTrainingMetrics(std::ostream& out, const TrainingProgress& progress) {
+    const double elapsed = progress.elapsed_seconds();
+    const int epoch = progress.epoch.load();
+    const unsigned long long samples = progress.samples_processed.load();
+    writeMetric(out, "mlapp_training_epoch", "gauge", "Epochs completed in the current training run.", epoch);
+    writeMetric(out, "mlapp_training_epochs_target", "gauge", "Epochs requested for the current training run.",
+                progress.total_epochs.load());
+    writeMetric(out, "mlapp_training_samples_total", "counter", "Training samples processed by backpropagation.",
+                static_cast<double>(samples));
+    writeMetric(out, "mlapp_training_epochs_per_second", "gauge", "Average epoch rate since training started.",
+                elapsed > 0.0 ? epoch / elapsed : 0.0);
+    writeMetric(out, "mlapp_training_samples_per_second", "gauge", "Average sample throughput since training started.",
+                elapsed > 0.0 ? samples / elapsed : 0.0);
+    writeMetric(out, "mlapp_training_loss", "gauge", "Most recently reported training MSE.", progress.last_loss.load());
+}
+
+// Backend spec from --blas, else the MLAPP_BLAS environment variable, else builtin
+std::string selectedBlasSpec(const CliArgs& args) {
+    if (args.has("blas")) {
+        return optionString(args, "blas", "builtin");
+    }
+    const char* env = std::getenv("MLAPP_BLAS");
+    return env && *env ? std::string(env) : std::string("builtin");
+}
+
+// Pre-flight estimate lines; the adjusted_* keys only appear when the job was changed to fit the budget
+void printCostEstimate(std::ostream& out, const BudgetDecision& decision, bool adjustment_applied) {
+    out << "estimated_flops=" << decision.original.flops << std::endl;
+    out << "estimated_bytes=" << decision.original.bytes << std::endl;
+    out << "estimated_peak_memory_bytes=" << decision.original.peak_memory_bytes << std::endl;
+    out << "estimated_time_ms=" << decision.original.time_ms << std::endl;
+    if (adjustment_applied && !decision.within_budget && decision.feasible) {
+        out << "budget_adjusted=1" << std::endl;
+        out << "adjusted_epochs=" << decision.job.epochs << std::endl;
+        out << "adjusted_samples=" << decision.job.samples << std::endl;
+        out << "adjusted_estimated_time_ms=" << decision.estimate.time_ms << std::endl;
+        out << "adjusted_estimated_peak_memory_bytes=" << decision.estimate.peak_memory_bytes << std::endl;
+    }
+}
+
+// Learning-rate range test summary (lr_train --solver sgd, nn_train_predict)
+void printLrRangeTest(std::ostream& out, const LrRangeTestResult& result) {
+    out << "lr_find_suggested_learning_rate=" << result.suggested_learning_rate << std::endl;
+    out << "lr_find_min_loss_learning_rate=" << result.min_loss_learning_rate << std::endl;
+    out << "lr_find_steps=" << result.learning_rates.size() << std::endl;
+    out << "lr_find_diverged=" << (result.diverged ? 1 : 0) << std::endl;
+    out << "lr_find_time_ms=" << result.elapsed_seconds * 1000.0 << std::endl;
+}
+
+// Evenly spaced subset of [0, total) with `count` entries (deterministic)
+std::vector<size_t> strideSubsample(size_t total, size_t count) {
+    std::vector<size_t> indices;
+    if (count == 0 || total == 0) {
+        return indices;
+    }
+    count = std::min(count, total);
+    indices.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        indices.push_back(static_cast<size_t>((static_cast<double>(i) * total) / count));
+    }
+    return indices;
+}
+
+// What Dataset::load did with the --data sidecar, counted for the metrics
+// export: "hit", "rehashed", "written" or "failed" (any "failed: <reason>")
+struct DatasetCacheCounters {
+    std::atomic<unsigned long> hit{0};
+    std::atomic<unsigned long> rehashed{0};
+    std::atomic<unsigned long> written{0};
+    std::atomic<unsigned long> failed{0};
+
+    static DatasetCacheCounters& instance() {
+        static DatasetCacheCounters counters;
+        return counters;
+    }
+
+    void record(const std::string& status) {
+        if (status == "hit") {
+            ++hit;
+        } else if (status == "rehashed") {
+            ++rehashed;
+        } else if (status == "written") {
+            ++written;
+        } else if (status.compare(0, 6, "failed") == 0) {
+            ++failed;
+        }
+    }
+};
+
+void writeDatasetCacheMetrics(std::ostream& out, const DatasetCacheCounters& counters) {
+    const std::string name = "mlapp_dataset_cache_lookups_total";
+    writeMetricHeader(out, name, "counter", "Dataset sidecar lookups by outcome.");
+    writeMetricSample(out, name, static_cast<double>(counters.hit.load()), "result=\"hit\"");
+    writeMetricSample(out, name, static_cast<double>(counters.rehashed.load()), "result=\"rehashed\"");
+    writeMetricSample(out, name, static_cast<double>(counters.written.load()), "result=\"written\"");
+    writeMetricSample(out, name, static_cast<double>(counters.failed.load()), "result=\"failed\"");
+}
+
+void writeStreamQueueMetrics(std::ostream& out, const StreamQueueGauges& gauges) {
+    writeMetricHeader(out, "mlapp_stream_queue_depth", "gauge", "Chunks waiting in each predict_stream queue.");
+    writeMetricSample(out, "mlapp_stream_queue_depth", static_cast<double>(gauges.input_depth.load()), "queue=\"input\"");
+    writeMetricSample(out, "mlapp_stream_queue_depth", static_cast<double>(gauges.done_depth.load()), "queue=\"done\"");
+    writeMetric(out, "mlapp_stream_queue_capacity", "gauge", "Capacity of each predict_stream queue.",
+                static_cast<double>(gauges.capacity.load()));
+}
+
+// Table given with --data, and the columns used as features and targets
+// (--x-cols/--y-cols; by default the last column is the target, the rest features)
+struct DataSelection {
+    std::unique_ptr<Dataset> dataset;
+    std::vector<size_t> x_columns;
+    std::vector<size_t> y_columns;
+};
+
+DataSelection loadDataSelection(const CliArgs& args) {
+    DatasetOptions options;
+    options.format = optionString(args, "data-format", "auto");
+    const long raw_columns = optionInt(args, "raw-cols", 1);
+    if (raw_columns <= 0) {
+        throw std::invalid_argument("--raw-cols must be positive.");
+    }
+    options.raw_columns = static_cast<size_t>(raw_columns);
+    const std::string path = optionString(args, "data", "");
+    const std::string cache = optionString(args, "data-cache", "auto");
+    if (cache == "auto") {
+        options.cache_path = path + ".mlcache";
+    } else if (cache != "off") {
+        options.cache_path = cache;
+    }
+    DataSelection selection;
+    selection.dataset.reset(new Dataset(Dataset::load(path, options)));
+    const Dataset& dataset = *selection.dataset;
+    DatasetCacheCounters::instance().record(dataset.cache_status());
+    if (!dataset.cache_status().empty()) {
+        std::cout << "dataset_cache=" << dataset.cache_status() << std::endl;
+    }
+    if (dataset.rows() == 0) {
+        throw std::invalid_argument("--data file has no rows.");
+    }
+    if (args.has("y-cols")) {
+        selection.y_columns = dataset.select_columns(optionString(args, "y-cols", ""));
+    } else {
+        selection.y_columns.push_back(dataset.cols() - 1);
+    }
+    if (args.has("x-cols")) {
+        selection.x_columns = dataset.select_columns(optionString(args, "x-cols", ""));
+    } else {
+        for (size_t j = 0; j < dataset.cols(); ++j) {
+            if (std::find(selection.y_columns.begin(), selection.y_columns.end(), j) == selection.y_columns.end()) {
+                selection.x_columns.push_back(j);
+            }
+        }
+    }
+    if (selection.x_columns.empty()) {
+        throw std::invalid_argument("--data needs at least one X column besides the Y columns.");
+    }
+    return selection;
+}
+
+// Gathers `columns` of the selection's dataset into sample-major rows: out[i * columns.size() + j]
+template <typename Container>
+void gatherRows(const DataSelection& selection, const std::vector<size_t>& columns, Container& out) {
+    out.resize(selection.dataset->rows() * columns.size());
+    for (size_t j = 0; j < columns.size(); ++j) {
+        selection.dataset->column(columns[j]).copy_to(&out[j], columns.size());
+    }
+}
+
+// Training rows for the network operations, sample-major: from --data, or an
+// X line and then one Y line per output neuron on stdin (one feature)
+void readNetworkData(const CliArgs& args, Arena& arena, ArenaVector& X, ArenaVector& Y, size_t& features,
+                     size_t& outputs) {
+    if (args.has("data")) {
+        const DataSelection data = loadDataSelection(args);
+        features = data.x_columns.size();
+        outputs = data.y_columns.size();
+        gatherRows(data, data.x_columns, X);
+        gatherRows(data, data.y_columns, Y);
+        return;
+    }
+    features = 1;
+    readAndParseVectorFromStdinInto(X);
+    std::vector<ArenaVector> columns;
+    for (;;) {
+        columns.push_back(ArenaVector{ArenaAllocator<double>(arena)});
+        readAndParseVectorFromStdinInto(columns.back());
+        if (columns.back().empty()) {
+            columns.pop_back();
+            break;
+        }
+        if (columns.back().size() != X.size()) {
+            throw std::invalid_argument("Every Y line must have one value per X value.");
+        }
+    }
+    outputs = columns.size();
+    Y.resize(X.size() * outputs);
+    for (size_t k = 0; k < outputs; ++k) {
+        for (size_t i = 0; i < X.size(); ++i) {
+            Y[i * outputs + k] = columns[k][i];
+        }
+    }
+}
+
 // Updated usage message function (no changes)
 void printUsage(const char* progName) {
     // ... (keep existing implementation) ...
     std::cerr << "Usage:" << std::endl;
     std::cerr << "  " << progName << " lr_train" << std::endl;
     std::cerr << "    (Reads X and Y from stdin, 1 line each, comma-separated)" << std::endl;
+    std::cerr << "    (Additional Y lines fit one line per target in a single pass; prints slopes=, intercepts=, ...)" << std::endl;
     std::cerr << "  " << progName << " lr_predict <slope> <intercept> <x_value>" << std::endl;
+    std::cerr << "  " << progName << " lr_predict <slope> <intercept> [--input-format text|binary]" << std::endl;
+    std::cerr << "    (Reads x values from stdin until EOF: comma/whitespace separated text, or raw float64;" << std::endl;
+    std::cerr << "     prints prediction_count= and predictions= with all results)" << std::endl;
+    std::cerr << "  " << progName << " lr_range <x_lo>:<x_hi> [<x_lo>:<x_hi> ...]" << std::endl;
+    std::cerr << "    (Reads X and Y from stdin like lr_train; indexes them once and prints one fit per x-range)" << std::endl;
+    std::cerr << "    (--index-cache <path> [--index-key <key>]: load a saved index instead, without reading stdin;" << std::endl;
+    std::cerr << "     when it is missing or keyed differently, index stdin and save it there)" << std::endl;
+    std::cerr << "  " << progName << " lr_segments" << std::endl;
+    std::cerr << "    (Reads X and Y from stdin like lr_train; fits a piecewise-linear model, one segment= line per piece)" << std::endl;
+    std::cerr << "  " << progName << " predict_stream <slope> <intercept>" << std::endl;
+    std::cerr << "    (Reads x values from stdin until EOF, comma/whitespace separated; writes one prediction per line)" << std::endl;
     std::cerr << "  " << progName << " nn_train_predict <layers> <learning_rate> <epochs>" << std::endl; // Kept command name
-    std::cerr << "    (e.g., " << progName << " nn_train_predict 1-5-1 0.05 1000)" << std::endl;
+    std::cerr << "    (e.g., " << progName << " nn_train_predict 1-5-1 0.05 1000; learning_rate 'auto' runs a range test first)" << std::endl;
     std::cerr << "    (Reads X and Y from stdin, 1 line each, comma-separated)" << std::endl;
+    std::cerr << "    (One Y line per output neuron, e.g. 1-8-3 takes 3 Y lines; predictions are printed output by output)" << std::endl;
     std::cerr << "    (Trains NN using train_for_epochs, outputs loss updates and final predictions)" << std::endl;
+    std::cerr << "  " << progName << " nn_distill <teacher_layers> <student_layers> <learning_rate> <epochs>" << std::endl;
+    std::cerr << "    (Reads data like nn_train_predict; trains the teacher, then the student on teacher outputs over dense synthetic inputs)" << std::endl;
+    std::cerr << "Options (nn_distill):" << std::endl;
+    std::cerr << "  --distill-samples <n>       Synthetic inputs labelled by the teacher (default 20 per data row, at least 1000)" << std::endl;
+    std::cerr << "  --student-epochs <n>        Student training epochs (default: <epochs>)" << std::endl;
+    std::cerr << "  --student-learning-rate <x> Student learning rate (default: <learning_rate>)" << std::endl;
+    std::cerr << "Options (nn_train_predict):" << std::endl;
+    std::cerr << "  --max-ms <ms>               Reject/adjust jobs whose estimated runtime exceeds <ms>" << std::endl;
+    std::cerr << "  --max-mem <bytes>           Reject/adjust jobs whose estimated peak memory exceeds <bytes> (K/M/G suffixes)" << std::endl;
+    std::cerr << "  --budget-policy reject|adjust  What to do when over budget (default reject; adjust lowers epochs, then subsamples)" << std::endl;
+    std::cerr << "  --divergence-factor <x>     Stop as diverged on NaN/inf or an epoch loss above x times the untrained loss (default 100; 0 disables)" << std::endl;
+    std::cerr << "  --max-rollbacks <n>         On divergence, restore the last healthy epoch and retry with a 10x lower learning rate, up to n times" << std::endl;
+    std::cerr << "  --train-mode sgd|local-sgd|race  Sequential SGD (default); one SGD replica per thread on its own shard, averaged" << std::endl;
+    std::cerr << "                              every H steps; or a race of several strategies, the first to fit winning" << std::endl;
+    std::cerr << "  --threads <n>               local-sgd replicas (default: OpenMP max threads)" << std::endl;
+    std::cerr << "  --sync-steps <n>|auto       local-sgd steps between averages; auto (default) adapts H to the replicas' divergence" << std::endl;
+    std::cerr << "  --target-mse <x>            local-sgd: report time_to_target_ms= and epochs_to_target= when the MSE reaches x;" << std::endl;
+    std::cerr << "                              race: the first strategy to reach x wins and the others are cancelled" << std::endl;
+    std::cerr << "  --race-strategies <n>       race: strategies trained in parallel (default 4; seeds and learning rates vary," << std::endl;
+    std::cerr << "                              spare --threads go to a local-sgd strategy)" << std::endl;
+    std::cerr << "  --deadline-ms <ms>          race: cancel every strategy after <ms> and keep the lowest MSE" << std::endl;
+    std::cerr << "  --seed <n>                  Initial weights (race: the first strategy's; default random)" << std::endl;
+    std::cerr << "  --validation-fraction <f>   sgd: hold out a fraction f of the rows and score weight snapshots on them" << std::endl;
+    std::cerr << "                              on a background thread; training ends with the best-scoring weights" << std::endl;
+    std::cerr << "  --validate-every <n>        Epochs between snapshots (default 1)" << std::endl;
+    std::cerr << "  --patience <n>              Stop early after n snapshots without a better validation MSE (default 0 = never)" << std::endl;
+    std::cerr << "  --keep-last                 Keep the last weights instead of restoring the best-scoring snapshot" << std::endl;
+    std::cerr << "Options (lr_train):" << std::endl;
+    std::cerr << "  --solver analytical|cg|sgd  Closed form (default), matrix-free preconditioned conjugate gradients or mini-batch SGD" << std::endl;
+    std::cerr << "  --max-iterations <n>        CG iteration / SGD epoch cap (default 1000)" << std::endl;
+    std::cerr << "  --learning-rate <x>|auto    SGD step size (default 0.01); auto runs a learning-rate range test first" << std::endl;
+    std::cerr << "  --lr-find                   Run the range test and print its suggestion without using it (also nn_train_predict)" << std::endl;
+    std::cerr << "  --tolerance <t>             CG relative normal-equation residual to stop at (default 1e-10)" << std::endl;
+    std::cerr << "Options (lr_segments):" << std::endl;
+    std::cerr << "  --penalty <p>               Squared-error cost of each extra segment (default 3 * noise variance * ln n)" << std::endl;
+    std::cerr << "  --min-segment-size <n>      Fewest points per segment (default 3)" << std::endl;
+    std::cerr << "  --max-candidates <n>        Breakpoints searched exactly before local refinement (default 2048, 0 = all)" << std::endl;
+    std::cerr << "Options (predict_stream):" << std::endl;
+    std::cerr << "  --chunk-bytes <bytes>       Input bytes parsed per chunk (default 1M; K/M/G suffixes)" << std::endl;
+    std::cerr << "  --workers <n>               Compute worker threads (default: hardware concurrency)" << std::endl;
+    std::cerr << "  --queue-depth <n>           Chunks buffered between stages (default 4)" << std::endl;
+    std::cerr << "Options (lr_train, nn_train_predict):" << std::endl;
+    std::cerr << "  --data <path>               Read the dataset from a file instead of stdin (.csv/.tsv/.txt, .npy, .bin/.raw/.f64)" << std::endl;
+    std::cerr << "  --data-format auto|csv|npy|raw  Override the format inferred from the extension" << std::endl;
+    std::cerr << "  --raw-cols <n>              float64 values per row of a raw file (default 1)" << std::endl;
+    std::cerr << "  --x-cols <cols>             Feature columns by name or index, comma separated (default: all but the Y columns)" << std::endl;
+    std::cerr << "  --y-cols <cols>             Target columns (default: the last column)" << std::endl;
+    std::cerr << "  --data-cache auto|off|<path>  Binary cache of a parsed CSV, reused while the CSV is unchanged (auto: <data>.mlcache)" << std::endl;
+    std::cerr << "Options (any operation):" << std::endl;
+    std::cerr << "  --blas <backend>            builtin (default), cblas, dlopen, dlopen:<path> or auto; also read from MLAPP_BLAS" << std::endl;
+    std::cerr << "  --metrics-file <path>       Periodically rewrite <path> with Prometheus text metrics" << std::endl;
+    std::cerr << "  --metrics-interval-ms <n>   Rewrite interval for --metrics-file (default 1000)" << std::endl;
+    std::cerr << "  (Send SIGUSR1 to dump training state and phase timers to stderr)" << std::endl;
 }
 
 #ifndef UNIT_TESTING
@@ -129,80 +566,589 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    std::string operation = argv[1];
+    // The command line is parsed before the SIGUSR1 dumper starts so the
+    // operation it reports is fixed by the time its thread can read it.
+    CliArgs args;
+    try {
+        args = parseCliArgs(argc, argv);
+    } catch (const std::invalid_argument& e) {
+        std::cerr << "Input Error: " << e.what() << std::endl;
+        printUsage(argv[0]);
+        return 1;
+    }
+    const std::string operation = args.positional.empty() ? "" : args.positional[0];
+
+    // Per-request accounting; emitted as key=value lines after the operation's own output
+    ResourceAccounting accounting;
+
+    // Phase timers and the SIGUSR1 dumper are set up before any worker thread
+    // exists so every thread inherits the blocked signal mask.
+    // Phases double as latency stages (parse, compute, evaluate, serialize).
+    const auto request_start = std::chrono::steady_clock::now();
+    PhaseTimers phases;
+    RequestLatencies& latencies = RequestLatencies::instance();
+    phases.set_observer([&](const std::string& stage, std::chrono::steady_clock::duration elapsed) {
+        latencies.histogram(operation, stage).record(elapsed);
+    });
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    ScopedCollector phase_collector(registry, [&phases, &latencies](std::ostream& out) {
+        writeMetric(out, "mlapp_up", "gauge", "Engine process is running.", 1.0);
+        phases.write_metrics(out);
+        latencies.write_metrics(out);
+    });
+    // Registered ahead of the metrics file exporter so its final snapshot still includes them
+    StreamQueueGauges queue_gauges;
+    std::unique_ptr<ScopedCollector> queue_collector;
+    if (operation == "predict_stream") {
+        queue_collector.reset(new ScopedCollector(registry, [&queue_gauges](std::ostream& out) {
+            writeStreamQueueMetrics(out, queue_gauges);
+        }));
+    }
+    std::unique_ptr<ScopedCollector> dataset_cache_collector;
+    if (args.has("data")) {
+        dataset_cache_collector.reset(new ScopedCollector(registry, [](std::ostream& out) {
+            writeDatasetCacheMetrics(out, DatasetCacheCounters::instance());
+        }));
+    }
+    StateDumper state_dumper([&](std::ostream& out) {
+        out << "operation=" << operation << "\n";
+        phases.dump(out);
+        out << registry.render();
+    });
 
     try {
+        std::unique_ptr<MetricsFileExporter> metrics_exporter;
+        if (args.has("metrics-file")) {
+            metrics_exporter.reset(new MetricsFileExporter(
+                optionString(args, "metrics-file", ""),
+                static_cast<int>(optionInt(args, "metrics-interval-ms", 1000)), registry));
+        }
+
+        const std::string blas_spec = selectedBlasSpec(args);
+        if (blas_spec != "builtin") {
+            setActiveBlasBackend(createBlasBackend(blas_spec));
+        }
+
         // --- Linear Regression Training Mode --- (No changes needed)
         if (operation == "lr_train") {
             // ... (keep existing implementation) ...
-             if (argc != 2) { /* ... */ return 1; }
-             std::vector<double> X = readAndParseVectorFromStdin();
-             std::vector<double> y = readAndParseVectorFromStdin();
+             if (args.positional.size() != 1) { /* ... */ return 1; }
+             std::vector<double> X;
+             std::vector<double> y;
+             // Further lines are extra response columns regressed on the same X
+             std::vector<double> extra_targets;
+             size_t targets = 1;
+             size_t features = 1; // X is rows x features, row-major
+             {
+                 auto phase = phases.measure("parse");
+                 if (args.has("data")) {
+                     const DataSelection data = loadDataSelection(args);
+                     features = data.x_columns.size();
+                     targets = data.y_columns.size();
+                     gatherRows(data, data.x_columns, X);
+                     y.resize(data.dataset->rows());
+                     data.dataset->column(data.y_columns[0]).copy_to(y.data());
+                     extra_targets.resize(y.size() * (targets - 1));
+                     for (size_t k = 1; k < targets; ++k) {
+                         data.dataset->column(data.y_columns[k]).copy_to(&extra_targets[(k - 1) * y.size()]);
+                     }
+                 } else {
+                     X = readAndParseVectorFromStdin();
+                     y = readAndParseVectorFromStdin();
+                     std::vector<double> column;
+                     while (readAndParseVectorFromStdinInto(column), !column.empty()) {
+                         if (column.size() != X.size()) {
+                             throw std::invalid_argument("Every Y line must have one value per X value.");
+                         }
+                         extra_targets.insert(extra_targets.end(), column.begin(), column.end());
+                         column.clear();
+                         ++targets;
+                     }
+                 }
+             }
              if (X.empty() || y.empty()) { /* ... */ return 1; }
-             if (X.size() != y.size()) { /* ... */ return 1; }
-             LinearRegression model;
-             auto start_time = std::chrono::high_resolution_clock::now();
-             model.fit_analytical(X, y);
-             auto end_time = std::chrono::high_resolution_clock::now();
-             auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
-             std::cout << "slope=" << model.get_slope() << std::endl;
-             std::cout << "intercept=" << model.get_intercept() << std::endl;
-             std::cout << "training_time_ms=" << duration.count() << std::endl;
-             std::cout << "mse=" << model.get_mse(X, y) << std::endl;
-             std::cout << "r_squared=" << model.get_r_squared(X, y) << std::endl;
+             if (X.size() != y.size() * features) {
+                 throw std::invalid_argument("X has " + std::to_string(X.size()) + " values but Y has " +
+                                             std::to_string(y.size()) + "; expected " + std::to_string(features) +
+                                             " X value(s) per Y value.");
+             }
+             const std::string solver = optionString(args, "solver", "analytical");
+             if (solver != "analytical" && solver != "cg" && solver != "sgd") {
+                 throw std::invalid_argument("--solver must be 'analytical', 'cg' or 'sgd', got '" + solver + "'.");
+             }
+             if (solver == "sgd" && (targets > 1 || features > 1)) {
+                 throw std::invalid_argument("--solver sgd fits one X column against a single Y line.");
+             }
+             if (solver == "cg" && targets > 1) {
+                 throw std::invalid_argument("--solver cg fits a single Y line.");
+             }
+             if (solver == "cg" && features > 1) {
+                 // Matrix-free CG on the rows x features design, never forming X^T X
+                 const size_t rows = y.size();
+                 LinearRegression model;
+                 IterativeSolveResult solve;
+                 auto start_time = std::chrono::high_resolution_clock::now();
+                 {
+                     auto phase = phases.measure("compute");
+                     solve = model.fit_iterative(DenseDesign(X.data(), rows, features), y,
+                                                 static_cast<int>(optionInt(args, "max-iterations", 1000)),
+                                                 optionDouble(args, "tolerance", 1e-10));
+                 }
+                 auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::high_resolution_clock::now() - start_time);
+                 double sse = 0.0;
+                 double y_sum = 0.0;
+                 for (size_t i = 0; i < rows; ++i) {
+                     const double error = model.predict_row(&X[i * features], features) - y[i];
+                     sse += error * error;
+                     y_sum += y[i];
+                 }
+                 double sst = 0.0;
+                 for (size_t i = 0; i < rows; ++i) {
+                     sst += (y[i] - y_sum / rows) * (y[i] - y_sum / rows);
+                 }
+                 auto output_phase = phases.measure("serialize");
+                 std::cout << "features=" << features << std::endl;
+                 std::cout << "weights=";
+                 printVector(model.get_weights());
+                 std::cout << std::endl << "intercept=" << model.get_intercept() << std::endl;
+                 std::cout << "training_time_ms=" << duration.count() << std::endl;
+                 std::cout << "mse=" << sse / rows << std::endl;
+                 std::cout << "r_squared=" << (sst > 0.0 ? 1.0 - sse / sst : 1.0) << std::endl;
+                 std::cout << "solver_iterations=" << solve.iterations << std::endl;
+                 std::cout << "solver_converged=" << (solve.converged ? 1 : 0) << std::endl;
+                 std::cout << "solver_relative_residual=" << solve.relative_residual << std::endl;
+                 std::cout << "solver_time_ms=" << solve.elapsed_seconds * 1000.0 << std::endl;
+             } else if (targets > 1 || features > 1) {
+                 // One X^T X, all X^T y_k in the same pass, one factorization
+                 std::vector<double> Y = y;
+                 Y.insert(Y.end(), extra_targets.begin(), extra_targets.end());
+                 auto start_time = std::chrono::high_resolution_clock::now();
+                 MultiTargetFit fit;
+                 {
+                     auto phase = phases.measure("compute");
+                     fit = LinearRegression::fit_multi_target(X, features, Y, targets);
+                 }
+                 auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::high_resolution_clock::now() - start_time);
+                 auto output_phase = phases.measure("serialize");
+                 std::cout << "targets=" << targets << std::endl;
+                 if (features > 1) {
+                     // One weight per (feature, target), feature-major
+                     std::cout << "features=" << features << std::endl;
+                     std::cout << "weights=";
+                 } else {
+                     std::cout << "slopes=";
+                 }
+                 printVector(fit.weights);
+                 std::cout << std::endl << "intercepts=";
+                 printVector(fit.intercepts);
+                 std::cout << std::endl << "training_time_ms=" << duration.count() << std::endl;
+                 std::cout << "mse=";
+                 printVector(fit.mse);
+                 std::cout << std::endl << "r_squared=";
+                 printVector(fit.r_squared);
+                 std::cout << std::endl;
+             } else {
+                 LinearRegression model;
+                 IterativeSolveResult solve;
+                 if (solver == "sgd") {
+                     // Mini-batch gradient descent; --learning-rate auto picks the rate with a range test
+                     const std::string rate = optionString(args, "learning-rate", "0.01");
+                     model = LinearRegression(rate == "auto" ? 0.01 : std::stod(rate),
+                                              static_cast<int>(optionInt(args, "max-iterations", 1000)));
+                     if (rate == "auto" || args.has("lr-find")) {
+                         LrRangeTestResult probe;
+                         {
+                             auto phase = phases.measure("lr_find");
+                             probe = model.lr_find(X, y);
+                         }
+                         printLrRangeTest(std::cout, probe);
+                         if (rate == "auto") {
+                             model.set_learning_rate(probe.suggested_learning_rate);
+                         }
+                     }
+                 }
+                 auto start_time = std::chrono::high_resolution_clock::now();
+                 {
+                     auto phase = phases.measure("compute");
+                     if (solver == "sgd") {
+                         model.fit(X, y);
+                     } else if (solver == "cg") {
+                         solve = model.fit_iterative(X, y, static_cast<int>(optionInt(args, "max-iterations", 1000)),
+                                                     optionDouble(args, "tolerance", 1e-10));
+                     } else {
+                         model.fit_analytical(X, y);
+                     }
+                 }
+                 auto end_time = std::chrono::high_resolution_clock::now();
+                 auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+                 auto output_phase = phases.measure("serialize");
+                 std::cout << "slope=" << model.get_slope() << std::endl;
+                 std::cout << "intercept=" << model.get_intercept() << std::endl;
+                 std::cout << "training_time_ms=" << duration.count() << std::endl;
+                 std::cout << "mse=" << model.get_mse(X, y) << std::endl;
+                 std::cout << "r_squared=" << model.get_r_squared(X, y) << std::endl;
+                 if (solver == "sgd") {
+                     std::cout << "learning_rate=" << model.get_learning_rate() << std::endl;
+                 }
+                 if (solver == "cg") {
+                     std::cout << "solver_iterations=" << solve.iterations << std::endl;
+                     std::cout << "solver_converged=" << (solve.converged ? 1 : 0) << std::endl;
+                     std::cout << "solver_relative_residual=" << solve.relative_residual << std::endl;
+                     std::cout << "solver_time_ms=" << solve.elapsed_seconds * 1000.0 << std::endl;
+                 }
+             }
 
         // --- Linear Regression Prediction Mode --- (No changes needed)
         } else if (operation == "lr_predict") {
-             // ... (keep existing implementation) ...
-             if (argc != 5) { /* ... */ return 1; }
-             double slope = std::stod(argv[2]);
-             double intercept = std::stod(argv[3]);
-             double x_value = std::stod(argv[4]);
-             double prediction = slope * x_value + intercept;
-             std::cout << "prediction=" << prediction << std::endl;
+             // lr_predict <slope> <intercept> <x_value> scores one value;
+             // lr_predict <slope> <intercept> scores every x value on stdin in one call
+             if (args.positional.size() != 3 && args.positional.size() != 4) {
+                 std::cerr << "Error: Invalid arguments for operation '" << operation << "'." << std::endl;
+                 printUsage(argv[0]);
+                 return 1;
+             }
+             LinearRegression model;
+             std::vector<double> x_values;
+             {
+                 auto phase = phases.measure("parse");
+                 model.set_parameters(std::stod(args.positional[1]), std::stod(args.positional[2]));
+                 if (args.positional.size() == 4) {
+                     x_values.push_back(std::stod(args.positional[3]));
+                 } else {
+                     const std::string format = optionString(args, "input-format", "text");
+#ifdef _WIN32
+                     if (format == "binary") {
+                         _setmode(_fileno(stdin), _O_BINARY);
+                     }
+#endif
+                     x_values = readNumbersToEof(std::cin, format);
+                 }
+             }
+             std::vector<double> predictions;
+             {
+                 auto phase = phases.measure("compute");
+                 predictions = model.predict(x_values);
+             }
+             auto output_phase = phases.measure("serialize");
+             if (args.positional.size() == 4) {
+                 std::cout << "prediction=" << predictions[0] << std::endl;
+             } else {
+                 std::cout << "prediction_count=" << predictions.size() << std::endl;
+                 std::cout << "predictions=";
+                 printVector(predictions);
+                 std::cout << std::endl;
+             }
+
+        // --- Linear Regression over x-ranges of one dataset ---
+        } else if (operation == "lr_range") {
+            if (args.positional.size() < 2) {
+                std::cerr << "Error: Invalid arguments for operation '" << operation << "'." << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+            std::vector<std::pair<double, double>> ranges;
+            for (size_t i = 1; i < args.positional.size(); ++i) {
+                const std::string& spec = args.positional[i];
+                const size_t colon = spec.find(':', 1);
+                if (colon == std::string::npos) {
+                    throw std::invalid_argument("Ranges are written <x_lo>:<x_hi>, got '" + spec + "'.");
+                }
+                const double lo = std::stod(spec.substr(0, colon));
+                const double hi = std::stod(spec.substr(colon + 1));
+                if (!(lo <= hi)) {
+                    throw std::invalid_argument("Range '" + spec + "' has x_lo > x_hi.");
+                }
+                ranges.push_back(std::make_pair(lo, hi));
+            }
+            const std::string index_cache = optionString(args, "index-cache", "");
+            const std::string index_key = optionString(args, "index-key", "");
+            std::unique_ptr<RangeRegressionIndex> index(new RangeRegressionIndex());
+            std::string index_status;
+            if (!index_cache.empty()) {
+                auto phase = phases.measure("load_index");
+                index_status = RangeRegressionIndex::load(index_cache, index_key, *index) ? "hit" : "";
+            }
+            if (index_status.empty()) {
+                std::vector<double> X;
+                std::vector<double> y;
+                {
+                    auto phase = phases.measure("parse");
+                    X = readAndParseVectorFromStdin();
+                    y = readAndParseVectorFromStdin();
+                }
+                {
+                    auto phase = phases.measure("compute");
+                    index.reset(new RangeRegressionIndex(X, y));
+                }
+                if (!index_cache.empty()) {
+                    auto phase = phases.measure("save_index");
+                    try {
+                        index->save(index_cache, index_key);
+                        index_status = "written";
+                    } catch (const std::runtime_error& e) {
+                        index_status = std::string("failed: ") + e.what();
+                    }
+                }
+            }
+            auto output_phase = phases.measure("serialize");
+            if (!index_status.empty()) {
+                std::cout << "index_cache=" << index_status << std::endl;
+            }
+            std::cout << "points=" << index->size() << std::endl;
+            for (const auto& range : ranges) {
+                std::cout << "range=" << range.first << ":" << range.second;
+                try {
+                    const RangeFit fit = index->fit_range(range.first, range.second);
+                    std::cout << ",count=" << fit.count << ",slope=" << fit.slope << ",intercept=" << fit.intercept
+                              << ",mse=" << fit.mse << ",r_squared=" << fit.r_squared << std::endl;
+                } catch (const std::invalid_argument&) {
+                    // An empty range is a valid question with no line as its answer
+                    std::cout << ",count=0" << std::endl;
+                }
+            }
+
+        // --- Piecewise-linear (segmented) regression ---
+        } else if (operation == "lr_segments") {
+            if (args.positional.size() != 1) {
+                std::cerr << "Error: Invalid arguments for operation '" << operation << "'." << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+            SegmentationOptions segment_options;
+            segment_options.penalty = optionDouble(args, "penalty", -1.0);
+            const long min_segment_size = optionInt(args, "min-segment-size", 3);
+            const long max_candidates = optionInt(args, "max-candidates", 2048);
+            if (min_segment_size <= 0 || max_candidates < 0) {
+                throw std::invalid_argument("--min-segment-size must be positive and --max-candidates >= 0.");
+            }
+            segment_options.min_segment_size = static_cast<size_t>(min_segment_size);
+            segment_options.max_candidates = static_cast<size_t>(max_candidates);
+            std::vector<double> X;
+            std::vector<double> y;
+            {
+                auto phase = phases.measure("parse");
+                X = readAndParseVectorFromStdin();
+                y = readAndParseVectorFromStdin();
+            }
+            Segmentation segmentation;
+            {
+                auto phase = phases.measure("compute");
+                const RangeRegressionIndex index(X, y);
+                segmentation = fitSegmentedRegression(index, segment_options);
+            }
+            auto output_phase = phases.measure("serialize");
+            std::cout << "segments=" << segmentation.segments.size() << std::endl;
+            for (const Segment& segment : segmentation.segments) {
+                std::cout << "segment=" << segment.x_first << ":" << segment.x_last << ",count=" << segment.fit.count
+                          << ",slope=" << segment.fit.slope << ",intercept=" << segment.fit.intercept
+                          << ",mse=" << segment.fit.mse << std::endl;
+            }
+            std::cout << "sse=" << segmentation.sse << std::endl;
+            std::cout << "penalty=" << segmentation.penalty << std::endl;
+            std::cout << "segment_candidates=" << segmentation.candidates << std::endl;
+            std::cout << "segment_evaluations=" << segmentation.evaluations << std::endl;
+            std::cout << "segmentation_time_ms=" << segmentation.elapsed_seconds * 1000.0 << std::endl;
+
+        // --- Streaming Linear Regression Scoring ---
+        } else if (operation == "predict_stream") {
+            if (args.positional.size() != 3) {
+                std::cerr << "Error: Invalid arguments for operation '" << operation << "'." << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+            const double slope = std::stod(args.positional[1]);
+            const double intercept = std::stod(args.positional[2]);
+            StreamPipelineOptions stream_options;
+            if (args.has("chunk-bytes")) {
+                stream_options.chunk_bytes = static_cast<size_t>(parseByteSize(optionString(args, "chunk-bytes", "")));
+            }
+            const long workers = optionInt(args, "workers", 0);
+            const long queue_depth = optionInt(args, "queue-depth", 4);
+            if (workers < 0 || queue_depth <= 0 || stream_options.chunk_bytes == 0) {
+                throw std::invalid_argument("--workers must be >= 0, --queue-depth and --chunk-bytes must be positive.");
+            }
+            stream_options.workers = static_cast<size_t>(workers);
+            stream_options.queue_depth = static_cast<size_t>(queue_depth);
+            // Per-chunk stage timings; the whole run is the "stream" phase
+            stream_options.observer = [&](const std::string& stage, std::chrono::steady_clock::duration elapsed) {
+                latencies.histogram(operation, stage).record(elapsed);
+            };
+            stream_options.queue_gauges = &queue_gauges;
+
+            StreamStats stream_stats;
+            {
+                auto phase = phases.measure("stream");
+                LinearRegression model;
+                model.set_parameters(slope, intercept);
+                // Workers already run one chunk each; keep the per-chunk loop single-threaded
+                const BatchPredictor predict = [&model](const double* x, size_t n, double* y) {
+                    model.predict(x, n, y, false);
+                };
+                stream_stats = runPredictStream(std::cin, std::cout, predict, stream_options);
+            }
+            // Predictions are bare lines; the summary keeps the key=value format
+            std::cout << "stream_values=" << stream_stats.values << std::endl;
+            std::cout << "stream_chunks=" << stream_stats.chunks << std::endl;
+            std::cout << "stream_bytes_in=" << stream_stats.bytes_in << std::endl;
+            std::cout << "stream_workers=" << stream_stats.workers << std::endl;
+            std::cout << "stream_max_chunks_in_flight=" << stream_stats.max_chunks_in_flight << std::endl;
+            std::cout << "stream_values_per_second="
+                      << (stream_stats.elapsed_seconds > 0.0 ? stream_stats.values / stream_stats.elapsed_seconds : 0.0)
+                      << std::endl;
 
         // --- Neural Network Training & Prediction Mode (MODIFIED) ---
         } else if (operation == "nn_train_predict") { // Keep command name consistent
-            if (argc != 5) {
+            if (args.positional.size() != 4) {
                 std::cerr << "Error: Invalid arguments for operation '" << operation << "'." << std::endl;
                 printUsage(argv[0]);
                 return 1;
             }
 
             // Parse NN parameters (same as before)
-            std::vector<size_t> layer_sizes = parseLayerSizes(argv[2]);
-            double learning_rate = std::stod(argv[3]);
-            int epochs = std::stoi(argv[4]);
+            std::vector<size_t> layer_sizes = parseLayerSizes(args.positional[1]);
+            // "auto": a learning-rate range test on the training data picks the rate
+            const bool auto_learning_rate = args.positional[2] == "auto";
+            double learning_rate = auto_learning_rate ? 0.01 : std::stod(args.positional[2]);
+            int epochs = std::stoi(args.positional[3]);
 
             // Validation (same as before)
             if (epochs <= 0) { /* ... */ return 1; }
             if (learning_rate <= 0) { /* ... warning ... */ }
 
-            // Read X and y values from stdin (same as before)
-            std::vector<double> X_train_flat = readAndParseVectorFromStdin();
-            std::vector<double> y_train_flat = readAndParseVectorFromStdin();
+            // Dataset storage for this request: 64-byte aligned, huge-page advised
+            // regions released in one go when the request ends
+            Arena arena;
+            ArenaVector X_train_flat{ArenaAllocator<double>(arena)};
+            // One Y line per output neuron, stored sample-major: sample i's
+            // targets are y_train_flat[i * outputs, (i + 1) * outputs)
+            ArenaVector y_train_flat{ArenaAllocator<double>(arena)};
+            size_t outputs = 0;
+            size_t features = 1; // X_train_flat is sample-major as well
+            {
+                auto phase = phases.measure("parse");
+                readNetworkData(args, arena, X_train_flat, y_train_flat, features, outputs);
+            }
 
              // Validation (same as before)
             if (X_train_flat.empty() || y_train_flat.empty()) { /* ... */ return 1; }
-            if (X_train_flat.size() != y_train_flat.size()) { /* ... */ return 1; }
-            if (layer_sizes[0] != 1) { /* ... */ return 1; }
-            if (layer_sizes.back() != 1) { /* ... */ return 1; }
+            if (layer_sizes[0] != features) {
+                throw std::invalid_argument("The input layer has " + std::to_string(layer_sizes[0]) +
+                                            " neurons but the data has " + std::to_string(features) + " X columns.");
+            }
+            if (layer_sizes.back() != outputs) {
+                throw std::invalid_argument("The output layer has " + std::to_string(layer_sizes.back()) +
+                                            " neurons but the data has " + std::to_string(outputs) + " Y columns.");
+            }
+            const size_t rows = X_train_flat.size() / features;
+
+            // Pre-flight cost estimate: always printed, enforced with --max-ms/--max-mem
+            const std::string budget_policy = optionString(args, "budget-policy", "reject");
+            if (budget_policy != "reject" && budget_policy != "adjust") {
+                throw std::invalid_argument("--budget-policy must be 'reject' or 'adjust', got '" + budget_policy + "'.");
+            }
+            const std::string train_mode = optionString(args, "train-mode", "sgd");
+            if (train_mode != "sgd" && train_mode != "local-sgd" && train_mode != "race") {
+                throw std::invalid_argument("--train-mode must be 'sgd', 'local-sgd' or 'race', got '" + train_mode + "'.");
+            }
+            const long race_strategies = optionInt(args, "race-strategies", 4);
+            if (race_strategies <= 0) {
+                throw std::invalid_argument("--race-strategies must be positive.");
+            }
+            const long requested_threads = optionInt(args, "threads", 0);
+            const int threads = requested_threads > 0 ? static_cast<int>(requested_threads) : omp_get_max_threads();
+            TrainingJob job;
+            job.layer_sizes = layer_sizes;
+            job.samples = rows;
+            job.epochs = epochs;
+            if (train_mode == "local-sgd") {
+                // One replica per thread plus the average
+                job.threads = threads;
+                job.model_copies = static_cast<size_t>(threads) + 1;
+            } else if (train_mode == "race") {
+                // Every strategy trains its own network over all of the data
+                const std::vector<RaceStrategy> layout =
+                    defaultRacePortfolio(static_cast<size_t>(race_strategies), learning_rate, 0, threads);
+                job.runs = layout.size();
+                job.model_copies = 0;
+                job.threads = 0;
+                for (const RaceStrategy& strategy : layout) {
+                    job.model_copies += strategy.optimizer == "local-sgd" ? strategy.threads + 1 : 1;
+                    job.threads += strategy.threads;
+                }
+            }
+            BudgetDecision budget;
+            {
+                auto phase = phases.measure("estimate");
+                CostModel cost_model(CostModel::calibrate());
+                const double max_mem = args.has("max-mem") ? parseByteSize(optionString(args, "max-mem", "")) : 0.0;
+                budget = cost_model.fit_to_budget(job, optionDouble(args, "max-ms", 0.0), max_mem);
+            }
+            printCostEstimate(std::cout, budget, budget_policy == "adjust");
+            if (!budget.within_budget) {
+                if (budget_policy == "reject" || !budget.feasible) {
+                    std::cerr << "Budget Error: estimated cost exceeds --max-ms/--max-mem"
+                              << (budget.reason.empty() ? "" : " (" + budget.reason + ")") << "." << std::endl;
+                    return 1;
+                }
+                std::cerr << "Warning: job adjusted to fit budget: " << budget.reason << std::endl;
+                epochs = budget.job.epochs;
+            }
+            const bool subsampled = budget.job.samples < rows;
+            const std::vector<size_t> train_rows = strideSubsample(rows, budget.job.samples);
 
             // --- MODIFICATION START ---
-            // Convert flat vectors to vector<Vector> format for train_for_epochs
-            std::vector<Vector> X_train_vec;
-            std::vector<Vector> y_train_vec;
-            X_train_vec.reserve(X_train_flat.size());
-            y_train_vec.reserve(y_train_flat.size());
-            for(size_t i = 0; i < X_train_flat.size(); ++i) {
-                X_train_vec.push_back({X_train_flat[i]});
-                y_train_vec.push_back({y_train_flat[i]});
+            // Convert flat vectors to per-sample vectors for train_for_epochs.
+            // SampleVector keeps samples of up to 8 values inline: no allocation per row.
+            std::vector<SampleVector, ArenaAllocator<SampleVector>> X_train_vec{ArenaAllocator<SampleVector>(arena)};
+            std::vector<SampleVector, ArenaAllocator<SampleVector>> y_train_vec{ArenaAllocator<SampleVector>(arena)};
+            X_train_vec.reserve(train_rows.size());
+            y_train_vec.reserve(train_rows.size());
+            for (size_t row : train_rows) {
+                X_train_vec.push_back(SampleVector(&X_train_flat[row * features], features));
+                y_train_vec.push_back(SampleVector(&y_train_flat[row * outputs], outputs));
             }
             // --- MODIFICATION END ---
 
 
             // Create the neural network
-            NeuralNetwork nn(layer_sizes, learning_rate);
+            const unsigned seed = args.has("seed") ? static_cast<unsigned>(optionInt(args, "seed", 0))
+                                                   : std::random_device()();
+            NeuralNetwork nn(layer_sizes, learning_rate, seed);
+            TrainingOptions training_options;
+            training_options.divergence_factor = optionDouble(args, "divergence-factor", training_options.divergence_factor);
+            training_options.stop_on_divergence = training_options.divergence_factor > 0.0;
+            training_options.max_rollbacks = static_cast<int>(optionInt(args, "max-rollbacks", 0));
+            if (training_options.max_rollbacks < 0) {
+                throw std::invalid_argument("--max-rollbacks must not be negative.");
+            }
+            training_options.validation_fraction = optionDouble(args, "validation-fraction", 0.0);
+            if (training_options.validation_fraction > 0.0 && train_mode != "sgd") {
+                throw std::invalid_argument("--validation-fraction is only supported with --train-mode sgd.");
+            }
+            training_options.validation_every_n_epochs = static_cast<int>(optionInt(args, "validate-every", 1));
+            training_options.patience = static_cast<int>(optionInt(args, "patience", 0));
+            if (training_options.validation_every_n_epochs <= 0 || training_options.patience < 0) {
+                throw std::invalid_argument("--validate-every must be positive and --patience must not be negative.");
+            }
+            training_options.restore_best = !args.has("keep-last");
+            nn.set_training_options(training_options);
+            if (auto_learning_rate || args.has("lr-find")) {
+                LrRangeTestResult probe;
+                {
+                    auto phase = phases.measure("lr_find");
+                    probe = nn.lr_find(X_train_vec.data(), y_train_vec.data(), X_train_vec.size());
+                }
+                printLrRangeTest(std::cout, probe);
+                if (auto_learning_rate) {
+                    nn.set_learning_rate(probe.suggested_learning_rate);
+                }
+                std::cout << "learning_rate=" << nn.learning_rate() << std::endl;
+            }
+            ScopedCollector training_collector(registry, [&nn](std::ostream& out) {
+                writeTrainingMetrics(out, nn.training_progress());
+            });
 
             auto start_time = std::chrono::high_resolution_clock::now();
 
@@ -210,7 +1156,57 @@ int main(int argc, char* argv[]) {
             // Call train_for_epochs instead of manual loop
             // This function will print loss updates to stdout periodically
             // It assumes report_every_n_epochs defaults to 10 or another value inside the class
-            Vector final_predictions_flat = nn.train_for_epochs(X_train_vec, y_train_vec, epochs);
+            Vector final_predictions_flat;
+            TlbMissCounter tlb_misses;
+            LocalSgdResult local_sgd;
+            RaceResult race;
+            {
+                auto phase = phases.measure("compute");
+                tlb_misses.start();
+                if (train_mode == "local-sgd") {
+                    LocalSgdOptions local_options;
+                    local_options.threads = threads;
+                    const std::string sync_steps = optionString(args, "sync-steps", "auto");
+                    if (sync_steps != "auto") {
+                        const long steps = optionInt(args, "sync-steps", 0);
+                        if (steps <= 0) {
+                            throw std::invalid_argument("--sync-steps must be positive or 'auto'.");
+                        }
+                        local_options.sync_steps = static_cast<size_t>(steps);
+                        local_options.adaptive = false;
+                    }
+                    local_options.target_mse = optionDouble(args, "target-mse", 0.0);
+                    local_sgd = trainLocalSgd(nn, X_train_vec.data(), y_train_vec.data(), X_train_vec.size(), epochs,
+                                              local_options);
+                } else if (train_mode == "race") {
+                    RaceOptions race_options;
+                    race_options.training = training_options;
+                    race_options.target_mse = optionDouble(args, "target-mse", 0.0);
+                    race_options.deadline_seconds = optionDouble(args, "deadline-ms", 0.0) / 1000.0;
+                    const std::vector<RaceStrategy> portfolio = defaultRacePortfolio(
+                        static_cast<size_t>(race_strategies), nn.learning_rate(), seed, threads);
+                    race = runTrainingRace(layer_sizes, portfolio, X_train_vec.data(), y_train_vec.data(),
+                                           X_train_vec.size(), epochs, race_options);
+                    nn = race.networks[race.winner];
+                } else {
+                    final_predictions_flat = nn.train_for_epochs(X_train_vec.data(), y_train_vec.data(),
+                                                                 X_train_vec.size(), epochs);
+                }
+                tlb_misses.stop();
+            }
+            if (subsampled || train_mode != "sgd") {
+                // Trained on a subsample (or by trainLocalSgd or a race, which
+                // return no predictions); still report a prediction for every input
+                auto phase = phases.measure("evaluate");
+                final_predictions_flat.clear();
+                final_predictions_flat.reserve(y_train_flat.size());
+                SampleVector prediction;
+                for (size_t i = 0; i < rows; ++i) {
+                    nn.predict_into(&X_train_flat[i * features], features, prediction);
+                    final_predictions_flat.insert(final_predictions_flat.end(), prediction.data(),
+                                                  prediction.data() + prediction.size());
+                }
+            }
             // --- MODIFICATION END ---
 
             auto end_time = std::chrono::high_resolution_clock::now();
@@ -219,13 +1215,14 @@ int main(int argc, char* argv[]) {
             // --- MODIFICATION START ---
             // Calculate final MSE AFTER training using the returned predictions
              double final_mse = 0.0;
+             Vector final_mse_per_output;
              if (final_predictions_flat.size() == y_train_flat.size()) {
-                 for (size_t i = 0; i < final_predictions_flat.size(); ++i) {
-                     // Note: y_train_vec[i][0] is equivalent to y_train_flat[i]
-                     double error = final_predictions_flat[i] - y_train_flat[i];
-                     final_mse += error * error;
+                 final_mse_per_output = NeuralNetwork::mean_squared_error_per_output(
+                     final_predictions_flat.data(), y_train_flat.data(), rows, outputs);
+                 for (double loss : final_mse_per_output) {
+                     final_mse += loss;
                  }
-                 final_mse /= final_predictions_flat.size();
+                 final_mse /= outputs;
              } else {
                  final_mse = std::numeric_limits<double>::quiet_NaN(); // Indicate error
                  std::cerr << "Warning: Prediction vector size mismatch after training." << std::endl;
@@ -234,18 +1231,174 @@ int main(int argc, char* argv[]) {
 
             // Output final results AFTER training is complete
             // Loss updates were already printed during the train_for_epochs call
+            auto output_phase = phases.measure("serialize");
             std::cout << "training_time_ms=" << duration.count() << std::endl;
             std::cout << "final_mse=" << final_mse << std::endl; // Use the calculated final MSE
+            const TrainingOutcome* outcome_of_mode = &nn.training_outcome();
+            if (train_mode == "local-sgd") {
+                outcome_of_mode = &local_sgd.outcome;
+            } else if (train_mode == "race") {
+                outcome_of_mode = &race.entries[race.winner].outcome;
+            }
+            const TrainingOutcome& outcome = *outcome_of_mode;
+            std::cout << "stopped_reason=" << outcome.stopped_reason << std::endl;
+            if (outcome.stopped_reason == "early stopped") {
+                std::cout << "stopped_epoch=" << outcome.stopped_epoch << std::endl;
+            }
+            if (outcome.validation_samples > 0) {
+                // Predictions and final_mse use the best snapshot's weights unless --keep-last
+                std::cout << "validation_samples=" << outcome.validation_samples << std::endl;
+                std::cout << "validation_evaluations=" << outcome.validation_evaluations << std::endl;
+                std::cout << "validation_snapshots_dropped=" << outcome.validation_snapshots_dropped << std::endl;
+                std::cout << "best_validation_mse=" << outcome.best_validation_mse << std::endl;
+                std::cout << "best_validation_epoch=" << outcome.best_validation_epoch << std::endl;
+                std::cout << "final_validation_mse=" << outcome.final_validation_mse << std::endl;
+                std::cout << "restored_best=" << (outcome.restored_best ? 1 : 0) << std::endl;
+            }
+            if (outcome.stopped_reason == "diverged") {
+                // Predictions and final_mse come from the last healthy epoch's weights
+                std::cout << "stopped_epoch=" << outcome.stopped_epoch << std::endl;
+                std::cout << "divergence=" << outcome.divergence << std::endl;
+            }
+            if (outcome.rollbacks > 0) {
+                std::cout << "learning_rate_rollbacks=" << outcome.rollbacks << std::endl;
+                std::cout << "final_learning_rate=" << outcome.learning_rate << std::endl;
+            }
+            if (train_mode == "local-sgd") {
+                std::cout << "train_mode=local-sgd" << std::endl;
+                std::cout << "local_sgd_threads=" << local_sgd.threads << std::endl;
+                std::cout << "local_sgd_rounds=" << local_sgd.rounds << std::endl;
+                std::cout << "local_sgd_mean_sync_steps=" << local_sgd.mean_sync_steps << std::endl;
+                std::cout << "local_sgd_final_sync_steps=" << local_sgd.final_sync_steps << std::endl;
+                std::cout << "local_sgd_replica_divergence=" << local_sgd.replica_divergence << std::endl;
+                std::cout << "samples_per_second=" << local_sgd.samples_per_second << std::endl;
+                if (local_sgd.time_to_target_seconds >= 0.0) {
+                    std::cout << "time_to_target_ms=" << local_sgd.time_to_target_seconds * 1000.0 << std::endl;
+                    std::cout << "epochs_to_target=" << local_sgd.epochs_to_target << std::endl;
+                }
+            } else if (train_mode == "race") {
+                // One race_entry= line per strategy: index,strategy,mse,epochs,ms,stopped_reason
+                std::cout << "train_mode=race" << std::endl;
+                std::cout << "race_strategies=" << race.entries.size() << std::endl;
+                for (size_t k = 0; k < race.entries.size(); ++k) {
+                    const RaceEntry& entry = race.entries[k];
+                    std::cout << "race_entry=" << k << "," << entry.strategy.name() << "," << entry.mse << ","
+                              << entry.epochs << "," << entry.seconds * 1000.0 << "," << entry.outcome.stopped_reason
+                              << std::endl;
+                }
+                std::cout << "race_winner=" << race.winner << std::endl;
+                std::cout << "race_winner_strategy=" << race.entries[race.winner].strategy.name() << std::endl;
+                std::cout << "race_decided_by=" << race.decided_by << std::endl;
+                std::cout << "time_to_fit_ms=" << race.time_to_fit_seconds * 1000.0 << std::endl;
+            } else if (training_options.stop_on_divergence) {
+                std::cout << "max_gradient_norm=" << outcome.max_gradient_norm << std::endl;
+            }
+            if (outputs > 1) {
+                // Predictions are laid out like the Y input: all of output 0, then output 1, ...
+                std::cout << "outputs=" << outputs << std::endl;
+                std::cout << "final_mse_per_output=";
+                printVector(final_mse_per_output);
+                std::cout << std::endl;
+                Vector by_output(final_predictions_flat.size());
+                for (size_t i = 0; i < rows && by_output.size() == rows * outputs; ++i) {
+                    for (size_t k = 0; k < outputs; ++k) {
+                        by_output[k * rows + i] = final_predictions_flat[i * outputs + k];
+                    }
+                }
+                final_predictions_flat.swap(by_output);
+            }
             std::cout << "nn_predictions=";
             printVector(final_predictions_flat); // Use the predictions returned by train_for_epochs
             std::cout << std::endl;
+            std::cout << "arena_reserved_bytes=" << arena.bytes_reserved() << std::endl;
+            std::cout << "arena_huge_page_regions=" << arena.huge_page_regions() << std::endl;
+            if (tlb_misses.available()) {
+                std::cout << "dtlb_load_misses=" << tlb_misses.dtlb_load_misses() << std::endl;
+            }
             // --- MODIFICATION END ---
 
+        // --- Distill a trained network into a smaller student ---
+        } else if (operation == "nn_distill") {
+            if (args.positional.size() != 5) {
+                std::cerr << "Error: Invalid arguments for operation '" << operation << "'." << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+            const std::vector<size_t> teacher_layers = parseLayerSizes(args.positional[1]);
+            const std::vector<size_t> student_layers = parseLayerSizes(args.positional[2]);
+            const double learning_rate = std::stod(args.positional[3]);
+            const int epochs = std::stoi(args.positional[4]);
+            if (epochs <= 0 || learning_rate <= 0.0) {
+                throw std::invalid_argument("nn_distill needs a positive learning rate and epoch count.");
+            }
+            Arena arena;
+            ArenaVector X{ArenaAllocator<double>(arena)};
+            ArenaVector Y{ArenaAllocator<double>(arena)};
+            size_t features = 1;
+            size_t outputs = 0;
+            {
+                auto phase = phases.measure("parse");
+                readNetworkData(args, arena, X, Y, features, outputs);
+            }
+            if (X.empty() || teacher_layers.front() != features || teacher_layers.back() != outputs) {
+                throw std::invalid_argument("The teacher's input and output layers must match the data's X and Y columns.");
+            }
+            const size_t rows = X.size() / features;
+            std::vector<SampleVector> inputs(rows);
+            std::vector<SampleVector> targets(rows);
+            for (size_t i = 0; i < rows; ++i) {
+                inputs[i].assign(&X[i * features], features);
+                targets[i].assign(&Y[i * outputs], outputs);
+            }
+
+            NeuralNetwork teacher(teacher_layers, learning_rate);
+            NeuralNetwork student(student_layers, optionDouble(args, "student-learning-rate", learning_rate));
+            DistillationOptions options;
+            options.samples = static_cast<size_t>(std::max(0L, optionInt(args, "distill-samples", 0)));
+            options.epochs = static_cast<int>(optionInt(args, "student-epochs", epochs));
+            DistillationResult result;
+            auto start_time = std::chrono::high_resolution_clock::now();
+            {
+                auto phase = phases.measure("compute");
+                teacher.train_for_epochs(inputs, targets, epochs);
+                result = distill(teacher, student, X.data(), Y.data(), rows, options);
+            }
+            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::high_resolution_clock::now() - start_time);
+
+            auto output_phase = phases.measure("serialize");
+            std::cout << "training_time_ms=" << duration.count() << std::endl;
+            std::cout << "distill_samples=" << result.samples << std::endl;
+            std::cout << "teacher_parameters=" << result.teacher_parameters << std::endl;
+            std::cout << "student_parameters=" << result.student_parameters << std::endl;
+            std::cout << "teacher_mse=" << result.teacher_mse_vs_truth << std::endl;
+            std::cout << "student_mse_vs_teacher=" << result.student_mse_vs_teacher << std::endl;
+            std::cout << "student_mse=" << result.student_mse_vs_truth << std::endl;
+            std::cout << "teacher_predict_ns=" << result.teacher_predict_ns << std::endl;
+            std::cout << "student_predict_ns=" << result.student_predict_ns << std::endl;
+            std::cout << "inference_speedup=" << result.speedup << std::endl;
+            // The student's predictions, laid out like nn_train_predict's
+            Vector predictions(rows * outputs);
+            SampleVector prediction;
+            for (size_t i = 0; i < rows; ++i) {
+                student.predict_into(inputs[i].data(), features, prediction);
+                for (size_t k = 0; k < outputs; ++k) {
+                    predictions[k * rows + i] = prediction[k];
+                }
+            }
+            std::cout << "nn_predictions=";
+            printVector(predictions);
+            std::cout << std::endl;
+
         } else {
             std::cerr << "Error: Unknown operation '" << operation << "'." << std::endl;
             printUsage(argv[0]);
             return 1;
         }
+
+        latencies.histogram(operation, "total").record(std::chrono::steady_clock::now() - request_start);
+        std::cout << "blas_backend=" << activeBlasBackend().name() << std::endl;
+        printResourceUsage(std::cout, accounting.elapsed());
     } catch (const std::invalid_argument& e) {
         std::cerr << "Input Error: " << e.what() << std::endl;
         printUsage(argv[0]);
@@ -0,0 +1,265 @@
+#include "metrics.h"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#include <signal.h>
+#define METRICS_HAVE_POSIX_SIGNALS 1
+#endif
+
+// --- Exposition helpers ---
+
+void writeMetricHeader(std::ostream& out, const std::string& name, const std::string& type, const std::string& help) {
+    out << "# HELP " << name << " " << help << "\n";
+    out << "# TYPE " << name << " " << type << "\n";
+}
+
+void writeMetricSample(std::ostream& out, const std::string& name, double value, const std::string& labels) {
+    out << name;
+    if (!labels.empty()) {
+        out << "{" << labels << "}";
+    }
+    out << " ";
+    // Prometheus spells special values as NaN / +Inf / -Inf
+    if (std::isnan(value)) {
+        out << "NaN";
+    } else if (std::isinf(value)) {
+        out << (value > 0 ? "+Inf" : "-Inf");
+    } else {
+        out << value;
+    }
+    out << "\n";
+}
+
+void writeMetric(std::ostream& out, const std::string& name, const std::string& type,
+                 const std::string& help, double value) {
+    writeMetricHeader(out, name, type, help);
+    writeMetricSample(out, name, value);
+}
+
+// --- MetricsRegistry ---
+
+MetricsRegistry& MetricsRegistry::instance() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+size_t MetricsRegistry::add_collector(Collector collector) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t id = next_id_++;
+    collectors_[id] = std::move(collector);
+    return id;
+}
+
+void MetricsRegistry::remove_collector(size_t id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    collectors_.erase(id);
+}
+
+std::string MetricsRegistry::render() const {
+    std::ostringstream out;
+    out.precision(std::numeric_limits<double>::max_digits10);
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& entry : collectors_) {
+        entry.second(out);
+    }
+    return out.str();
+}
+
+ScopedCollector::ScopedCollector(MetricsRegistry& registry, MetricsRegistry::Collector collector)
+    : registry_(registry), id_(registry.add_collector(std::move(collector))) {}
+
+ScopedCollector::~ScopedCollector() {
+    registry_.remove_collector(id_);
+}
+
+// --- MetricsFileExporter ---
+
+MetricsFileExporter::MetricsFileExporter(const std::string& path, int interval_ms, MetricsRegistry& registry)
+    : path_(path), interval_(interval_ms > 0 ? interval_ms : 1000), registry_(registry) {
+    if (path_.empty()) {
+        throw std::invalid_argument("Metrics file path cannot be empty.");
+    }
+    worker_ = std::thread(&MetricsFileExporter::run, this);
+}
+
+MetricsFileExporter::~MetricsFileExporter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    write_now(); // Leave the final state behind for post-mortem scrapes
+}
+
+bool MetricsFileExporter::write_now() {
+    const std::string body = registry_.render();
+    const std::string tmp_path = path_ + ".tmp";
+    {
+        std::ofstream file(tmp_path.c_str(), std::ios::out | std::ios::trunc);
+        if (!file) {
+            return false;
+        }
+        file << body;
+        if (!file) {
+            return false;
+        }
+    }
+    return std::rename(tmp_path.c_str(), path_.c_str()) == 0;
+}
+
+void MetricsFileExporter::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        lock.unlock();
+        write_now();
+        lock.lock();
+        wake_.wait_for(lock, interval_, [this] { return stopping_; });
+    }
+}
+
+// --- PhaseTimers ---
+
+PhaseTimers::Scope::Scope(PhaseTimers& timers, const std::string& phase)
+    : timers_(&timers), slot_(timers.slot_for(phase)), start_(std::chrono::steady_clock::now()), phase_(phase) {
+    std::lock_guard<std::mutex> lock(timers.mutex_);
+    previous_ = timers.current_;
+    previous_start_ = timers.current_start_;
+    timers.current_ = phase;
+    timers.current_start_ = start_;
+}
+
+PhaseTimers::Scope::Scope(Scope&& other)
+    : timers_(other.timers_), slot_(other.slot_), start_(other.start_), phase_(std::move(other.phase_)),
+      previous_(std::move(other.previous_)), previous_start_(other.previous_start_) {
+    other.timers_ = nullptr;
+    other.slot_ = nullptr;
+}
+
+PhaseTimers::Scope::~Scope() {
+    if (!timers_) {
+        return;
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start_;
+    slot_->fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    {
+        std::lock_guard<std::mutex> lock(timers_->mutex_);
+        timers_->current_ = previous_;
+        timers_->current_start_ = previous_start_;
+    }
+    if (timers_->observer_) {
+        timers_->observer_(phase_, elapsed);
+    }
+}
+
+PhaseTimers::Scope PhaseTimers::measure(const std::string& phase) {
+    return Scope(*this, phase);
+}
+
+std::atomic<long long>* PhaseTimers::slot_for(const std::string& phase) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& slot = nanos_[phase];
+    if (!slot) {
+        slot.reset(new std::atomic<long long>(0));
+    }
+    return slot.get();
+}
+
+std::string PhaseTimers::current_phase() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return current_.empty() ? "idle" : current_;
+}
+
+std::map<std::string, double> PhaseTimers::totals_seconds() const {
+    std::map<std::string, double> totals;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& entry : nanos_) {
+        totals[entry.first] = static_cast<double>(entry.second->load()) * 1e-9;
+    }
+    if (!current_.empty()) {
+        totals[current_] += std::chrono::duration<double>(std::chrono::steady_clock::now() - current_start_).count();
+    }
+    return totals;
+}
+
+void PhaseTimers::write_metrics(std::ostream& out) const {
+    const auto totals = totals_seconds();
+    if (totals.empty()) {
+        return;
+    }
+    writeMetricHeader(out, "mlapp_phase_seconds_total", "counter", "Wall time spent in each request phase.");
+    for (const auto& entry : totals) {
+        writeMetricSample(out, "mlapp_phase_seconds_total", entry.second, "phase=\"" + entry.first + "\"");
+    }
+}
+
+void PhaseTimers::dump(std::ostream& out) const {
+    out << "current_phase=" << current_phase() << "\n";
+    for (const auto& entry : totals_seconds()) {
+        out << "phase_" << entry.first << "_ms=" << entry.second * 1000.0 << "\n";
+    }
+}
+
+// --- StateDumper ---
+
+#ifdef METRICS_HAVE_POSIX_SIGNALS
+
+StateDumper::StateDumper(DumpFn dump) : dump_(std::move(dump)), stopping_(false), dumps_(0) {
+    // Block SIGUSR1 here; threads created afterwards inherit the mask, so the
+    // only place the signal is ever consumed is the sigwait() below.
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &set, nullptr);
+    worker_ = std::thread(&StateDumper::run, this);
+}
+
+StateDumper::~StateDumper() {
+    stopping_ = true;
+    if (worker_.joinable()) {
+        pthread_kill(worker_.native_handle(), SIGUSR1);
+        worker_.join();
+    }
+}
+
+void StateDumper::run() {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+    while (true) {
+        int signal_number = 0;
+        if (sigwait(&set, &signal_number) != 0) {
+            continue;
+        }
+        if (stopping_) {
+            return;
+        }
+        std::ostringstream out;
+        out.precision(std::numeric_limits<double>::max_digits10);
+        out << "--- state dump (SIGUSR1) ---\n";
+        dump_(out);
+        out << "--- end state dump ---\n";
+        std::cerr << out.str() << std::flush; // Single write keeps the block contiguous
+        ++dumps_;
+    }
+}
+
+#else
+
+StateDumper::StateDumper(DumpFn dump) : dump_(std::move(dump)), stopping_(false), dumps_(0) {}
+
+StateDumper::~StateDumper() {}
+
+void StateDumper::run() {}
+
+#endif
@@ -0,0 +1,163 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+
+// --- Prometheus text exposition helpers ---
+// Writes "# HELP", "# TYPE" and one sample line. `labels` is the raw label set
+// without braces (e.g. `phase="train"`); pass an empty string for none.
+void writeMetricHeader(std::ostream& out, const std::string& name, const std::string& type, const std::string& help);
+void writeMetricSample(std::ostream& out, const std::string& name, double value, const std::string& labels = "");
+void writeMetric(std::ostream& out, const std::string& name, const std::string& type,
+                 const std::string& help, double value);
+
+// Registry of pull-style collectors. Each collector writes one or more metric
+// families when the registry is rendered; values stay owned by the component
+// that produces them (training progress, phase timers, queues...).
+class MetricsRegistry {
+public:
+    using Collector = std::function<void(std::ostream&)>;
+
+    // Process-wide registry used by the CLI
+    static MetricsRegistry& instance();
+
+    size_t add_collector(Collector collector);
+    void remove_collector(size_t id);
+
+    // Full exposition in Prometheus text format
+    std::string render() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::map<size_t, Collector> collectors_;
+    size_t next_id_ = 0;
+};
+
+// Registers a collector for the lifetime of the object, so collectors that
+// capture stack objects are removed before those objects go away.
+class ScopedCollector {
+public:
+    ScopedCollector(MetricsRegistry& registry, MetricsRegistry::Collector collector);
+    ~ScopedCollector();
+
+    ScopedCollector(const ScopedCollector&) = delete;
+    ScopedCollector& operator=(const ScopedCollector&) = delete;
+
+private:
+    MetricsRegistry& registry_;
+    size_t id_;
+};
+
+// Periodically rewrites a file with the registry's exposition. The file is
+// replaced atomically (write to temp + rename) so scrapers never see a partial
+// write; node_exporter's textfile collector can pick it up directly.
+class MetricsFileExporter {
+public:
+    MetricsFileExporter(const std::string& path, int interval_ms, MetricsRegistry& registry);
+    ~MetricsFileExporter(); // Stops the thread and writes a final snapshot
+
+    MetricsFileExporter(const MetricsFileExporter&) = delete;
+    MetricsFileExporter& operator=(const MetricsFileExporter&) = delete;
+
+    // Render and write immediately. Returns false if the file could not be written.
+    bool write_now();
+
+private:
+    void run();
+
+    std::string path_;
+    std::chrono::milliseconds interval_;
+    MetricsRegistry& registry_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    std::thread worker_;
+};
+
+// Accumulated wall time per named phase (parse, train, evaluate, output...).
+// Phases are measured on the request thread and read concurrently by the
+// exporter and the SIGUSR1 dumper.
+class PhaseTimers {
+public:
+    class Scope {
+    public:
+        Scope(PhaseTimers& timers, const std::string& phase);
+        Scope(Scope&& other);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        PhaseTimers* timers_;
+        std::atomic<long long>* slot_;
+        std::chrono::steady_clock::time_point start_;
+        std::string phase_;
+        std::string previous_; // Phase to restore when this scope ends (nesting)
+        std::chrono::steady_clock::time_point previous_start_;
+    };
+
+    // Called with every completed measurement (e.g. to feed latency histograms)
+    using Observer = std::function<void(const std::string& phase, std::chrono::steady_clock::duration elapsed)>;
+
+    // Starts timing `phase` until the returned scope is destroyed
+    Scope measure(const std::string& phase);
+
+    // Install before the first measurement; not synchronized with running scopes
+    void set_observer(Observer observer) { observer_ = std::move(observer); }
+
+    // Name of the phase currently being measured ("idle" if none)
+    std::string current_phase() const;
+    // Accumulated seconds per phase, including the in-progress one
+    std::map<std::string, double> totals_seconds() const;
+
+    void write_metrics(std::ostream& out) const;
+    void dump(std::ostream& out) const;
+
+private:
+    std::atomic<long long>* slot_for(const std::string& phase);
+
+    mutable std::mutex mutex_;
+    std::map<std::string, std::unique_ptr<std::atomic<long long>>> nanos_;
+    std::string current_;
+    std::chrono::steady_clock::time_point current_start_;
+    Observer observer_;
+};
+
+// Dumps process state to stderr whenever SIGUSR1 arrives. The signal is
+// blocked in every thread and consumed by a dedicated sigwait() thread, so the
+// dump runs outside signal context and never interrupts the compute threads.
+// Must be constructed before any worker threads (OpenMP included) are started.
+// On platforms without POSIX signals this is a no-op.
+class StateDumper {
+public:
+    using DumpFn = std::function<void(std::ostream&)>;
+
+    explicit StateDumper(DumpFn dump);
+    ~StateDumper();
+
+    StateDumper(const StateDumper&) = delete;
+    StateDumper& operator=(const StateDumper&) = delete;
+
+    // Number of dumps written so far
+    int dump_count() const { return dumps_.load(); }
+
+private:
+    void run();
+
+    DumpFn dump_;
+    std::atomic<bool> stopping_;
+    std::atomic<int> dumps_;
+    std::thread worker_;
+};
+
+#endif // METRICS_H
@@ -1,8 +1,71 @@
 #include "neural_network.h"
+#include "blas_backend.h"
+#include "vector_expr.h"
 #include <random>       // For random number generation
 #include <stdexcept>    // For exceptions
-#include <algorithm>    // For std::transform
+#include <algorithm>    // For std::shuffle
 #include <numeric>      // For std::inner_product
+#include <chrono>       // For TrainingProgress timestamps
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>       // For the background validator
+
+namespace {
+
+long long steadyNowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// x * 0 is 0 for finite x and NaN for NaN/inf, so a plain sum finds any
+// non-finite value without branches in the loop (it vectorizes)
+bool allFinite(const double* values, size_t n) {
+    double probe = 0.0;
+    #pragma omp simd reduction(+:probe)
+    for (size_t i = 0; i < n; ++i) {
+        probe += values[i] * 0.0;
+    }
+    return probe == 0.0;
+}
+
+double squaredNorm(const SampleVector& values) {
+    double sum = 0.0;
+    for (size_t i = 0; i < values.size(); ++i) {
+        sum += values[i] * values[i];
+    }
+    return sum;
+}
+
+} // namespace
+
+// --- Training Progress ---
+TrainingProgress::TrainingProgress()
+    : epoch(0), total_epochs(0), samples_processed(0),
+      last_loss(std::numeric_limits<double>::quiet_NaN()), started_at_ns(0) {}
+
+TrainingProgress::TrainingProgress(const TrainingProgress& other)
+    : epoch(other.epoch.load()), total_epochs(other.total_epochs.load()),
+      samples_processed(other.samples_processed.load()), last_loss(other.last_loss.load()),
+      started_at_ns(other.started_at_ns.load()) {}
+
+TrainingProgress& TrainingProgress::operator=(const TrainingProgress& other) {
+    epoch = other.epoch.load();
+    total_epochs = other.total_epochs.load();
+    samples_processed = other.samples_processed.load();
+    last_loss = other.last_loss.load();
+    started_at_ns = other.started_at_ns.load();
+    return *this;
+}
+
+double TrainingProgress::elapsed_seconds() const {
+    const long long started = started_at_ns.load(std::memory_order_relaxed);
+    if (started == 0) {
+        return 0.0;
+    }
+    return static_cast<double>(steadyNowNanos() - started) * 1e-9;
+}
 
 // --- Constructor ---
 NeuralNetwork::NeuralNetwork(const std::vector<size_t>& layer_sizes, double learning_rate)
@@ -10,13 +73,20 @@ NeuralNetwork::NeuralNetwork(const std::vector<size_t>& layer_sizes, double lear
     if (layer_sizes_.size() < 2) {
         throw std::invalid_argument("Network must have at least an input and an output layer.");
     }
-    initialize_weights_biases();
+    initialize_weights_biases(std::random_device()());
+}
+
+NeuralNetwork::NeuralNetwork(const std::vector<size_t>& layer_sizes, double learning_rate, unsigned seed)
+    : layer_sizes_(layer_sizes), learning_rate_(learning_rate) {
+    if (layer_sizes_.size() < 2) {
+        throw std::invalid_argument("Network must have at least an input and an output layer.");
+    }
+    initialize_weights_biases(seed);
 }
 
 // --- Weight and Bias Initialization ---
-void NeuralNetwork::initialize_weights_biases() {
-    std::random_device rd;
-    std::mt19937 gen(rd());
+void NeuralNetwork::initialize_weights_biases(unsigned seed) {
+    std::mt19937 gen(seed);
     // He initialization recommended for ReLU, Xavier/Glorot for sigmoid/tanh
     // Using a simple small random range for now
     std::uniform_real_distribution<> dis(-0.5, 0.5); // Distribution for weights
@@ -45,6 +115,40 @@ void NeuralNetwork::initialize_weights_biases() {
     }
 }
 
+size_t NeuralNetwork::parameter_count() const {
+    size_t count = 0;
+    for (size_t i = 0; i + 1 < layer_sizes_.size(); ++i) {
+        count += (layer_sizes_[i] + 1) * layer_sizes_[i + 1];
+    }
+    return count;
+}
+
+void NeuralNetwork::get_parameters(Vector& out) const {
+    out.clear();
+    out.reserve(parameter_count());
+    for (size_t i = 0; i < weights_.size(); ++i) {
+        for (const Vector& row : weights_[i]) {
+            out.insert(out.end(), row.begin(), row.end());
+        }
+        out.insert(out.end(), biases_[i].begin(), biases_[i].end());
+    }
+}
+
+void NeuralNetwork::set_parameters(const Vector& values) {
+    if (values.size() != parameter_count()) {
+        throw std::invalid_argument("Parameter vector size does not match the network.");
+    }
+    const double* next = values.data();
+    for (size_t i = 0; i < weights_.size(); ++i) {
+        for (Vector& row : weights_[i]) {
+            std::copy(next, next + row.size(), row.begin());
+            next += row.size();
+        }
+        std::copy(next, next + biases_[i].size(), biases_[i].begin());
+        next += biases_[i].size();
+    }
+}
+
 // --- Activation Functions ---
 double NeuralNetwork::sigmoid(double x) {
     return 1.0 / (1.0 + std::exp(-x));
@@ -80,111 +184,200 @@ Vector NeuralNetwork::mean_squared_error_derivative(const Vector& predicted, con
 }
 
 
+Vector NeuralNetwork::mean_squared_error_per_output(const double* predicted, const double* target,
+                                                    size_t samples, size_t outputs) {
+    if (samples == 0) {
+        throw std::invalid_argument("Per-output MSE needs at least one sample.");
+    }
+    Vector loss(outputs, 0.0);
+    for (size_t i = 0; i < samples; ++i) {
+        for (size_t k = 0; k < outputs; ++k) {
+            const double error = predicted[i * outputs + k] - target[i * outputs + k];
+            loss[k] += error * error;
+        }
+    }
+    for (double& value : loss) {
+        value /= samples;
+    }
+    return loss;
+}
+
+
 // --- Forward Pass ---
 Vector NeuralNetwork::forward_pass(const Vector& input) {
-    if (input.size() != layer_sizes_[0]) {
+    forward_sample(input.data(), input.size());
+    return layer_outputs_.back().to_vector(); // Final layer's output
+}
+
+void NeuralNetwork::forward_sample(const double* input, size_t input_size) {
+    if (input_size != layer_sizes_[0]) {
         throw std::invalid_argument("Input vector size does not match network input layer size.");
     }
 
-    layer_outputs_.assign(layer_sizes_.size(), Vector());
-    layer_inputs_.assign(layer_sizes_.size() - 1 , Vector()); // No inputs for the input layer itself
+    // resize (not assign) keeps the per-layer buffers, and any heap capacity
+    // of layers wider than SampleVector's inline storage, between samples
+    layer_outputs_.resize(layer_sizes_.size());
+    layer_inputs_.resize(layer_sizes_.size() - 1); // No inputs for the input layer itself
 
-    layer_outputs_[0] = input; // Output of layer 0 is the input itself
+    layer_outputs_[0].assign(input, input_size); // Output of layer 0 is the input itself
+    forward_layers(0);
+}
 
-    Vector current_output = input;
-    size_t num_hidden_layers = layer_sizes_.size() - 2; // Number of layers before the output layer
+void NeuralNetwork::forward_sparse_sample(const SparseRow& input) {
+    if (input.nnz > 0 && input.indices[input.nnz - 1] >= layer_sizes_[0]) {
+        throw std::invalid_argument("Sparse input column exceeds network input layer size.");
+    }
+    layer_outputs_.resize(layer_sizes_.size());
+    layer_inputs_.resize(layer_sizes_.size() - 1);
+    layer_outputs_[0].clear(); // The (possibly huge) dense input is never materialized
+
+    // First layer: z_r = W_0[r] . x + b_r, gathering only the active columns
+    const Matrix& first = weights_[0];
+    layer_inputs_[0].resize(first.size());
+    for (size_t r = 0; r < first.size(); ++r) {
+        layer_inputs_[0][r] = sparseDot(input, first[r].data()) + biases_[0][r];
+    }
+    activate_layer(0);
+    forward_layers(1);
+}
 
+void NeuralNetwork::forward_layers(size_t first_layer) {
     // Process layers
-    for (size_t i = 0; i < layer_sizes_.size() - 1; ++i) { // Iterate through weights/biases
-        // Calculate weighted input: z = W * a_prev + b
-        Vector z = add(multiply(weights_[i], current_output), biases_[i]);
-        layer_inputs_[i] = z; // Store the input *before* activation
-
-        // Calculate activation (sigmoid for hidden, linear for output)
-        current_output.resize(z.size());
-        if (i < num_hidden_layers) { // Apply sigmoid to hidden layers (layers 0 to num_hidden_layers-1)
-             std::transform(z.begin(), z.end(), current_output.begin(), sigmoid);
-        } else { // Apply linear activation (identity) to output layer (layer num_hidden_layers)
-             current_output = z; // a = z
-        }
-       layer_outputs_[i + 1] = current_output; // Store the output *after* activation/identity
+    for (size_t i = first_layer; i < layer_sizes_.size() - 1; ++i) { // Iterate through weights/biases
+        // Calculate weighted input: z = W * a_prev + b, stored *before* activation
+        expr::assign(layer_inputs_[i], expr::lazy(weights_[i]) * expr::lazy(layer_outputs_[i]) + expr::lazy(biases_[i]));
+        activate_layer(i);
     }
+}
 
-    return current_output; // Final layer's output
+void NeuralNetwork::activate_layer(size_t layer) {
+    const size_t num_hidden_layers = layer_sizes_.size() - 2; // Number of layers before the output layer
+    // Calculate activation (sigmoid for hidden, linear for output)
+    if (layer < num_hidden_layers) { // Apply sigmoid to hidden layers (layers 0 to num_hidden_layers-1)
+        expr::assign(layer_outputs_[layer + 1], expr::apply(expr::lazy(layer_inputs_[layer]), sigmoid));
+    } else { // Apply linear activation (identity) to output layer (layer num_hidden_layers)
+        layer_outputs_[layer + 1] = layer_inputs_[layer]; // a = z
+    }
 }
 
 // --- Prediction ---
 Vector NeuralNetwork::predict(const Vector& input) {
+    SampleVector output;
+    predict_into(input.data(), input.size(), output);
+    return output.to_vector();
+}
+
+void NeuralNetwork::predict_into(const double* input, size_t input_size, SampleVector& output) {
     // Forward pass without storing intermediate values for training
-    if (input.size() != layer_sizes_[0]) {
+    if (input_size != layer_sizes_[0]) {
         throw std::invalid_argument("Input vector size does not match network input layer size.");
     }
 
-    Vector current_output = input;
+    // Two buffers swapped per layer; activation is fused into the W * a + b loop.
+    // Both live on the stack for layers up to SampleVector's inline capacity.
+    SampleVector current_output(input, input_size);
+    SampleVector next_output;
     size_t num_layers = layer_sizes_.size();
     for (size_t i = 0; i < num_layers - 1; ++i) {
-        Vector z = add(multiply(weights_[i], current_output), biases_[i]);
-        current_output.resize(z.size());
+        auto z = expr::lazy(weights_[i]) * expr::lazy(current_output) + expr::lazy(biases_[i]);
         if (i < num_layers - 2) { // Apply sigmoid to hidden layers
-             std::transform(z.begin(), z.end(), current_output.begin(), sigmoid);
+            expr::assign(next_output, expr::apply(z, sigmoid));
         } else { // Apply linear activation (identity) to output layer
-             current_output = z; // a = z
+            expr::assign(next_output, z); // a = z
         }
+        std::swap(current_output, next_output);
     }
-    return current_output;
+    output = std::move(current_output);
 }
 
 
 // --- Backpropagation ---
 void NeuralNetwork::backpropagate(const Vector& input, const Vector& target) {
+    backpropagate_sample(input.data(), input.size(), target.data(), target.size());
+}
+
+void NeuralNetwork::backpropagate_sample(const double* input, size_t input_size,
+                                         const double* target, size_t target_size) {
     // 1. Perform forward pass to get activations and pre-activation inputs
-    Vector predicted_output = forward_pass(input); // This also populates layer_outputs_ and layer_inputs_
+    forward_sample(input, input_size); // Populates layer_outputs_ and layer_inputs_
+    backpropagate_from_forward(target, target_size, nullptr);
+}
 
-    if (target.size() != layer_sizes_.back()) {
+void NeuralNetwork::backpropagate_from_forward(const double* target, size_t target_size,
+                                               const SparseRow* sparse_input) {
+    if (target_size != layer_sizes_.back()) {
         throw std::invalid_argument("Target vector size does not match network output layer size.");
     }
 
     size_t num_layers = layer_sizes_.size();
-    std::vector<Vector> deltas(num_layers - 1); // Error deltas for each layer (excluding input)
+    deltas_.resize(num_layers - 1); // Error deltas for each layer (excluding input)
 
     // 2. Calculate delta for the output layer (L)
     // delta_L = (output_L - target) * derivative_of_activation(z_L)
-    Vector error_derivative = mean_squared_error_derivative(predicted_output, target);
-    Vector last_layer_input = layer_inputs_.back(); // z_L
-
     // For linear output activation, the derivative is 1
-    deltas.back() = error_derivative; // delta_L = (output_L - target) * 1
+    expr::assign(deltas_.back(), expr::lazy(layer_outputs_.back()) - expr::VecRef(target, target_size));
 
     // 3. Propagate deltas backwards from L-1 to layer 1
+    const BlasBackend& blas = activeBlasBackend();
     for (int i = num_layers - 2; i > 0; --i) { // Note: int for loop condition
         // delta_l = (W_{l+1}^T * delta_{l+1}) * sigmoid_derivative(z_l)
-        Matrix W_T = transpose(weights_[i]); // Transpose weights of the layer *ahead*
-        Vector propagated_delta = multiply(W_T, deltas[i]); // W^T * delta_next
-
-        Vector layer_input = layer_inputs_[i-1]; // z_l is stored at index i-1
-        Vector sigmoid_deriv_hidden(layer_input.size());
-        std::transform(layer_input.begin(), layer_input.end(), sigmoid_deriv_hidden.begin(), sigmoid_derivative);
+        const Matrix& weights = weights_[i];
+        propagated_delta_.clear();
+        propagated_delta_.resize(weights[0].size()); // W^T * delta_next, accumulated row by row
+        for (size_t r = 0; r < weights.size(); ++r) {
+            blas.axpy(propagated_delta_.size(), deltas_[i][r], weights[r].data(), propagated_delta_.data());
+        }
 
-        deltas[i - 1] = elementwise_multiply(propagated_delta, sigmoid_deriv_hidden);
+        // z_l is stored at index i-1; sigmoid' and the Hadamard product run in one loop
+        expr::assign(deltas_[i - 1],
+                     expr::lazy(propagated_delta_) * expr::apply(expr::lazy(layer_inputs_[i - 1]), sigmoid_derivative));
     }
 
     // 4. Update weights and biases using calculated deltas
+    // grad_W_l = delta_l * a_{l-1}^T and grad_b_l = delta_l, applied in place
+    // one row at a time: W[r] -= learning_rate * delta_l[r] * a_{l-1}
     for (size_t i = 0; i < num_layers - 1; ++i) {
-        const Vector& current_delta = deltas[i];
-        const Vector& prev_layer_output = layer_outputs_[i]; // Activation from the previous layer
+        const SampleVector& current_delta = deltas_[i];
+        const SampleVector& prev_layer_output = layer_outputs_[i]; // Activation from the previous layer
+        Matrix& weights = weights_[i];
+        if (i == 0 && sparse_input) {
+            // Only the columns of active input features have a non-zero gradient
+            for (size_t r = 0; r < weights.size(); ++r) {
+                sparseAxpy(-learning_rate_ * current_delta[r], *sparse_input, weights[r].data());
+            }
+        } else {
+            for (size_t r = 0; r < weights.size(); ++r) {
+                blas.axpy(prev_layer_output.size(), -learning_rate_ * current_delta[r],
+                          prev_layer_output.data(), weights[r].data());
+            }
+        }
+        blas.axpy(current_delta.size(), -learning_rate_, current_delta.data(), biases_[i].data());
+    }
+}
 
-        // Calculate gradients
-        // grad_W_l = delta_l * a_{l-1}^T
-        Matrix grad_W = outer_product(current_delta, prev_layer_output);
-        // grad_b_l = delta_l
-        Vector grad_b = current_delta; // Bias gradient is just the delta
 
-        // Update weights: W = W - learning_rate * grad_W
-        weights_[i] = subtract(weights_[i], multiply(grad_W, learning_rate_));
+double NeuralNetwork::last_gradient_norm_squared() const {
+    // Layer i's weight gradient delta_i a_i^T has Frobenius norm |delta_i| |a_i|;
+    // its bias gradient is delta_i itself
+    double sum = 0.0;
+    for (size_t i = 0; i < deltas_.size(); ++i) {
+        sum += squaredNorm(deltas_[i]) * (1.0 + squaredNorm(layer_outputs_[i]));
+    }
+    return sum;
+}
 
-        // Update biases: b = b - learning_rate * grad_b
-        biases_[i] = subtract(biases_[i], multiply(grad_b, learning_rate_));
+bool NeuralNetwork::parameters_finite() const {
+    for (size_t i = 0; i < weights_.size(); ++i) {
+        for (const Vector& row : weights_[i]) {
+            if (!allFinite(row.data(), row.size())) {
+                return false;
+            }
+        }
+        if (!allFinite(biases_[i].data(), biases_[i].size())) {
+            return false;
+        }
     }
+    return true;
 }
 
 
@@ -196,6 +389,59 @@ void NeuralNetwork::train(const Vector& input, const Vector& target) {
     // or call this multiple times within an epoch loop.
 }
 
+void NeuralNetwork::train(const double* input, size_t input_size, const double* target, size_t target_size) {
+    backpropagate_sample(input, input_size, target, target_size);
+}
+
+Vector NeuralNetwork::predict_sparse(const SparseRow& input) {
+    forward_sparse_sample(input);
+    return layer_outputs_.back().to_vector();
+}
+
+void NeuralNetwork::train_sparse(const SparseRow& input, const Vector& target) {
+    forward_sparse_sample(input);
+    backpropagate_from_forward(target.data(), target.size(), &input);
+}
+
+
+// --- Learning-rate range test ---
+LrRangeTestResult NeuralNetwork::lr_find(const std::vector<Vector>& inputs, const std::vector<Vector>& targets,
+                                         const LrRangeTestOptions& options) const {
+    if (inputs.size() != targets.size()) {
+        throw std::invalid_argument("Input and target datasets must be non-empty and have the same size.");
+    }
+    return lr_find_samples(inputs.data(), targets.data(), inputs.size(), options);
+}
+
+LrRangeTestResult NeuralNetwork::lr_find(const SampleVector* inputs, const SampleVector* targets, size_t count,
+                                         const LrRangeTestOptions& options) const {
+    return lr_find_samples(inputs, targets, count, options);
+}
+
+template <typename Sample>
+LrRangeTestResult NeuralNetwork::lr_find_samples(const Sample* inputs, const Sample* targets, size_t n_samples,
+                                                 const LrRangeTestOptions& options) const {
+    if (n_samples == 0) {
+        throw std::invalid_argument("Input and target datasets must be non-empty and have the same size.");
+    }
+    NeuralNetwork probe(*this);
+    const std::vector<size_t> subsample = rangeTestSubsample(n_samples, options);
+    const size_t batch = std::max<size_t>(1, options.batch_size);
+    size_t next = 0;
+    // The batch loss is each sample's error just before its own SGD update
+    return runLrRangeTest([&](double learning_rate) {
+        probe.learning_rate_ = learning_rate;
+        double loss = 0.0;
+        for (size_t b = 0; b < batch; ++b) {
+            const size_t idx = subsample[next];
+            next = (next + 1) % subsample.size();
+            probe.backpropagate_sample(inputs[idx].data(), inputs[idx].size(), targets[idx].data(), targets[idx].size());
+            loss += squaredNorm(probe.deltas_.back());
+        }
+        return loss / static_cast<double>(batch * layer_sizes_.back());
+    }, options);
+}
+
 
 // --- Train for multiple epochs with reporting ---
 Vector NeuralNetwork::train_for_epochs(
@@ -204,56 +450,415 @@ Vector NeuralNetwork::train_for_epochs(
     int epochs,
     int report_every_n_epochs
 ) {
-    if (inputs.empty() || inputs.size() != targets.size()) {
+    if (inputs.size() != targets.size()) {
         throw std::invalid_argument("Input and target datasets must be non-empty and have the same size.");
     }
+    return train_samples_for_epochs(inputs.data(), targets.data(), inputs.size(), epochs, report_every_n_epochs);
+}
+
+Vector NeuralNetwork::train_for_epochs(
+    const std::vector<SampleVector>& inputs,
+    const std::vector<SampleVector>& targets,
+    int epochs,
+    int report_every_n_epochs
+) {
+    if (inputs.size() != targets.size()) {
+        throw std::invalid_argument("Input and target datasets must be non-empty and have the same size.");
+    }
+    return train_samples_for_epochs(inputs.data(), targets.data(), inputs.size(), epochs, report_every_n_epochs);
+}
+
+Vector NeuralNetwork::train_for_epochs(
+    const SampleVector* inputs,
+    const SampleVector* targets,
+    size_t count,
+    int epochs,
+    int report_every_n_epochs
+) {
+    return train_samples_for_epochs(inputs, targets, count, epochs, report_every_n_epochs);
+}
+
+namespace {
+
+// Scores weight snapshots on the held-out samples on a thread of its own, so
+// the training thread only pays for copying the parameters. It keeps one
+// pending snapshot: publishing while the previous one is still waiting
+// replaces it, so a slow validator never queues up stale work.
+template <typename Sample>
+class SnapshotValidator {
+public:
+    SnapshotValidator(const NeuralNetwork& network, const Sample* inputs, const Sample* targets,
+                      const size_t* indices, size_t count, int patience, double min_improvement)
+        : network_(network), inputs_(inputs), targets_(targets), indices_(indices), count_(count),
+          patience_(patience), min_improvement_(min_improvement), stop_(false),
+          thread_(&SnapshotValidator::run, this) {}
+
+    ~SnapshotValidator() { join(); }
+
+    void publish(const NeuralNetwork& network, int epoch) {
+        network.get_parameters(scratch_); // Outside the lock: the validator never touches the live network
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (has_pending_) {
+                ++dropped_;
+            }
+            pending_.swap(scratch_);
+            pending_epoch_ = epoch;
+            has_pending_ = true;
+        }
+        ready_.notify_one();
+    }
+
+    // Patience ran out (or scoring failed)
+    bool should_stop() const { return stop_.load(std::memory_order_relaxed); }
+
+    // Scores whatever is still pending, stops the thread and rethrows its error
+    void finish() {
+        join();
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+    }
+
+    int evaluations() const { return evaluations_; }
+    int dropped() const { return dropped_; }
+    bool has_best() const { return best_evaluation_ > 0; }
+    double best_mse() const { return best_mse_; }
+    int best_epoch() const { return best_epoch_; }
+    const Vector& best_parameters() const { return best_parameters_; }
+    bool best_is_last() const { return best_evaluation_ == evaluations_; }
+    double last_mse() const { return last_mse_; }
+
+private:
+    void join() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            done_ = true;
+        }
+        ready_.notify_one();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            ready_.wait(lock, [this] { return has_pending_ || done_; });
+            if (!has_pending_) {
+                return;
+            }
+            current_.swap(pending_);
+            const int epoch = pending_epoch_;
+            has_pending_ = false;
+            lock.unlock();
+            try {
+                score(epoch);
+            } catch (...) {
+                error_ = std::current_exception();
+                stop_.store(true);
+                return;
+            }
+            lock.lock();
+        }
+    }
+
+    void score(int epoch) {
+        network_.set_parameters(current_);
+        double mse = 0.0;
+        SampleVector prediction;
+        for (size_t i = 0; i < count_; ++i) {
+            const size_t idx = indices_[i];
+            network_.predict_into(inputs_[idx].data(), inputs_[idx].size(), prediction);
+            if (prediction.size() != targets_[idx].size()) {
+                throw std::invalid_argument("Predicted and target vectors must have the same size for MSE.");
+            }
+            double sum_sq_error = 0.0;
+            for (size_t k = 0; k < prediction.size(); ++k) {
+                const double error = prediction[k] - targets_[idx][k];
+                sum_sq_error += error * error;
+            }
+            mse += sum_sq_error / prediction.size();
+        }
+        mse /= count_;
+
+        ++evaluations_;
+        last_mse_ = mse;
+        if (std::isfinite(mse) && (!has_best() || mse < best_mse_ * (1.0 - min_improvement_))) {
+            best_mse_ = mse;
+            best_epoch_ = epoch;
+            best_evaluation_ = evaluations_;
+            best_parameters_ = current_;
+        } else if (patience_ > 0 && evaluations_ - best_evaluation_ >= patience_) {
+            stop_.store(true);
+        }
+    }
+
+    NeuralNetwork network_; // Private copy the snapshots are loaded into
+    const Sample* inputs_;
+    const Sample* targets_;
+    const size_t* indices_;
+    size_t count_;
+    int patience_;
+    double min_improvement_;
+
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    Vector pending_;         // Guarded by mutex_
+    int pending_epoch_ = 0;  // Guarded by mutex_
+    bool has_pending_ = false;
+    bool done_ = false;
+    int dropped_ = 0;
+    Vector scratch_;         // Training thread only
+
+    // Validator thread only (read by the training thread after join)
+    Vector current_;
+    int evaluations_ = 0;
+    double last_mse_ = std::numeric_limits<double>::quiet_NaN();
+    double best_mse_ = std::numeric_limits<double>::quiet_NaN();
+    int best_epoch_ = 0;
+    int best_evaluation_ = 0;
+    Vector best_parameters_;
+    std::exception_ptr error_;
+
+    std::atomic<bool> stop_;
+    std::thread thread_; // Last: starts once everything above is initialized
+};
+
+} // namespace
+
+// Shared by all sample containers; Sample needs data() and size()
+template <typename Sample>
+Vector NeuralNetwork::train_samples_for_epochs(
+    const Sample* inputs,
+    const Sample* targets,
+    size_t n_samples,
+    int epochs,
+    int report_every_n_epochs
+) {
+    if (n_samples == 0) {
+        throw std::invalid_argument("Input and target datasets must be non-empty and have the same size.");
+    }
+
+    const double validation_fraction = training_options_.validation_fraction;
+    if (!(validation_fraction >= 0.0 && validation_fraction < 1.0)) {
+        throw std::invalid_argument("Validation fraction must be in [0, 1).");
+    }
 
-    size_t n_samples = inputs.size();
     std::vector<size_t> indices(n_samples);
     std::iota(indices.begin(), indices.end(), 0);
+    // Held-out split: indices [0, n_train) train, the rest validate. The
+    // samples themselves stay where they are.
+    size_t n_train = n_samples;
+    if (validation_fraction > 0.0) {
+        if (n_samples < 2) {
+            throw std::invalid_argument("Held-out validation needs at least two samples.");
+        }
+        std::mt19937 split(training_options_.validation_seed);
+        std::shuffle(indices.begin(), indices.end(), split);
+        const size_t n_validation = std::min(
+            n_samples - 1, std::max<size_t>(1, static_cast<size_t>(validation_fraction * n_samples)));
+        n_train = n_samples - n_validation;
+    }
 
     std::random_device rd;
     std::mt19937 gen(rd());
 
     Vector final_predictions;
-    final_predictions.reserve(n_samples);
+    final_predictions.reserve(n_samples * layer_sizes_.back());
+
+    progress_.epoch.store(0);
+    progress_.total_epochs.store(epochs);
+    progress_.samples_processed.store(0);
+    progress_.last_loss.store(std::numeric_limits<double>::quiet_NaN());
+    progress_.started_at_ns.store(steadyNowNanos());
+
+    const std::atomic<bool>* cancel = training_options_.cancel;
+    // Divergence monitor state: the weights after the last healthy epoch
+    const bool monitor = training_options_.stop_on_divergence;
+    training_outcome_ = TrainingOutcome();
+    std::vector<Matrix> healthy_weights;
+    std::vector<Vector> healthy_biases;
+    if (monitor) {
+        healthy_weights = weights_;
+        healthy_biases = biases_;
+    }
+    // Loss explosion is measured against the untrained loss: SGD's running loss
+    // is noisy near a minimum, but a healthy run never ends up far above where
+    // it started. The running loss only grows within an epoch, so its sum is
+    // checked against the limit after every sample.
+    double loss_sum_limit = std::numeric_limits<double>::infinity();
+    if (monitor) {
+        double initial_loss_sum = 0.0;
+        SampleVector prediction;
+        for (size_t i = 0; i < n_train; ++i) {
+            const size_t idx = indices[i];
+            predict_into(inputs[idx].data(), inputs[idx].size(), prediction);
+            for (size_t k = 0; k < prediction.size() && k < targets[idx].size(); ++k) {
+                const double error = prediction[k] - targets[idx][k];
+                initial_loss_sum += error * error;
+            }
+        }
+        if (initial_loss_sum > 0.0) {
+            loss_sum_limit = training_options_.divergence_factor * initial_loss_sum;
+        }
+    }
+
+    std::unique_ptr<SnapshotValidator<Sample>> validator;
+    if (n_train < n_samples) {
+        validator.reset(new SnapshotValidator<Sample>(*this, inputs, targets, indices.data() + n_train,
+                                                      n_samples - n_train, training_options_.patience,
+                                                      training_options_.min_improvement));
+    }
+    const int validate_every = std::max(1, training_options_.validation_every_n_epochs);
+    int published_epoch = 0;
 
     for (int epoch = 0; epoch < epochs; ++epoch) {
         // Shuffle data for stochasticity (optional but often good)
-        std::shuffle(indices.begin(), indices.end(), gen);
+        std::shuffle(indices.begin(), indices.begin() + n_train, gen);
 
         // Train on each sample in the (shuffled) dataset
-        for (size_t i = 0; i < n_samples; ++i) {
+        const char* divergence = nullptr;
+        bool cancelled = false;
+        double epoch_loss = 0.0; // Running loss sum: each sample's error just before its update
+        for (size_t i = 0; i < n_train; ++i) {
+            if (cancel && (i & 63) == 0 && cancel->load(std::memory_order_relaxed)) {
+                cancelled = true;
+                break;
+            }
             size_t idx = indices[i];
             // Simple stochastic gradient descent (one sample at a time)
-            backpropagate(inputs[idx], targets[idx]);
+            backpropagate_sample(inputs[idx].data(), inputs[idx].size(), targets[idx].data(), targets[idx].size());
             // Note: For larger datasets, mini-batch gradient descent is more common
+            if (monitor) {
+                // Stop at the first NaN/inf instead of pushing it through the rest of the epoch
+                const double sample_loss = squaredNorm(deltas_.back());
+                const double gradient_norm = std::sqrt(last_gradient_norm_squared());
+                if (!std::isfinite(sample_loss + gradient_norm)) {
+                    divergence = "non-finite gradient";
+                    break;
+                }
+                epoch_loss += sample_loss;
+                training_outcome_.max_gradient_norm = std::max(training_outcome_.max_gradient_norm, gradient_norm);
+                if (epoch_loss > loss_sum_limit) {
+                    divergence = "loss explosion";
+                    break;
+                }
+            }
+        }
+        if (cancelled) {
+            // Mid-epoch weights are kept unless they are not finite
+            if (monitor && !parameters_finite()) {
+                weights_ = healthy_weights;
+                biases_ = healthy_biases;
+            }
+            training_outcome_.stopped_reason = "cancelled";
+            training_outcome_.stopped_epoch = epoch + 1;
+            break;
         }
+        if (monitor && !divergence) {
+            // Weights can overflow without the samples seen so far showing it
+            if (!parameters_finite()) {
+                divergence = "non-finite weights";
+            }
+        }
+        if (divergence) {
+            weights_ = healthy_weights;
+            biases_ = healthy_biases;
+            if (training_outcome_.rollbacks < training_options_.max_rollbacks) {
+                ++training_outcome_.rollbacks;
+                learning_rate_ *= training_options_.rollback_backoff;
+                --epoch; // Retry the epoch from the restored weights
+                continue;
+            }
+            training_outcome_.stopped_reason = "diverged";
+            training_outcome_.stopped_epoch = epoch + 1;
+            training_outcome_.divergence = divergence;
+            break;
+        }
+        if (monitor) {
+            healthy_weights = weights_;
+            healthy_biases = biases_;
+        }
+        progress_.samples_processed.fetch_add(n_train, std::memory_order_relaxed);
+        progress_.epoch.store(epoch + 1, std::memory_order_relaxed);
 
-        // Report loss periodically
-        if ((epoch + 1) % report_every_n_epochs == 0 || epoch == epochs - 1) {
+        // Report loss periodically (and check it against the target every epoch)
+        const bool report = report_every_n_epochs > 0 &&
+                            ((epoch + 1) % report_every_n_epochs == 0 || epoch == epochs - 1);
+        if (report || training_options_.target_mse > 0.0) {
             double current_mse = 0.0;
-            // Calculate MSE over the *entire* dataset
-            for (size_t i = 0; i < n_samples; ++i) {
+            // Calculate MSE over the *entire* training set
+            SampleVector prediction;
+            for (size_t i = 0; i < n_train; ++i) {
+                const size_t idx = indices[i];
                  // Use predict, not forward_pass, as we don't need intermediate state here
-                Vector prediction = predict(inputs[i]);
-                current_mse += mean_squared_error(prediction, targets[i]);
+                predict_into(inputs[idx].data(), inputs[idx].size(), prediction);
+                if (prediction.size() != targets[idx].size()) {
+                    throw std::invalid_argument("Predicted and target vectors must have the same size for MSE.");
+                }
+                double sum_sq_error = 0.0;
+                for (size_t k = 0; k < prediction.size(); ++k) {
+                    const double error = prediction[k] - targets[idx][k];
+                    sum_sq_error += error * error;
+                }
+                current_mse += sum_sq_error / prediction.size();
+            }
+            current_mse /= n_train;
+            progress_.last_loss.store(current_mse, std::memory_order_relaxed);
+            if (report) {
+                std::cout << "epoch=" << (epoch + 1) << ",mse=" << current_mse << std::endl;
+            }
+            if (training_options_.target_mse > 0.0 && current_mse <= training_options_.target_mse) {
+                training_outcome_.stopped_reason = "target reached";
+                training_outcome_.stopped_epoch = epoch + 1;
+                break;
+            }
+        }
+
+        if (validator) {
+            if ((epoch + 1) % validate_every == 0) {
+                validator->publish(*this, epoch + 1);
+                published_epoch = epoch + 1;
+            }
+            // The verdict on an earlier snapshot may arrive an epoch or two late
+            if (validator->should_stop()) {
+                training_outcome_.stopped_reason = "early stopped";
+                training_outcome_.stopped_epoch = epoch + 1;
+                break;
+            }
+        }
+    }
+
+    training_outcome_.learning_rate = learning_rate_;
+
+    if (validator) {
+        // Score the weights training ended with too, then wait for the validator
+        const int completed = progress_.epoch.load();
+        if (published_epoch != completed || training_outcome_.stopped_reason == "cancelled") {
+            validator->publish(*this, completed);
+        }
+        validator->finish();
+        training_outcome_.validation_samples = n_samples - n_train;
+        training_outcome_.validation_evaluations = validator->evaluations();
+        training_outcome_.validation_snapshots_dropped = validator->dropped();
+        training_outcome_.final_validation_mse = validator->last_mse();
+        if (validator->has_best()) {
+            training_outcome_.best_validation_mse = validator->best_mse();
+            training_outcome_.best_validation_epoch = validator->best_epoch();
+            if (training_options_.restore_best && !validator->best_is_last()) {
+                set_parameters(validator->best_parameters());
+                training_outcome_.restored_best = true;
             }
-            current_mse /= n_samples;
-            std::cout << "epoch=" << (epoch + 1) << ",mse=" << current_mse << std::endl;
         }
     }
 
     // After training, calculate final predictions for the entire input set
     final_predictions.clear();
-    for(const auto& input : inputs) {
-        Vector prediction = predict(input);
-        // Assuming single output neuron for simplicity based on frontend
-        if (!prediction.empty()) {
-            final_predictions.push_back(prediction[0]);
-        } else {
-            final_predictions.push_back(NAN); // Indicate error if prediction failed
-        }
+    SampleVector prediction;
+    for (size_t i = 0; i < n_samples; ++i) {
+        predict_into(inputs[i].data(), inputs[i].size(), prediction);
+        final_predictions.insert(final_predictions.end(), prediction.data(), prediction.data() + prediction.size());
     }
 
     return final_predictions;
@@ -267,47 +872,38 @@ Vector NeuralNetwork::multiply(const Matrix& matrix, const Vector& vector) {
     if (matrix.empty() || matrix[0].size() != vector.size()) {
         throw std::invalid_argument("Matrix columns must match vector size for multiplication.");
     }
-    size_t rows = matrix.size();
-    size_t cols = matrix[0].size();
-    Vector result(rows, 0.0);
-    for (size_t i = 0; i < rows; ++i) {
-        for (size_t j = 0; j < cols; ++j) {
-            result[i] += matrix[i][j] * vector[j];
-        }
-        // Alternative using inner_product:
-        // result[i] = std::inner_product(matrix[i].begin(), matrix[i].end(), vector.begin(), 0.0);
+    return expr::evaluate(expr::lazy(matrix) * expr::lazy(vector));
+}
+
+// Matrix^T * Vector, without materializing the transpose
+Vector NeuralNetwork::multiply_transposed(const Matrix& matrix, const Vector& vector) {
+    if (matrix.size() != vector.size()) {
+        throw std::invalid_argument("Matrix rows must match vector size for transposed multiplication.");
+    }
+    if (matrix.empty()) {
+        return Vector();
+    }
+    const BlasBackend& blas = activeBlasBackend();
+    Vector result(matrix[0].size(), 0.0);
+    for (size_t i = 0; i < matrix.size(); ++i) {
+        blas.axpy(result.size(), vector[i], matrix[i].data(), result.data());
     }
     return result;
 }
 
 // Vector + Vector
 Vector NeuralNetwork::add(const Vector& vec1, const Vector& vec2) {
-    if (vec1.size() != vec2.size()) {
-        throw std::invalid_argument("Vectors must have the same size for addition.");
-    }
-    Vector result(vec1.size());
-    std::transform(vec1.begin(), vec1.end(), vec2.begin(), result.begin(), std::plus<double>());
-    return result;
+    return expr::evaluate(expr::lazy(vec1) + expr::lazy(vec2));
 }
 
 // Vector - Vector
 Vector NeuralNetwork::subtract(const Vector& vec1, const Vector& vec2) {
-    if (vec1.size() != vec2.size()) {
-        throw std::invalid_argument("Vectors must have the same size for subtraction.");
-    }
-    Vector result(vec1.size());
-    std::transform(vec1.begin(), vec1.end(), vec2.begin(), result.begin(), std::minus<double>());
-    return result;
+    return expr::evaluate(expr::lazy(vec1) - expr::lazy(vec2));
 }
 
 // Vector .* Vector (Element-wise multiplication)
 Vector NeuralNetwork::elementwise_multiply(const Vector& vec1, const Vector& vec2) {
-    if (vec1.size() != vec2.size()) {
-        throw std::invalid_argument("Vectors must have the same size for element-wise multiplication.");
-    }
-    Vector result(vec1.size());
-    std::transform(vec1.begin(), vec1.end(), vec2.begin(), result.begin(), std::multiplies<double>());
-    return result;
+    return expr::evaluate(expr::lazy(vec1) * expr::lazy(vec2));
 }
 
 // Matrix Transpose
@@ -341,10 +937,9 @@ Matrix NeuralNetwork::outer_product(const Vector& vec1, const Vector& vec2) {
 
 // Matrix * Scalar
 Matrix NeuralNetwork::multiply(const Matrix& mat, double scalar) {
-    Matrix result = mat; // Copy
-    for (auto& row : result) {
-        std::transform(row.begin(), row.end(), row.begin(),
-                       [scalar](double val){ return val * scalar; });
+    Matrix result(mat.size());
+    for (size_t i = 0; i < mat.size(); ++i) {
+        expr::assign(result[i], scalar * expr::lazy(mat[i]));
     }
     return result;
 }
@@ -354,17 +949,14 @@ Matrix NeuralNetwork::subtract(const Matrix& mat1, const Matrix& mat2) {
      if (mat1.size() != mat2.size() || (!mat1.empty() && mat1[0].size() != mat2[0].size())) {
         throw std::invalid_argument("Matrices must have the same dimensions for subtraction.");
     }
-    Matrix result = mat1; // Copy
-    for (size_t i = 0; i < result.size(); ++i) {
-         std::transform(result[i].begin(), result[i].end(), mat2[i].begin(), result[i].begin(), std::minus<double>());
+    Matrix result(mat1.size());
+    for (size_t i = 0; i < mat1.size(); ++i) {
+        expr::assign(result[i], expr::lazy(mat1[i]) - expr::lazy(mat2[i]));
     }
     return result;
 }
 
 // Vector * Scalar
 Vector NeuralNetwork::multiply(const Vector& vec, double scalar) {
-    Vector result = vec; // Copy
-    std::transform(result.begin(), result.end(), result.begin(),
-                   [scalar](double val){ return val * scalar; });
-    return result;
+    return expr::evaluate(scalar * expr::lazy(vec));
 }
\ No newline at end of file
@@ -6,31 +6,169 @@
 #include <random>
 #include <stdexcept> // For exceptions
 #include <iostream>  // For potential debugging output
+#include <atomic>    // For TrainingProgress counters
+#include <limits>
+#include <string>
+
+#include "inline_vector.h"
+#include "lr_finder.h"
+#include "sparse.h"
 
 // Define a type alias for matrices (vector of vectors)
 using Matrix = std::vector<std::vector<double>>;
 using Vector = std::vector<double>;
+// Per-sample data (single inputs/targets, layer activations): stays inside the
+// object, i.e. on the stack or inline in its container, for up to 8 elements
+using SampleVector = InlineVector<8>;
+
+// Live counters published by train_for_epochs. Every field is atomic so that
+// metrics exporters and the SIGUSR1 dumper can read them from other threads
+// while training runs. Copying a network copies the current values.
+struct TrainingProgress {
+    std::atomic<int> epoch;                       // Epochs completed so far
+    std::atomic<int> total_epochs;                // Epochs requested for the current run
+    std::atomic<unsigned long long> samples_processed;
+    std::atomic<double> last_loss;                // Most recent reported MSE (NaN before the first report)
+    std::atomic<long long> started_at_ns;         // steady_clock time the run started (0 if never)
+
+    TrainingProgress();
+    TrainingProgress(const TrainingProgress& other);
+    TrainingProgress& operator=(const TrainingProgress& other);
+
+    // Seconds since the current run started (0 if no run started)
+    double elapsed_seconds() const;
+};
+
+// Options read by train_for_epochs (see NeuralNetwork::set_training_options)
+struct TrainingOptions {
+    // Divergence monitor: every sample's loss and gradient norm are checked for
+    // NaN/inf and the epoch's running loss against the untrained loss, and
+    // after every epoch the weights are scanned. A diverged run restores the
+    // weights of the last healthy epoch and stops, or, while max_rollbacks
+    // allows, retries that epoch with learning_rate * rollback_backoff.
+    bool stop_on_divergence = true;
+    double divergence_factor = 100.0; // Loss explosion: running epoch loss above this multiple of the untrained loss
+    int max_rollbacks = 0;
+    double rollback_backoff = 0.1;
+    // > 0: the MSE is evaluated after every epoch and training stops at the
+    // first epoch that reaches it
+    double target_mse = 0.0;
+    // Cooperative cancellation: another thread sets the flag and training
+    // stops within 64 samples, keeping the weights it has (null = never)
+    const std::atomic<bool>* cancel = nullptr;
+
+    // Held-out validation: validation_fraction of the samples (drawn with
+    // validation_seed and kept as indices, nothing is copied) is left out of
+    // training. Every validation_every_n_epochs epochs the training thread
+    // publishes a copy of the weights and carries on; a background thread
+    // scores the newest snapshot on the held-out samples (older unscored
+    // ones are dropped). After `patience` scores without a relative
+    // improvement of min_improvement training stops early, and with
+    // restore_best the network ends with the best-scoring snapshot.
+    double validation_fraction = 0.0;
+    int validation_every_n_epochs = 1;
+    int patience = 0; // 0 = never stop early
+    double min_improvement = 0.0;
+    bool restore_best = true;
+    unsigned validation_seed = 42;
+};
+
+// How the last train_for_epochs run ended
+struct TrainingOutcome {
+    std::string stopped_reason = "completed"; // "completed", "diverged", "target reached", "cancelled" or "early stopped"
+    int stopped_epoch = 0;                    // 1-based epoch in which training stopped early
+    std::string divergence = "";              // "non-finite gradient", "non-finite weights" or "loss explosion"
+    int rollbacks = 0;
+    double learning_rate = 0.0;               // After any rollbacks
+    double max_gradient_norm = 0.0;           // Largest per-sample gradient L2 norm seen
+
+    // Held-out validation (TrainingOptions::validation_fraction > 0)
+    size_t validation_samples = 0;
+    int validation_evaluations = 0;
+    int validation_snapshots_dropped = 0;     // Replaced by a newer one before they were scored
+    double best_validation_mse = std::numeric_limits<double>::quiet_NaN();
+    int best_validation_epoch = 0;
+    double final_validation_mse = std::numeric_limits<double>::quiet_NaN(); // Of the last snapshot
+    bool restored_best = false;               // The network holds the best snapshot, not the last
+};
 
 class NeuralNetwork {
 public:
     // Constructor: specifies the number of neurons in each layer (including input and output)
     // Example: {2, 3, 1} means 2 input neurons, 3 hidden neurons, 1 output neuron
     NeuralNetwork(const std::vector<size_t>& layer_sizes, double learning_rate = 0.01);
+    // Same, with reproducible initial weights drawn from `seed`
+    NeuralNetwork(const std::vector<size_t>& layer_sizes, double learning_rate, unsigned seed);
 
     // Predict the output for a given input vector
     Vector predict(const Vector& input);
 
+    // Allocation-free variant of predict for the per-sample hot paths: reuses
+    // `output` and keeps intermediate layers up to 8 wide on the stack
+    void predict_into(const double* input, size_t input_size, SampleVector& output);
+
     // Train the network on a single data point (input and target output)
     void train(const Vector& input, const Vector& target);
-
-    // Train the network over multiple epochs with periodic loss reporting
+    void train(const double* input, size_t input_size, const double* target, size_t target_size);
+
+    // Sparse inputs (e.g. CsrMatrix rows of hashed one-hot features): the first
+    // layer reads, and when training updates, only the weight columns of the
+    // row's non-zero features, so its cost scales with nnz, not the input width.
+    Vector predict_sparse(const SparseRow& input);
+    void train_sparse(const SparseRow& input, const Vector& target);
+
+    // Train the network over multiple epochs with periodic loss reporting.
+    // Returns the trained network's outputs for every sample, sample-major:
+    // sample i's K outputs are at [i * K, (i + 1) * K). The reported mse is
+    // averaged over outputs; all K targets share one hidden-layer pass.
     Vector train_for_epochs(
         const std::vector<Vector>& inputs,
         const std::vector<Vector>& targets,
         int epochs,
-        int report_every_n_epochs = 10 // Report every 10 epochs by default
+        int report_every_n_epochs = 10 // Report every 10 epochs by default; 0 = no epoch lines
+    );
+
+    // Same, for datasets whose samples are built without per-sample heap allocations
+    Vector train_for_epochs(
+        const std::vector<SampleVector>& inputs,
+        const std::vector<SampleVector>& targets,
+        int epochs,
+        int report_every_n_epochs = 10
     );
 
+    // Same, for sample arrays in caller-managed storage (e.g. an Arena)
+    Vector train_for_epochs(
+        const SampleVector* inputs,
+        const SampleVector* targets,
+        size_t count,
+        int epochs,
+        int report_every_n_epochs = 10
+    );
+
+    // Live progress of the current (or last) train_for_epochs run
+    const TrainingProgress& training_progress() const { return progress_; }
+
+    // Learning-rate range test on a copy of this network (left untouched):
+    // options.steps mini-batches of options.batch_size samples from a
+    // subsample, each at a higher rate. Use the suggestion with set_learning_rate.
+    LrRangeTestResult lr_find(const std::vector<Vector>& inputs, const std::vector<Vector>& targets,
+                              const LrRangeTestOptions& options = LrRangeTestOptions()) const;
+    LrRangeTestResult lr_find(const SampleVector* inputs, const SampleVector* targets, size_t count,
+                              const LrRangeTestOptions& options = LrRangeTestOptions()) const;
+
+    const std::vector<size_t>& layer_sizes() const { return layer_sizes_; }
+    size_t parameter_count() const; // Weights and biases
+    // All weights and biases as one flat vector of parameter_count() values:
+    // layer by layer, the weight rows and then the biases. set_parameters
+    // throws std::invalid_argument when the size does not match.
+    void get_parameters(Vector& out) const;
+    void set_parameters(const Vector& values);
+    double learning_rate() const { return learning_rate_; }
+    void set_learning_rate(double learning_rate) { learning_rate_ = learning_rate; }
+
+    void set_training_options(const TrainingOptions& options) { training_options_ = options; }
+    const TrainingOutcome& training_outcome() const { return training_outcome_; }
+
     // --- Activation Functions ---
     // Sigmoid activation function
     static double sigmoid(double x);
@@ -42,6 +180,9 @@ public:
     static double mean_squared_error(const Vector& predicted, const Vector& target);
     // Derivative of Mean Squared Error (for backpropagation)
     static Vector mean_squared_error_derivative(const Vector& predicted, const Vector& target);
+    // Per-output MSE over a batch of `samples` sample-major rows of `outputs` values
+    static Vector mean_squared_error_per_output(const double* predicted, const double* target,
+                                                size_t samples, size_t outputs);
 
 
 private:
@@ -53,23 +194,51 @@ private:
     // --- Training Parameters ---
     double learning_rate_;
 
+    // --- Progress reporting ---
+    TrainingProgress progress_;
+    TrainingOptions training_options_;
+    TrainingOutcome training_outcome_;
+
     // --- Internal State (for backpropagation) ---
-    std::vector<Vector> layer_outputs_; // Stores outputs of each layer during forward pass (including input)
-    std::vector<Vector> layer_inputs_; // Stores weighted inputs to each layer *before* activation
+    std::vector<SampleVector> layer_outputs_; // Stores outputs of each layer during forward pass (including input)
+    std::vector<SampleVector> layer_inputs_; // Stores weighted inputs to each layer *before* activation
+    std::vector<SampleVector> deltas_; // Error deltas of the last backpropagation (excluding input)
+    SampleVector propagated_delta_; // W^T * delta scratch for backpropagate
 
     // --- Helper Methods ---
     // Initialize weights and biases randomly
-    void initialize_weights_biases();
+    void initialize_weights_biases(unsigned seed);
 
     // Perform the forward pass calculation
     Vector forward_pass(const Vector& input);
+    void forward_sample(const double* input, size_t input_size); // Fills layer_outputs_/layer_inputs_ only
+    void forward_sparse_sample(const SparseRow& input); // Same; layer_outputs_[0] is left empty
+    void forward_layers(size_t first_layer); // z = W * a + b and activation for layers >= first_layer
+    void activate_layer(size_t layer);       // layer_outputs_[layer + 1] from layer_inputs_[layer]
 
     // Perform the backpropagation calculation and update weights/biases
     void backpropagate(const Vector& input, const Vector& target);
+    void backpropagate_sample(const double* input, size_t input_size, const double* target, size_t target_size);
+    // Deltas and SGD step after a forward pass; the first layer is updated
+    // sparsely when `sparse_input` is given (its dense input was never stored)
+    void backpropagate_from_forward(const double* target, size_t target_size, const SparseRow* sparse_input);
+    // Squared L2 norm of the last backpropagated sample's gradient (all layers)
+    double last_gradient_norm_squared() const;
+    bool parameters_finite() const;
+
+    template <typename Sample>
+    LrRangeTestResult lr_find_samples(const Sample* inputs, const Sample* targets, size_t n_samples,
+                                      const LrRangeTestOptions& options) const;
+
+    template <typename Sample>
+    Vector train_samples_for_epochs(const Sample* inputs, const Sample* targets, size_t n_samples,
+                                    int epochs, int report_every_n_epochs);
 
     // --- Matrix/Vector Operations (Basic implementations) ---
-    // These could be replaced by a dedicated linear algebra library for performance
+    // The hot ones (multiply, multiply_transposed and the weight update in
+    // backpropagate) go through the process-wide BlasBackend.
     static Vector multiply(const Matrix& matrix, const Vector& vector);
+    static Vector multiply_transposed(const Matrix& matrix, const Vector& vector); // matrix^T * vector
     static Vector add(const Vector& vec1, const Vector& vec2);
     static Vector subtract(const Vector& vec1, const Vector& vec2);
     static Vector elementwise_multiply(const Vector& vec1, const Vector& vec2);
@@ -0,0 +1,68 @@
+#include "perf_counters.h"
+
+#include <cerrno>
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+TlbMissCounter::TlbMissCounter() : fd_(-1) {
+#if defined(__linux__)
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.inherit = 1;        // Follow threads created later (OpenMP pool)
+    attr.exclude_kernel = 1; // Works with perf_event_paranoid <= 2
+    attr.exclude_hv = 1;
+    fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    if (fd_ < 0) {
+        error_ = std::string("perf_event_open: ") + std::strerror(errno);
+    }
+#else
+    error_ = "perf counters are only supported on Linux";
+#endif
+}
+
+TlbMissCounter::~TlbMissCounter() {
+#if defined(__linux__)
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+#endif
+}
+
+void TlbMissCounter::start() {
+#if defined(__linux__)
+    if (fd_ >= 0) {
+        ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+void TlbMissCounter::stop() {
+#if defined(__linux__)
+    if (fd_ >= 0) {
+        ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+    }
+#endif
+}
+
+uint64_t TlbMissCounter::dtlb_load_misses() const {
+    uint64_t value = 0;
+#if defined(__linux__)
+    if (fd_ >= 0 && read(fd_, &value, sizeof(value)) != static_cast<ssize_t>(sizeof(value))) {
+        value = 0;
+    }
+#endif
+    return value;
+}
@@ -0,0 +1,37 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <cstdint>
+#include <string>
+
+// Data-TLB miss counter backed by Linux perf_event_open.
+//
+// Counts dTLB load misses of the calling thread and of every thread it
+// creates after construction (OpenMP workers included). On other platforms,
+// in containers without perf access, or with a restrictive
+// perf_event_paranoid, available() is false and error() says why; callers
+// should simply omit the numbers then.
+class TlbMissCounter {
+public:
+    TlbMissCounter();
+    ~TlbMissCounter();
+
+    TlbMissCounter(const TlbMissCounter&) = delete;
+    TlbMissCounter& operator=(const TlbMissCounter&) = delete;
+
+    bool available() const { return fd_ >= 0; }
+    const std::string& error() const { return error_; }
+
+    // Zero and enable / disable the counter
+    void start();
+    void stop();
+
+    // Misses counted between start() and stop() (or now, if still running)
+    uint64_t dtlb_load_misses() const;
+
+private:
+    int fd_;
+    std::string error_;
+};
+
+#endif // PERF_COUNTERS_H
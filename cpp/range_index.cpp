@@ -0,0 +1,351 @@
+#include "range_index.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <utility>
+
+#include <omp.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#define MLAPP_HAVE_GETPID 1
+#endif
+
+namespace {
+
+typedef std::pair<double, double> Point;
+
+bool byX(const Point& a, const Point& b) {
+    return a.first < b.first;
+}
+
+// Stable sort by x: threads sort contiguous chunks, then neighbours are merged pairwise
+void parallelSortByX(std::vector<Point>& points) {
+    const size_t n = points.size();
+    const size_t chunks = std::max<size_t>(1, std::min<size_t>(omp_get_max_threads(), n / 4096));
+    std::vector<size_t> bounds(chunks + 1);
+    for (size_t c = 0; c <= chunks; ++c) {
+        bounds[c] = n * c / chunks;
+    }
+    #pragma omp parallel for schedule(static)
+    for (long c = 0; c < static_cast<long>(chunks); ++c) {
+        std::stable_sort(points.begin() + bounds[c], points.begin() + bounds[c + 1], byX);
+    }
+    for (size_t width = 1; width < chunks; width *= 2) {
+        #pragma omp parallel for schedule(static)
+        for (long c = 0; c < static_cast<long>(chunks); c += static_cast<long>(2 * width)) {
+            if (c + width < chunks) {
+                const size_t end = bounds[std::min(chunks, c + 2 * width)];
+                std::inplace_merge(points.begin() + bounds[c], points.begin() + bounds[c + width],
+                                   points.begin() + end, byX);
+            }
+        }
+    }
+}
+
+// upper - lower, still in double-double form
+CompensatedSum difference(const CompensatedSum& upper, const CompensatedSum& lower) {
+    CompensatedSum result;
+    result.add(upper.hi);
+    result.add(-lower.hi);
+    result.lo += upper.lo - lower.lo;
+    return result;
+}
+
+// sum_ab - sum_a * sum_b / n: the centered (co)moment of a range. The product
+// and division carry their exact rounding errors (via fma), because this is
+// where short ranges would otherwise cancel most of their significant digits.
+double centeredMoment(const CompensatedSum& sum_ab, const CompensatedSum& sum_a, const CompensatedSum& sum_b,
+                      double n) {
+    const double product = sum_a.hi * sum_b.hi;
+    const double product_error = std::fma(sum_a.hi, sum_b.hi, -product);
+    const double quotient = product / n;
+    const double remainder = std::fma(-quotient, n, product);
+    const double quotient_low = (remainder + product_error + sum_a.hi * sum_b.lo + sum_a.lo * sum_b.hi) / n;
+    return (sum_ab.hi - quotient) + (sum_ab.lo - quotient_low);
+}
+
+} // namespace
+
+void CompensatedSum::add(double value) {
+    // TwoSum: `error` is exactly what rounding hi + value dropped
+    const double sum = hi + value;
+    const double b = sum - hi;
+    const double error = (hi - (sum - b)) + (value - b);
+    hi = sum;
+    lo += error;
+}
+
+void CompensatedSum::add_product(double a, double b) {
+    // TwoProduct: fma recovers the low half of a * b exactly
+    const double product = a * b;
+    add(product);
+    lo += std::fma(a, b, -product);
+}
+
+void CompensatedSum::add(const CompensatedSum& other) {
+    add(other.hi);
+    lo += other.lo;
+}
+
+RangeRegressionIndex::RangeRegressionIndex() : center_x_(0.0), center_y_(0.0), prefix_(1) {}
+
+RangeRegressionIndex::RangeRegressionIndex(const std::vector<double>& X, const std::vector<double>& y) {
+    if (X.size() != y.size()) {
+        throw std::invalid_argument("X and y must have the same length");
+    }
+    if (X.empty()) {
+        throw std::invalid_argument("Input vectors cannot be empty");
+    }
+    const size_t n = X.size();
+
+    // Centering on the means keeps the moment sums small, so range differences cancel less
+    double sum_x = 0.0;
+    double sum_y = 0.0;
+    #pragma omp parallel for reduction(+:sum_x, sum_y)
+    for (size_t i = 0; i < n; ++i) {
+        sum_x += X[i];
+        sum_y += y[i];
+    }
+    center_x_ = sum_x / n;
+    center_y_ = sum_y / n;
+
+    std::vector<Point> points(n);
+    #pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < n; ++i) {
+        points[i] = Point(X[i], y[i]);
+    }
+    parallelSortByX(points);
+    x_.resize(n);
+    y_.resize(n);
+    #pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < n; ++i) {
+        x_[i] = points[i].first;
+        y_[i] = points[i].second;
+    }
+
+    // Parallel scan: each thread sums its block locally, block totals are
+    // scanned sequentially, then every block adds the total of those before it
+    prefix_.assign(n + 1, PrefixEntry());
+    std::vector<PrefixEntry> block_offsets;
+    #pragma omp parallel
+    {
+        const size_t threads = static_cast<size_t>(omp_get_num_threads());
+        const size_t thread = static_cast<size_t>(omp_get_thread_num());
+        const size_t begin = n * thread / threads;
+        const size_t end = n * (thread + 1) / threads;
+        PrefixEntry running;
+        for (size_t i = begin; i < end; ++i) {
+            const double dx = x_[i] - center_x_;
+            const double dy = y_[i] - center_y_;
+            running.x.add(dx);
+            running.y.add(dy);
+            running.xx.add_product(dx, dx);
+            running.xy.add_product(dx, dy);
+            running.yy.add_product(dy, dy);
+            prefix_[i + 1] = running;
+        }
+        #pragma omp barrier
+        #pragma omp single
+        {
+            block_offsets.assign(threads, PrefixEntry());
+            for (size_t t = 1; t < threads; ++t) {
+                const size_t previous_end = n * t / threads;
+                block_offsets[t] = block_offsets[t - 1];
+                if (previous_end > n * (t - 1) / threads) {
+                    const PrefixEntry& total = prefix_[previous_end];
+                    block_offsets[t].x.add(total.x);
+                    block_offsets[t].y.add(total.y);
+                    block_offsets[t].xx.add(total.xx);
+                    block_offsets[t].xy.add(total.xy);
+                    block_offsets[t].yy.add(total.yy);
+                }
+            }
+        }
+        // The single construct ends with an implicit barrier
+        const PrefixEntry& offset = block_offsets[thread];
+        if (thread > 0) {
+            for (size_t i = begin; i < end; ++i) {
+                PrefixEntry& entry = prefix_[i + 1];
+                entry.x.add(offset.x);
+                entry.y.add(offset.y);
+                entry.xx.add(offset.xx);
+                entry.xy.add(offset.xy);
+                entry.yy.add(offset.yy);
+            }
+        }
+    }
+}
+
+RangeRegressionIndex::Moments RangeRegressionIndex::moments(size_t begin, size_t end) const {
+    const PrefixEntry& upper = prefix_[end];
+    const PrefixEntry& lower = prefix_[begin];
+    Moments m;
+    m.n = static_cast<double>(end - begin);
+    m.x = difference(upper.x, lower.x);
+    m.y = difference(upper.y, lower.y);
+    m.xx = difference(upper.xx, lower.xx);
+    m.xy = difference(upper.xy, lower.xy);
+    m.yy = difference(upper.yy, lower.yy);
+    return m;
+}
+
+RangeFit RangeRegressionIndex::fit_positions(size_t begin, size_t end) const {
+    if (begin >= end || end > x_.size()) {
+        throw std::invalid_argument("Regression range contains no points");
+    }
+    const Moments m = moments(begin, end);
+    const double mean_x = m.x.value() / m.n;
+    const double mean_y = m.y.value() / m.n;
+    const double sxx = centeredMoment(m.xx, m.x, m.x, m.n);
+    const double sxy = centeredMoment(m.xy, m.x, m.y, m.n);
+    const double syy = std::max(0.0, centeredMoment(m.yy, m.y, m.y, m.n));
+
+    RangeFit fit;
+    fit.count = end - begin;
+    fit.slope = sxx < 1e-10 ? 0.0 : sxy / sxx; // Same cut-off as fit_analytical
+    fit.intercept = (mean_y + center_y_) - fit.slope * (mean_x + center_x_);
+    const double rss = std::max(0.0, syy - fit.slope * sxy);
+    fit.mse = rss / m.n;
+    fit.r_squared = syy > 0.0 ? 1.0 - rss / syy : 1.0;
+    return fit;
+}
+
+double RangeRegressionIndex::sse(size_t begin, size_t end) const {
+    if (begin >= end) {
+        return 0.0;
+    }
+    // Hot path of segment searches: only the moments the residual needs
+    const Moments m = moments(begin, end);
+    const double sxx = centeredMoment(m.xx, m.x, m.x, m.n);
+    const double sxy = centeredMoment(m.xy, m.x, m.y, m.n);
+    const double syy = centeredMoment(m.yy, m.y, m.y, m.n);
+    const double slope = sxx < 1e-10 ? 0.0 : sxy / sxx;
+    return std::max(0.0, syy - slope * sxy);
+}
+
+RangeFit RangeRegressionIndex::fit_range(double x_lo, double x_hi) const {
+    const size_t begin = std::lower_bound(x_.begin(), x_.end(), x_lo) - x_.begin();
+    const size_t end = std::upper_bound(x_.begin(), x_.end(), x_hi) - x_.begin();
+    if (begin >= end) {
+        throw std::invalid_argument("No points with x in the requested range");
+    }
+    return fit_positions(begin, end);
+}
+
+namespace {
+
+const char kIndexMagic[8] = {'M', 'L', 'R', 'N', 'G', 'I', 'D', 'X'};
+const uint32_t kIndexVersion = 1;
+const uint32_t kByteOrderMark = 0x01020304;
+
+struct IndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t key_hash;
+    uint64_t points;
+    uint64_t file_size;
+    double center_x;
+    double center_y;
+};
+
+// 64-bit FNV-1a
+uint64_t keyHash(const std::string& key) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : key) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Sibling of `path` used by no other writer (see Dataset::write_cache)
+std::string temporaryPath(const std::string& path) {
+    static std::atomic<unsigned long> counter(0);
+    unsigned long process = std::random_device()();
+#ifdef MLAPP_HAVE_GETPID
+    process = static_cast<unsigned long>(getpid());
+#endif
+    return path + "." + std::to_string(process) + "." + std::to_string(counter.fetch_add(1)) + ".tmp";
+}
+
+} // namespace
+
+void RangeRegressionIndex::save(const std::string& path, const std::string& key) const {
+    IndexHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kIndexMagic, sizeof(kIndexMagic));
+    header.version = kIndexVersion;
+    header.byte_order = kByteOrderMark;
+    header.key_hash = keyHash(key);
+    header.points = x_.size();
+    header.file_size = sizeof(header) + 2 * x_.size() * sizeof(double) + prefix_.size() * sizeof(PrefixEntry);
+    header.center_x = center_x_;
+    header.center_y = center_y_;
+
+    const std::string temporary = temporaryPath(path);
+    std::ofstream out(temporary.c_str(), std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(x_.data()), static_cast<std::streamsize>(x_.size() * sizeof(double)));
+    out.write(reinterpret_cast<const char*>(y_.data()), static_cast<std::streamsize>(y_.size() * sizeof(double)));
+    out.write(reinterpret_cast<const char*>(prefix_.data()),
+              static_cast<std::streamsize>(prefix_.size() * sizeof(PrefixEntry)));
+    out.close();
+    if (!out) {
+        std::remove(temporary.c_str());
+        throw std::runtime_error("cannot write '" + temporary + "'");
+    }
+#ifdef _WIN32
+    std::remove(path.c_str()); // rename does not replace on Windows
+#endif
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        throw std::runtime_error("cannot rename '" + temporary + "' to '" + path + "'");
+    }
+}
+
+bool RangeRegressionIndex::load(const std::string& path, const std::string& key, RangeRegressionIndex& index) {
+    std::ifstream in(path.c_str(), std::ios::binary);
+    IndexHeader header;
+    if (!in || !in.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+        return false;
+    }
+    if (std::memcmp(header.magic, kIndexMagic, sizeof(kIndexMagic)) != 0 || header.version != kIndexVersion ||
+        header.byte_order != kByteOrderMark || header.key_hash != keyHash(key) || header.points == 0) {
+        return false;
+    }
+    const uint64_t n = header.points;
+    const uint64_t per_point = 2 * sizeof(double) + sizeof(PrefixEntry);
+    if ((header.file_size - sizeof(header) - sizeof(PrefixEntry)) / per_point != n ||
+        header.file_size != sizeof(header) + n * per_point + sizeof(PrefixEntry)) {
+        return false;
+    }
+    in.seekg(0, std::ios::end);
+    if (static_cast<uint64_t>(in.tellg()) != header.file_size) {
+        return false;
+    }
+    in.seekg(sizeof(header));
+
+    RangeRegressionIndex loaded;
+    loaded.x_.resize(n);
+    loaded.y_.resize(n);
+    loaded.prefix_.resize(n + 1);
+    in.read(reinterpret_cast<char*>(loaded.x_.data()), static_cast<std::streamsize>(n * sizeof(double)));
+    in.read(reinterpret_cast<char*>(loaded.y_.data()), static_cast<std::streamsize>(n * sizeof(double)));
+    in.read(reinterpret_cast<char*>(loaded.prefix_.data()), static_cast<std::streamsize>((n + 1) * sizeof(PrefixEntry)));
+    if (!in) {
+        return false;
+    }
+    loaded.center_x_ = header.center_x;
+    loaded.center_y_ = header.center_y;
+    index = std::move(loaded);
+    return true;
+}
@@ -0,0 +1,86 @@
+#ifndef RANGE_INDEX_H
+#define RANGE_INDEX_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Double-double accumulator (Neumaier/TwoSum): hi + lo carries roughly twice
+// the precision of a plain double, so long prefix sums and their differences
+// do not lose the small moments of short ranges.
+struct CompensatedSum {
+    double hi = 0.0;
+    double lo = 0.0;
+
+    void add(double value);
+    void add(const CompensatedSum& other);
+    // Adds a * b including the rounding error of the product
+    void add_product(double a, double b);
+    double value() const { return hi + lo; }
+};
+
+// Least-squares line over a subset of the indexed points
+struct RangeFit {
+    size_t count = 0;
+    double slope = 0.0;
+    double intercept = 0.0;
+    double mse = 0.0;
+    double r_squared = 0.0;
+};
+
+// Index answering simple linear regression over any x-range without touching
+// the points again. Built once per dataset: points are sorted by x (in
+// parallel) and prefix sums of the moments (n, x, y, xx, xy, yy) are stored
+// in compensated form, after centering on the dataset means. A range query is
+// two binary searches plus O(1) arithmetic on prefix differences.
+class RangeRegressionIndex {
+public:
+    // Throws std::invalid_argument for mismatched or empty inputs
+    RangeRegressionIndex(const std::vector<double>& X, const std::vector<double>& y);
+    // Empty index (size 0), to load() into
+    RangeRegressionIndex();
+
+    // Persistence, so an index is built once per dataset rather than once per
+    // process: save() writes the sorted points and prefix sums under `key`
+    // (e.g. a hash of the data) through a temporary file and a rename, and
+    // throws std::runtime_error when it cannot. load() reads them back without
+    // sorting or summing again; a missing, truncated, foreign or differently
+    // keyed file returns false and leaves `index` untouched.
+    void save(const std::string& path, const std::string& key) const;
+    static bool load(const std::string& path, const std::string& key, RangeRegressionIndex& index);
+
+    size_t size() const { return x_.size(); }
+    // Points sorted by x (ties keep input order)
+    const std::vector<double>& sorted_x() const { return x_; }
+    const std::vector<double>& sorted_y() const { return y_; }
+
+    // Fit over the points with x_lo <= x <= x_hi. An empty range throws
+    // std::invalid_argument; a single point or constant x gives slope 0 (as
+    // LinearRegression::fit_analytical does).
+    RangeFit fit_range(double x_lo, double x_hi) const;
+
+    // Fit over sorted positions [begin, end) in O(1)
+    RangeFit fit_positions(size_t begin, size_t end) const;
+
+    // Residual sum of squares of the best line over sorted positions [begin, end), O(1)
+    double sse(size_t begin, size_t end) const;
+
+private:
+    struct Moments {
+        double n;
+        CompensatedSum x, y, xx, xy, yy; // Sums of centered values over the range
+    };
+    Moments moments(size_t begin, size_t end) const;
+
+    std::vector<double> x_;
+    std::vector<double> y_;
+    double center_x_;
+    double center_y_;
+    // prefix_[k] holds the centered moment sums over the first k sorted points
+    struct PrefixEntry {
+        CompensatedSum x, y, xx, xy, yy;
+    };
+    std::vector<PrefixEntry> prefix_;
+};
+
+#endif // RANGE_INDEX_H
@@ -0,0 +1,109 @@
+#include "resource_usage.h"
+
+#include <fstream>
+#include <string>
+#include <sstream>
+#include <algorithm>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#include <sys/time.h>
+#define RESOURCE_USAGE_HAVE_GETRUSAGE 1
+#endif
+
+namespace {
+
+#ifdef RESOURCE_USAGE_HAVE_GETRUSAGE
+double timevalToMs(const timeval& tv) {
+    return static_cast<double>(tv.tv_sec) * 1000.0 + static_cast<double>(tv.tv_usec) / 1000.0;
+}
+#endif
+
+// Reads a "Key:   <value> kB" line from /proc/self/status. Returns false when
+// the file or key is missing (non-Linux platforms, restricted sandboxes).
+bool readProcStatusKb(const std::string& key, long& value_kb) {
+    std::ifstream status("/proc/self/status");
+    if (!status) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, key.size(), key) == 0 && line.size() > key.size() && line[key.size()] == ':') {
+            std::istringstream fields(line.substr(key.size() + 1));
+            long parsed = 0;
+            if (fields >> parsed) {
+                value_kb = parsed;
+                return true;
+            }
+            return false;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+ResourceSnapshot captureResourceSnapshot() {
+    ResourceSnapshot snapshot;
+    snapshot.wall_clock = std::chrono::steady_clock::now();
+
+#ifdef RESOURCE_USAGE_HAVE_GETRUSAGE
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        snapshot.user_cpu_ms = timevalToMs(usage.ru_utime);
+        snapshot.sys_cpu_ms = timevalToMs(usage.ru_stime);
+        snapshot.minor_faults = usage.ru_minflt;
+        snapshot.major_faults = usage.ru_majflt;
+        snapshot.voluntary_context_switches = usage.ru_nvcsw;
+        snapshot.involuntary_context_switches = usage.ru_nivcsw;
+#if defined(__APPLE__)
+        snapshot.peak_rss_kb = usage.ru_maxrss / 1024; // Reported in bytes on macOS
+#else
+        snapshot.peak_rss_kb = usage.ru_maxrss;        // Reported in kilobytes on Linux/BSD
+#endif
+    }
+#endif
+
+    // /proc is more precise than ru_maxrss and also exposes the current RSS.
+    long proc_value = 0;
+    if (readProcStatusKb("VmHWM", proc_value)) {
+        snapshot.peak_rss_kb = proc_value;
+    }
+    if (readProcStatusKb("VmRSS", proc_value)) {
+        snapshot.current_rss_kb = proc_value;
+    }
+
+    return snapshot;
+}
+
+ResourceUsage diffResourceSnapshots(const ResourceSnapshot& start, const ResourceSnapshot& end) {
+    ResourceUsage usage;
+    usage.wall_time_ms = std::chrono::duration<double, std::milli>(end.wall_clock - start.wall_clock).count();
+    usage.user_cpu_ms = end.user_cpu_ms - start.user_cpu_ms;
+    usage.sys_cpu_ms = end.sys_cpu_ms - start.sys_cpu_ms;
+    usage.peak_rss_kb = end.peak_rss_kb;
+    usage.peak_rss_delta_kb = std::max(0L, end.peak_rss_kb - start.peak_rss_kb);
+    usage.minor_faults = end.minor_faults - start.minor_faults;
+    usage.major_faults = end.major_faults - start.major_faults;
+    usage.voluntary_context_switches = end.voluntary_context_switches - start.voluntary_context_switches;
+    usage.involuntary_context_switches = end.involuntary_context_switches - start.involuntary_context_switches;
+    return usage;
+}
+
+void printResourceUsage(std::ostream& out, const ResourceUsage& usage) {
+    out << "wall_time_ms=" << usage.wall_time_ms << std::endl;
+    out << "user_cpu_ms=" << usage.user_cpu_ms << std::endl;
+    out << "sys_cpu_ms=" << usage.sys_cpu_ms << std::endl;
+    out << "peak_rss_kb=" << usage.peak_rss_kb << std::endl;
+    out << "peak_rss_delta_kb=" << usage.peak_rss_delta_kb << std::endl;
+    out << "minor_page_faults=" << usage.minor_faults << std::endl;
+    out << "major_page_faults=" << usage.major_faults << std::endl;
+    out << "voluntary_context_switches=" << usage.voluntary_context_switches << std::endl;
+    out << "involuntary_context_switches=" << usage.involuntary_context_switches << std::endl;
+}
+
+ResourceAccounting::ResourceAccounting() : start_(captureResourceSnapshot()) {}
+
+ResourceUsage ResourceAccounting::elapsed() const {
+    return diffResourceSnapshots(start_, captureResourceSnapshot());
+}
@@ -0,0 +1,57 @@
+#ifndef RESOURCE_USAGE_H
+#define RESOURCE_USAGE_H
+
+#include <chrono>
+#include <ostream>
+
+// Point-in-time view of the process' resource counters.
+// CPU times and fault/context-switch counters come from getrusage(RUSAGE_SELF),
+// so they include every OpenMP worker thread. Memory figures prefer
+// /proc/self/status (VmHWM/VmRSS) and fall back to ru_maxrss elsewhere.
+struct ResourceSnapshot {
+    std::chrono::steady_clock::time_point wall_clock;
+    double user_cpu_ms = 0.0;
+    double sys_cpu_ms = 0.0;
+    long peak_rss_kb = 0;    // High-water mark of the resident set
+    long current_rss_kb = 0; // Resident set at capture time (0 if unknown)
+    long minor_faults = 0;
+    long major_faults = 0;
+    long voluntary_context_switches = 0;
+    long involuntary_context_switches = 0;
+};
+
+// Resources consumed between two snapshots.
+struct ResourceUsage {
+    double wall_time_ms = 0.0;
+    double user_cpu_ms = 0.0;
+    double sys_cpu_ms = 0.0;
+    long peak_rss_kb = 0;       // Absolute peak at the end of the interval
+    long peak_rss_delta_kb = 0; // How much the interval raised the peak
+    long minor_faults = 0;
+    long major_faults = 0;
+    long voluntary_context_switches = 0;
+    long involuntary_context_switches = 0;
+};
+
+// Capture the current counters. Never throws; unavailable values stay zero.
+ResourceSnapshot captureResourceSnapshot();
+
+// Difference between two snapshots (end - start).
+ResourceUsage diffResourceSnapshots(const ResourceSnapshot& start, const ResourceSnapshot& end);
+
+// Emit the usage as key=value lines (same format as the other CLI stats).
+void printResourceUsage(std::ostream& out, const ResourceUsage& usage);
+
+// Scoped accounting for one operation: snapshot on construction, diff on demand.
+class ResourceAccounting {
+public:
+    ResourceAccounting();
+
+    // Resources used since construction.
+    ResourceUsage elapsed() const;
+
+private:
+    ResourceSnapshot start_;
+};
+
+#endif // RESOURCE_USAGE_H
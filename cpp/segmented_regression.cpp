@@ -0,0 +1,176 @@
+#include "segmented_regression.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+// Below this many live candidates a PELT step is cheaper than a parallel region
+const long kParallelCandidates = 1024;
+
+// A position that may still start the last segment
+struct Candidate {
+    size_t node;
+    // Sorted position from which the candidate is provably beaten (see below)
+    size_t expires;
+};
+
+} // namespace
+
+double estimateNoiseVariance(const RangeRegressionIndex& index) {
+    const std::vector<double>& y = index.sorted_y();
+    if (y.size() < 3) {
+        return 0.0;
+    }
+    // y[i+1] - y[i] is noise with variance 2 sigma^2 plus a small trend term;
+    // median |d| / 0.6745 estimates its standard deviation
+    std::vector<double> differences(y.size() - 1);
+    for (size_t i = 0; i + 1 < y.size(); ++i) {
+        differences[i] = std::fabs(y[i + 1] - y[i]);
+    }
+    std::nth_element(differences.begin(), differences.begin() + differences.size() / 2, differences.end());
+    const double sigma = 1.4826 * differences[differences.size() / 2] / std::sqrt(2.0);
+    return sigma * sigma;
+}
+
+Segmentation fitSegmentedRegression(const RangeRegressionIndex& index, const SegmentationOptions& options) {
+    const auto start = std::chrono::steady_clock::now();
+    const size_t n = index.size();
+    const size_t min_size = std::max<size_t>(1, options.min_segment_size);
+    if (n < min_size) {
+        throw std::invalid_argument("Segmented regression needs at least min_segment_size points");
+    }
+    const std::vector<double>& x = index.sorted_x();
+
+    Segmentation result;
+    result.penalty = options.penalty;
+    if (result.penalty < 0.0) {
+        result.penalty = 3.0 * estimateNoiseVariance(index) * std::log(static_cast<double>(n));
+        // Noise-free data still needs a positive price so exact fits use as few segments as possible
+        result.penalty = std::max(result.penalty, 1e-12 * index.sse(0, n) + std::numeric_limits<double>::min());
+    }
+
+    // Positions where a new segment may start: between distinct x values,
+    // leaving room for a full segment on both sides
+    std::vector<size_t> boundaries;
+    for (size_t p = min_size; p + min_size <= n; ++p) {
+        if (x[p - 1] < x[p]) {
+            boundaries.push_back(p);
+        }
+    }
+    const bool coarse = options.max_candidates != 0 && boundaries.size() > options.max_candidates;
+    std::vector<size_t> nodes(1, 0);
+    if (coarse) {
+        const size_t grid = options.max_candidates;
+        for (size_t k = 0; k < grid; ++k) {
+            nodes.push_back(boundaries[(2 * k + 1) * boundaries.size() / (2 * grid)]);
+        }
+    } else {
+        nodes.insert(nodes.end(), boundaries.begin(), boundaries.end());
+    }
+    nodes.push_back(n);
+    result.candidates = nodes.size() - 2;
+
+    // best[j]: cheapest segmentation of [0, nodes[j]), counting one penalty per segment
+    const size_t m = nodes.size();
+    const double infinity = std::numeric_limits<double>::infinity();
+    std::vector<double> best(m, infinity);
+    std::vector<size_t> previous(m, 0);
+    best[0] = -result.penalty;
+    std::vector<Candidate> active(1, Candidate{0, std::numeric_limits<size_t>::max()});
+    std::vector<double> cost;
+    for (size_t j = 1; j < m; ++j) {
+        const size_t end = nodes[j];
+        size_t live = 0;
+        for (size_t a = 0; a < active.size(); ++a) {
+            if (active[a].expires > end) {
+                active[live++] = active[a];
+            }
+        }
+        active.resize(live);
+
+        const long count = static_cast<long>(active.size());
+        cost.resize(active.size());
+        #pragma omp parallel for schedule(static) if (count >= kParallelCandidates)
+        for (long a = 0; a < count; ++a) {
+            const size_t begin = nodes[active[a].node];
+            cost[a] = end - begin >= min_size ? best[active[a].node] + index.sse(begin, end) : infinity;
+        }
+        result.evaluations += active.size();
+
+        for (size_t a = 0; a < active.size(); ++a) {
+            if (cost[a] < best[j]) {
+                best[j] = cost[a];
+                previous[j] = active[a].node;
+            }
+        }
+        best[j] += result.penalty;
+
+        // PELT pruning: splitting a segment never raises its SSE, so a start s
+        // with best[s] + sse(s, t) > best[t] loses to t for every end t' at
+        // least one minimum segment past t. Until then it stays a candidate.
+        for (size_t a = 0; a < active.size(); ++a) {
+            if (cost[a] != infinity && cost[a] > best[j] && active[a].expires > end + min_size) {
+                active[a].expires = end + min_size;
+            }
+        }
+        if (best[j] < infinity) {
+            active.push_back(Candidate{j, std::numeric_limits<size_t>::max()});
+        }
+    }
+
+    std::vector<size_t> cut_nodes;
+    for (size_t j = m - 1; j != 0; j = previous[j]) {
+        cut_nodes.push_back(j);
+    }
+    cut_nodes.push_back(0);
+    std::reverse(cut_nodes.begin(), cut_nodes.end());
+    std::vector<size_t> cuts(cut_nodes.size());
+    for (size_t k = 0; k < cuts.size(); ++k) {
+        cuts[k] = nodes[cut_nodes[k]];
+    }
+
+    if (coarse) {
+        // Move each breakpoint to its best boundary between the neighbouring
+        // grid candidates (inclusive), holding the others fixed, until nothing moves
+        bool moved = true;
+        for (int sweep = 0; moved && sweep < 10; ++sweep) {
+            moved = false;
+            for (size_t k = 1; k + 1 < cuts.size(); ++k) {
+                const size_t lo = std::max(nodes[cut_nodes[k] - 1], cuts[k - 1] + min_size);
+                const size_t hi = std::min(nodes[cut_nodes[k] + 1], cuts[k + 1] - min_size);
+                double best_cost = index.sse(cuts[k - 1], cuts[k]) + index.sse(cuts[k], cuts[k + 1]);
+                size_t best_cut = cuts[k];
+                for (auto it = std::lower_bound(boundaries.begin(), boundaries.end(), lo);
+                     it != boundaries.end() && *it <= hi; ++it) {
+                    const double candidate = index.sse(cuts[k - 1], *it) + index.sse(*it, cuts[k + 1]);
+                    result.evaluations += 2;
+                    if (candidate < best_cost) {
+                        best_cost = candidate;
+                        best_cut = *it;
+                    }
+                }
+                if (best_cut != cuts[k]) {
+                    cuts[k] = best_cut;
+                    moved = true;
+                }
+            }
+        }
+    }
+
+    for (size_t k = 0; k + 1 < cuts.size(); ++k) {
+        Segment segment;
+        segment.begin = cuts[k];
+        segment.end = cuts[k + 1];
+        segment.x_first = x[segment.begin];
+        segment.x_last = x[segment.end - 1];
+        segment.fit = index.fit_positions(segment.begin, segment.end);
+        result.sse += index.sse(segment.begin, segment.end);
+        result.segments.push_back(segment);
+    }
+    result.elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
@@ -0,0 +1,54 @@
+#ifndef SEGMENTED_REGRESSION_H
+#define SEGMENTED_REGRESSION_H
+
+#include <cstddef>
+#include <vector>
+
+#include "range_index.h"
+
+struct SegmentationOptions {
+    // Cost of each extra segment, in units of squared error. Negative picks a
+    // BIC-style default of 3 * sigma^2 * ln(n) (slope, intercept and breakpoint
+    // per segment), with sigma^2 from estimateNoiseVariance.
+    double penalty = -1.0;
+    // Fewest points in a segment (a line through two points always fits exactly)
+    size_t min_segment_size = 3;
+    // Breakpoint candidates searched exactly by PELT. Larger inputs search an
+    // evenly spaced subset and then move each breakpoint to its best position
+    // between the neighbouring candidates. 0 searches every position (exact,
+    // but quadratic in the length of long straight segments).
+    size_t max_candidates = 2048;
+};
+
+// One fitted piece over sorted positions [begin, end)
+struct Segment {
+    size_t begin = 0;
+    size_t end = 0;
+    double x_first = 0.0; // x of the first and last point in the segment
+    double x_last = 0.0;
+    RangeFit fit;
+};
+
+struct Segmentation {
+    std::vector<Segment> segments;
+    double sse = 0.0;     // Residual sum of squares over all segments
+    double penalty = 0.0; // Penalty actually used
+    size_t candidates = 0; // Breakpoint positions PELT searched
+    size_t evaluations = 0; // Segment costs computed (search and refinement)
+    double elapsed_seconds = 0.0;
+};
+
+// Piecewise-linear fit minimising SSE + penalty * segments. Every segment
+// cost is O(1) from the index's prefix moments; optimal breakpoints come from
+// dynamic programming with PELT pruning (candidates that can no longer start
+// the last segment are dropped), and candidate costs are evaluated in
+// parallel. Breakpoints only fall between distinct x values. Throws
+// std::invalid_argument when the index has fewer than min_segment_size points.
+Segmentation fitSegmentedRegression(const RangeRegressionIndex& index,
+                                    const SegmentationOptions& options = SegmentationOptions());
+
+// Robust noise variance from consecutive differences of the x-sorted y values
+// (MAD-based, so breakpoints and outliers barely move it)
+double estimateNoiseVariance(const RangeRegressionIndex& index);
+
+#endif // SEGMENTED_REGRESSION_H
@@ -0,0 +1,161 @@
+#include "sparse.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+CsrMatrix::CsrMatrix(size_t cols) : cols_(cols), row_offsets_(1, 0) {
+    if (cols > size_t(UINT32_MAX) + 1) {
+        throw std::invalid_argument("CsrMatrix supports at most 2^32 columns");
+    }
+}
+
+void CsrMatrix::add_row(const std::vector<std::pair<uint32_t, double>>& entries) {
+    std::vector<std::pair<uint32_t, double>> sorted(entries);
+    std::sort(sorted.begin(), sorted.end(),
+              [](const std::pair<uint32_t, double>& a, const std::pair<uint32_t, double>& b) { return a.first < b.first; });
+    const size_t row_start = values_.size();
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        if (sorted[i].first >= cols_ || !std::isfinite(sorted[i].second)) {
+            indices_.resize(row_start);
+            values_.resize(row_start);
+            throw std::invalid_argument("Sparse entry out of range or not finite");
+        }
+        if (values_.size() > row_start && indices_.back() == sorted[i].first) {
+            values_.back() += sorted[i].second;
+        } else {
+            indices_.push_back(sorted[i].first);
+            values_.push_back(sorted[i].second);
+        }
+    }
+    // Drop zeros (given explicitly or produced by cancelling duplicates)
+    size_t kept = row_start;
+    for (size_t i = row_start; i < values_.size(); ++i) {
+        if (values_[i] != 0.0) {
+            indices_[kept] = indices_[i];
+            values_[kept] = values_[i];
+            ++kept;
+        }
+    }
+    indices_.resize(kept);
+    values_.resize(kept);
+    row_offsets_.push_back(kept);
+}
+
+SparseRow CsrMatrix::row(size_t i) const {
+    const size_t begin = row_offsets_[i];
+    SparseRow row;
+    row.indices = indices_.data() + begin;
+    row.values = values_.data() + begin;
+    row.nnz = row_offsets_[i + 1] - begin;
+    return row;
+}
+
+double sparseDot(const SparseRow& row, const double* dense) {
+    double sum = 0.0;
+    for (size_t k = 0; k < row.nnz; ++k) {
+        sum += row.values[k] * dense[row.indices[k]];
+    }
+    return sum;
+}
+
+void sparseAxpy(double alpha, const SparseRow& row, double* dense) {
+    for (size_t k = 0; k < row.nnz; ++k) {
+        dense[row.indices[k]] += alpha * row.values[k];
+    }
+}
+
+CsrDesign::CsrDesign(const CsrMatrix& matrix)
+    : matrix_(matrix), column_offsets_(matrix.cols() + 1, 0), column_rows_(matrix.nnz()),
+      column_values_(matrix.nnz()) {
+    // Counting sort of the entries by column; rows stay in increasing order
+    for (size_t i = 0; i < matrix_.rows(); ++i) {
+        const SparseRow row = matrix_.row(i);
+        for (size_t k = 0; k < row.nnz; ++k) {
+            ++column_offsets_[row.indices[k] + 1];
+        }
+    }
+    for (size_t j = 0; j < matrix_.cols(); ++j) {
+        column_offsets_[j + 1] += column_offsets_[j];
+    }
+    std::vector<size_t> next(column_offsets_.begin(), column_offsets_.end() - 1);
+    for (size_t i = 0; i < matrix_.rows(); ++i) {
+        const SparseRow row = matrix_.row(i);
+        for (size_t k = 0; k < row.nnz; ++k) {
+            const size_t slot = next[row.indices[k]]++;
+            column_rows_[slot] = i;
+            column_values_[slot] = row.values[k];
+        }
+    }
+}
+
+void CsrDesign::multiply(const double* v, double* out) const {
+    const long n = static_cast<long>(matrix_.rows());
+    #pragma omp parallel for schedule(static)
+    for (long i = 0; i < n; ++i) {
+        out[i] = sparseDot(matrix_.row(static_cast<size_t>(i)), v);
+    }
+}
+
+void CsrDesign::multiply_transposed(const double* u, double* out) const {
+    // One gather per column: every thread writes only its own columns
+    const long n = static_cast<long>(matrix_.cols());
+    #pragma omp parallel for schedule(dynamic, 4096)
+    for (long j = 0; j < n; ++j) {
+        double sum = 0.0;
+        for (size_t k = column_offsets_[j]; k < column_offsets_[j + 1]; ++k) {
+            sum += column_values_[k] * u[column_rows_[k]];
+        }
+        out[j] = sum;
+    }
+}
+
+void CsrDesign::column_squared_norms(double* out) const {
+    const long n = static_cast<long>(matrix_.cols());
+    #pragma omp parallel for schedule(dynamic, 4096)
+    for (long j = 0; j < n; ++j) {
+        double sum = 0.0;
+        for (size_t k = column_offsets_[j]; k < column_offsets_[j + 1]; ++k) {
+            sum += column_values_[k] * column_values_[k];
+        }
+        out[j] = sum;
+    }
+}
+
+FeatureHasher::FeatureHasher(unsigned bits) : bits_(bits) {
+    if (bits == 0 || bits > 31) {
+        throw std::invalid_argument("FeatureHasher bits must be between 1 and 31");
+    }
+}
+
+std::pair<uint32_t, double> FeatureHasher::slot(const std::string& name) const {
+    // 64-bit FNV-1a; low bits pick the column, the top bit the sign
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : name) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    hash ^= hash >> 29; // FNV's low bits mix poorly for short keys
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 32;
+    const uint32_t column = static_cast<uint32_t>(hash & (dimensions() - 1));
+    return std::make_pair(column, (hash >> 63) ? -1.0 : 1.0);
+}
+
+void FeatureHasher::append_row(const std::vector<std::pair<std::string, double>>& numeric,
+                               const std::vector<std::pair<std::string, std::string>>& categorical,
+                               CsrMatrix& matrix) const {
+    if (matrix.cols() != dimensions()) {
+        throw std::invalid_argument("Hashed rows need a matrix with exactly 2^bits columns");
+    }
+    std::vector<std::pair<uint32_t, double>> entries;
+    entries.reserve(numeric.size() + categorical.size());
+    for (const auto& feature : numeric) {
+        const std::pair<uint32_t, double> s = slot(feature.first);
+        entries.push_back(std::make_pair(s.first, s.second * feature.second));
+    }
+    for (const auto& feature : categorical) {
+        entries.push_back(slot(feature.first + "=" + feature.second));
+    }
+    matrix.add_row(entries);
+}
@@ -0,0 +1,93 @@
+#ifndef SPARSE_H
+#define SPARSE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "iterative_solver.h"
+
+// One row of a CSR matrix: `nnz` (column, value) pairs with increasing columns
+struct SparseRow {
+    const uint32_t* indices;
+    const double* values;
+    size_t nnz;
+};
+
+// Compressed sparse row matrix with a fixed column count. Rows are appended
+// one at a time; memory is proportional to the number of non-zeros, not to
+// rows * cols. Column indices are 32-bit (up to ~4 billion features).
+class CsrMatrix {
+public:
+    explicit CsrMatrix(size_t cols = 0);
+
+    // Appends a row. Entries may come in any order; repeated columns are
+    // summed and explicit zeros dropped. Throws std::invalid_argument for a
+    // column >= cols() or a non-finite value.
+    void add_row(const std::vector<std::pair<uint32_t, double>>& entries);
+
+    size_t rows() const { return row_offsets_.size() - 1; }
+    size_t cols() const { return cols_; }
+    size_t nnz() const { return values_.size(); }
+    SparseRow row(size_t i) const;
+
+private:
+    size_t cols_;
+    std::vector<size_t> row_offsets_; // rows() + 1 entries; row i is [offsets[i], offsets[i + 1])
+    std::vector<uint32_t> indices_;
+    std::vector<double> values_;
+};
+
+// row . dense
+double sparseDot(const SparseRow& row, const double* dense);
+// dense += alpha * row (touches only the row's columns)
+void sparseAxpy(double alpha, const SparseRow& row, double* dense);
+
+// A CsrMatrix as a matrix-free design for solveLeastSquaresCg; products cost
+// O(nnz). The constructor builds a column-major (CSC) copy once, so X^T u is
+// a parallel gather per column instead of a row scatter whose writes collide
+// on shared columns.
+class CsrDesign : public DesignOperator {
+public:
+    explicit CsrDesign(const CsrMatrix& matrix);
+
+    size_t rows() const override { return matrix_.rows(); }
+    size_t cols() const override { return matrix_.cols(); }
+    void multiply(const double* v, double* out) const override;
+    void multiply_transposed(const double* u, double* out) const override;
+    void column_squared_norms(double* out) const override;
+
+private:
+    const CsrMatrix& matrix_;
+    std::vector<size_t> column_offsets_; // cols() + 1 entries; column j is [offsets[j], offsets[j + 1])
+    std::vector<size_t> column_rows_;
+    std::vector<double> column_values_;
+};
+
+// Hashing trick: maps named features into a fixed 2^bits-column space without
+// a vocabulary. Numeric features hash their name and keep their value;
+// categorical ones hash "name=value" with value 1 (one-hot without the
+// millions of columns). A second hash bit picks the sign so collisions cancel
+// out in expectation instead of biasing the weights.
+class FeatureHasher {
+public:
+    explicit FeatureHasher(unsigned bits = 20);
+
+    size_t dimensions() const { return size_t(1) << bits_; }
+
+    // Column and sign (+1/-1) for a feature name
+    std::pair<uint32_t, double> slot(const std::string& name) const;
+
+    // Appends one row built from numeric and categorical features to `matrix`
+    // (whose cols() must equal dimensions())
+    void append_row(const std::vector<std::pair<std::string, double>>& numeric,
+                    const std::vector<std::pair<std::string, std::string>>& categorical,
+                    CsrMatrix& matrix) const;
+
+private:
+    unsigned bits_;
+};
+
+#endif // SPARSE_H
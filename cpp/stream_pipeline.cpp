@@ -0,0 +1,257 @@
+#include "stream_pipeline.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <map>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+bool isSeparator(char c) {
+    return c == ',' || c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\f' || c == '\v';
+}
+
+struct Chunk {
+    uint64_t sequence = 0;
+    std::vector<double> inputs;
+    std::vector<double> outputs;
+    Clock::time_point enqueued_at;
+};
+
+// Counting semaphore bounding the chunks alive in the pipeline; abort() releases all waiters
+class InFlightLimit {
+public:
+    explicit InFlightLimit(size_t limit) : available_(limit), aborted_(false) {}
+
+    bool acquire() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        released_.wait(lock, [this]() { return aborted_ || available_ > 0; });
+        if (aborted_) {
+            return false;
+        }
+        --available_;
+        return true;
+    }
+
+    void release() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++available_;
+        released_.notify_one();
+    }
+
+    void abort() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        aborted_ = true;
+        released_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable released_;
+    size_t available_;
+    bool aborted_;
+};
+
+} // namespace
+
+void parseNumberList(const char* begin, const char* end, std::vector<double>& values) {
+    const char* cursor = begin;
+    while (cursor < end) {
+        if (isSeparator(*cursor)) {
+            ++cursor;
+            continue;
+        }
+        char* parsed_end;
+        errno = 0;
+        const double value = std::strtod(cursor, &parsed_end);
+        if (parsed_end == cursor || (parsed_end < end && !isSeparator(*parsed_end)) ||
+            errno == ERANGE || !std::isfinite(value)) {
+            const char* token_end = cursor;
+            while (token_end < end && !isSeparator(*token_end)) {
+                ++token_end;
+            }
+            throw std::invalid_argument("Invalid numeric value in input: '" + std::string(cursor, token_end) + "'");
+        }
+        values.push_back(value);
+        cursor = parsed_end;
+    }
+}
+
+StreamStats runPredictStream(std::istream& in, std::ostream& out, const BatchPredictor& predict,
+                             const StreamPipelineOptions& options) {
+    const auto start = Clock::now();
+    StreamStats stats;
+    stats.workers = options.workers != 0 ? options.workers : std::max(1u, std::thread::hardware_concurrency());
+    const size_t queue_depth = options.queue_depth == 0 ? 1 : options.queue_depth;
+    const size_t chunk_bytes = options.chunk_bytes == 0 ? 1 : options.chunk_bytes;
+    // Every chunk is in the input queue, on a worker, in the done queue or
+    // waiting for its turn in the writer; bounding the total bounds memory.
+    stats.max_chunks_in_flight = 2 * queue_depth + stats.workers;
+
+    BoundedQueue<Chunk> input(queue_depth);
+    BoundedQueue<Chunk> done(queue_depth);
+    InFlightLimit in_flight(stats.max_chunks_in_flight);
+
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    std::atomic<bool> failed(false);
+    auto fail = [&](std::exception_ptr e) {
+        {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error) {
+                error = e;
+            }
+        }
+        failed = true;
+        in_flight.abort();
+        input.close();
+        done.close();
+    };
+    auto update_gauges = [&]() {
+        if (options.queue_gauges) {
+            options.queue_gauges->input_depth = input.size();
+            options.queue_gauges->done_depth = done.size();
+        }
+    };
+    if (options.queue_gauges) {
+        options.queue_gauges->capacity = queue_depth;
+    }
+    auto observe = [&](const char* stage, Clock::duration elapsed) {
+        if (options.observer) {
+            options.observer(stage, elapsed);
+        }
+    };
+
+    std::atomic<uint64_t> bytes_in(0);
+    std::thread reader([&]() {
+        try {
+            std::vector<char> buffer(chunk_bytes);
+            std::string text;
+            uint64_t sequence = 0;
+            bool eof = false;
+            while (!eof && !failed) {
+                if (!in_flight.acquire()) {
+                    break;
+                }
+                in.read(buffer.data(), static_cast<std::streamsize>(chunk_bytes));
+                const size_t got = static_cast<size_t>(in.gcount());
+                if (in.bad()) {
+                    throw std::runtime_error("Failed to read from the input stream.");
+                }
+                eof = got < chunk_bytes;
+                bytes_in += got;
+                text.append(buffer.data(), got);
+
+                const auto parse_start = Clock::now();
+                // Parse up to the last separator; the partial token after it starts the next chunk
+                size_t cut = text.size();
+                if (!eof) {
+                    while (cut > 0 && !isSeparator(text[cut - 1])) {
+                        --cut;
+                    }
+                }
+                Chunk chunk;
+                parseNumberList(text.data(), text.data() + cut, chunk.inputs);
+                text.erase(0, cut);
+                observe("parse", Clock::now() - parse_start);
+
+                if (chunk.inputs.empty()) {
+                    in_flight.release();
+                    continue;
+                }
+                chunk.sequence = sequence++;
+                chunk.enqueued_at = Clock::now();
+                if (!input.push(std::move(chunk))) {
+                    break;
+                }
+                update_gauges();
+            }
+        } catch (...) {
+            fail(std::current_exception());
+        }
+        input.close();
+    });
+
+    std::atomic<size_t> workers_running(stats.workers);
+    std::vector<std::thread> workers;
+    for (size_t w = 0; w < stats.workers; ++w) {
+        workers.emplace_back([&]() {
+            try {
+                Chunk chunk;
+                while (!failed && input.pop(chunk)) {
+                    update_gauges();
+                    const auto compute_start = Clock::now();
+                    observe("queue_wait", compute_start - chunk.enqueued_at);
+                    chunk.outputs.resize(chunk.inputs.size());
+                    predict(chunk.inputs.data(), chunk.inputs.size(), chunk.outputs.data());
+                    observe("compute", Clock::now() - compute_start);
+                    if (!done.push(std::move(chunk))) {
+                        break;
+                    }
+                    update_gauges();
+                }
+            } catch (...) {
+                fail(std::current_exception());
+            }
+            if (--workers_running == 0) {
+                done.close();
+            }
+        });
+    }
+
+    // Writer: completed chunks arrive in any order and are held until their turn
+    try {
+        std::map<uint64_t, Chunk> pending;
+        uint64_t next = 0;
+        std::string text;
+        char number[32];
+        Chunk chunk;
+        while (!failed && done.pop(chunk)) {
+            update_gauges();
+            const uint64_t sequence = chunk.sequence;
+            pending[sequence] = std::move(chunk);
+            for (auto it = pending.begin(); it != pending.end() && it->first == next; it = pending.begin()) {
+                const auto format_start = Clock::now();
+                text.clear();
+                for (double y : it->second.outputs) {
+                    const int length = std::snprintf(number, sizeof(number), "%.17g\n", y);
+                    text.append(number, static_cast<size_t>(length));
+                }
+                out.write(text.data(), static_cast<std::streamsize>(text.size()));
+                if (!out) {
+                    throw std::runtime_error("Failed to write predictions to the output stream.");
+                }
+                observe("serialize", Clock::now() - format_start);
+                stats.values += it->second.outputs.size();
+                stats.bytes_out += text.size();
+                ++stats.chunks;
+                ++next;
+                pending.erase(it);
+                in_flight.release();
+            }
+        }
+        out.flush();
+    } catch (...) {
+        fail(std::current_exception());
+    }
+
+    reader.join();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    update_gauges();
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    stats.bytes_in = bytes_in;
+    stats.elapsed_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return stats;
+}
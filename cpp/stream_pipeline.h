@@ -0,0 +1,127 @@
+#ifndef STREAM_PIPELINE_H
+#define STREAM_PIPELINE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Blocking FIFO with a fixed capacity: push() waits while the queue is full,
+// pop() waits while it is empty. close() wakes everyone; afterwards push()
+// fails and pop() drains what is left, then fails.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : capacity_(capacity == 0 ? 1 : capacity), closed_(false) {}
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    // Returns false (dropping `item`) if the queue was closed
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this]() { return closed_ || items_.size() < capacity_; });
+        if (closed_) {
+            return false;
+        }
+        items_.push_back(std::move(item));
+        not_empty_.notify_one();
+        return true;
+    }
+
+    // Returns false once the queue is closed and empty
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this]() { return closed_ || !items_.empty(); });
+        if (items_.empty()) {
+            return false;
+        }
+        item = std::move(items_.front());
+        items_.pop_front();
+        not_full_.notify_one();
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+    size_t capacity() const { return capacity_; }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return items_.size();
+    }
+
+private:
+    const size_t capacity_;
+    mutable std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::deque<T> items_;
+    bool closed_;
+};
+
+// Batched model evaluation: writes predictions for inputs[0..count) into outputs
+using BatchPredictor = std::function<void(const double* inputs, size_t count, double* outputs)>;
+
+// Current occupancy of the pipeline's queues, updated by runPredictStream as
+// chunks move and readable from any thread (e.g. a metrics collector)
+struct StreamQueueGauges {
+    std::atomic<size_t> input_depth{0};
+    std::atomic<size_t> done_depth{0};
+    std::atomic<size_t> capacity{0}; // Of each queue
+};
+
+struct StreamPipelineOptions {
+    size_t chunk_bytes = size_t(1) << 20; // Input bytes parsed per chunk (cut at a delimiter)
+    size_t workers = 0;                   // Compute workers; 0 = hardware concurrency
+    size_t queue_depth = 4;               // Capacity of each queue between stages
+
+    // Per-chunk stage timings (parse, queue_wait, compute, serialize), called from the stage's thread
+    std::function<void(const std::string& stage, std::chrono::steady_clock::duration elapsed)> observer;
+    // Optional; must outlive the call
+    StreamQueueGauges* queue_gauges = nullptr;
+};
+
+struct StreamStats {
+    uint64_t values = 0;
+    uint64_t chunks = 0;
+    uint64_t bytes_in = 0;
+    uint64_t bytes_out = 0;
+    size_t workers = 0;
+    size_t max_chunks_in_flight = 0; // Bound on chunks held anywhere in the pipeline
+    double elapsed_seconds = 0.0;
+};
+
+// Streaming scorer: reads numbers separated by commas and/or whitespace from
+// `in`, and writes one prediction per line to `out` in input order.
+//
+//   reader --(input queue)--> N compute workers --(done queue)--> writer
+//
+// The reader parses fixed-size chunks, workers run `predict` on whole chunks,
+// and the writer (the calling thread) restores input order and formats the
+// results. At most max_chunks_in_flight chunks exist at once, so memory stays
+// bounded however long the input is, and throughput settles at the rate of
+// the slowest stage. The first error from any stage (e.g. a malformed value)
+// stops the pipeline and is rethrown here; output already written stays.
+StreamStats runPredictStream(std::istream& in, std::ostream& out, const BatchPredictor& predict,
+                             const StreamPipelineOptions& options = StreamPipelineOptions());
+
+// Appends the numbers in [begin, end) to `values`. Separators are commas and
+// whitespace; empty fields are skipped. Throws std::invalid_argument on a
+// malformed or non-finite value. `end` must point at a separator or a NUL.
+void parseNumberList(const char* begin, const char* end, std::vector<double>& values);
+
+#endif // STREAM_PIPELINE_H
@@ -0,0 +1,99 @@
+#include "../arena.h"
+
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TestRunner {
+    int total{0};
+    int failed{0};
+
+    void expectTrue(bool condition, const std::string& name, const std::string& message = "") {
+        ++total;
+        if (!condition) {
+            ++failed;
+            std::cerr << "[FAIL] " << name;
+            if (!message.empty()) {
+                std::cerr << ": " << message;
+            }
+            std::cerr << std::endl;
+        } else {
+            std::cout << "[PASS] " << name << std::endl;
+        }
+    }
+};
+
+bool aligned(const void* p, size_t alignment) {
+    return reinterpret_cast<uintptr_t>(p) % alignment == 0;
+}
+
+} // namespace
+
+int main() {
+    TestRunner runner;
+
+    {
+        Arena arena;
+        char* a = static_cast<char*>(arena.allocate(3));
+        char* b = static_cast<char*>(arena.allocate(5));
+        runner.expectTrue(aligned(a, 64) && aligned(b, 64), "blocks are 64-byte aligned");
+        runner.expectTrue(b >= a + 64 && arena.region_count() == 1, "small blocks share one region");
+        void* page = arena.allocate(10, 4096);
+        runner.expectTrue(aligned(page, 4096), "larger power-of-two alignment is honoured");
+        runner.expectTrue(arena.bytes_allocated() == 18, "bytes_allocated counts requested bytes",
+                          std::to_string(arena.bytes_allocated()));
+        runner.expectTrue(arena.bytes_reserved() % Arena::kHugePageSize == 0, "regions are whole huge pages");
+        runner.expectTrue(arena.huge_page_regions() <= arena.region_count(), "huge page regions never exceed regions");
+    }
+
+    {
+        Arena arena(Arena::kHugePageSize);
+        double* big = arena.allocate_array<double>(600000); // ~4.8MB, more than one region
+        big[0] = 1.0;
+        big[599999] = 2.0;
+        runner.expectTrue(arena.region_count() == 1 && arena.bytes_reserved() >= 600000 * sizeof(double),
+                          "oversized request gets a region of its own");
+        runner.expectTrue(aligned(big, Arena::kHugePageSize), "fresh regions start on a huge page boundary");
+        arena.reset();
+        runner.expectTrue(arena.region_count() == 0 && arena.bytes_reserved() == 0 && arena.bytes_allocated() == 0,
+                          "reset releases everything");
+        runner.expectTrue(arena.allocate(8) != nullptr && arena.region_count() == 1, "arena is reusable after reset");
+    }
+
+    {
+        bool threw = false;
+        Arena arena;
+        try {
+            arena.allocate(8, 48);
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        runner.expectTrue(threw, "non power-of-two alignment throws");
+    }
+
+    {
+        Arena arena;
+        ArenaVector values{ArenaAllocator<double>(arena)};
+        for (int i = 0; i < 10000; ++i) {
+            values.push_back(i * 0.5);
+        }
+        runner.expectTrue(values.size() == 10000 && values[9999] == 4999.5, "ArenaVector grows like std::vector");
+        runner.expectTrue(aligned(values.data(), 64), "ArenaVector storage is cache-line aligned");
+        runner.expectTrue(arena.bytes_allocated() >= 10000 * sizeof(double), "ArenaVector draws from the arena");
+
+        std::vector<int, ArenaAllocator<int>> other{ArenaAllocator<int>(arena)};
+        runner.expectTrue(ArenaAllocator<double>(arena) == ArenaAllocator<int>(arena), "allocators on one arena compare equal");
+    }
+
+    if (runner.failed == 0) {
+        std::cout << "\nAll " << runner.total << " arena tests passed." << std::endl;
+        return 0;
+    }
+
+    std::cerr << "\n" << runner.failed << " of " << runner.total << " arena tests failed." << std::endl;
+    return 1;
+}
@@ -0,0 +1,157 @@
+#include "../blas_backend.h"
+
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TestRunner {
+    int total{0};
+    int failed{0};
+
+    void expectTrue(bool condition, const std::string& name, const std::string& message = "") {
+        ++total;
+        if (!condition) {
+            ++failed;
+            std::cerr << "[FAIL] " << name;
+            if (!message.empty()) {
+                std::cerr << ": " << message;
+            }
+            std::cerr << std::endl;
+        } else {
+            std::cout << "[PASS] " << name << std::endl;
+        }
+    }
+
+    void expectNear(double actual, double expected, double tolerance, const std::string& name) {
+        expectTrue(std::fabs(actual - expected) <= tolerance, name,
+                   "expected " + std::to_string(expected) + ", got " + std::to_string(actual));
+    }
+};
+
+bool allNear(const std::vector<double>& a, const std::vector<double>& b, double tolerance) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::fabs(a[i] - b[i]) > tolerance) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Runs the same kernels on `backend` and checks them against hand-computed values
+void checkKernels(TestRunner& runner, const BlasBackend& backend) {
+    const std::string prefix = backend.name() + ": ";
+    const std::vector<double> x = {1.0, 2.0, 3.0};
+    const std::vector<double> y = {4.0, -5.0, 6.0};
+    runner.expectNear(backend.dot(3, x.data(), y.data()), 12.0, 1e-12, prefix + "dot");
+
+    std::vector<double> acc = y;
+    backend.axpy(3, 2.0, x.data(), acc.data());
+    runner.expectTrue(allNear(acc, {6.0, -1.0, 12.0}, 1e-12), prefix + "axpy");
+
+    // A = [1 2 3; 4 5 6] stored with lda = 4 (one padding column)
+    const std::vector<double> a = {1.0, 2.0, 3.0, 99.0,
+                                   4.0, 5.0, 6.0, 99.0};
+    std::vector<double> out = {1.0, 1.0};
+    backend.gemv(false, 2, 3, 1.0, a.data(), 4, x.data(), 2.0, out.data());
+    runner.expectTrue(allNear(out, {16.0, 34.0}, 1e-12), prefix + "gemv computes A*x + beta*y with padded rows");
+
+    const std::vector<double> v = {1.0, -1.0};
+    std::vector<double> out_t(3, std::nan(""));
+    backend.gemv(true, 2, 3, 1.0, a.data(), 4, v.data(), 0.0, out_t.data());
+    runner.expectTrue(allNear(out_t, {-3.0, -3.0, -3.0}, 1e-12), prefix + "gemv transpose with beta=0 ignores old y");
+
+    // C = A * A^T = [14 32; 32 77]
+    std::vector<double> c(4, 0.0);
+    backend.gemm(false, true, 2, 2, 3, 1.0, a.data(), 4, a.data(), 4, 0.0, c.data(), 2);
+    runner.expectTrue(allNear(c, {14.0, 32.0, 32.0, 77.0}, 1e-12), prefix + "gemm A*A^T");
+
+    // C = A^T * A (3x3), accumulated on top of the identity
+    std::vector<double> g = {1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0};
+    backend.gemm(true, false, 3, 3, 2, 1.0, a.data(), 4, a.data(), 4, 1.0, g.data(), 3);
+    runner.expectTrue(allNear(g, {18.0, 22.0, 27.0, 22.0, 30.0, 36.0, 27.0, 36.0, 46.0}, 1e-12),
+                      prefix + "gemm A^T*A with beta=1");
+
+    std::vector<double> untouched = {7.0};
+    backend.gemv(false, 1, 0, 1.0, a.data(), 4, x.data(), 0.5, untouched.data());
+    runner.expectNear(untouched[0], 3.5, 1e-12, prefix + "gemv with zero columns only scales y");
+}
+
+} // namespace
+
+int main() {
+    TestRunner runner;
+
+    BuiltinBlas builtin;
+    checkKernels(runner, builtin);
+
+    runner.expectTrue(activeBlasBackend().name() == "builtin", "builtin backend is active by default");
+    runner.expectTrue(createBlasBackend("builtin")->name() == "builtin", "createBlasBackend builds builtin");
+
+    {
+        bool threw = false;
+        try {
+            createBlasBackend("mkl-please");
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        runner.expectTrue(threw, "unknown backend name throws invalid_argument");
+    }
+
+    {
+        bool threw = false;
+        try {
+            createBlasBackend("dlopen:/nonexistent/libcblas.so");
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        runner.expectTrue(threw, "dlopen of a missing library throws runtime_error");
+    }
+
+    {
+        bool threw = false;
+        try {
+            createBlasBackend("cblas");
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        runner.expectTrue(threw != blasLinkedAtBuildTime(), "cblas backend available exactly when linked at build time");
+    }
+
+    // Optional backends: exercised when the host provides them
+    if (blasLinkedAtBuildTime()) {
+        checkKernels(runner, *createBlasBackend("cblas"));
+    }
+    try {
+        std::unique_ptr<BlasBackend> loaded = createBlasBackend("dlopen");
+        runner.expectTrue(loaded->name().compare(0, 7, "dlopen:") == 0, "dlopen backend reports its library");
+        checkKernels(runner, *loaded);
+    } catch (const std::runtime_error& e) {
+        std::cout << "[SKIP] dlopen backend: " << e.what() << std::endl;
+    }
+
+    {
+        std::unique_ptr<BlasBackend> chosen = createBlasBackend("auto");
+        runner.expectTrue(!chosen->name().empty(), "auto always yields a backend");
+        const BlasBackend* raw = chosen.get();
+        setActiveBlasBackend(std::move(chosen));
+        runner.expectTrue(&activeBlasBackend() == raw, "setActiveBlasBackend switches the active backend");
+        setActiveBlasBackend(createBlasBackend("builtin"));
+        const double two = 2.0, three = 3.0;
+        runner.expectTrue(raw->dot(1, &two, &three) == 6.0, "replaced backend stays usable");
+    }
+
+    if (runner.failed == 0) {
+        std::cout << "\nAll " << runner.total << " blas backend tests passed." << std::endl;
+        return 0;
+    }
+
+    std::cerr << "\n" << runner.failed << " of " << runner.total << " blas backend tests failed." << std::endl;
+    return 1;
+}
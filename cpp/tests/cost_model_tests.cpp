@@ -0,0 +1,173 @@
+#include "../cost_model.h"
+
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TestRunner {
+    int total{0};
+    int failed{0};
+
+    void expectTrue(bool condition, const std::string& name, const std::string& message = "") {
+        ++total;
+        if (!condition) {
+            ++failed;
+            std::cerr << "[FAIL] " << name;
+            if (!message.empty()) {
+                std::cerr << ": " << message;
+            }
+            std::cerr << std::endl;
+        } else {
+            std::cout << "[PASS] " << name << std::endl;
+        }
+    }
+
+    void expectNear(double actual, double expected, double tolerance, const std::string& name) {
+        const double diff = std::fabs(actual - expected);
+        expectTrue(diff <= tolerance, name,
+                   "expected " + std::to_string(expected) + ", got " + std::to_string(actual) +
+                       ", diff " + std::to_string(diff) + ", tolerance " + std::to_string(tolerance));
+    }
+
+    template <typename Func>
+    void expectThrows(const std::string& name, Func&& func) {
+        ++total;
+        try {
+            func();
+        } catch (const std::invalid_argument&) {
+            std::cout << "[PASS] " << name << std::endl;
+            return;
+        } catch (...) {
+        }
+        ++failed;
+        std::cerr << "[FAIL] " << name << ": expected std::invalid_argument" << std::endl;
+    }
+};
+
+MachineProfile fixedProfile() {
+    MachineProfile profile;
+    profile.overhead_ms_per_layer = 0.001; // 1us per layer per sample
+    profile.flops_per_ms = 1e6;            // 1 GFLOP/s
+    return profile;
+}
+
+TrainingJob makeJob(size_t samples, int epochs) {
+    TrainingJob job;
+    job.layer_sizes = {1, 5, 1};
+    job.samples = samples;
+    job.epochs = epochs;
+    job.report_every = 10;
+    return job;
+}
+
+} // namespace
+
+int main() {
+    TestRunner runner;
+
+    // 1-5-1: forward = (2*1*5 + 5 + 20*5) + (2*5*1 + 1) = 115 + 11 = 126
+    runner.expectNear(CostModel::forward_flops_per_sample({1, 5, 1}), 126.0, 1e-9, "forward flops for 1-5-1");
+    runner.expectTrue(CostModel::train_flops_per_sample({1, 5, 1}) > 2 * CostModel::forward_flops_per_sample({1, 5, 1}),
+                      "training step costs more than two forward passes");
+
+    CostModel model(fixedProfile());
+
+    {
+        CostEstimate small = model.estimate(makeJob(1000, 10));
+        CostEstimate more_epochs = model.estimate(makeJob(1000, 20));
+        CostEstimate more_samples = model.estimate(makeJob(2000, 10));
+        runner.expectTrue(more_epochs.time_ms > small.time_ms && more_epochs.flops > small.flops,
+                          "estimate grows with epochs");
+        runner.expectTrue(more_samples.peak_memory_bytes > small.peak_memory_bytes,
+                          "peak memory grows with samples");
+        runner.expectNear(more_epochs.peak_memory_bytes, small.peak_memory_bytes, 1e-9,
+                          "peak memory independent of epochs");
+    }
+
+    {
+        // A race of 4 strategies on 2 of 4 cores: 4x the work at 2x the speed
+        MachineProfile quad = fixedProfile();
+        quad.cores = 4;
+        const CostModel parallel(quad);
+        const CostEstimate single = parallel.estimate(makeJob(1000, 10));
+        TrainingJob race = makeJob(1000, 10);
+        race.runs = 4;
+        race.model_copies = 4;
+        race.threads = 2;
+        const CostEstimate raced = parallel.estimate(race);
+        runner.expectNear(raced.flops, 4.0 * single.flops, 1e-6, "race work scales with the strategies");
+        runner.expectNear(raced.time_ms, 2.0 * single.time_ms, 1e-9, "race time divides by the threads in use");
+        TrainingJob local = makeJob(1000, 10);
+        local.model_copies = 9;
+        local.threads = 8;
+        const CostEstimate replicated = parallel.estimate(local);
+        runner.expectTrue(replicated.flops == single.flops && std::fabs(replicated.time_ms - single.time_ms / 4.0) < 1e-9 &&
+                              replicated.peak_memory_bytes > single.peak_memory_bytes,
+                          "local-sgd replicas cost memory, and threads past the cores do not help");
+    }
+
+    {
+        // Updates are in place: a wide model needs little beyond its own parameters
+        TrainingJob wide;
+        wide.layer_sizes = {1000, 1000, 1};
+        wide.samples = 1;
+        wide.epochs = 1;
+        const double parameter_bytes = 8.0 * (1000.0 * 1000.0 + 1000.0 + 1000.0 + 1.0);
+        const double peak = model.estimate(wide).peak_memory_bytes;
+        runner.expectTrue(peak > parameter_bytes && peak < 1.1 * parameter_bytes,
+                          "peak memory holds no gradient or transpose copies", std::to_string(peak));
+    }
+
+    {
+        TrainingJob job = makeJob(1000, 100);
+        BudgetDecision unlimited = model.fit_to_budget(job, 0.0, 0.0);
+        runner.expectTrue(unlimited.within_budget && unlimited.job.epochs == 100, "no limits keeps the job");
+
+        const double full_ms = model.estimate(job).time_ms;
+        BudgetDecision halved = model.fit_to_budget(job, full_ms / 2.0, 0.0);
+        runner.expectTrue(!halved.within_budget && halved.feasible, "over time budget is adjustable");
+        runner.expectTrue(halved.job.epochs < 100 && halved.job.epochs >= 40 && halved.job.samples == 1000,
+                          "time budget lowers epochs before subsampling");
+        runner.expectTrue(halved.estimate.time_ms <= full_ms / 2.0, "adjusted job fits time budget");
+        runner.expectNear(halved.original.time_ms, full_ms, 1e-9, "decision keeps original estimate");
+
+        const double one_epoch_ms = model.estimate(makeJob(1000, 1)).time_ms;
+        BudgetDecision tiny = model.fit_to_budget(job, one_epoch_ms / 4.0, 0.0);
+        runner.expectTrue(tiny.feasible && tiny.job.epochs == 1 && tiny.job.samples < 1000,
+                          "very small time budget subsamples at one epoch");
+
+        const double full_mem = model.estimate(job).peak_memory_bytes;
+        BudgetDecision mem = model.fit_to_budget(job, 0.0, full_mem * 0.6);
+        runner.expectTrue(mem.feasible && mem.job.samples < 1000 && mem.job.epochs == 100 &&
+                              mem.estimate.peak_memory_bytes <= full_mem * 0.6,
+                          "memory budget subsamples");
+
+        BudgetDecision impossible = model.fit_to_budget(job, 0.0, 16.0);
+        runner.expectTrue(!impossible.feasible && !impossible.reason.empty(), "unreachable memory budget is infeasible");
+    }
+
+    {
+        MachineProfile calibrated = CostModel::calibrate();
+        runner.expectTrue(calibrated.flops_per_ms > 0.0 && std::isfinite(calibrated.flops_per_ms) &&
+                              calibrated.overhead_ms_per_layer >= 0.0,
+                          "calibration produces a usable profile");
+    }
+
+    runner.expectNear(parseByteSize("512"), 512.0, 0.0, "parseByteSize plain bytes");
+    runner.expectNear(parseByteSize("64M"), 64.0 * 1024 * 1024, 0.0, "parseByteSize megabytes");
+    runner.expectNear(parseByteSize("1.5G"), 1.5 * 1024 * 1024 * 1024, 0.0, "parseByteSize fractional gigabytes");
+    runner.expectThrows("parseByteSize rejects unknown suffix", [] { parseByteSize("10X"); });
+    runner.expectThrows("parseByteSize rejects empty input", [] { parseByteSize(""); });
+
+    if (runner.failed == 0) {
+        std::cout << "\nAll " << runner.total << " cost model tests passed." << std::endl;
+        return 0;
+    }
+
+    std::cerr << "\n" << runner.failed << " of " << runner.total << " cost model tests failed." << std::endl;
+    return 1;
+}
@@ -0,0 +1,276 @@
+#include "../dataset.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TestRunner {
+    int total{0};
+    int failed{0};
+
+    void expectTrue(bool condition, const std::string& name, const std::string& message = "") {
+        ++total;
+        if (!condition) {
+            ++failed;
+            std::cerr << "[FAIL] " << name;
+            if (!message.empty()) {
+                std::cerr << ": " << message;
+            }
+            std::cerr << std::endl;
+        } else {
+            std::cout << "[PASS] " << name << std::endl;
+        }
+    }
+};
+
+Dataset parseCsv(const std::string& text, size_t chunk_bytes = size_t(4) << 20) {
+    DatasetOptions options;
+    options.chunk_bytes = chunk_bytes;
+    return Dataset::parse_csv(text.data(), text.data() + text.size(), options);
+}
+
+std::string csvError(const std::string& text, size_t chunk_bytes) {
+    try {
+        parseCsv(text, chunk_bytes);
+    } catch (const std::invalid_argument& e) {
+        return e.what();
+    }
+    return "";
+}
+
+void writeFile(const std::string& path, const std::string& bytes) {
+    std::ofstream out(path.c_str(), std::ios::binary);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+// Version 1.0 .npy with the header padded to 64 bytes, as NumPy writes it
+std::string npyBytes(const std::string& descr, bool fortran_order, const std::string& shape,
+                     const void* data, size_t data_bytes) {
+    std::string header = "{'descr': '" + descr + "', 'fortran_order': " + (fortran_order ? "True" : "False") +
+                         ", 'shape': " + shape + ", }";
+    while ((10 + header.size() + 1) % 64 != 0) {
+        header += ' ';
+    }
+    header += '\n';
+    std::string bytes("\x93NUMPY\x01\x00", 8);
+    bytes += static_cast<char>(header.size() & 0xff);
+    bytes += static_cast<char>(header.size() >> 8);
+    bytes += header;
+    bytes.append(static_cast<const char*>(data), data_bytes);
+    return bytes;
+}
+
+} // namespace
+
+int main() {
+    TestRunner runner;
+
+    {
+        const std::string text = "a, b ,\"c\"\r\n1,2,3\r\n\r\n4.5,-5,6e1\n7,8,9";
+        const Dataset single = parseCsv(text);
+        runner.expectTrue(single.rows() == 3 && single.cols() == 3 && single.format() == "csv",
+                          "CSV rows and columns (blank lines skipped)");
+        runner.expectTrue(single.column_names()[1] == "b" && single.column_names()[2] == "c",
+                          "header names are trimmed and unquoted");
+        const ColumnView c = single.column(2);
+        runner.expectTrue(c[0] == 3.0 && c[1] == 60.0 && c[2] == 9.0 && c.contiguous() != nullptr &&
+                              c.contiguous()[1] == 60.0,
+                          "CSV columns are contiguous float64");
+
+        bool same = true;
+        for (size_t chunk_bytes = 1; chunk_bytes < 12; ++chunk_bytes) {
+            const Dataset chunked = parseCsv(text, chunk_bytes);
+            same = same && chunked.rows() == 3;
+            for (size_t j = 0; same && j < 3; ++j) {
+                for (size_t i = 0; same && i < 3; ++i) {
+                    same = chunked.column(j)[i] == single.column(j)[i];
+                }
+            }
+        }
+        runner.expectTrue(same, "chunked parallel parse matches a single chunk");
+
+        const Dataset headerless = parseCsv("1,2\n3,4\n");
+        runner.expectTrue(headerless.rows() == 2 && headerless.column_names()[0] == "0" &&
+                              headerless.column(1)[1] == 4.0,
+                          "numeric first line is data; columns are named by index");
+    }
+
+    {
+        const std::string bad_value = csvError("x,y\n1,2\n3,4\n5,oops\n", 4);
+        runner.expectTrue(bad_value.find("line 4") != std::string::npos && bad_value.find("oops") != std::string::npos,
+                          "invalid values report their file line across chunks", bad_value);
+        const std::string bad_width = csvError("1,2\n3\n", 1 << 20);
+        runner.expectTrue(bad_width.find("line 2") != std::string::npos, "rows with the wrong field count throw",
+                          bad_width);
+        runner.expectTrue(!csvError("1,2\n3,\n", 1 << 20).empty() && !csvError("", 1 << 20).empty() &&
+                              !csvError("x,y\n1,inf\n", 1 << 20).empty(),
+                          "empty fields, empty input and non-finite values throw");
+    }
+
+    {
+        const Dataset dataset = parseCsv("price,size,rooms\n1,2,3\n");
+        const std::vector<size_t> selected = dataset.select_columns("rooms, 0");
+        runner.expectTrue(selected.size() == 2 && selected[0] == 2 && selected[1] == 0 &&
+                              dataset.column_index("size") == 1,
+                          "columns are selected by name or index");
+        bool threw = false;
+        try {
+            dataset.select_columns("price,missing");
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        runner.expectTrue(threw, "unknown columns throw");
+    }
+
+    {
+        const double c_order[] = {1.0, 10.0, 2.0, 20.0, 3.0, 30.0};
+        writeFile("dataset_test_c.npy", npyBytes("<f8", false, "(3, 2)", c_order, sizeof(c_order)));
+        const Dataset c = Dataset::load("dataset_test_c.npy");
+        runner.expectTrue(c.format() == "npy" && c.rows() == 3 && c.cols() == 2 && c.column(1)[2] == 30.0 &&
+                              c.column(0)[1] == 2.0 && c.column(1).contiguous() == nullptr,
+                          "C-order .npy columns are strided views");
+
+        const float fortran[] = {1.5f, 2.5f, 3.5f, -1.0f, -2.0f, -3.0f};
+        writeFile("dataset_test_f.npy", npyBytes("<f4", true, "(3, 2)", fortran, sizeof(fortran)));
+        const Dataset f = Dataset::load("dataset_test_f.npy");
+        runner.expectTrue(f.rows() == 3 && f.cols() == 2 && f.column(0)[2] == 3.5 && f.column(1)[0] == -1.0,
+                          "Fortran-order float32 .npy");
+
+        const double vector[] = {4.0, 5.0};
+        writeFile("dataset_test_v.npy", npyBytes("<f8", false, "(2,)", vector, sizeof(vector)));
+        const Dataset v = Dataset::load("dataset_test_v.npy");
+        runner.expectTrue(v.rows() == 2 && v.cols() == 1 && v.column(0).contiguous() != nullptr &&
+                              v.column(0).contiguous()[1] == 5.0,
+                          "1-D .npy is one contiguous column");
+
+        writeFile("dataset_test_bad.npy", npyBytes("<i8", false, "(2,)", vector, sizeof(vector)));
+        bool threw = false;
+        try {
+            Dataset::load("dataset_test_bad.npy");
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        runner.expectTrue(threw, "unsupported .npy dtypes throw");
+        std::remove("dataset_test_c.npy");
+        std::remove("dataset_test_f.npy");
+        std::remove("dataset_test_v.npy");
+        std::remove("dataset_test_bad.npy");
+    }
+
+    {
+        const double rows[] = {1.0, 2.0, 3.0, 4.0, 5.0, 6.0};
+        writeFile("dataset_test.f64", std::string(reinterpret_cast<const char*>(rows), sizeof(rows)));
+        DatasetOptions options;
+        options.raw_columns = 3;
+        const Dataset raw = Dataset::load("dataset_test.f64", options);
+        std::vector<double> gathered(2);
+        raw.column(2).copy_to(gathered.data());
+        runner.expectTrue(raw.format() == "raw" && raw.rows() == 2 && gathered[0] == 3.0 && gathered[1] == 6.0,
+                          "raw float64 rows are mapped and gathered by column");
+        options.raw_columns = 4;
+        bool threw = false;
+        try {
+            Dataset::load("dataset_test.f64", options);
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        runner.expectTrue(threw, "raw files must hold whole rows");
+        std::remove("dataset_test.f64");
+
+        writeFile("dataset_test.csv", "x,y\n1,2\n");
+        runner.expectTrue(Dataset::load("dataset_test.csv").column(1)[0] == 2.0, "format is inferred from the extension");
+        std::remove("dataset_test.csv");
+
+        bool missing = false;
+        try {
+            Dataset::load("dataset_test_missing.csv");
+        } catch (const std::runtime_error&) {
+            missing = true;
+        }
+        runner.expectTrue(missing, "missing files throw runtime_error");
+    }
+
+    {
+        writeFile("dataset_test_cache.csv", "x,y\n1,10\n2,20\n3,30\n4,40\n");
+        DatasetOptions options;
+        options.cache_path = "dataset_test_cache.csv.mlcache";
+        std::remove(options.cache_path.c_str());
+        const Dataset parsed = Dataset::load("dataset_test_cache.csv", options);
+        runner.expectTrue(parsed.cache_status() == "written", "first load parses and writes the sidecar",
+                          parsed.cache_status());
+
+        const Dataset cached = Dataset::load("dataset_test_cache.csv", options);
+        const ColumnStats stats = cached.column_stats(1);
+        runner.expectTrue(cached.cache_status() == "hit" && cached.rows() == 4 && cached.cols() == 2 &&
+                              cached.column_names()[1] == "y" && cached.column(1)[3] == 40.0 &&
+                              cached.column(0).contiguous() != nullptr,
+                          "second load maps the sidecar", cached.cache_status());
+        runner.expectTrue(stats.min == 10.0 && stats.max == 40.0 && stats.mean == 25.0 && stats.variance == 125.0,
+                          "column statistics are stored in the sidecar");
+
+        // Same bytes, new mtime: revalidated by hash without parsing
+        writeFile("dataset_test_cache.csv", "x,y\n1,10\n2,20\n3,30\n4,40\n");
+        std::fstream header(options.cache_path.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+        header.seekp(24); // CacheHeader::source_mtime_ns
+        const long long stale = 1;
+        header.write(reinterpret_cast<const char*>(&stale), sizeof(stale));
+        header.close();
+        const Dataset rehashed = Dataset::load("dataset_test_cache.csv", options);
+        const Dataset again = Dataset::load("dataset_test_cache.csv", options);
+        runner.expectTrue(rehashed.cache_status() == "rehashed" && rehashed.column(1)[0] == 10.0 &&
+                              again.cache_status() == "hit",
+                          "touched but unchanged sources are rehashed, then hit", rehashed.cache_status());
+
+        writeFile("dataset_test_cache.csv", "x,y\n1,10\n2,20\n3,30\n4,99\n");
+        const Dataset changed = Dataset::load("dataset_test_cache.csv", options);
+        runner.expectTrue(changed.cache_status() == "written" && changed.column(1)[3] == 99.0,
+                          "changed content invalidates the sidecar", changed.cache_status());
+
+        options.header = 0;
+        bool threw = false;
+        try {
+            Dataset::load("dataset_test_cache.csv", options); // the header line is now data
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        runner.expectTrue(threw, "different parse options do not reuse the sidecar");
+
+        writeFile(options.cache_path, "not a cache");
+        options.header = -1;
+        runner.expectTrue(Dataset::load("dataset_test_cache.csv", options).cache_status() == "written",
+                          "corrupt sidecars are rewritten");
+
+        // Another process's half-written sidecar under the old fixed name
+        const std::string foreign = options.cache_path + ".tmp";
+        writeFile(foreign, "another writer");
+        writeFile("dataset_test_cache.csv", "x,y\n5,50\n6,60\n");
+        const Dataset rewritten = Dataset::load("dataset_test_cache.csv", options);
+        std::ifstream foreign_in(foreign.c_str(), std::ios::binary);
+        const std::string foreign_bytes((std::istreambuf_iterator<char>(foreign_in)), std::istreambuf_iterator<char>());
+        runner.expectTrue(rewritten.cache_status() == "written" && foreign_bytes == "another writer",
+                          "sidecars are written through a temporary file of their own", rewritten.cache_status());
+        std::remove(foreign.c_str());
+
+        const Dataset plain = parseCsv("a\n1\n2\n4\n");
+        const ColumnStats computed = plain.column_stats(0);
+        runner.expectTrue(plain.cache_status().empty() && computed.mean == 7.0 / 3.0 && computed.max == 4.0,
+                          "statistics are computed on demand without a sidecar");
+        std::remove("dataset_test_cache.csv");
+        std::remove(options.cache_path.c_str());
+    }
+
+    if (runner.failed == 0) {
+        std::cout << "\nAll " << runner.total << " dataset tests passed." << std::endl;
+        return 0;
+    }
+
+    std::cerr << "\n" << runner.failed << " of " << runner.total << " dataset tests failed." << std::endl;
+    return 1;
+}
@@ -0,0 +1,99 @@
+#include "../distillation.h"
+
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TestRunner {
+    int total{0};
+    int failed{0};
+
+    void expectTrue(bool condition, const std::string& name, const std::string& message = "") {
+        ++total;
+        if (!condition) {
+            ++failed;
+            std::cerr << "[FAIL] " << name;
+            if (!message.empty()) {
+                std::cerr << ": " << message;
+            }
+            std::cerr << std::endl;
+        } else {
+            std::cout << "[PASS] " << name << std::endl;
+        }
+    }
+};
+
+} // namespace
+
+int main() {
+    TestRunner runner;
+
+    {
+        std::vector<double> X;
+        std::vector<double> Y;
+        std::vector<Vector> inputs;
+        std::vector<Vector> targets;
+        for (int i = 0; i < 50; ++i) {
+            X.push_back(i / 49.0);
+            Y.push_back(0.5 + 0.4 * std::sin(4.0 * X.back()));
+            inputs.push_back({X.back()});
+            targets.push_back({Y.back()});
+        }
+        NeuralNetwork teacher({1, 64, 1}, 0.1);
+        teacher.train_for_epochs(inputs, targets, 1000, 100000);
+        NeuralNetwork student({1, 6, 1}, 0.1);
+        DistillationOptions options;
+        options.epochs = 300;
+        options.report_every_n_epochs = 100000;
+        const DistillationResult result = distill(teacher, student, X.data(), Y.data(), X.size(), options);
+
+        runner.expectTrue(result.samples == 1000, "default synthetic sample count", std::to_string(result.samples));
+        // Against the truth the student can only be off by the teacher's error plus its own
+        runner.expectTrue(result.student_mse_vs_teacher < 0.002 &&
+                              std::sqrt(result.student_mse_vs_truth) <
+                                  std::sqrt(result.teacher_mse_vs_truth) + 3.0 * std::sqrt(result.student_mse_vs_teacher) + 1e-3,
+                          "the student learns the teacher's function",
+                          std::to_string(result.student_mse_vs_teacher) + " " +
+                              std::to_string(result.student_mse_vs_truth));
+        runner.expectTrue(result.teacher_parameters == 193 && result.student_parameters == 19,
+                          "parameter counts include biases");
+        runner.expectTrue(result.speedup > 2.0 && result.teacher_predict_ns > result.student_predict_ns,
+                          "the small student predicts faster", std::to_string(result.speedup));
+    }
+
+    {
+        // Two inputs: uniform samples inside the data's bounding box
+        std::vector<double> X{0.0, 0.0, 1.0, 0.0, 0.0, 2.0, 1.0, 2.0};
+        std::vector<double> Y{0.0, 1.0, 2.0, 3.0};
+        NeuralNetwork teacher({2, 4, 1}, 0.1);
+        NeuralNetwork student({2, 2, 1}, 0.1);
+        DistillationOptions options;
+        options.samples = 64;
+        options.epochs = 2;
+        options.report_every_n_epochs = 100000;
+        const DistillationResult result = distill(teacher, student, X.data(), Y.data(), 4, options);
+        runner.expectTrue(result.samples == 64 && std::isfinite(result.student_mse_vs_teacher),
+                          "multi-input data is sampled in its bounding box");
+
+        NeuralNetwork wrong({3, 2, 1}, 0.1);
+        bool threw = false;
+        try {
+            distill(teacher, wrong, X.data(), Y.data(), 4, options);
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        runner.expectTrue(threw, "students with other input or output sizes throw");
+    }
+
+    if (runner.failed == 0) {
+        std::cout << "\nAll " << runner.total << " distillation tests passed." << std::endl;
+        return 0;
+    }
+
+    std::cerr << "\n" << runner.failed << " of " << runner.total << " distillation tests failed." << std::endl;
+    return 1;
+}
@@ -0,0 +1,90 @@
+#include "../inline_vector.h"
+
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct TestRunner {
+    int total{0};
+    int failed{0};
+
+    void expectTrue(bool condition, const std::string& name, const std::string& message = "") {
+        ++total;
+        if (!condition) {
+            ++failed;
+            std::cerr << "[FAIL] " << name;
+            if (!message.empty()) {
+                std::cerr << ": " << message;
+            }
+            std::cerr << std::endl;
+        } else {
+            std::cout << "[PASS] " << name << std::endl;
+        }
+    }
+};
+
+template <size_t N>
+bool equals(const InlineVector<N>& actual, const std::vector<double>& expected) {
+    return actual.to_vector() == expected;
+}
+
+} // namespace
+
+int main() {
+    TestRunner runner;
+
+    {
+        InlineVector<4> v = {1.0, 2.0, 3.0};
+        runner.expectTrue(v.is_inline() && v.size() == 3 && equals(v, {1.0, 2.0, 3.0}),
+                          "initializer list within capacity stays inline");
+        v.push_back(4.0);
+        runner.expectTrue(v.is_inline() && v.capacity() == 4, "filling to capacity stays inline");
+        v.push_back(5.0);
+        runner.expectTrue(!v.is_inline() && equals(v, {1.0, 2.0, 3.0, 4.0, 5.0}), "growing past capacity spills to heap");
+        v.resize(2);
+        runner.expectTrue(!v.is_inline() && v.capacity() >= 5 && equals(v, {1.0, 2.0}), "shrinking keeps heap capacity");
+        v.resize(4, 7.0);
+        runner.expectTrue(equals(v, {1.0, 2.0, 7.0, 7.0}), "resize fills new elements");
+    }
+
+    {
+        InlineVector<2> small = {1.0, 2.0};
+        InlineVector<2> copy = small;
+        copy[0] = 9.0;
+        runner.expectTrue(copy.is_inline() && small[0] == 1.0 && copy[0] == 9.0, "copies are independent");
+
+        InlineVector<2> moved = std::move(small);
+        runner.expectTrue(moved.is_inline() && equals(moved, {1.0, 2.0}) && small.empty(), "moving inline data copies it");
+
+        InlineVector<2> big(5, 3.0);
+        const double* heap = big.data();
+        InlineVector<2> taken = std::move(big);
+        runner.expectTrue(taken.data() == heap && big.empty() && big.is_inline(), "moving heap data steals the buffer");
+
+        taken = copy;
+        runner.expectTrue(equals(taken, {9.0, 2.0}), "copy assignment into a spilled vector");
+    }
+
+    {
+        const std::vector<double> source = {0.5, 1.5};
+        InlineVector<8> from_vector(source);
+        InlineVector<8> from_pointer(source.data(), source.size());
+        runner.expectTrue(equals(from_vector, source) && equals(from_pointer, source), "constructs from vector and pointer range");
+        double sum = 0.0;
+        for (double value : from_vector) {
+            sum += value;
+        }
+        runner.expectTrue(sum == 2.0, "range-for iterates the elements");
+    }
+
+    if (runner.failed == 0) {
+        std::cout << "\nAll " << runner.total << " inline vector tests passed." << std::endl;
+        return 0;
+    }
+
+    std::cerr << "\n" << runner.failed << " of " << runner.total << " inline vector tests failed." << std::endl;
+    return 1;
+}
@@ -0,0 +1,183 @@
+#include "../iterative_solver.h"
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TestRunner {
+    int total{0};
+    int failed{0};
+
+    void expectTrue(bool condition, const std::string& name, const std::string& message = "") {
+        ++total;
+        if (!condition) {
+            ++failed;
+            std::cerr << "[FAIL] " << name;
+            if (!message.empty()) {
+                std::cerr << ": " << message;
+            }
+            std::cerr << std::endl;
+        } else {
+            std::cout << "[PASS] " << name << std::endl;
+        }
+    }
+};
+
+// rows x cols design with columns on very different scales, and exact targets
+struct Problem {
+    size_t rows;
+    size_t cols;
+    std::vector<double> X;
+    std::vector<double> y;
+    std::vector<double> weights;
+    double intercept;
+};
+
+Problem makeProblem(size_t rows, size_t cols, unsigned seed) {
+    Problem problem{rows, cols, std::vector<double>(rows * cols), std::vector<double>(rows, 0.0),
+                    std::vector<double>(cols), -3.0};
+    std::mt19937 gen(seed);
+    std::normal_distribution<double> normal(0.0, 1.0);
+    for (size_t j = 0; j < cols; ++j) {
+        problem.weights[j] = normal(gen);
+    }
+    for (size_t i = 0; i < rows; ++i) {
+        double target = problem.intercept;
+        for (size_t j = 0; j < cols; ++j) {
+            const double scale = std::pow(10.0, static_cast<double>(j % 4)); // 1 .. 1000
+            const double value = scale * normal(gen) + 0.5;
+            problem.X[i * cols + j] = value;
+            target += value * problem.weights[j];
+        }
+        problem.y[i] = target;
+    }
+    return problem;
+}
+
+double maxError(const std::vector<double>& a, const std::vector<double>& b) {
+    double worst = 0.0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        worst = std::max(worst, std::fabs(a[i] - b[i]));
+    }
+    return worst;
+}
+
+// Diagonal design given only through its products
+class DiagonalDesign : public DesignOperator {
+public:
+    explicit DiagonalDesign(std::vector<double> diagonal) : diagonal_(std::move(diagonal)) {}
+    size_t rows() const override { return diagonal_.size(); }
+    size_t cols() const override { return diagonal_.size(); }
+    void multiply(const double* v, double* out) const override {
+        for (size_t i = 0; i < diagonal_.size(); ++i) out[i] = diagonal_[i] * v[i];
+    }
+    void multiply_transposed(const double* u, double* out) const override { multiply(u, out); }
+    void column_squared_norms(double* out) const override {
+        for (size_t i = 0; i < diagonal_.size(); ++i) out[i] = diagonal_[i] * diagonal_[i];
+    }
+
+private:
+    std::vector<double> diagonal_;
+};
+
+} // namespace
+
+int main() {
+    TestRunner runner;
+
+    {
+        const Problem problem = makeProblem(3000, 40, 7);
+        const DenseDesign design(problem.X.data(), problem.rows, problem.cols);
+        std::vector<double> v(problem.cols, 1.0);
+        std::vector<double> out(problem.rows);
+        design.multiply(v.data(), out.data());
+        double expected = 0.0;
+        for (size_t j = 0; j < problem.cols; ++j) {
+            expected += problem.X[1234 * problem.cols + j];
+        }
+        runner.expectTrue(std::fabs(out[1234] - expected) < 1e-9, "DenseDesign::multiply computes row sums");
+        std::vector<double> u(problem.rows, 1.0);
+        std::vector<double> column_sums(problem.cols);
+        design.multiply_transposed(u.data(), column_sums.data());
+        double column_0 = 0.0;
+        for (size_t i = 0; i < problem.rows; ++i) {
+            column_0 += problem.X[i * problem.cols];
+        }
+        runner.expectTrue(std::fabs(column_sums[0] - column_0) < 1e-6, "DenseDesign::multiply_transposed sums columns");
+
+        const IterativeSolveResult result = solveLeastSquaresCg(design, problem.y);
+        runner.expectTrue(result.converged && result.relative_residual <= 1e-10, "CG converges to tolerance",
+                          std::to_string(result.relative_residual));
+        runner.expectTrue(maxError(result.weights, problem.weights) < 1e-6 &&
+                              std::fabs(result.intercept - problem.intercept) < 1e-6,
+                          "CG recovers weights and intercept across badly scaled columns",
+                          std::to_string(maxError(result.weights, problem.weights)));
+        runner.expectTrue(result.iterations > 0 && result.iterations < 200 && result.elapsed_seconds >= 0.0,
+                          "CG reports iterations and time", std::to_string(result.iterations));
+
+        IterativeSolveOptions warm;
+        warm.initial_weights = result.weights;
+        warm.initial_intercept = result.intercept;
+        const IterativeSolveResult rerun = solveLeastSquaresCg(design, problem.y, warm);
+        runner.expectTrue(rerun.converged && rerun.iterations <= 1, "warm start from the solution stops immediately",
+                          std::to_string(rerun.iterations));
+
+        IterativeSolveOptions capped;
+        capped.max_iterations = 2;
+        const IterativeSolveResult partial = solveLeastSquaresCg(design, problem.y, capped);
+        runner.expectTrue(!partial.converged && partial.iterations == 2, "max_iterations caps the solve");
+    }
+
+    {
+        // A column of zeros is left at its starting value instead of dividing by zero
+        std::vector<double> X = {1.0, 0.0, 2.0, 0.0, 3.0, 0.0, 4.0, 0.0};
+        std::vector<double> y = {3.0, 5.0, 7.0, 9.0};
+        const IterativeSolveResult result = solveLeastSquaresCg(DenseDesign(X.data(), 4, 2), y);
+        runner.expectTrue(result.converged && std::fabs(result.weights[0] - 2.0) < 1e-9 && result.weights[1] == 0.0 &&
+                              std::fabs(result.intercept - 1.0) < 1e-9,
+                          "zero columns are tolerated");
+    }
+
+    {
+        const DiagonalDesign design({1.0, 2.0, 4.0});
+        const IterativeSolveResult result = solveLeastSquaresCg(design, {2.0, 2.0, 2.0});
+        std::vector<double> fitted(3);
+        design.multiply(result.weights.data(), fitted.data());
+        runner.expectTrue(result.converged && std::fabs(fitted[0] + result.intercept - 2.0) < 1e-9 &&
+                              std::fabs(fitted[2] + result.intercept - 2.0) < 1e-9,
+                          "any DesignOperator can be solved matrix-free");
+    }
+
+    {
+        std::vector<double> X = {1.0, 2.0};
+        bool threw = false;
+        try {
+            solveLeastSquaresCg(DenseDesign(X.data(), 2, 1), {1.0});
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        runner.expectTrue(threw, "mismatched y throws");
+        threw = false;
+        try {
+            IterativeSolveOptions options;
+            options.initial_weights = {1.0, 2.0};
+            solveLeastSquaresCg(DenseDesign(X.data(), 2, 1), {1.0, 2.0}, options);
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        runner.expectTrue(threw, "mismatched warm start throws");
+    }
+
+    if (runner.failed == 0) {
+        std::cout << "\nAll " << runner.total << " iterative solver tests passed." << std::endl;
+        return 0;
+    }
+
+    std::cerr << "\n" << runner.failed << " of " << runner.total << " iterative solver tests failed." << std::endl;
+    return 1;
+}
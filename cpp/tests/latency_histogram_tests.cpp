@@ -0,0 +1,122 @@
+#include "../latency_histogram.h"
+
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct TestRunner {
+    int total{0};
+    int failed{0};
+
+    void expectTrue(bool condition, const std::string& name, const std::string& message = "") {
+        ++total;
+        if (!condition) {
+            ++failed;
+            std::cerr << "[FAIL] " << name;
+            if (!message.empty()) {
+                std::cerr << ": " << message;
+            }
+            std::cerr << std::endl;
+        } else {
+            std::cout << "[PASS] " << name << std::endl;
+        }
+    }
+
+    void expectNear(double actual, double expected, double tolerance, const std::string& name) {
+        const double diff = std::fabs(actual - expected);
+        expectTrue(diff <= tolerance, name,
+                   "expected " + std::to_string(expected) + ", got " + std::to_string(actual) +
+                       ", diff " + std::to_string(diff) + ", tolerance " + std::to_string(tolerance));
+    }
+};
+
+} // namespace
+
+int main() {
+    TestRunner runner;
+
+    {
+        bool exact = true;
+        for (uint64_t v = 0; v < 64; ++v) {
+            if (LatencyHistogram::bucket_upper_bound(LatencyHistogram::bucket_index(v)) != v) {
+                exact = false;
+            }
+        }
+        runner.expectTrue(exact, "small values map to exact buckets");
+
+        bool bounded = true;
+        for (uint64_t v = 64; v < (uint64_t(1) << 40); v = v * 3 / 2 + 1) {
+            const uint64_t upper = LatencyHistogram::bucket_upper_bound(LatencyHistogram::bucket_index(v));
+            if (upper < v || static_cast<double>(upper - v) > v / 64.0) {
+                bounded = false;
+            }
+        }
+        runner.expectTrue(bounded, "bucket upper bound within 1/64 relative error");
+
+        runner.expectTrue(LatencyHistogram::bucket_index(~uint64_t(0)) == LatencyHistogram::kBucketCount - 1,
+                          "huge values clamp into last bucket");
+    }
+
+    {
+        LatencyHistogram histogram;
+        for (uint64_t v = 1; v <= 1000; ++v) {
+            histogram.record(v * 1000); // 1us .. 1ms
+        }
+        HistogramSnapshot snapshot = histogram.snapshot();
+        runner.expectTrue(snapshot.count() == 1000, "snapshot counts every sample");
+        runner.expectNear(snapshot.percentile(0.5), 500000.0, 500000.0 / 60, "p50 within bucket precision");
+        runner.expectNear(snapshot.percentile(0.99), 990000.0, 990000.0 / 60, "p99 within bucket precision");
+        runner.expectTrue(snapshot.percentile(1.0) == 1000000, "p100 clamps to observed max");
+        runner.expectTrue(snapshot.min() == 1000, "snapshot tracks min");
+        runner.expectNear(snapshot.mean(), 500500.0, 1e-6, "snapshot mean is exact");
+    }
+
+    {
+        LatencyHistogram histogram;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.push_back(std::thread([&histogram, t] {
+                for (int i = 0; i < 10000; ++i) {
+                    histogram.record(static_cast<uint64_t>(100 * (t + 1)));
+                }
+            }));
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        HistogramSnapshot snapshot = histogram.snapshot();
+        runner.expectTrue(snapshot.count() == 40000, "per-thread shards merge without losing samples");
+        runner.expectTrue(snapshot.max() == 400 && snapshot.min() == 100, "merged min/max span all threads");
+    }
+
+    {
+        HistogramSnapshot empty;
+        runner.expectTrue(empty.percentile(0.99) == 0 && empty.count() == 0, "empty snapshot reports zeros");
+    }
+
+    {
+        RequestLatencies latencies;
+        latencies.histogram("lr_predict", "compute").record(uint64_t(2000));
+        latencies.histogram("lr_predict", "compute").record(uint64_t(4000));
+        std::ostringstream out;
+        latencies.write_metrics(out);
+        const std::string text = out.str();
+        runner.expectTrue(text.find("# TYPE mlapp_request_latency_seconds summary") != std::string::npos &&
+                              text.find("stage=\"compute\",quantile=\"0.999\"") != std::string::npos &&
+                              text.find("mlapp_request_latency_seconds_count{operation=\"lr_predict\",stage=\"compute\"} 2") != std::string::npos,
+                          "request latencies export a Prometheus summary", text);
+    }
+
+    if (runner.failed == 0) {
+        std::cout << "\nAll " << runner.total << " latency histogram tests passed." << std::endl;
+        return 0;
+    }
+
+    std::cerr << "\n" << runner.failed << " of " << runner.total << " latency histogram tests failed." << std::endl;
+    return 1;
+}
@@ -138,6 +138,188 @@ int main() {
         runner.expectNear(model.get_mse(empty, empty), 0.0, 1e-12, "get_mse returns zero for empty dataset");
     }
 
+    {
+        LinearRegression model;
+        model.set_parameters(-0.5, 3.0);
+        std::vector<double> X(200003);
+        for (size_t i = 0; i < X.size(); ++i) {
+            X[i] = static_cast<double>(i) * 0.25 - 100.0;
+        }
+        const std::vector<double> batch = model.predict(X);
+        bool matches = batch.size() == X.size();
+        for (size_t i = 0; matches && i < X.size(); ++i) {
+            matches = std::fabs(batch[i] - model.predict(X[i])) <= 1e-12;
+        }
+        runner.expectTrue(matches, "batch predict matches scalar predict (parallel path)");
+
+        std::vector<double> out(5, 0.0);
+        model.predict(X.data(), 5, out.data(), false);
+        runner.expectNear(out[4], -0.5 * X[4] + 3.0, 1e-12, "batch predict into raw buffer (sequential path)");
+        runner.expectTrue(model.predict(std::vector<double>()).empty(), "batch predict of empty input is empty");
+    }
+
+    {
+        // Three targets sharing x; the third is noisy so its R^2 drops below one
+        const size_t rows = 1000;
+        std::vector<double> X(rows);
+        std::vector<double> Y(3 * rows);
+        for (size_t i = 0; i < rows; ++i) {
+            const double x = 1000.0 + 0.01 * static_cast<double>(i); // Far from zero: exercises the shift
+            X[i] = x;
+            Y[i] = 2.0 * x + 1.0;
+            Y[rows + i] = -0.5 * x + 7.0;
+            Y[2 * rows + i] = 3.0 * x + ((i % 2) ? 0.5 : -0.5);
+        }
+        const MultiTargetFit fit = LinearRegression::fit_multi_target(X, 1, Y, 3);
+        runner.expectNear(fit.weight(0, 0), 2.0, 1e-8, "multi-target slope of first target");
+        runner.expectNear(fit.intercepts[0], 1.0, 1e-5, "multi-target intercept of first target");
+        runner.expectNear(fit.weight(0, 1), -0.5, 1e-8, "multi-target slope of second target");
+        runner.expectNear(fit.intercepts[1], 7.0, 1e-5, "multi-target intercept of second target");
+
+        LinearRegression single;
+        const std::vector<double> noisy(Y.begin() + 2 * rows, Y.end());
+        single.fit_analytical(X, noisy);
+        runner.expectNear(fit.weight(0, 2), single.get_slope(), 1e-8, "multi-target matches fit_analytical per column");
+        runner.expectNear(fit.mse[2], single.get_mse(X, noisy), 1e-6, "multi-target mse from sufficient statistics");
+        runner.expectNear(fit.r_squared[2], single.get_r_squared(X, noisy), 1e-9, "multi-target r_squared matches");
+        runner.expectNear(fit.mse[0], 0.0, 1e-9, "multi-target mse is zero for exact targets");
+
+        double out[3];
+        fit.predict(&X[10], out);
+        runner.expectNear(out[1], -0.5 * X[10] + 7.0, 1e-6, "MultiTargetFit::predict scores every target");
+    }
+
+    {
+        // Two features, two targets
+        const size_t rows = 50;
+        std::vector<double> X(rows * 2);
+        std::vector<double> Y(rows * 2);
+        for (size_t i = 0; i < rows; ++i) {
+            const double u = static_cast<double>(i);
+            const double v = static_cast<double>((i * 7) % 11);
+            X[2 * i] = u;
+            X[2 * i + 1] = v;
+            Y[i] = 1.5 * u - 2.0 * v + 4.0;
+            Y[rows + i] = 0.25 * v - 1.0;
+        }
+        const MultiTargetFit fit = LinearRegression::fit_multi_target(X, 2, Y, 2);
+        runner.expectTrue(std::fabs(fit.weight(0, 0) - 1.5) < 1e-9 && std::fabs(fit.weight(1, 0) + 2.0) < 1e-9 &&
+                              std::fabs(fit.intercepts[0] - 4.0) < 1e-9 && std::fabs(fit.weight(0, 1)) < 1e-9 &&
+                              std::fabs(fit.weight(1, 1) - 0.25) < 1e-9 && std::fabs(fit.intercepts[1] + 1.0) < 1e-9,
+                          "multi-feature multi-target fit recovers coefficients");
+    }
+
+    {
+        LinearRegression model;
+        std::vector<double> X{1.0, 2.0, 3.0, 4.0, 5.0};
+        std::vector<double> y{3.0, 5.0, 7.0, 9.0, 11.0};
+        const IterativeSolveResult first = model.fit_iterative(X, y);
+        runner.expectNear(model.get_slope(), 2.0, 1e-9, "fit_iterative computes expected slope");
+        runner.expectNear(model.get_intercept(), 1.0, 1e-9, "fit_iterative computes expected intercept");
+        const IterativeSolveResult again = model.fit_iterative(X, y);
+        runner.expectTrue(first.converged && again.converged && again.iterations <= 1,
+                          "fit_iterative warm-starts from the current line");
+    }
+
+    {
+        // Three dense columns: y = 1.5 u - 2 v + 0.5 w + 4
+        const size_t rows = 300;
+        std::vector<double> X(rows * 3);
+        std::vector<double> y(rows);
+        for (size_t i = 0; i < rows; ++i) {
+            X[3 * i] = static_cast<double>(i) / 30.0;
+            X[3 * i + 1] = static_cast<double>((i * 7) % 11);
+            X[3 * i + 2] = std::sin(0.1 * static_cast<double>(i));
+            y[i] = 1.5 * X[3 * i] - 2.0 * X[3 * i + 1] + 0.5 * X[3 * i + 2] + 4.0;
+        }
+        LinearRegression model;
+        const IterativeSolveResult first = model.fit_iterative(DenseDesign(X.data(), rows, 3), y);
+        const std::vector<double>& w = model.get_weights();
+        runner.expectTrue(first.converged && w.size() == 3 && std::fabs(w[0] - 1.5) < 1e-8 &&
+                              std::fabs(w[1] + 2.0) < 1e-8 && std::fabs(w[2] - 0.5) < 1e-8 &&
+                              std::fabs(model.get_intercept() - 4.0) < 1e-8 &&
+                              std::fabs(model.predict_row(&X[30], 3) - y[10]) < 1e-8,
+                          "multi-feature fit_iterative recovers every weight");
+        const IterativeSolveResult again = model.fit_iterative(DenseDesign(X.data(), rows, 3), y);
+        runner.expectTrue(again.converged && again.iterations <= 1 && again.iterations < first.iterations,
+                          "multi-feature fit_iterative warm-starts from the stored weights",
+                          std::to_string(again.iterations));
+    }
+
+    {
+        // The same model through CsrMatrix rows (every value stored)
+        CsrMatrix X(2);
+        std::vector<double> y;
+        for (int i = 0; i < 100; ++i) {
+            const double u = i / 10.0;
+            const double v = static_cast<double>(i % 3);
+            X.add_row({{0, u}, {1, v}});
+            y.push_back(-u + 3.0 * v + 2.0);
+        }
+        LinearRegression model;
+        const IterativeSolveResult result = model.fit_iterative(X, y);
+        runner.expectTrue(result.converged && std::fabs(model.get_weights()[0] + 1.0) < 1e-8 &&
+                              std::fabs(model.get_weights()[1] - 3.0) < 1e-8 &&
+                              std::fabs(model.predict(X.row(5)) - y[5]) < 1e-8,
+                          "fit_iterative on a CsrMatrix goes through CsrDesign");
+    }
+
+    {
+        // Hashed one-hot city feature plus a numeric one; y depends on both
+        const FeatureHasher hasher(16);
+        CsrMatrix X(hasher.dimensions());
+        std::vector<double> y;
+        const char* cities[] = {"paris", "tokyo", "lima", "oslo"};
+        const double city_effect[] = {1.0, -2.0, 0.5, 3.0};
+        for (int i = 0; i < 400; ++i) {
+            const double size = static_cast<double>(i % 10) * 0.1;
+            hasher.append_row({{"size", size}}, {{"city", cities[i % 4]}}, X);
+            y.push_back(city_effect[i % 4] + 2.0 * size + 0.5);
+        }
+        LinearRegression model(0.1, 500, 16);
+        model.fit(X, y);
+        double worst = 0.0;
+        for (size_t i = 0; i < X.rows(); ++i) {
+            worst = std::max(worst, std::fabs(model.predict(X.row(i)) - y[i]));
+        }
+        runner.expectTrue(model.get_weights().size() == hasher.dimensions() && worst < 0.05,
+                          "sparse fit learns hashed one-hot and numeric features", std::to_string(worst));
+    }
+
+    {
+        std::vector<double> X;
+        std::vector<double> y;
+        for (int i = 0; i < 200; ++i) {
+            X.push_back(i / 20.0);
+            y.push_back(2.0 * X.back() + 1.0);
+        }
+        LinearRegression model(0.01, 200);
+        const LrRangeTestResult probe = model.lr_find(X, y);
+        runner.expectTrue(probe.suggested_learning_rate > 0.0 && probe.diverged && model.get_slope() == 0.0,
+                          "lr_find suggests a rate and leaves the model untouched",
+                          std::to_string(probe.suggested_learning_rate));
+        // Plain SGD on x up to 10 is only stable below about 2 / E[x^2] ~ 0.06
+        model.set_learning_rate(probe.suggested_learning_rate);
+        model.fit(X, y);
+        runner.expectTrue(probe.suggested_learning_rate < 0.06 && std::fabs(model.get_slope() - 2.0) < 0.05,
+                          "fit converges with the suggested rate", std::to_string(model.get_slope()));
+    }
+
+    runner.expectThrows("sparse fit rejects mismatched y", [] {
+        CsrMatrix X(4);
+        X.add_row({{1, 1.0}});
+        LinearRegression model;
+        model.fit(X, std::vector<double>{1.0, 2.0});
+    });
+
+    runner.expectThrows("fit_multi_target rejects mismatched Y", [] {
+        LinearRegression::fit_multi_target({1.0, 2.0, 3.0}, 1, {1.0, 2.0}, 1);
+    });
+
+    runner.expectThrows("fit_multi_target rejects a constant feature", [] {
+        LinearRegression::fit_multi_target({2.0, 2.0, 2.0}, 1, {1.0, 2.0, 3.0}, 1);
+    });
+
     if (runner.failed == 0) {
         std::cout << "\nAll " << runner.total << " C++ linear regression tests passed." << std::endl;
         return 0;
@@ -0,0 +1,174 @@
+#include "../local_sgd.h"
+
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TestRunner {
+    int total{0};
+    int failed{0};
+
+    void expectTrue(bool condition, const std::string& name, const std::string& message = "") {
+        ++total;
+        if (!condition) {
+            ++failed;
+            std::cerr << "[FAIL] " << name;
+            if (!message.empty()) {
+                std::cerr << ": " << message;
+            }
+            std::cerr << std::endl;
+        } else {
+            std::cout << "[PASS] " << name << std::endl;
+        }
+    }
+};
+
+// y = 0.5 + 0.4 sin(4x) on n evenly spaced x in [0, 1]
+void sineSamples(size_t n, std::vector<SampleVector>& inputs, std::vector<SampleVector>& targets) {
+    inputs.clear();
+    targets.clear();
+    for (size_t i = 0; i < n; ++i) {
+        const double x = static_cast<double>(i) / (n - 1);
+        const double y = 0.5 + 0.4 * std::sin(4.0 * x);
+        inputs.push_back(SampleVector(&x, 1));
+        targets.push_back(SampleVector(&y, 1));
+    }
+}
+
+double meanSquaredError(NeuralNetwork& network, const std::vector<SampleVector>& inputs,
+                        const std::vector<SampleVector>& targets) {
+    double sum = 0.0;
+    SampleVector prediction;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        network.predict_into(inputs[i].data(), 1, prediction);
+        sum += (prediction[0] - targets[i][0]) * (prediction[0] - targets[i][0]);
+    }
+    return sum / inputs.size();
+}
+
+} // namespace
+
+int main() {
+    TestRunner runner;
+    std::vector<SampleVector> inputs;
+    std::vector<SampleVector> targets;
+    sineSamples(200, inputs, targets);
+
+    {
+        NeuralNetwork network({1, 16, 1}, 0.1);
+        const double untrained = meanSquaredError(network, inputs, targets);
+        LocalSgdOptions options;
+        options.threads = 4;
+        options.report_every_n_epochs = 0;
+        const LocalSgdResult result = trainLocalSgd(network, inputs.data(), targets.data(), inputs.size(), 800, options);
+        const double trained = meanSquaredError(network, inputs, targets);
+        runner.expectTrue(result.threads == 4 && result.epochs == 800 && result.outcome.stopped_reason == "completed" &&
+                              result.outcome.learning_rate == 0.4,
+                          "four replicas run every epoch at the scaled learning rate", std::to_string(result.threads));
+        runner.expectTrue(trained < 0.01 && trained < untrained / 5.0, "averaged replicas fit the data",
+                          std::to_string(untrained) + " -> " + std::to_string(trained));
+        runner.expectTrue(std::fabs(result.final_mse - trained) < 1e-12,
+                          "the network holds the final average and final_mse scores it");
+        runner.expectTrue(result.rounds >= 800 && result.mean_sync_steps >= 1.0 && result.samples_per_second > 0.0,
+                          "rounds, sync steps and throughput are reported");
+    }
+
+    {
+        NeuralNetwork base({1, 8, 1}, 0.1);
+        LocalSgdOptions options;
+        options.threads = 4;
+        options.report_every_n_epochs = 0;
+        options.sync_steps = 8;
+
+        options.divergence_target = 1e-300; // Replicas always disagree more than this
+        NeuralNetwork tight = base;
+        const LocalSgdResult shrunk = trainLocalSgd(tight, inputs.data(), targets.data(), inputs.size(), 5, options);
+        options.divergence_target = 1e300;
+        NeuralNetwork loose = base;
+        const LocalSgdResult grown = trainLocalSgd(loose, inputs.data(), targets.data(), inputs.size(), 5, options);
+        runner.expectTrue(shrunk.final_sync_steps == 1 && grown.final_sync_steps == options.max_sync_steps,
+                          "H halves when replicas diverge and doubles when they agree",
+                          std::to_string(shrunk.final_sync_steps) + " " + std::to_string(grown.final_sync_steps));
+
+        options.adaptive = false;
+        options.sync_steps = 20;
+        NeuralNetwork fixed = base;
+        const LocalSgdResult constant = trainLocalSgd(fixed, inputs.data(), targets.data(), inputs.size(), 3, options);
+        // 200 samples in 4 shards of 50: rounds of 20, 20 and 10 steps per epoch
+        runner.expectTrue(constant.rounds == 9 && constant.final_sync_steps == 20 &&
+                              std::fabs(constant.mean_sync_steps - 50.0 / 3.0) < 1e-12,
+                          "fixed H syncs every H steps and at the end of each epoch",
+                          std::to_string(constant.rounds));
+    }
+
+    {
+        NeuralNetwork network({1, 8, 1}, 0.1);
+        LocalSgdOptions options;
+        options.threads = 2;
+        options.report_every_n_epochs = 0;
+        options.target_mse = 1e6;
+        options.stop_at_target = true;
+        const LocalSgdResult result = trainLocalSgd(network, inputs.data(), targets.data(), inputs.size(), 50, options);
+        runner.expectTrue(result.epochs == 1 && result.epochs_to_target == 1 && result.time_to_target_seconds >= 0.0 &&
+                              result.outcome.stopped_reason == "target reached",
+                          "reaching target_mse is timed and can stop training");
+    }
+
+    {
+        NeuralNetwork network({1, 8, 1}, 1e6);
+        std::vector<double> before;
+        network.get_parameters(before);
+        LocalSgdOptions options;
+        options.threads = 2;
+        options.report_every_n_epochs = 0;
+        options.sync_steps = 1;
+        options.adaptive = false;
+        const LocalSgdResult result = trainLocalSgd(network, inputs.data(), targets.data(), inputs.size(), 50, options);
+        std::vector<double> after;
+        network.get_parameters(after);
+        bool finite = true;
+        for (double value : after) {
+            finite = finite && std::isfinite(value);
+        }
+        runner.expectTrue(result.outcome.stopped_reason == "diverged" && finite,
+                          "a non-finite average stops training and keeps the last finite one",
+                          result.outcome.stopped_reason);
+    }
+
+    {
+        NeuralNetwork network({1, 8, 1}, 0.1);
+        std::atomic<bool> cancel(true);
+        LocalSgdOptions options;
+        options.threads = 2;
+        options.report_every_n_epochs = 0;
+        options.cancel = &cancel;
+        const LocalSgdResult result = trainLocalSgd(network, inputs.data(), targets.data(), inputs.size(), 50, options);
+        runner.expectTrue(result.outcome.stopped_reason == "cancelled" && result.rounds == 1 && result.epochs == 0 &&
+                              std::isfinite(result.final_mse),
+                          "cancellation is honoured at the next average");
+    }
+
+    {
+        NeuralNetwork network({2, 4, 1}, 0.1);
+        bool threw = false;
+        try {
+            trainLocalSgd(network, inputs.data(), targets.data(), inputs.size(), 1);
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        runner.expectTrue(threw, "samples that do not fit the network throw");
+    }
+
+    if (runner.failed == 0) {
+        std::cout << "\nAll " << runner.total << " local SGD tests passed." << std::endl;
+        return 0;
+    }
+
+    std::cerr << "\n" << runner.failed << " of " << runner.total << " local SGD tests failed." << std::endl;
+    return 1;
+}
@@ -0,0 +1,114 @@
+#include "../lr_finder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TestRunner {
+    int total{0};
+    int failed{0};
+
+    void expectTrue(bool condition, const std::string& name, const std::string& message = "") {
+        ++total;
+        if (!condition) {
+            ++failed;
+            std::cerr << "[FAIL] " << name;
+            if (!message.empty()) {
+                std::cerr << ": " << message;
+            }
+            std::cerr << std::endl;
+        } else {
+            std::cout << "[PASS] " << name << std::endl;
+        }
+    }
+};
+
+bool throwsInvalidArgument(const LrRangeTestOptions& options) {
+    try {
+        runLrRangeTest([](double) { return 1.0; }, options);
+    } catch (const std::invalid_argument&) {
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+int main() {
+    TestRunner runner;
+
+    {
+        // Gradient descent on 0.5 * curvature * w^2 converges for rates below
+        // 2 / curvature and diverges above it
+        const double curvature = 50.0;
+        double w = 1.0;
+        const LrRangeTestResult result = runLrRangeTest([&](double learning_rate) {
+            const double loss = 0.5 * curvature * w * w;
+            w -= learning_rate * curvature * w;
+            return loss;
+        });
+        runner.expectTrue(result.diverged && result.learning_rates.size() < 200 &&
+                              result.learning_rates.back() > 2.0 / curvature,
+                          "the sweep stops once the loss diverges", std::to_string(result.learning_rates.size()));
+        runner.expectTrue(result.suggested_learning_rate > 1e-3 / curvature &&
+                              result.suggested_learning_rate < 2.0 / curvature,
+                          "the suggestion is a stable rate", std::to_string(result.suggested_learning_rate));
+        runner.expectTrue(result.suggested_learning_rate <= result.min_loss_learning_rate,
+                          "the suggestion lies below the loss minimum");
+        bool increasing = result.losses.size() == result.learning_rates.size();
+        for (size_t k = 1; increasing && k < result.learning_rates.size(); ++k) {
+            increasing = result.learning_rates[k] > result.learning_rates[k - 1];
+        }
+        runner.expectTrue(increasing && std::fabs(result.learning_rates[0] - 1e-6) < 1e-18,
+                          "learning rates grow geometrically from the minimum");
+    }
+
+    {
+        int calls = 0;
+        LrRangeTestOptions options;
+        options.steps = 50;
+        const LrRangeTestResult flat = runLrRangeTest([&](double) { ++calls; return 3.0; }, options);
+        runner.expectTrue(calls == 50 && !flat.diverged && flat.suggested_learning_rate > 0.0,
+                          "a flat loss runs every step and still suggests a rate");
+
+        const LrRangeTestResult nan = runLrRangeTest([](double learning_rate) {
+            return learning_rate > 1e-3 ? std::nan("") : 1.0 / (1.0 + learning_rate);
+        });
+        runner.expectTrue(nan.diverged && nan.learning_rates.back() <= 1e-3, "NaN losses stop the sweep");
+    }
+
+    {
+        LrRangeTestOptions inverted;
+        inverted.min_learning_rate = 1.0;
+        inverted.max_learning_rate = 0.1;
+        LrRangeTestOptions short_sweep;
+        short_sweep.steps = 2;
+        runner.expectTrue(throwsInvalidArgument(inverted) && throwsInvalidArgument(short_sweep),
+                          "invalid ranges throw");
+    }
+
+    {
+        LrRangeTestOptions options;
+        options.max_samples = 100;
+        std::vector<size_t> indices = rangeTestSubsample(1000, options);
+        std::sort(indices.begin(), indices.end());
+        runner.expectTrue(indices.size() == 100 && indices[0] == 0 && indices[1] == 10 && indices[99] == 990,
+                          "subsamples are strided");
+        runner.expectTrue(rangeTestSubsample(1000, options) == rangeTestSubsample(1000, options) &&
+                              rangeTestSubsample(5, options).size() == 5,
+                          "subsamples are reproducible and capped by the data");
+    }
+
+    if (runner.failed == 0) {
+        std::cout << "\nAll " << runner.total << " lr finder tests passed." << std::endl;
+        return 0;
+    }
+
+    std::cerr << "\n" << runner.failed << " of " << runner.total << " lr finder tests failed." << std::endl;
+    return 1;
+}
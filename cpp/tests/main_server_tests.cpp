@@ -136,6 +136,92 @@ int main() {
                           "printUsage prints usage header");
     }
 
+    {
+        const char* argv[] = {"app", "lr_predict", "-1.5", "--metrics-file", "out.prom", "0.5", "--metrics-interval-ms=250", "2"};
+        CliArgs args = parseCliArgs(8, const_cast<char**>(argv));
+        runner.expectTrue(args.positional.size() == 4 && args.positional[1] == "-1.5" && args.positional[3] == "2",
+                          "parseCliArgs keeps negative numbers positional");
+        runner.expectTrue(optionString(args, "metrics-file", "") == "out.prom" &&
+                              optionInt(args, "metrics-interval-ms", 0) == 250,
+                          "parseCliArgs accepts both option spellings");
+    }
+
+    {
+        std::istringstream text("1, 2\n-3.5 ");
+        const std::vector<double> parsed = readNumbersToEof(text, "text");
+        const double raw[] = {0.5, -2.0};
+        std::istringstream binary(std::string(reinterpret_cast<const char*>(raw), sizeof(raw)));
+        const std::vector<double> decoded = readNumbersToEof(binary, "binary");
+        runner.expectTrue(parsed == std::vector<double>({1.0, 2.0, -3.5}) &&
+                              decoded == std::vector<double>({0.5, -2.0}),
+                          "readNumbersToEof reads text and raw float64 input");
+    }
+
+    runner.expectThrows("readNumbersToEof rejects truncated binary input", [] {
+        std::istringstream binary(std::string(12, '\0'));
+        readNumbersToEof(binary, "binary");
+    });
+
+    runner.expectThrows("parseCliArgs rejects unknown options", [] {
+        const char* argv[] = {"app", "lr_train", "--no-such-option", "1"};
+        parseCliArgs(4, const_cast<char**>(argv));
+    });
+
+    runner.expectThrows("parseCliArgs rejects option without value", [] {
+        const char* argv[] = {"app", "lr_train", "--metrics-file"};
+        parseCliArgs(3, const_cast<char**>(argv));
+    });
+
+    runner.expectThrows("optionInt rejects non-integer values", [] {
+        const char* argv[] = {"app", "lr_train", "--metrics-interval-ms", "fast"};
+        CliArgs args = parseCliArgs(4, const_cast<char**>(argv));
+        optionInt(args, "metrics-interval-ms", 0);
+    });
+
+    {
+        TrainingProgress progress;
+        progress.epoch = 3;
+        progress.samples_processed = 30;
+        progress.last_loss = 0.25;
+        std::ostringstream out;
+        writeTrainingMetrics(out, progress);
+        runner.expectTrue(out.str().find("mlapp_training_epoch 3") != std::string::npos &&
+                              out.str().find("mlapp_training_loss 0.25") != std::string::npos,
+                          "writeTrainingMetrics exports epoch and loss");
+    }
+
+    {
+        DatasetCacheCounters counters;
+        counters.record("hit");
+        counters.record("failed: disk full");
+        StreamQueueGauges gauges;
+        StreamPipelineOptions options;
+        options.queue_depth = 3;
+        options.queue_gauges = &gauges;
+        std::istringstream in("1 2 3");
+        std::ostringstream predictions;
+        runPredictStream(in, predictions, [](const double* x, size_t n, double* y) {
+            std::copy(x, x + n, y);
+        }, options);
+
+        MetricsRegistry registry;
+        ScopedCollector cache_collector(registry, [&counters](std::ostream& out) {
+            writeDatasetCacheMetrics(out, counters);
+        });
+        ScopedCollector queue_collector(registry, [&gauges](std::ostream& out) {
+            writeStreamQueueMetrics(out, gauges);
+        });
+        const std::string rendered = registry.render();
+        runner.expectTrue(rendered.find("mlapp_dataset_cache_lookups_total{result=\"hit\"} 1") != std::string::npos &&
+                              rendered.find("mlapp_dataset_cache_lookups_total{result=\"failed\"} 1") != std::string::npos &&
+                              rendered.find("mlapp_dataset_cache_lookups_total{result=\"written\"} 0") != std::string::npos,
+                          "dataset sidecar lookups are exported by outcome", rendered);
+        runner.expectTrue(rendered.find("mlapp_stream_queue_depth{queue=\"input\"} 0") != std::string::npos &&
+                              rendered.find("mlapp_stream_queue_depth{queue=\"done\"} 0") != std::string::npos &&
+                              rendered.find("mlapp_stream_queue_capacity 3") != std::string::npos,
+                          "predict_stream queue depths are exported after the stream drains", rendered);
+    }
+
     if (runner.failed == 0) {
         std::cout << "\nAll " << runner.total << " CLI helper tests passed." << std::endl;
         return 0;
@@ -0,0 +1,135 @@
+#include "../metrics.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+struct TestRunner {
+    int total{0};
+    int failed{0};
+
+    void expectTrue(bool condition, const std::string& name, const std::string& message = "") {
+        ++total;
+        if (!condition) {
+            ++failed;
+            std::cerr << "[FAIL] " << name;
+            if (!message.empty()) {
+                std::cerr << ": " << message;
+            }
+            std::cerr << std::endl;
+        } else {
+            std::cout << "[PASS] " << name << std::endl;
+        }
+    }
+};
+
+bool contains(const std::string& text, const std::string& needle) {
+    return text.find(needle) != std::string::npos;
+}
+
+} // namespace
+
+int main() {
+    TestRunner runner;
+
+    // The dumper has to exist before any other thread is started.
+    std::ostringstream dump_sink;
+    StateDumper dumper([](std::ostream& out) { out << "training_epoch=7\n"; });
+
+    {
+        std::ostringstream out;
+        writeMetric(out, "mlapp_test_value", "gauge", "A test gauge.", 2.5);
+        runner.expectTrue(out.str() == "# HELP mlapp_test_value A test gauge.\n"
+                                       "# TYPE mlapp_test_value gauge\n"
+                                       "mlapp_test_value 2.5\n",
+                          "writeMetric emits HELP, TYPE and sample lines", out.str());
+    }
+
+    {
+        std::ostringstream out;
+        writeMetricSample(out, "mlapp_nan", std::numeric_limits<double>::quiet_NaN(), "phase=\"x\"");
+        runner.expectTrue(out.str() == "mlapp_nan{phase=\"x\"} NaN\n", "writeMetricSample spells NaN and labels", out.str());
+    }
+
+    {
+        MetricsRegistry registry;
+        {
+            ScopedCollector collector(registry, [](std::ostream& out) {
+                writeMetric(out, "mlapp_scoped", "counter", "Scoped.", 1.0);
+            });
+            runner.expectTrue(contains(registry.render(), "mlapp_scoped 1"), "registry renders registered collector");
+        }
+        runner.expectTrue(registry.render().empty(), "ScopedCollector unregisters on destruction");
+    }
+
+    {
+        PhaseTimers phases;
+        runner.expectTrue(phases.current_phase() == "idle", "phase timers start idle");
+        {
+            auto outer = phases.measure("train");
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            {
+                auto inner = phases.measure("evaluate");
+                runner.expectTrue(phases.current_phase() == "evaluate", "nested phase becomes current");
+            }
+            runner.expectTrue(phases.current_phase() == "train", "outer phase restored after nested scope");
+        }
+        auto totals = phases.totals_seconds();
+        runner.expectTrue(totals["train"] >= 0.004, "phase timer accumulates elapsed time");
+        std::ostringstream out;
+        phases.write_metrics(out);
+        runner.expectTrue(contains(out.str(), "mlapp_phase_seconds_total{phase=\"train\"}"),
+                          "phase timers export labelled counter", out.str());
+    }
+
+    {
+        MetricsRegistry registry;
+        ScopedCollector collector(registry, [](std::ostream& out) {
+            writeMetric(out, "mlapp_file_metric", "gauge", "File export.", 42.0);
+        });
+        const std::string path = "metrics_tests_output.prom";
+        {
+            MetricsFileExporter exporter(path, 10, registry);
+            std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        }
+        std::ifstream file(path.c_str());
+        std::stringstream content;
+        content << file.rdbuf();
+        runner.expectTrue(contains(content.str(), "mlapp_file_metric 42"), "file exporter writes exposition", content.str());
+        std::remove(path.c_str());
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    {
+        auto* original = std::cerr.rdbuf(dump_sink.rdbuf());
+        kill(getpid(), SIGUSR1);
+        for (int i = 0; i < 200 && dumper.dump_count() == 0; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        std::cerr.rdbuf(original);
+        runner.expectTrue(dumper.dump_count() == 1, "SIGUSR1 triggers exactly one state dump");
+        runner.expectTrue(contains(dump_sink.str(), "training_epoch=7"), "state dump contains callback output",
+                          dump_sink.str());
+    }
+#endif
+
+    if (runner.failed == 0) {
+        std::cout << "\nAll " << runner.total << " metrics tests passed." << std::endl;
+        return 0;
+    }
+
+    std::cerr << "\n" << runner.failed << " of " << runner.total << " metrics tests failed." << std::endl;
+    return 1;
+}
@@ -3,9 +3,12 @@
 #undef private
 
 #include <cmath>
+#include <algorithm>
 #include <functional>
 #include <iostream>
 #include <limits>
+#include <numeric>
+#include <random>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -136,6 +139,244 @@ int main() {
                           "predict remains numerically stable after training");
     }
 
+    {
+        // Two targets share one hidden layer; predictions come back sample-major
+        NeuralNetwork nn({1, 6, 2}, 0.1);
+        std::vector<Vector> inputs;
+        std::vector<Vector> targets;
+        for (int i = 0; i <= 10; ++i) {
+            const double x = i / 10.0;
+            inputs.push_back({x});
+            targets.push_back({x, 1.0 - 0.5 * x});
+        }
+        const Vector predictions = nn.train_for_epochs(inputs, targets, 400, 1000);
+        runner.expectTrue(predictions.size() == 2 * inputs.size(), "train_for_epochs returns every output of every sample");
+        const Vector last = nn.predict(inputs.back());
+        runner.expectTrue(last.size() == 2 && last[0] == predictions[20] && last[1] == predictions[21],
+                          "sample-major layout matches predict");
+
+        Vector flat_targets;
+        for (const Vector& target : targets) {
+            flat_targets.insert(flat_targets.end(), target.begin(), target.end());
+        }
+        const Vector losses = NeuralNetwork::mean_squared_error_per_output(predictions.data(), flat_targets.data(),
+                                                                          inputs.size(), 2);
+        runner.expectTrue(losses.size() == 2 && losses[0] < 0.01 && losses[1] < 0.01, "both outputs are learned",
+                          std::to_string(losses[0]) + " " + std::to_string(losses[1]));
+    }
+
+    {
+        const double predicted[] = {1.0, 2.0, 3.0, 6.0};
+        const double target[] = {0.0, 2.0, 1.0, 2.0};
+        const Vector losses = NeuralNetwork::mean_squared_error_per_output(predicted, target, 2, 2);
+        runner.expectTrue(losses.size() == 2 && losses[0] == 2.5 && losses[1] == 8.0,
+                          "mean_squared_error_per_output averages each column");
+    }
+
+    {
+        // Sparse and dense inputs must give identical predictions and updates
+        NeuralNetwork dense_nn({6, 3, 1}, 0.1);
+        NeuralNetwork sparse_nn = dense_nn;
+        CsrMatrix rows(6);
+        rows.add_row({{1, 0.5}, {4, -2.0}});
+        const Vector dense_input{0.0, 0.5, 0.0, 0.0, -2.0, 0.0};
+        const Vector target{0.3};
+
+        const Vector dense_prediction = dense_nn.predict(dense_input);
+        const Vector sparse_prediction = sparse_nn.predict_sparse(rows.row(0));
+        runner.expectNear(sparse_prediction[0], dense_prediction[0], 1e-12, "predict_sparse matches dense predict");
+
+        const double untouched = sparse_nn.weights_[0][2][3];
+        dense_nn.train(dense_input, target);
+        sparse_nn.train_sparse(rows.row(0), target);
+        bool same = true;
+        for (size_t layer = 0; layer < dense_nn.weights_.size(); ++layer) {
+            for (size_t r = 0; r < dense_nn.weights_[layer].size(); ++r) {
+                for (size_t c = 0; c < dense_nn.weights_[layer][r].size(); ++c) {
+                    same = same && std::fabs(dense_nn.weights_[layer][r][c] - sparse_nn.weights_[layer][r][c]) < 1e-12;
+                }
+            }
+        }
+        runner.expectTrue(same, "train_sparse applies the same update as dense train");
+        runner.expectTrue(sparse_nn.weights_[0][2][3] == untouched, "train_sparse leaves inactive columns untouched");
+    }
+
+    {
+        // A far too large step blows up within a few epochs
+        std::vector<Vector> inputs;
+        std::vector<Vector> targets;
+        for (int i = 0; i <= 20; ++i) {
+            inputs.push_back({i / 20.0});
+            targets.push_back({100.0 * i / 20.0});
+        }
+        NeuralNetwork diverging({1, 4, 1}, 5.0);
+        const Vector predictions = diverging.train_for_epochs(inputs, targets, 1000, 100000);
+        const TrainingOutcome& outcome = diverging.training_outcome();
+        runner.expectTrue(outcome.stopped_reason == "diverged" && outcome.stopped_epoch >= 1 &&
+                              outcome.stopped_epoch < 1000 && diverging.training_progress().epoch.load() < 1000,
+                          "divergence stops the run early", outcome.stopped_reason + " at " +
+                                                                std::to_string(outcome.stopped_epoch));
+        bool finite = true;
+        for (double prediction : predictions) {
+            finite = finite && std::isfinite(prediction);
+        }
+        runner.expectTrue(finite && diverging.parameters_finite(), "a diverged run keeps its last healthy weights");
+
+        NeuralNetwork recovering({1, 4, 1}, 5.0);
+        TrainingOptions options;
+        options.max_rollbacks = 10;
+        recovering.set_training_options(options);
+        recovering.train_for_epochs(inputs, targets, 50, 100000);
+        const TrainingOutcome& recovered = recovering.training_outcome();
+        runner.expectTrue(recovered.stopped_reason == "completed" && recovered.rollbacks >= 1 &&
+                              recovered.learning_rate < 5.0 && recovered.max_gradient_norm > 0.0,
+                          "rollbacks lower the learning rate and finish the run",
+                          std::to_string(recovered.rollbacks) + " rollbacks");
+
+        NeuralNetwork healthy({1, 4, 1}, 0.01);
+        healthy.train_for_epochs(inputs, targets, 20, 100000);
+        runner.expectTrue(healthy.training_outcome().stopped_reason == "completed" &&
+                              healthy.training_outcome().rollbacks == 0,
+                          "a stable run completes");
+        healthy.biases_[0][1] = std::numeric_limits<double>::infinity();
+        runner.expectTrue(!healthy.parameters_finite(), "the weight scan finds non-finite values");
+    }
+
+    {
+        std::vector<Vector> inputs;
+        std::vector<Vector> targets;
+        for (int i = 0; i <= 40; ++i) {
+            inputs.push_back({i / 40.0});
+            targets.push_back({std::sin(3.0 * i / 40.0)});
+        }
+        NeuralNetwork nn({1, 6, 1}, 0.001);
+        const Matrix before = nn.weights_[0];
+        const LrRangeTestResult probe = nn.lr_find(inputs, targets);
+        runner.expectTrue(nn.weights_[0] == before && nn.learning_rate() == 0.001,
+                          "lr_find probes a copy of the network");
+        runner.expectTrue(probe.suggested_learning_rate > 1e-4 && probe.suggested_learning_rate < 10.0 &&
+                              probe.suggested_learning_rate <= probe.min_loss_learning_rate,
+                          "lr_find suggests a rate below the loss minimum",
+                          std::to_string(probe.suggested_learning_rate));
+    }
+
+    {
+        NeuralNetwork nn({2, 3, 1});
+        Vector parameters;
+        nn.get_parameters(parameters);
+        runner.expectTrue(parameters.size() == nn.parameter_count() && parameters[0] == nn.weights_[0][0][0] &&
+                              parameters[6] == nn.biases_[0][0] && parameters[9] == nn.weights_[1][0][0] &&
+                              parameters.back() == nn.biases_[1][0],
+                          "get_parameters flattens weight rows, then biases, layer by layer");
+        for (double& value : parameters) {
+            value += 1.0;
+        }
+        NeuralNetwork other({2, 3, 1});
+        other.set_parameters(parameters);
+        const Vector input{0.3, -0.2};
+        nn.set_parameters(parameters);
+        runner.expectTrue(other.predict(input)[0] == nn.predict(input)[0] && other.weights_[1][0][2] == nn.weights_[1][0][2],
+                          "set_parameters loads a flat parameter vector");
+    }
+
+    {
+        Vector first, same, other;
+        NeuralNetwork({2, 5, 1}, 0.1, 7).get_parameters(first);
+        NeuralNetwork({2, 5, 1}, 0.1, 7).get_parameters(same);
+        NeuralNetwork({2, 5, 1}, 0.1, 8).get_parameters(other);
+        runner.expectTrue(first == same && first != other, "a seed fixes the initial weights");
+    }
+
+    {
+        std::vector<Vector> inputs;
+        std::vector<Vector> targets;
+        for (int i = 0; i < 20; ++i) {
+            inputs.push_back({i / 19.0});
+            targets.push_back({0.2 + 0.5 * i / 19.0});
+        }
+        NeuralNetwork nn({1, 4, 1}, 0.1, 3);
+        TrainingOptions options;
+        options.target_mse = 1e6;
+        nn.set_training_options(options);
+        nn.train_for_epochs(inputs, targets, 50, 0);
+        runner.expectTrue(nn.training_outcome().stopped_reason == "target reached" &&
+                              nn.training_outcome().stopped_epoch == 1 && nn.training_progress().epoch.load() == 1,
+                          "training stops at the first epoch that reaches target_mse");
+
+        std::atomic<bool> cancel(true);
+        options.target_mse = 0.0;
+        options.cancel = &cancel;
+        nn.set_training_options(options);
+        Vector before, after;
+        nn.get_parameters(before);
+        nn.train_for_epochs(inputs, targets, 50, 0);
+        nn.get_parameters(after);
+        runner.expectTrue(nn.training_outcome().stopped_reason == "cancelled" && before == after &&
+                              nn.training_progress().epoch.load() == 0,
+                          "a set cancel flag stops training before the next sample");
+    }
+
+    {
+        std::vector<Vector> inputs;
+        std::vector<Vector> targets;
+        for (int i = 0; i < 40; ++i) {
+            inputs.push_back({i / 39.0});
+            targets.push_back({0.5 + 0.4 * std::sin(4.0 * i / 39.0)});
+        }
+        NeuralNetwork nn({1, 6, 1}, 0.1, 5);
+        TrainingOptions options;
+        options.validation_fraction = 0.25;
+        nn.set_training_options(options);
+        nn.train_for_epochs(inputs, targets, 30, 0);
+        const TrainingOutcome& outcome = nn.training_outcome();
+        runner.expectTrue(outcome.validation_samples == 10 && nn.training_progress().samples_processed.load() == 30 * 30 &&
+                              outcome.validation_evaluations >= 1 &&
+                              outcome.validation_evaluations + outcome.validation_snapshots_dropped == 30 &&
+                              outcome.best_validation_mse <= outcome.final_validation_mse,
+                          "a validation fraction holds samples out and every snapshot is scored or dropped");
+
+        // The held-out indices, drawn the way train_for_epochs draws them
+        std::vector<size_t> order(inputs.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::mt19937 split(options.validation_seed);
+        std::shuffle(order.begin(), order.end(), split);
+        double mse = 0.0;
+        for (size_t i = 30; i < order.size(); ++i) {
+            const double error = nn.predict(inputs[order[i]])[0] - targets[order[i]][0];
+            mse += error * error / 10.0;
+        }
+        runner.expectNear(mse, outcome.best_validation_mse, 1e-12, "training ends with the best-scoring snapshot");
+
+        options.patience = 1;
+        options.min_improvement = 1.0; // Nothing after the first score counts as better
+        nn.set_training_options(options);
+        nn.train_for_epochs(inputs, targets, 100000, 0);
+        runner.expectTrue(nn.training_outcome().stopped_reason == "early stopped" &&
+                              nn.training_outcome().stopped_epoch < 100000 &&
+                              nn.training_outcome().validation_evaluations >= 2,
+                          "validation without improvement stops training early");
+    }
+
+    runner.expectThrows("train_for_epochs rejects a validation fraction outside [0, 1)", [] {
+        NeuralNetwork nn({1, 2, 1});
+        TrainingOptions options;
+        options.validation_fraction = 1.0;
+        nn.set_training_options(options);
+        nn.train_for_epochs(std::vector<Vector>{{0.0}, {1.0}}, std::vector<Vector>{{0.0}, {1.0}}, 1);
+    });
+
+    runner.expectThrows("set_parameters rejects a wrong size", [] {
+        NeuralNetwork nn({2, 3, 1});
+        nn.set_parameters(Vector(5, 0.0));
+    });
+
+    runner.expectThrows("predict_sparse rejects columns beyond the input layer", [] {
+        NeuralNetwork nn({3, 2, 1});
+        CsrMatrix rows(10);
+        rows.add_row({{5, 1.0}});
+        nn.predict_sparse(rows.row(0));
+    });
+
     runner.expectThrows("train_for_epochs rejects mismatched dataset sizes", [] {
         NeuralNetwork nn({1, 2, 1});
         std::vector<Vector> inputs{{0.0}};
@@ -0,0 +1,62 @@
+#include "../perf_counters.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TestRunner {
+    int total{0};
+    int failed{0};
+
+    void expectTrue(bool condition, const std::string& name, const std::string& message = "") {
+        ++total;
+        if (!condition) {
+            ++failed;
+            std::cerr << "[FAIL] " << name;
+            if (!message.empty()) {
+                std::cerr << ": " << message;
+            }
+            std::cerr << std::endl;
+        } else {
+            std::cout << "[PASS] " << name << std::endl;
+        }
+    }
+};
+
+} // namespace
+
+int main() {
+    TestRunner runner;
+
+    TlbMissCounter counter;
+    runner.expectTrue(counter.available() != !counter.error().empty(), "either available or explains why not",
+                      counter.error());
+
+    counter.start();
+    // Strided walk over 64MB: one touch per 4KB page
+    std::vector<char> memory(64 << 20, 1);
+    long sum = 0;
+    for (size_t i = 0; i < memory.size(); i += 4096) {
+        sum += memory[i];
+    }
+    counter.stop();
+    const uint64_t misses = counter.dtlb_load_misses();
+    if (counter.available()) {
+        runner.expectTrue(misses > 0, "page-strided walk records dTLB misses", std::to_string(misses));
+        runner.expectTrue(counter.dtlb_load_misses() == misses, "stopped counter no longer changes");
+    } else {
+        std::cout << "[SKIP] dTLB counter unavailable: " << counter.error() << std::endl;
+        runner.expectTrue(misses == 0, "unavailable counter reads zero");
+    }
+    runner.expectTrue(sum == 64 * 256, "walk touched every page");
+
+    if (runner.failed == 0) {
+        std::cout << "\nAll " << runner.total << " perf counter tests passed." << std::endl;
+        return 0;
+    }
+
+    std::cerr << "\n" << runner.failed << " of " << runner.total << " perf counter tests failed." << std::endl;
+    return 1;
+}
@@ -0,0 +1,200 @@
+#include "../range_index.h"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TestRunner {
+    int total{0};
+    int failed{0};
+
+    void expectTrue(bool condition, const std::string& name, const std::string& message = "") {
+        ++total;
+        if (!condition) {
+            ++failed;
+            std::cerr << "[FAIL] " << name;
+            if (!message.empty()) {
+                std::cerr << ": " << message;
+            }
+            std::cerr << std::endl;
+        } else {
+            std::cout << "[PASS] " << name << std::endl;
+        }
+    }
+};
+
+// Two-pass reference fit over the points with x in [lo, hi]
+RangeFit bruteForce(const std::vector<double>& X, const std::vector<double>& y, double lo, double hi) {
+    std::vector<double> xs;
+    std::vector<double> ys;
+    for (size_t i = 0; i < X.size(); ++i) {
+        if (X[i] >= lo && X[i] <= hi) {
+            xs.push_back(X[i]);
+            ys.push_back(y[i]);
+        }
+    }
+    double mx = 0.0, my = 0.0;
+    for (size_t i = 0; i < xs.size(); ++i) {
+        mx += xs[i];
+        my += ys[i];
+    }
+    mx /= xs.size();
+    my /= xs.size();
+    double sxx = 0.0, sxy = 0.0, syy = 0.0;
+    for (size_t i = 0; i < xs.size(); ++i) {
+        sxx += (xs[i] - mx) * (xs[i] - mx);
+        sxy += (xs[i] - mx) * (ys[i] - my);
+        syy += (ys[i] - my) * (ys[i] - my);
+    }
+    RangeFit fit;
+    fit.count = xs.size();
+    fit.slope = sxx < 1e-10 ? 0.0 : sxy / sxx;
+    fit.intercept = my - fit.slope * mx;
+    double rss = 0.0;
+    for (size_t i = 0; i < xs.size(); ++i) {
+        const double e = ys[i] - (fit.slope * xs[i] + fit.intercept);
+        rss += e * e;
+    }
+    fit.mse = rss / xs.size();
+    fit.r_squared = syy > 0.0 ? 1.0 - rss / syy : 1.0;
+    return fit;
+}
+
+bool close(double a, double b, double tolerance) {
+    return std::fabs(a - b) <= tolerance * std::max(1.0, std::fabs(b));
+}
+
+} // namespace
+
+int main() {
+    TestRunner runner;
+
+    {
+        CompensatedSum sum;
+        sum.add(1e16);
+        for (int i = 0; i < 1000; ++i) {
+            sum.add(1.0);
+        }
+        sum.add(-1e16);
+        runner.expectTrue(sum.value() == 1000.0, "CompensatedSum keeps addends a plain double would drop");
+    }
+
+    {
+        // Unsorted input, large enough for a multi-chunk parallel sort
+        const size_t n = 50000;
+        std::mt19937 gen(3);
+        std::uniform_real_distribution<double> uniform(-50.0, 50.0);
+        std::normal_distribution<double> noise(0.0, 0.3);
+        std::vector<double> X(n), y(n);
+        for (size_t i = 0; i < n; ++i) {
+            X[i] = uniform(gen);
+            y[i] = (X[i] < 0 ? 2.0 * X[i] : -0.5 * X[i]) + 4.0 + noise(gen);
+        }
+        const RangeRegressionIndex index(X, y);
+        bool sorted = index.size() == n;
+        for (size_t i = 1; sorted && i < n; ++i) {
+            sorted = index.sorted_x()[i - 1] <= index.sorted_x()[i];
+        }
+        runner.expectTrue(sorted, "index sorts points by x");
+
+        const double ranges[][2] = {{-50.0, 50.0}, {-10.0, -2.0}, {3.0, 3.5}, {-0.01, 0.01}, {-60.0, -49.99}};
+        bool matches = true;
+        std::string detail;
+        for (const auto& range : ranges) {
+            const RangeFit fast = index.fit_range(range[0], range[1]);
+            const RangeFit slow = bruteForce(X, y, range[0], range[1]);
+            const bool ok = fast.count == slow.count && close(fast.slope, slow.slope, 1e-9) &&
+                            close(fast.intercept, slow.intercept, 1e-9) && close(fast.mse, slow.mse, 1e-8) &&
+                            close(fast.r_squared, slow.r_squared, 1e-8);
+            if (!ok) {
+                detail += std::to_string(range[0]) + ".." + std::to_string(range[1]) + " ";
+            }
+            matches = matches && ok;
+        }
+        runner.expectTrue(matches, "range fits match a two-pass fit over the filtered points", detail);
+
+        const RangeFit left = index.fit_range(-50.0, 0.0);
+        runner.expectTrue(std::fabs(left.slope - 2.0) < 0.01 && std::fabs(left.intercept - 4.0) < 0.05 &&
+                              left.r_squared > 0.99,
+                          "range fit recovers the line on its side of the kink");
+        runner.expectTrue(std::fabs(index.sse(0, n) - index.fit_positions(0, n).mse * n) < 1e-6,
+                          "sse is mse times count");
+    }
+
+    {
+        // Far from zero with a tiny range: centering plus compensation keeps precision
+        std::vector<double> X, y;
+        for (int i = 0; i < 20000; ++i) {
+            const double x = 1e7 + i * 1e-3;
+            X.push_back(x);
+            y.push_back(3.0 * (x - 1e7) + 1e6);
+        }
+        const RangeRegressionIndex index(X, y);
+        const RangeFit fit = index.fit_range(1e7 + 19.0, 1e7 + 19.99);
+        runner.expectTrue(fit.count == 991 && std::fabs(fit.slope - 3.0) < 1e-5 && fit.mse < 1e-6,
+                          "short ranges far from the origin stay accurate", std::to_string(fit.slope));
+    }
+
+    {
+        const RangeRegressionIndex index({1.0, 2.0, 2.0, 3.0}, {1.0, 2.0, 4.0, 3.0});
+        const RangeFit single = index.fit_range(1.0, 1.0);
+        runner.expectTrue(single.count == 1 && single.slope == 0.0 && single.intercept == 1.0,
+                          "single point gives a flat line through it");
+        const RangeFit tied = index.fit_range(2.0, 2.0);
+        runner.expectTrue(tied.count == 2 && tied.slope == 0.0 && tied.intercept == 3.0 && tied.mse == 1.0,
+                          "ties are inclusive and constant x gives slope 0");
+        bool threw = false;
+        try {
+            index.fit_range(5.0, 6.0);
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        runner.expectTrue(threw, "empty range throws");
+    }
+
+    {
+        const std::string path = "range_index_test.idx";
+        std::vector<double> X, y;
+        for (int i = 0; i < 1000; ++i) {
+            X.push_back(static_cast<double>((i * 37) % 1000) / 10.0);
+            y.push_back(0.5 * X.back() + std::sin(0.1 * i));
+        }
+        const RangeRegressionIndex built(X, y);
+        built.save(path, "dataset-a");
+        RangeRegressionIndex loaded;
+        const bool hit = RangeRegressionIndex::load(path, "dataset-a", loaded);
+        const RangeFit expected = built.fit_range(10.0, 42.0);
+        const RangeFit actual = loaded.fit_range(10.0, 42.0);
+        runner.expectTrue(hit && loaded.size() == 1000 && loaded.sorted_x() == built.sorted_x() &&
+                              actual.count == expected.count && actual.slope == expected.slope &&
+                              actual.mse == expected.mse,
+                          "a saved index loads back and answers the same fits");
+
+        RangeRegressionIndex untouched;
+        const bool other_key = RangeRegressionIndex::load(path, "dataset-b", untouched);
+        {
+            std::ofstream truncate(path.c_str(), std::ios::binary | std::ios::trunc);
+            truncate << "MLRNGIDX";
+        }
+        const bool truncated = RangeRegressionIndex::load(path, "dataset-a", untouched);
+        std::remove(path.c_str());
+        const bool missing = RangeRegressionIndex::load(path, "dataset-a", untouched);
+        runner.expectTrue(!other_key && !truncated && !missing && untouched.size() == 0,
+                          "a differently keyed, truncated or missing index is not loaded");
+    }
+
+    if (runner.failed == 0) {
+        std::cout << "\nAll " << runner.total << " range index tests passed." << std::endl;
+        return 0;
+    }
+
+    std::cerr << "\n" << runner.failed << " of " << runner.total << " range index tests failed." << std::endl;
+    return 1;
+}
@@ -0,0 +1,95 @@
+#include "../resource_usage.h"
+
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TestRunner {
+    int total{0};
+    int failed{0};
+
+    void expectTrue(bool condition, const std::string& name, const std::string& message = "") {
+        ++total;
+        if (!condition) {
+            ++failed;
+            std::cerr << "[FAIL] " << name;
+            if (!message.empty()) {
+                std::cerr << ": " << message;
+            }
+            std::cerr << std::endl;
+        } else {
+            std::cout << "[PASS] " << name << std::endl;
+        }
+    }
+};
+
+// Keeps the CPU busy long enough for getrusage to register some user time.
+double burnCpu() {
+    double acc = 0.0;
+    for (int i = 1; i < 20000000; ++i) {
+        acc += std::sqrt(static_cast<double>(i));
+    }
+    return acc;
+}
+
+} // namespace
+
+int main() {
+    TestRunner runner;
+
+    {
+        ResourceAccounting accounting;
+        volatile double sink = burnCpu();
+        (void)sink;
+        ResourceUsage usage = accounting.elapsed();
+
+        runner.expectTrue(usage.wall_time_ms > 0.0, "elapsed reports positive wall time");
+        runner.expectTrue(usage.user_cpu_ms >= 0.0 && usage.sys_cpu_ms >= 0.0,
+                          "elapsed reports non-negative CPU time");
+        runner.expectTrue(usage.minor_faults >= 0 && usage.major_faults >= 0,
+                          "elapsed reports non-negative fault counts");
+        runner.expectTrue(usage.peak_rss_delta_kb >= 0, "peak RSS delta never negative");
+    }
+
+    {
+        ResourceSnapshot start = captureResourceSnapshot();
+        // Touch a fresh allocation so the resident set has a reason to grow.
+        std::vector<char> block(32 * 1024 * 1024, 1);
+        ResourceSnapshot end = captureResourceSnapshot();
+        ResourceUsage usage = diffResourceSnapshots(start, end);
+        runner.expectTrue(usage.peak_rss_kb >= usage.peak_rss_delta_kb,
+                          "absolute peak RSS bounds the delta");
+        runner.expectTrue(block[block.size() - 1] == 1, "allocation touched");
+    }
+
+    {
+        ResourceUsage usage;
+        usage.wall_time_ms = 12.5;
+        usage.minor_faults = 3;
+        std::ostringstream out;
+        printResourceUsage(out, usage);
+        const std::string text = out.str();
+        const char* keys[] = {"wall_time_ms=12.5", "user_cpu_ms=", "sys_cpu_ms=", "peak_rss_kb=",
+                              "peak_rss_delta_kb=", "minor_page_faults=3", "major_page_faults=",
+                              "voluntary_context_switches=", "involuntary_context_switches="};
+        bool all_present = true;
+        for (const char* key : keys) {
+            if (text.find(key) == std::string::npos) {
+                all_present = false;
+            }
+        }
+        runner.expectTrue(all_present, "printResourceUsage emits every key=value line", text);
+    }
+
+    if (runner.failed == 0) {
+        std::cout << "\nAll " << runner.total << " resource usage tests passed." << std::endl;
+        return 0;
+    }
+
+    std::cerr << "\n" << runner.failed << " of " << runner.total << " resource usage tests failed." << std::endl;
+    return 1;
+}
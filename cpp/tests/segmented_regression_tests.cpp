@@ -0,0 +1,179 @@
+#include "../segmented_regression.h"
+
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TestRunner {
+    int total{0};
+    int failed{0};
+
+    void expectTrue(bool condition, const std::string& name, const std::string& message = "") {
+        ++total;
+        if (!condition) {
+            ++failed;
+            std::cerr << "[FAIL] " << name;
+            if (!message.empty()) {
+                std::cerr << ": " << message;
+            }
+            std::cerr << std::endl;
+        } else {
+            std::cout << "[PASS] " << name << std::endl;
+        }
+    }
+};
+
+// Three lines joined at x = 0.3 and x = 0.7 (continuous), x evenly spaced on [0, 1)
+void piecewise(size_t n, double noise_sd, unsigned seed, std::vector<double>& X, std::vector<double>& y) {
+    std::mt19937 gen(seed);
+    std::normal_distribution<double> noise(0.0, noise_sd);
+    X.resize(n);
+    y.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        const double x = static_cast<double>(i) / n;
+        X[i] = x;
+        if (x < 0.3) {
+            y[i] = 10.0 * x;
+        } else if (x < 0.7) {
+            y[i] = 3.0 - 5.0 * (x - 0.3);
+        } else {
+            y[i] = 1.0 + 8.0 * (x - 0.7);
+        }
+        y[i] += noise(gen);
+    }
+}
+
+// SSE plus penalty per breakpoint of the optimal segmentation, by the plain O(n^2) recursion
+double bruteForceCost(const RangeRegressionIndex& index, double penalty, size_t min_size) {
+    const size_t n = index.size();
+    const std::vector<double>& x = index.sorted_x();
+    std::vector<double> best(n + 1, std::numeric_limits<double>::infinity());
+    best[0] = -penalty;
+    for (size_t t = min_size; t <= n; ++t) {
+        if (t < n && !(x[t - 1] < x[t])) {
+            continue;
+        }
+        for (size_t s = 0; s + min_size <= t; ++s) {
+            if (best[s] != std::numeric_limits<double>::infinity()) {
+                best[t] = std::min(best[t], best[s] + index.sse(s, t) + penalty);
+            }
+        }
+    }
+    return best[n];
+}
+
+} // namespace
+
+int main() {
+    TestRunner runner;
+
+    {
+        std::vector<double> X, y;
+        piecewise(3000, 0.05, 1, X, y);
+        const RangeRegressionIndex index(X, y);
+        SegmentationOptions options;
+        options.max_candidates = 0;
+        const Segmentation exact = fitSegmentedRegression(index, options);
+        const bool three = exact.segments.size() == 3;
+        runner.expectTrue(three, "exact search finds the three pieces", std::to_string(exact.segments.size()));
+        if (three) {
+            runner.expectTrue(std::abs(static_cast<long>(exact.segments[1].begin) - 900) <= 30 &&
+                                  std::abs(static_cast<long>(exact.segments[2].begin) - 2100) <= 30,
+                              "breakpoints land near x = 0.3 and x = 0.7",
+                              std::to_string(exact.segments[1].begin) + " " + std::to_string(exact.segments[2].begin));
+            runner.expectTrue(std::fabs(exact.segments[0].fit.slope - 10.0) < 0.2 &&
+                                  std::fabs(exact.segments[1].fit.slope + 5.0) < 0.2 &&
+                                  std::fabs(exact.segments[2].fit.slope - 8.0) < 0.2,
+                              "each segment recovers its slope");
+            runner.expectTrue(exact.segments[0].begin == 0 && exact.segments[2].end == 3000 &&
+                                  exact.segments[0].end == exact.segments[1].begin &&
+                                  exact.segments[1].x_first == X[exact.segments[1].begin],
+                              "segments tile the sorted points");
+        }
+        runner.expectTrue(exact.evaluations < 3000.0 * 3000.0 / 4.0, "PELT pruning skips most of the quadratic work",
+                          std::to_string(exact.evaluations));
+
+        options.max_candidates = 100;
+        const Segmentation coarse = fitSegmentedRegression(index, options);
+        bool same = coarse.segments.size() == exact.segments.size();
+        for (size_t k = 0; same && k < coarse.segments.size(); ++k) {
+            same = coarse.segments[k].begin == exact.segments[k].begin;
+        }
+        runner.expectTrue(same && coarse.candidates == 100, "grid search plus refinement matches the exact breakpoints");
+    }
+
+    {
+        // Small noisy inputs: the pruned search must reach the true optimum
+        bool optimal = true;
+        std::string detail;
+        for (unsigned seed = 0; seed < 20; ++seed) {
+            std::mt19937 gen(seed);
+            std::uniform_real_distribution<double> uniform(0.0, 10.0);
+            std::normal_distribution<double> noise(0.0, 1.0);
+            std::vector<double> X(60), y(60);
+            for (size_t i = 0; i < X.size(); ++i) {
+                X[i] = std::round(uniform(gen) * 4.0) / 4.0; // ties included
+                y[i] = (X[i] < 5.0 ? X[i] : 10.0 - 2.0 * X[i]) + noise(gen);
+            }
+            const RangeRegressionIndex index(X, y);
+            SegmentationOptions options;
+            options.max_candidates = 0;
+            options.penalty = 2.0 + seed % 5;
+            options.min_segment_size = 2 + seed % 4;
+            const Segmentation fit = fitSegmentedRegression(index, options);
+            const double cost = fit.sse + options.penalty * (fit.segments.size() - 1.0);
+            const double expected = bruteForceCost(index, options.penalty, options.min_segment_size);
+            bool sizes = true;
+            for (const Segment& segment : fit.segments) {
+                sizes = sizes && segment.end - segment.begin >= options.min_segment_size &&
+                        (segment.begin == 0 || index.sorted_x()[segment.begin - 1] < index.sorted_x()[segment.begin]);
+            }
+            if (!(std::fabs(cost - expected) < 1e-9 * std::max(1.0, expected) && sizes)) {
+                optimal = false;
+                detail += std::to_string(seed) + " ";
+            }
+        }
+        runner.expectTrue(optimal, "pruned search matches the brute-force optimum and respects ties and sizes", detail);
+    }
+
+    {
+        std::vector<double> X, y;
+        std::mt19937 gen(9);
+        std::normal_distribution<double> noise(0.0, 0.2);
+        for (int i = 0; i < 5000; ++i) {
+            X.push_back(i * 0.01);
+            y.push_back(1.5 * X.back() - 2.0 + noise(gen));
+        }
+        const RangeRegressionIndex index(X, y);
+        const Segmentation fit = fitSegmentedRegression(index);
+        runner.expectTrue(fit.segments.size() == 1, "a single noisy line stays one segment",
+                          std::to_string(fit.segments.size()));
+        runner.expectTrue(std::fabs(estimateNoiseVariance(index) - 0.04) < 0.005, "noise variance estimate",
+                          std::to_string(estimateNoiseVariance(index)));
+    }
+
+    {
+        const RangeRegressionIndex index({1.0, 2.0}, {1.0, 2.0});
+        bool threw = false;
+        try {
+            fitSegmentedRegression(index);
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        runner.expectTrue(threw, "fewer points than one minimum segment throws");
+    }
+
+    if (runner.failed == 0) {
+        std::cout << "\nAll " << runner.total << " segmented regression tests passed." << std::endl;
+        return 0;
+    }
+
+    std::cerr << "\n" << runner.failed << " of " << runner.total << " segmented regression tests failed." << std::endl;
+    return 1;
+}
@@ -0,0 +1,165 @@
+#include "../sparse.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TestRunner {
+    int total{0};
+    int failed{0};
+
+    void expectTrue(bool condition, const std::string& name, const std::string& message = "") {
+        ++total;
+        if (!condition) {
+            ++failed;
+            std::cerr << "[FAIL] " << name;
+            if (!message.empty()) {
+                std::cerr << ": " << message;
+            }
+            std::cerr << std::endl;
+        } else {
+            std::cout << "[PASS] " << name << std::endl;
+        }
+    }
+};
+
+} // namespace
+
+int main() {
+    TestRunner runner;
+
+    {
+        CsrMatrix matrix(10);
+        matrix.add_row({{7, 1.0}, {2, 3.0}, {7, 1.5}, {4, 0.0}});
+        matrix.add_row({});
+        matrix.add_row({{9, -2.0}, {1, 2.0}, {1, -2.0}});
+        runner.expectTrue(matrix.rows() == 3 && matrix.cols() == 10 && matrix.nnz() == 3, "CSR counts rows and non-zeros");
+        const SparseRow first = matrix.row(0);
+        runner.expectTrue(first.nnz == 2 && first.indices[0] == 2 && first.indices[1] == 7 && first.values[1] == 2.5,
+                          "add_row sorts columns, sums duplicates and drops zeros");
+        runner.expectTrue(matrix.row(1).nnz == 0, "empty rows are allowed");
+        const SparseRow last = matrix.row(2);
+        runner.expectTrue(last.nnz == 1 && last.indices[0] == 9, "cancelled duplicates are dropped");
+
+        bool threw = false;
+        try {
+            matrix.add_row({{3, 1.0}, {10, 1.0}});
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        runner.expectTrue(threw && matrix.rows() == 3 && matrix.nnz() == 3, "out-of-range column throws and leaves the matrix intact");
+
+        std::vector<double> dense(10, 1.0);
+        dense[7] = 4.0;
+        runner.expectTrue(sparseDot(first, dense.data()) == 3.0 + 2.5 * 4.0, "sparseDot gathers active columns");
+        sparseAxpy(2.0, first, dense.data());
+        runner.expectTrue(dense[2] == 7.0 && dense[7] == 9.0 && dense[0] == 1.0, "sparseAxpy touches only active columns");
+    }
+
+    {
+        // CsrDesign products agree with the dense definition
+        CsrMatrix matrix(4);
+        matrix.add_row({{0, 1.0}, {3, 2.0}});
+        matrix.add_row({{1, -1.0}});
+        matrix.add_row({{0, 0.5}, {1, 4.0}, {2, 3.0}});
+        const CsrDesign design(matrix);
+        const double v[] = {1.0, 2.0, 3.0, 4.0};
+        double xv[3];
+        design.multiply(v, xv);
+        const double u[] = {1.0, 10.0, 100.0};
+        double xtu[4];
+        design.multiply_transposed(u, xtu);
+        double norms[4];
+        design.column_squared_norms(norms);
+        runner.expectTrue(xv[0] == 9.0 && xv[1] == -2.0 && xv[2] == 17.5, "CsrDesign::multiply");
+        runner.expectTrue(xtu[0] == 51.0 && xtu[1] == 390.0 && xtu[2] == 300.0 && xtu[3] == 2.0,
+                          "CsrDesign::multiply_transposed");
+        runner.expectTrue(norms[0] == 1.25 && norms[1] == 17.0 && norms[3] == 4.0, "CsrDesign::column_squared_norms");
+    }
+
+    {
+        // Hashed rows share columns: the per-column gather must match a row scatter
+        const FeatureHasher hasher(10);
+        CsrMatrix matrix(hasher.dimensions());
+        std::vector<double> u;
+        for (int i = 0; i < 5000; ++i) {
+            hasher.append_row({{"x", 0.01 * (i % 37)}}, {{"user", std::to_string(i % 700)}, {"day", std::to_string(i % 7)}},
+                              matrix);
+            u.push_back(std::sin(0.3 * i));
+        }
+        std::vector<double> scattered(matrix.cols(), 0.0);
+        std::vector<double> squares(matrix.cols(), 0.0);
+        for (size_t i = 0; i < matrix.rows(); ++i) {
+            const SparseRow row = matrix.row(i);
+            sparseAxpy(u[i], row, scattered.data());
+            for (size_t k = 0; k < row.nnz; ++k) {
+                squares[row.indices[k]] += row.values[k] * row.values[k];
+            }
+        }
+        const CsrDesign design(matrix);
+        std::vector<double> gathered(matrix.cols());
+        std::vector<double> norms(matrix.cols());
+        design.multiply_transposed(u.data(), gathered.data());
+        design.column_squared_norms(norms.data());
+        double worst = 0.0;
+        for (size_t j = 0; j < matrix.cols(); ++j) {
+            worst = std::max(worst, std::fabs(gathered[j] - scattered[j]) + std::fabs(norms[j] - squares[j]));
+        }
+        runner.expectTrue(worst < 1e-9, "CsrDesign's column gathers match row scatters on hashed data",
+                          std::to_string(worst));
+    }
+
+    {
+        const FeatureHasher hasher(12);
+        runner.expectTrue(hasher.dimensions() == 4096, "hasher has 2^bits dimensions");
+        const auto a = hasher.slot("city=paris");
+        runner.expectTrue(a == hasher.slot("city=paris") && a.first < 4096 && std::fabs(a.second) == 1.0,
+                          "hashing is deterministic, in range and signed");
+        std::set<uint32_t> columns;
+        int negative = 0;
+        for (int i = 0; i < 1000; ++i) {
+            const auto s = hasher.slot("user=" + std::to_string(i));
+            columns.insert(s.first);
+            negative += s.second < 0.0 ? 1 : 0;
+        }
+        runner.expectTrue(columns.size() > 850 && negative > 400 && negative < 600,
+                          "hashes spread over columns and signs",
+                          std::to_string(columns.size()) + " columns, " + std::to_string(negative) + " negative");
+
+        CsrMatrix matrix(hasher.dimensions());
+        hasher.append_row({{"age", 2.5}}, {{"city", "paris"}, {"device", "ios"}}, matrix);
+        const SparseRow row = matrix.row(0);
+        runner.expectTrue(matrix.rows() == 1 && row.nnz <= 3 && row.nnz >= 2, "append_row adds one hashed row");
+        const auto age = hasher.slot("age");
+        double age_value = 0.0;
+        for (size_t k = 0; k < row.nnz; ++k) {
+            if (row.indices[k] == age.first) {
+                age_value = row.values[k];
+            }
+        }
+        runner.expectTrue(std::fabs(age_value) >= 1.5, "numeric features keep their (signed) value");
+
+        bool threw = false;
+        try {
+            CsrMatrix wrong(100);
+            hasher.append_row({}, {{"city", "paris"}}, wrong);
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        runner.expectTrue(threw, "append_row rejects a matrix of the wrong width");
+    }
+
+    if (runner.failed == 0) {
+        std::cout << "\nAll " << runner.total << " sparse tests passed." << std::endl;
+        return 0;
+    }
+
+    std::cerr << "\n" << runner.failed << " of " << runner.total << " sparse tests failed." << std::endl;
+    return 1;
+}
@@ -0,0 +1,240 @@
+#include "../stream_pipeline.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct TestRunner {
+    int total{0};
+    int failed{0};
+
+    void expectTrue(bool condition, const std::string& name, const std::string& message = "") {
+        ++total;
+        if (!condition) {
+            ++failed;
+            std::cerr << "[FAIL] " << name;
+            if (!message.empty()) {
+                std::cerr << ": " << message;
+            }
+            std::cerr << std::endl;
+        } else {
+            std::cout << "[PASS] " << name << std::endl;
+        }
+    }
+};
+
+// Discards output but counts the writes (the pipeline issues one per chunk)
+class CountingBuf : public std::streambuf {
+public:
+    std::atomic<long> writes{0};
+    std::string text;
+
+protected:
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        text.append(s, static_cast<size_t>(n));
+        ++writes;
+        return n;
+    }
+    int overflow(int c) override {
+        text.push_back(static_cast<char>(c));
+        return c;
+    }
+};
+
+std::vector<double> readLines(const std::string& text) {
+    std::vector<double> values;
+    std::istringstream in(text);
+    double v;
+    while (in >> v) {
+        values.push_back(v);
+    }
+    return values;
+}
+
+const BatchPredictor doubler = [](const double* x, size_t n, double* y) {
+    for (size_t i = 0; i < n; ++i) {
+        y[i] = 2.0 * x[i];
+    }
+};
+
+} // namespace
+
+int main() {
+    TestRunner runner;
+
+    {
+        std::vector<double> values;
+        const std::string text = "1, 2.5\n-3e2\t,,4 ";
+        parseNumberList(text.data(), text.data() + text.size(), values);
+        runner.expectTrue(values == std::vector<double>({1.0, 2.5, -300.0, 4.0}),
+                          "parseNumberList accepts commas, whitespace and empty fields");
+        bool threw = false;
+        const std::string bad = "1,2x,3";
+        try {
+            parseNumberList(bad.data(), bad.data() + bad.size(), values);
+        } catch (const std::invalid_argument& e) {
+            threw = std::string(e.what()).find("'2x'") != std::string::npos;
+        }
+        runner.expectTrue(threw, "parseNumberList rejects malformed tokens and names them");
+        threw = false;
+        const std::string inf = "inf";
+        try {
+            parseNumberList(inf.data(), inf.data() + inf.size(), values);
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        runner.expectTrue(threw, "parseNumberList rejects non-finite values");
+    }
+
+    {
+        BoundedQueue<int> queue(2);
+        runner.expectTrue(queue.push(1) && queue.push(2), "queue accepts up to capacity");
+        std::thread producer([&]() { queue.push(3); });
+        int value = 0;
+        queue.pop(value);
+        producer.join();
+        queue.close();
+        int a = 0, b = 0, c = 0;
+        const bool drained = queue.pop(a) && queue.pop(b) && !queue.pop(c);
+        runner.expectTrue(value == 1 && drained && a == 2 && b == 3, "closed queue drains in FIFO order, then fails");
+        runner.expectTrue(!queue.push(4), "push fails after close");
+    }
+
+    {
+        // Many tiny chunks, more workers than cores and uneven compute times
+        std::ostringstream input;
+        const int n = 5000;
+        for (int i = 0; i < n; ++i) {
+            input << i << (i % 7 == 0 ? "\n" : ",");
+        }
+        std::istringstream in(input.str());
+        std::ostringstream out;
+        StreamPipelineOptions options;
+        options.chunk_bytes = 37; // Splits numbers across chunk boundaries
+        options.workers = 4;
+        options.queue_depth = 2;
+        const BatchPredictor jittery = [](const double* x, size_t count, double* y) {
+            if (static_cast<long>(x[0]) % 3 == 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+            doubler(x, count, y);
+        };
+        const StreamStats stats = runPredictStream(in, out, jittery, options);
+        const std::vector<double> got = readLines(out.str());
+        bool ordered = got.size() == static_cast<size_t>(n);
+        for (int i = 0; ordered && i < n; ++i) {
+            ordered = got[i] == 2.0 * i;
+        }
+        runner.expectTrue(ordered, "output preserves input order across workers and chunk boundaries");
+        runner.expectTrue(stats.values == static_cast<uint64_t>(n) && stats.chunks > 100 &&
+                              stats.bytes_in == input.str().size() && stats.bytes_out == out.str().size(),
+                          "stats count values, chunks and bytes");
+    }
+
+    {
+        // The writer is the bottleneck: chunks pile up only to the in-flight bound
+        std::string input;
+        for (int i = 0; i < 4000; ++i) {
+            input += "1\n";
+        }
+        std::istringstream in(input);
+        CountingBuf sink;
+        std::ostream out(&sink);
+        StreamPipelineOptions options;
+        options.chunk_bytes = 8;
+        options.workers = 3;
+        options.queue_depth = 2;
+        std::atomic<long> started(0);
+        std::atomic<long> worst(0);
+        const BatchPredictor counting = [&](const double* x, size_t count, double* y) {
+            const long in_flight = ++started - sink.writes.load();
+            long seen = worst.load();
+            while (in_flight > seen && !worst.compare_exchange_weak(seen, in_flight)) {
+            }
+            doubler(x, count, y);
+        };
+        const StreamStats stats = runPredictStream(in, out, counting, options);
+        runner.expectTrue(stats.max_chunks_in_flight == 7, "in-flight bound is 2 * queue_depth + workers");
+        runner.expectTrue(worst.load() <= static_cast<long>(stats.max_chunks_in_flight),
+                          "chunks in flight never exceed the bound", std::to_string(worst.load()));
+        runner.expectTrue(stats.values == 4000, "bounded run still scores everything");
+    }
+
+    {
+        std::istringstream in("");
+        std::ostringstream out;
+        const StreamStats stats = runPredictStream(in, out, doubler);
+        runner.expectTrue(stats.values == 0 && stats.chunks == 0 && out.str().empty(), "empty input produces no output");
+    }
+
+    {
+        std::istringstream in("1,2,3,oops,5");
+        std::ostringstream out;
+        StreamPipelineOptions options;
+        options.chunk_bytes = 4;
+        options.workers = 2;
+        bool threw = false;
+        try {
+            runPredictStream(in, out, doubler, options);
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        runner.expectTrue(threw, "parse errors stop the pipeline and are rethrown");
+    }
+
+    {
+        std::istringstream in("1,2,3,4,5,6,7,8,9");
+        std::ostringstream out;
+        StreamPipelineOptions options;
+        options.chunk_bytes = 2;
+        options.workers = 2;
+        const BatchPredictor failing = [](const double* x, size_t count, double* y) {
+            if (x[0] == 5.0) {
+                throw std::runtime_error("model failed");
+            }
+            doubler(x, count, y);
+        };
+        std::string message;
+        try {
+            runPredictStream(in, out, failing, options);
+        } catch (const std::runtime_error& e) {
+            message = e.what();
+        }
+        runner.expectTrue(message == "model failed", "worker errors are rethrown to the caller", message);
+    }
+
+    {
+        std::istringstream in("1 2 3");
+        std::ostringstream out;
+        std::atomic<int> parse_events(0), wait_events(0), compute_events(0), serialize_events(0);
+        StreamPipelineOptions options;
+        options.workers = 1;
+        options.observer = [&](const std::string& stage, std::chrono::steady_clock::duration) {
+            if (stage == "parse") ++parse_events;
+            if (stage == "queue_wait") ++wait_events;
+            if (stage == "compute") ++compute_events;
+            if (stage == "serialize") ++serialize_events;
+        };
+        runPredictStream(in, out, doubler, options);
+        runner.expectTrue(parse_events == 1 && wait_events == 1 && compute_events == 1 && serialize_events == 1,
+                          "observer sees every stage once per chunk");
+        runner.expectTrue(out.str() == "2\n4\n6\n", "predictions are written one per line", out.str());
+    }
+
+    if (runner.failed == 0) {
+        std::cout << "\nAll " << runner.total << " stream pipeline tests passed." << std::endl;
+        return 0;
+    }
+
+    std::cerr << "\n" << runner.failed << " of " << runner.total << " stream pipeline tests failed." << std::endl;
+    return 1;
+}
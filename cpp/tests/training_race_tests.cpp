@@ -0,0 +1,132 @@
+#include "../training_race.h"
+
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TestRunner {
+    int total{0};
+    int failed{0};
+
+    void expectTrue(bool condition, const std::string& name, const std::string& message = "") {
+        ++total;
+        if (!condition) {
+            ++failed;
+            std::cerr << "[FAIL] " << name;
+            if (!message.empty()) {
+                std::cerr << ": " << message;
+            }
+            std::cerr << std::endl;
+        } else {
+            std::cout << "[PASS] " << name << std::endl;
+        }
+    }
+};
+
+// y = 0.5 + 0.4 sin(4x) on n evenly spaced x in [0, 1]
+void sineSamples(size_t n, std::vector<SampleVector>& inputs, std::vector<SampleVector>& targets) {
+    for (size_t i = 0; i < n; ++i) {
+        const double x = static_cast<double>(i) / (n - 1);
+        const double y = 0.5 + 0.4 * std::sin(4.0 * x);
+        inputs.push_back(SampleVector(&x, 1));
+        targets.push_back(SampleVector(&y, 1));
+    }
+}
+
+std::string reasons(const RaceResult& result) {
+    std::string text;
+    for (const RaceEntry& entry : result.entries) {
+        text += entry.outcome.stopped_reason + "; ";
+    }
+    return text;
+}
+
+} // namespace
+
+int main() {
+    TestRunner runner;
+    std::vector<SampleVector> inputs;
+    std::vector<SampleVector> targets;
+    sineSamples(100, inputs, targets);
+    const std::vector<size_t> layers{1, 8, 1};
+
+    {
+        const std::vector<RaceStrategy> plain = defaultRacePortfolio(3, 0.1, 7, 2);
+        runner.expectTrue(plain.size() == 3 && plain[0].optimizer == "sgd" && plain[2].optimizer == "sgd" &&
+                              plain[1].learning_rate == 0.1 * 3.0 && plain[2].seed == 9,
+                          "the portfolio varies seeds and learning rates");
+        const std::vector<RaceStrategy> wide = defaultRacePortfolio(3, 0.1, 7, 8);
+        runner.expectTrue(wide[2].optimizer == "local-sgd" && wide[2].threads == 6 && wide[1].threads == 1 &&
+                              wide[2].name() == "local-sgd lr=0.1 seed=9 threads=6",
+                          "spare threads go to a local-sgd strategy", wide[2].name());
+    }
+
+    {
+        RaceOptions options;
+        options.target_mse = 0.05;
+        std::vector<RaceStrategy> portfolio = defaultRacePortfolio(3, 0.1, 1, 3);
+        portfolio.push_back(RaceStrategy());
+        portfolio.back().optimizer = "local-sgd";
+        portfolio.back().learning_rate = 0.1;
+        portfolio.back().threads = 2;
+        const RaceResult result =
+            runTrainingRace(layers, portfolio, inputs.data(), targets.data(), inputs.size(), 100000, options);
+        const RaceEntry& winner = result.entries[result.winner];
+        runner.expectTrue(result.decided_by == "target" && winner.outcome.stopped_reason == "target reached" &&
+                              winner.mse <= 0.05 && result.time_to_fit_seconds == winner.seconds,
+                          "the first strategy to reach the target wins", reasons(result));
+        bool cancelled = true;
+        for (size_t k = 0; k < result.entries.size(); ++k) {
+            const std::string& reason = result.entries[k].outcome.stopped_reason;
+            cancelled = cancelled && (k == result.winner || reason == "cancelled" || reason == "target reached");
+        }
+        runner.expectTrue(cancelled && result.elapsed_seconds < 30.0, "the other strategies are cancelled",
+                          reasons(result));
+    }
+
+    {
+        RaceOptions options;
+        options.target_mse = 1e-300;
+        options.deadline_seconds = 0.2;
+        const RaceResult result = runTrainingRace(layers, defaultRacePortfolio(2, 0.1, 1, 3), inputs.data(),
+                                                  targets.data(), inputs.size(), 1000000, options);
+        const size_t other = 1 - result.winner;
+        runner.expectTrue(result.decided_by == "deadline" && result.entries[0].outcome.stopped_reason == "cancelled" &&
+                              result.entries[1].outcome.stopped_reason == "cancelled" &&
+                              result.entries[result.winner].mse <= result.entries[other].mse &&
+                              result.elapsed_seconds < 5.0,
+                          "at the deadline everyone is cancelled and the lowest MSE wins", reasons(result));
+    }
+
+    {
+        const RaceResult result = runTrainingRace(layers, defaultRacePortfolio(2, 0.1, 5, 1), inputs.data(),
+                                                  targets.data(), inputs.size(), 5);
+        runner.expectTrue(result.decided_by == "best" && result.entries[0].outcome.stopped_reason == "completed" &&
+                              result.entries[1].epochs == 5 &&
+                              result.entries[result.winner].mse <= result.entries[1 - result.winner].mse,
+                          "without a target or deadline the best finished strategy wins", reasons(result));
+    }
+
+    {
+        bool threw = false;
+        try {
+            runTrainingRace({2, 4, 1}, defaultRacePortfolio(2, 0.1, 1, 1), inputs.data(), targets.data(),
+                            inputs.size(), 1);
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        runner.expectTrue(threw, "errors inside a strategy's thread are rethrown to the caller");
+    }
+
+    if (runner.failed == 0) {
+        std::cout << "\nAll " << runner.total << " training race tests passed." << std::endl;
+        return 0;
+    }
+
+    std::cerr << "\n" << runner.failed << " of " << runner.total << " training race tests failed." << std::endl;
+    return 1;
+}
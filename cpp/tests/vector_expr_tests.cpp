@@ -0,0 +1,127 @@
+#include "../vector_expr.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Counts heap allocations so the tests can check that expressions build no temporaries
+static size_t g_allocations = 0;
+
+void* operator new(size_t size) {
+    ++g_allocations;
+    void* p = std::malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+struct TestRunner {
+    int total{0};
+    int failed{0};
+
+    void expectTrue(bool condition, const std::string& name, const std::string& message = "") {
+        ++total;
+        if (!condition) {
+            ++failed;
+            std::cerr << "[FAIL] " << name;
+            if (!message.empty()) {
+                std::cerr << ": " << message;
+            }
+            std::cerr << std::endl;
+        } else {
+            std::cout << "[PASS] " << name << std::endl;
+        }
+    }
+};
+
+bool allNear(const std::vector<double>& a, const std::vector<double>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::fabs(a[i] - b[i]) > 1e-12) {
+            return false;
+        }
+    }
+    return true;
+}
+
+double square(double x) {
+    return x * x;
+}
+
+} // namespace
+
+int main() {
+    TestRunner runner;
+    using expr::lazy;
+
+    const std::vector<double> a = {1.0, 2.0, 3.0};
+    const std::vector<double> b = {0.5, -1.0, 2.0};
+    const std::vector<std::vector<double>> W = {{1.0, 0.0, 1.0}, {0.0, 2.0, 0.0}};
+
+    runner.expectTrue(allNear(expr::evaluate(lazy(a) + lazy(b)), {1.5, 1.0, 5.0}), "vector addition");
+    runner.expectTrue(allNear(expr::evaluate(lazy(a) - 2.0 * lazy(b)), {0.0, 4.0, -1.0}), "subtract scaled vector");
+    runner.expectTrue(allNear(expr::evaluate(lazy(a) * lazy(b)), {0.5, -2.0, 6.0}), "vector * vector is element-wise");
+    runner.expectTrue(allNear(expr::evaluate(expr::apply(lazy(a) - lazy(b), square)), {0.25, 9.0, 1.0}),
+                      "apply maps a compound expression");
+    runner.expectTrue(allNear(expr::evaluate(lazy(W) * lazy(a) + lazy(std::vector<double>{1.0, 1.0})), {5.0, 5.0}),
+                      "matrix * vector + bias");
+
+    {
+        std::vector<double> out(2);
+        const std::vector<double> bias = {0.1, 0.2};
+        g_allocations = 0;
+        expr::assign(out, expr::apply(lazy(W) * lazy(a) + lazy(bias), square) * 3.0);
+        const size_t allocations = g_allocations;
+        runner.expectTrue(allocations == 0, "fused expression allocates nothing",
+                          std::to_string(allocations) + " allocations");
+        runner.expectTrue(allNear(out, {3.0 * 4.1 * 4.1, 3.0 * 4.2 * 4.2}), "fused expression value");
+    }
+
+    {
+        std::vector<double> w = {1.0, 1.0, 1.0};
+        expr::assign(w, lazy(w) - 0.5 * lazy(a));
+        runner.expectTrue(allNear(w, {0.5, 0.0, -0.5}), "element-wise expression may write into its operand");
+    }
+
+    {
+        bool threw = false;
+        try {
+            expr::evaluate(lazy(a) + lazy(std::vector<double>{1.0}));
+        } catch (const std::invalid_argument& e) {
+            threw = std::string(e.what()).find("addition") != std::string::npos;
+        }
+        runner.expectTrue(threw, "size mismatch throws when the expression is built");
+    }
+
+    {
+        bool threw = false;
+        std::vector<double> out = {9.0};
+        try {
+            expr::assign(out, lazy(W) * lazy(std::vector<double>{1.0, 2.0}));
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        runner.expectTrue(threw && out.size() == 1 && out[0] == 9.0, "matrix-vector mismatch throws before writing");
+    }
+
+    if (runner.failed == 0) {
+        std::cout << "\nAll " << runner.total << " vector expression tests passed." << std::endl;
+        return 0;
+    }
+
+    std::cerr << "\n" << runner.failed << " of " << runner.total << " vector expression tests failed." << std::endl;
+    return 1;
+}
@@ -0,0 +1,176 @@
+#include "training_race.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include "local_sgd.h"
+
+namespace {
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+double meanSquaredError(NeuralNetwork& network, const SampleVector* inputs, const SampleVector* targets,
+                        size_t count) {
+    double sum = 0.0;
+    size_t values = 0;
+    SampleVector prediction;
+    for (size_t i = 0; i < count; ++i) {
+        network.predict_into(inputs[i].data(), inputs[i].size(), prediction);
+        for (size_t k = 0; k < prediction.size(); ++k) {
+            const double error = prediction[k] - targets[i][k];
+            sum += error * error;
+        }
+        values += prediction.size();
+    }
+    return sum / static_cast<double>(values);
+}
+
+} // namespace
+
+std::string RaceStrategy::name() const {
+    std::ostringstream out;
+    out << optimizer << " lr=" << learning_rate << " seed=" << seed;
+    if (optimizer == "local-sgd") {
+        out << " threads=" << threads;
+    }
+    return out.str();
+}
+
+std::vector<RaceStrategy> defaultRacePortfolio(size_t count, double learning_rate, unsigned seed, int threads) {
+    static const double kLearningRateScales[] = {1.0, 3.0, 1.0 / 3.0};
+    std::vector<RaceStrategy> portfolio(std::max<size_t>(1, count));
+    for (size_t k = 0; k < portfolio.size(); ++k) {
+        portfolio[k].learning_rate = learning_rate * kLearningRateScales[k % 3];
+        portfolio[k].seed = seed + static_cast<unsigned>(k);
+    }
+    if (threads > static_cast<int>(portfolio.size())) {
+        RaceStrategy& last = portfolio.back();
+        last.optimizer = "local-sgd";
+        last.learning_rate = learning_rate;
+        last.threads = threads - static_cast<int>(portfolio.size() - 1);
+    }
+    return portfolio;
+}
+
+RaceResult runTrainingRace(const std::vector<size_t>& layer_sizes, const std::vector<RaceStrategy>& strategies,
+                           const SampleVector* inputs, const SampleVector* targets, size_t count, int epochs,
+                           const RaceOptions& options) {
+    const auto start = std::chrono::steady_clock::now();
+    if (strategies.empty() || count == 0) {
+        throw std::invalid_argument("A training race needs at least one strategy and one sample.");
+    }
+    RaceResult result;
+    result.networks.reserve(strategies.size()); // Threads hold references into it
+    for (const RaceStrategy& strategy : strategies) {
+        if (strategy.optimizer != "sgd" && strategy.optimizer != "local-sgd") {
+            throw std::invalid_argument("Unknown race optimizer '" + strategy.optimizer + "'.");
+        }
+        result.networks.push_back(NeuralNetwork(layer_sizes, strategy.learning_rate, strategy.seed));
+        RaceEntry entry;
+        entry.strategy = strategy;
+        result.entries.push_back(entry);
+    }
+
+    std::atomic<bool> cancel(false);
+    std::atomic<int> first(-1); // First strategy to reach the target
+    std::mutex mutex;
+    std::condition_variable finished;
+    size_t running = strategies.size();
+    std::vector<std::exception_ptr> errors(strategies.size());
+    std::vector<std::thread> racers;
+    for (size_t k = 0; k < strategies.size(); ++k) {
+        racers.emplace_back([&, k] {
+            try {
+                NeuralNetwork& network = result.networks[k];
+                RaceEntry& entry = result.entries[k];
+                if (entry.strategy.optimizer == "sgd") {
+                    TrainingOptions training = options.training;
+                    training.target_mse = options.target_mse;
+                    training.cancel = &cancel;
+                    network.set_training_options(training);
+                    network.train_for_epochs(inputs, targets, count, epochs, 0);
+                    entry.outcome = network.training_outcome();
+                    entry.epochs = network.training_progress().epoch.load();
+                } else {
+                    LocalSgdOptions local;
+                    local.threads = entry.strategy.threads;
+                    local.target_mse = options.target_mse;
+                    local.stop_at_target = options.target_mse > 0.0;
+                    local.report_every_n_epochs = 0;
+                    local.cancel = &cancel;
+                    local.seed = entry.strategy.seed;
+                    const LocalSgdResult trained = trainLocalSgd(network, inputs, targets, count, epochs, local);
+                    entry.outcome = trained.outcome;
+                    entry.epochs = trained.epochs;
+                }
+                entry.seconds = secondsSince(start);
+                if (entry.outcome.stopped_reason == "target reached") {
+                    int none = -1;
+                    if (first.compare_exchange_strong(none, static_cast<int>(k))) {
+                        cancel.store(true);
+                    }
+                }
+            } catch (...) {
+                errors[k] = std::current_exception();
+                cancel.store(true);
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                --running;
+            }
+            finished.notify_all();
+        });
+    }
+
+    bool deadline_passed = false;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        const auto decided = [&] { return running == 0 || first.load() >= 0; };
+        if (options.deadline_seconds > 0.0) {
+            deadline_passed = !finished.wait_for(lock, std::chrono::duration<double>(options.deadline_seconds), decided);
+        } else {
+            finished.wait(lock, decided);
+        }
+    }
+    result.time_to_fit_seconds = secondsSince(start);
+    cancel.store(true);
+    for (std::thread& racer : racers) {
+        racer.join();
+    }
+    for (const std::exception_ptr& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+    result.elapsed_seconds = secondsSince(start);
+
+    for (size_t k = 0; k < strategies.size(); ++k) {
+        result.entries[k].mse = meanSquaredError(result.networks[k], inputs, targets, count);
+    }
+    if (first.load() >= 0) {
+        result.winner = static_cast<size_t>(first.load());
+        result.decided_by = "target";
+        result.time_to_fit_seconds = result.entries[result.winner].seconds;
+    } else {
+        double best = std::numeric_limits<double>::infinity();
+        for (size_t k = 0; k < strategies.size(); ++k) {
+            if (result.entries[k].mse < best) {
+                best = result.entries[k].mse;
+                result.winner = k;
+            }
+        }
+        result.decided_by = deadline_passed ? "deadline" : "best";
+    }
+    return result;
+}
@@ -0,0 +1,62 @@
+#ifndef TRAINING_RACE_H
+#define TRAINING_RACE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "neural_network.h"
+
+// One contestant: how its network is initialized and trained
+struct RaceStrategy {
+    std::string optimizer = "sgd"; // "sgd" (train_for_epochs) or "local-sgd" (trainLocalSgd)
+    double learning_rate = 0.01;
+    unsigned seed = 0;             // Initial weights
+    int threads = 1;               // local-sgd replicas; sgd always runs on one thread
+
+    // e.g. "sgd lr=0.1 seed=3" or "local-sgd lr=0.1 seed=4 threads=6"
+    std::string name() const;
+};
+
+// A default portfolio of `count` strategies sharing `threads` hardware
+// threads: seeds seed, seed + 1, ... and learning rates cycling through
+// learning_rate * {1, 3, 1/3}. When there are more threads than strategies,
+// the last strategy becomes local-sgd on all of the spare threads.
+std::vector<RaceStrategy> defaultRacePortfolio(size_t count, double learning_rate, unsigned seed, int threads);
+
+struct RaceOptions {
+    double target_mse = 0.0;       // > 0: the first strategy to reach it wins and the rest are cancelled
+    double deadline_seconds = 0.0; // > 0: cancel everyone then and take the lowest MSE
+    TrainingOptions training;      // Divergence monitor settings for the sgd strategies
+};
+
+struct RaceEntry {
+    RaceStrategy strategy;
+    double mse = 0.0;      // On the training data, as the strategy stopped
+    int epochs = 0;        // Completed
+    double seconds = 0.0;  // From the start of the race until it stopped
+    TrainingOutcome outcome;
+};
+
+struct RaceResult {
+    std::vector<RaceEntry> entries;  // In strategy order
+    std::vector<NeuralNetwork> networks; // The strategies' networks, as they stopped
+    size_t winner = 0;
+    // "target" (first to reach target_mse), "deadline" (lowest MSE when the
+    // deadline cancelled the rest) or "best" (lowest MSE after every
+    // strategy finished its epochs)
+    std::string decided_by;
+    double time_to_fit_seconds = 0.0; // Until the winner was decided
+    double elapsed_seconds = 0.0;     // Including cancelled strategies winding down
+};
+
+// Trains one network per strategy, each on its own thread (local-sgd
+// strategies on an OpenMP team of their own), over the same samples. The
+// losers are cancelled cooperatively through TrainingOptions::cancel /
+// LocalSgdOptions::cancel and stop within a few samples. Throws
+// std::invalid_argument for an empty portfolio or data, or an unknown optimizer.
+RaceResult runTrainingRace(const std::vector<size_t>& layer_sizes, const std::vector<RaceStrategy>& strategies,
+                           const SampleVector* inputs, const SampleVector* targets, size_t count, int epochs,
+                           const RaceOptions& options = RaceOptions());
+
+#endif // TRAINING_RACE_H
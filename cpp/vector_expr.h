@@ -0,0 +1,200 @@
+#ifndef VECTOR_EXPR_H
+#define VECTOR_EXPR_H
+
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include "blas_backend.h"
+
+// Lazy expression templates for std::vector<double> arithmetic.
+//
+// Wrapping operands with lazy() turns +, -, * and apply() into lightweight
+// expression objects; nothing is computed until the expression is written
+// into a vector with assign() or evaluate(), which then runs one fused loop
+// with no intermediate storage:
+//
+//     expr::assign(z, expr::lazy(W) * expr::lazy(a) + expr::lazy(b));
+//     expr::assign(out, expr::apply(expr::lazy(z), sigmoid));
+//
+// Vector * vector is element-wise; Matrix * vector is a row-wise dot product
+// through the active BlasBackend. Size mismatches throw std::invalid_argument
+// when the expression is built, before anything is written.
+//
+// Operands are referenced, not copied: an expression must be assigned within
+// the statement that builds it, and the destination of a matrix-vector
+// product must not be its vector operand (element-wise expressions may write
+// into one of their operands).
+namespace expr {
+
+// CRTP base identifying vector expressions
+template <typename E>
+struct VecExpr {
+    const E& self() const { return static_cast<const E&>(*this); }
+};
+
+// Leaf: existing contiguous storage
+class VecRef : public VecExpr<VecRef> {
+public:
+    VecRef(const double* data, size_t size) : data_(data), size_(size) {}
+    size_t size() const { return size_; }
+    double operator[](size_t i) const { return data_[i]; }
+    const double* data() const { return data_; }
+
+private:
+    const double* data_;
+    size_t size_;
+};
+
+// Leaf: an existing matrix (one vector per row); only usable in matrix * vector
+class MatRef {
+public:
+    explicit MatRef(const std::vector<std::vector<double>>& rows) : rows_(&rows) {}
+    const std::vector<std::vector<double>>& rows() const { return *rows_; }
+
+private:
+    const std::vector<std::vector<double>>* rows_;
+};
+
+struct AddOp {
+    static double apply(double a, double b) { return a + b; }
+    static const char* mismatch() { return "Vectors must have the same size for addition."; }
+};
+
+struct SubtractOp {
+    static double apply(double a, double b) { return a - b; }
+    static const char* mismatch() { return "Vectors must have the same size for subtraction."; }
+};
+
+struct MultiplyOp {
+    static double apply(double a, double b) { return a * b; }
+    static const char* mismatch() { return "Vectors must have the same size for element-wise multiplication."; }
+};
+
+template <typename L, typename R, typename Op>
+class BinaryExpr : public VecExpr<BinaryExpr<L, R, Op>> {
+public:
+    BinaryExpr(const L& left, const R& right) : left_(left), right_(right) {
+        if (left_.size() != right_.size()) {
+            throw std::invalid_argument(Op::mismatch());
+        }
+    }
+    size_t size() const { return left_.size(); }
+    double operator[](size_t i) const { return Op::apply(left_[i], right_[i]); }
+
+private:
+    L left_;
+    R right_;
+};
+
+template <typename E>
+class ScaledExpr : public VecExpr<ScaledExpr<E>> {
+public:
+    ScaledExpr(const E& inner, double scalar) : inner_(inner), scalar_(scalar) {}
+    size_t size() const { return inner_.size(); }
+    double operator[](size_t i) const { return scalar_ * inner_[i]; }
+
+private:
+    E inner_;
+    double scalar_;
+};
+
+template <typename E, typename F>
+class MappedExpr : public VecExpr<MappedExpr<E, F>> {
+public:
+    MappedExpr(const E& inner, F fn) : inner_(inner), fn_(fn) {}
+    size_t size() const { return inner_.size(); }
+    double operator[](size_t i) const { return fn_(inner_[i]); }
+
+private:
+    E inner_;
+    F fn_;
+};
+
+// Element i is row_i . x; rows are separate allocations, so each element is
+// one backend dot product rather than part of a gemv.
+class MatVecExpr : public VecExpr<MatVecExpr> {
+public:
+    MatVecExpr(const MatRef& matrix, const VecRef& vector)
+        : rows_(&matrix.rows()), x_(vector.data()), blas_(&activeBlasBackend()) {
+        if (rows_->empty() || (*rows_)[0].size() != vector.size()) {
+            throw std::invalid_argument("Matrix columns must match vector size for multiplication.");
+        }
+    }
+    size_t size() const { return rows_->size(); }
+    double operator[](size_t i) const {
+        const std::vector<double>& row = (*rows_)[i];
+        return blas_->dot(row.size(), row.data(), x_);
+    }
+
+private:
+    const std::vector<std::vector<double>>* rows_;
+    const double* x_;
+    const BlasBackend* blas_;
+};
+
+// Any contiguous container with data() and size() (std::vector, InlineVector, ...)
+template <typename Container>
+VecRef lazy(const Container& values) { return VecRef(values.data(), values.size()); }
+inline MatRef lazy(const std::vector<std::vector<double>>& rows) { return MatRef(rows); }
+
+inline MatVecExpr operator*(const MatRef& matrix, const VecRef& vector) {
+    return MatVecExpr(matrix, vector);
+}
+
+template <typename L, typename R>
+BinaryExpr<L, R, AddOp> operator+(const VecExpr<L>& left, const VecExpr<R>& right) {
+    return BinaryExpr<L, R, AddOp>(left.self(), right.self());
+}
+
+template <typename L, typename R>
+BinaryExpr<L, R, SubtractOp> operator-(const VecExpr<L>& left, const VecExpr<R>& right) {
+    return BinaryExpr<L, R, SubtractOp>(left.self(), right.self());
+}
+
+// Element-wise (Hadamard) product
+template <typename L, typename R>
+BinaryExpr<L, R, MultiplyOp> operator*(const VecExpr<L>& left, const VecExpr<R>& right) {
+    return BinaryExpr<L, R, MultiplyOp>(left.self(), right.self());
+}
+
+template <typename E>
+ScaledExpr<E> operator*(double scalar, const VecExpr<E>& inner) {
+    return ScaledExpr<E>(inner.self(), scalar);
+}
+
+template <typename E>
+ScaledExpr<E> operator*(const VecExpr<E>& inner, double scalar) {
+    return ScaledExpr<E>(inner.self(), scalar);
+}
+
+// fn applied to every element, e.g. apply(lazy(z), NeuralNetwork::sigmoid)
+template <typename E, typename F>
+MappedExpr<E, F> apply(const VecExpr<E>& inner, F fn) {
+    return MappedExpr<E, F>(inner.self(), fn);
+}
+
+// Evaluates `expression` into `destination` (any container with resize() and
+// data()) in a single loop, resizing it (reusing its capacity) to the
+// expression's size.
+template <typename Destination, typename E>
+void assign(Destination& destination, const VecExpr<E>& expression) {
+    const E& source = expression.self();
+    const size_t n = source.size();
+    destination.resize(n);
+    double* out = destination.data();
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = source[i];
+    }
+}
+
+template <typename E>
+std::vector<double> evaluate(const VecExpr<E>& expression) {
+    std::vector<double> result;
+    assign(result, expression);
+    return result;
+}
+
+} // namespace expr
+
+#endif // VECTOR_EXPR_H
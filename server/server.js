@@ -5,6 +5,9 @@ const { spawn } = require('child_process');
 const path = require('path');
 const cors = require('cors');
 const http = require('http');
+const crypto = require('crypto');
+const fs = require('fs');
+const os = require('os');
 const WebSocket = require('ws');
 
 const app = express();
@@ -13,6 +16,8 @@ const port = 3001;
 // --- Configuration ---
 const cppExecutablePath = path.join(__dirname, '..', 'cpp', 'linear_regression_app');
 const CPP_PROCESS_TIMEOUT_MS = 30000; // 30 seconds timeout for C++ processes
+// Saved range regression indexes, one file per dataset hash
+const rangeIndexDirectory = path.join(os.tmpdir(), 'mlapp-range-index');
 // --- End Configuration ---
 
 
@@ -55,6 +60,47 @@ function broadcast(data) {
 }
 // --- End WebSocket Setup ---
 
+// --- In-flight Request Coalescing (singleflight) ---
+// Training requests with the same operation, parameters and data that arrive
+// while an identical job is still running attach to that job instead of
+// spawning another C++ process. Jobs are forgotten as soon as they finish, so
+// a repeated request after completion trains again.
+const inFlightJobs = new Map(); // key -> job
+const coalescingStats = {};     // operation -> { started, coalesced }
+let nextJobId = 1;
+
+function datasetHash(...arrays) {
+    const hash = crypto.createHash('sha256');
+    arrays.forEach(values => { hash.update(JSON.stringify(values)); hash.update('\n'); });
+    return hash.digest('hex');
+}
+
+// Returns { job, coalesced }: the running job for (operation, parameters, data),
+// or a new one that the caller must start and later pass to finishJob()
+function joinOrCreateJob(operation, parameters, dataHash) {
+    const stats = coalescingStats[operation] || (coalescingStats[operation] = { started: 0, coalesced: 0 });
+    const key = `${operation}|${dataHash}|${JSON.stringify(parameters)}`;
+    const running = inFlightJobs.get(key);
+    if (running) {
+        stats.coalesced++;
+        running.subscribers++;
+        console.log(`${operation}: request coalesced into running job ${running.id} (${running.subscribers} subscribers)`);
+        return { job: running, coalesced: true };
+    }
+    const job = { id: nextJobId++, key, operation, subscribers: 1, waiters: [], progress: [], done: false };
+    inFlightJobs.set(key, job);
+    stats.started++;
+    return { job, coalesced: false };
+}
+
+function finishJob(job) {
+    job.done = true;
+    if (inFlightJobs.get(job.key) === job) {
+        inFlightJobs.delete(job.key);
+    }
+}
+// --- End In-flight Request Coalescing ---
+
 // --- Helper Functions ---
 
 // parseCppLine: Handles both loss updates and final stats
@@ -135,6 +181,25 @@ app.post('/api/lr_train', (req, res) => {
         return res.status(400).json({ error: 'Invalid input data. Ensure X and Y are non-empty arrays of the same length.' });
     }
 
+    const { job, coalesced } = joinOrCreateJob('lr_train', {}, datasetHash(x_values, y_values));
+    job.waiters.push(res);
+    if (coalesced) {
+        return; // Answered with the running job's result
+    }
+    // Sends the job's single outcome to every request attached to it
+    const respond = (status, body) => {
+        if (job.done) {
+            console.warn("LR Train: Job already answered. Cannot send response.");
+            return;
+        }
+        finishJob(job);
+        job.waiters.forEach(waiter => {
+            if (!waiter.headersSent) {
+                waiter.status(status).json(body);
+            }
+        });
+    };
+
     const x_str = x_values.join(',');
     const y_str = y_values.join(',');
     const args = ['lr_train']; // Argument for C++ main()
@@ -164,10 +229,7 @@ app.post('/api/lr_train', (req, res) => {
     cppProcess.on('error', (err) => {
         console.error(`LR Train Error: Failed to start C++ subprocess: ${err.message}`);
         console.error(`LR Train Error: Path was ${cppExecutablePath}`);
-        // Ensure response is sent ONLY if headers not already sent
-        if (!res.headersSent) {
-             res.status(500).json({ error: `Server error: Failed to execute LR training process. Check server logs. Path: ${cppExecutablePath}` });
-        }
+        respond(500, { error: `Server error: Failed to execute LR training process. Check server logs. Path: ${cppExecutablePath}` });
     });
 
     // Only write to stdin once the process has actually spawned
@@ -218,19 +280,19 @@ app.post('/api/lr_train', (req, res) => {
         }
         console.log(`LR Train C++ Final Stdout:\n${stdoutData}`); // <-- Log Final Output
 
-        if (res.headersSent) {
-             console.warn("LR Train: Headers already sent before C++ close event. Cannot send response.");
+        if (job.done) {
+             console.warn("LR Train: Job already answered before C++ close event. Cannot send response.");
              return;
         }
 
         if (killedForTimeout) {
-            return res.status(504).json({ error: `LR Training timed out after ${CPP_PROCESS_TIMEOUT_MS} ms.` });
+            return respond(504, { error: `LR Training timed out after ${CPP_PROCESS_TIMEOUT_MS} ms.` });
         }
 
         if (code !== 0) {
             const errorMsg = stderrData.trim() || `C++ process failed with exit code ${code}`;
             console.error(`LR Train Error: C++ process exited abnormally. Code: ${code}`);
-            return res.status(500).json({ error: `LR Training failed in C++: ${errorMsg}` });
+            return respond(500, { error: `LR Training failed in C++: ${errorMsg}` });
         }
 
         // --- Parse final results ONLY for LR ---
@@ -257,7 +319,7 @@ app.post('/api/lr_train', (req, res) => {
         // --- Validate parsed results ---
         if (parseError || results.slope === undefined || results.intercept === undefined || isNaN(results.slope) || isNaN(results.intercept) || results.training_time_ms === undefined || isNaN(results.training_time_ms) || results.mse === undefined || isNaN(results.mse) || results.r_squared === undefined || isNaN(results.r_squared)) {
              console.error(`LR Train Error: Failed to parse essential C++ LR output or values invalid/missing. Raw output:\n${stdoutData}`);
-             return res.status(500).json({ error: 'Failed to parse valid LR training results from C++ process.' });
+             return respond(500, { error: 'Failed to parse valid LR training results from C++ process.' });
         }
 
         // --- Success: Update server state and send response ---
@@ -265,8 +327,8 @@ app.post('/api/lr_train', (req, res) => {
         trainedLRModel.intercept = results.intercept;
         trainedLRModel.trained = true; // Mark model as trained
 
-        console.log('LR Train: Sending success response to frontend.');
-        res.json({
+        console.log(`LR Train: Sending success response to ${job.waiters.length} request(s).`);
+        respond(200, {
             slope: trainedLRModel.slope,
             intercept: trainedLRModel.intercept,
             trainingTimeMs: results.training_time_ms,
@@ -279,6 +341,114 @@ app.post('/api/lr_train', (req, res) => {
     // Note: stdin write is handled in the 'spawn' event above
 });
 
+// POST /api/lr_range: least-squares lines over x-ranges of one dataset.
+// Body: { x_values, y_values, ranges: [[lo, hi], ...] } the first time, then
+// { datasetId, ranges } for more ranges of the same data. The engine indexes
+// a dataset once (sort plus prefix sums) and saves the index under its hash;
+// later queries load that file instead of re-sending, parsing and sorting.
+app.post('/api/lr_range', (req, res) => {
+    const { x_values, y_values, ranges } = req.body;
+    let { datasetId } = req.body;
+    const hasData = Array.isArray(x_values) && Array.isArray(y_values);
+    if (hasData && (x_values.length === 0 || x_values.length !== y_values.length)) {
+        return res.status(400).json({ error: 'Invalid input data. Ensure X and Y are non-empty arrays of the same length.' });
+    }
+    if (!Array.isArray(ranges) || ranges.length === 0 ||
+        !ranges.every(r => Array.isArray(r) && r.length === 2 && Number.isFinite(r[0]) && Number.isFinite(r[1]) && r[0] <= r[1])) {
+        return res.status(400).json({ error: 'ranges must be a non-empty array of [lo, hi] pairs with lo <= hi.' });
+    }
+    if (hasData) {
+        datasetId = datasetHash(x_values, y_values);
+    } else if (typeof datasetId !== 'string' || !/^[0-9a-f]{64}$/.test(datasetId)) {
+        return res.status(400).json({ error: 'Send x_values and y_values, or the datasetId of an earlier lr_range request.' });
+    }
+
+    try {
+        fs.mkdirSync(rangeIndexDirectory, { recursive: true });
+    } catch (err) {
+        console.error('LR Range Error: cannot create index directory:', err);
+        return res.status(500).json({ error: 'Server error: cannot create the range index directory.' });
+    }
+    const indexPath = path.join(rangeIndexDirectory, `${datasetId}.idx`);
+    const args = ['lr_range', ...ranges.map(([lo, hi]) => `${lo}:${hi}`),
+                  '--index-cache', indexPath, '--index-key', datasetId];
+    // With a saved index the data is not needed; without one (or if the
+    // file turns out stale) the engine indexes stdin and saves it
+    const stdinData = hasData ? `${x_values.join(',')}\n${y_values.join(',')}\n` : '';
+
+    const run = (input, done) => {
+        const cppProcess = spawn(cppExecutablePath, args, { cwd: path.dirname(cppExecutablePath) });
+        let stdoutData = '';
+        let stderrData = '';
+        let killedForTimeout = false;
+        const timeoutHandle = setTimeout(() => {
+            killedForTimeout = true;
+            try { cppProcess.kill('SIGKILL'); } catch (e) { /* ignore */ }
+        }, CPP_PROCESS_TIMEOUT_MS);
+        cppProcess.on('error', (err) => {
+            clearTimeout(timeoutHandle);
+            done({ spawnError: err });
+        });
+        cppProcess.stdout.on('data', (data) => { stdoutData += data.toString(); });
+        cppProcess.stderr.on('data', (data) => { stderrData += data.toString(); });
+        cppProcess.stdin.on('error', () => { /* the engine does not read stdin on a cache hit */ });
+        cppProcess.stdin.end(input);
+        cppProcess.on('close', (code) => {
+            clearTimeout(timeoutHandle);
+            done({ code, stdoutData, stderrData, killedForTimeout });
+        });
+    };
+
+    const firstInput = fs.existsSync(indexPath) ? '' : stdinData;
+    run(firstInput, function finish(outcome, retried) {
+        if (outcome.spawnError) {
+            console.error(`LR Range Error: Failed to start C++ subprocess: ${outcome.spawnError.message}`);
+            return res.status(500).json({ error: `Server error: Failed to execute LR range process. Path: ${cppExecutablePath}` });
+        }
+        if (outcome.killedForTimeout) {
+            return res.status(504).json({ error: `LR range timed out after ${CPP_PROCESS_TIMEOUT_MS} ms.` });
+        }
+        if (outcome.code !== 0) {
+            if (!retried && hasData && firstInput === '') {
+                // The saved index was unusable and no data was sent: index it now
+                return run(stdinData, (second) => finish(second, true));
+            }
+            if (!hasData) {
+                return res.status(404).json({ error: 'Unknown datasetId: send x_values and y_values again.' });
+            }
+            const errorMsg = outcome.stderrData.trim() || `C++ process failed with exit code ${outcome.code}`;
+            return res.status(500).json({ error: `LR range failed in C++: ${errorMsg}` });
+        }
+
+        // range=<lo>:<hi>,count=<n>[,slope=..,intercept=..,mse=..,r_squared=..]
+        const results = { datasetId, ranges: [] };
+        outcome.stdoutData.split('\n').forEach(line => {
+            line = line.trim();
+            if (line.startsWith('range=')) {
+                const fields = {};
+                line.split(',').forEach(field => {
+                    const [key, value] = field.split('=');
+                    fields[key] = value;
+                });
+                const [lo, hi] = fields.range.split(':').map(Number);
+                const fit = { lo, hi, count: parseInt(fields.count, 10) };
+                ['slope', 'intercept', 'mse', 'r_squared'].forEach(key => {
+                    if (fields[key] !== undefined) {
+                        fit[key] = parseFloat(fields[key]);
+                    }
+                });
+                results.ranges.push(fit);
+            } else {
+                const parsed = parseCppLine(line);
+                if (parsed && parsed.type === 'final_stat' && (parsed.key === 'points' || parsed.key === 'index_cache')) {
+                    results[parsed.key === 'index_cache' ? 'indexCache' : 'points'] = parsed.value;
+                }
+            }
+        });
+        res.json(results);
+    });
+});
+
 // POST /api/lr_predict (no changes)
 app.post('/api/lr_predict', (req, res) =>{
     console.log('--- [BACKEND] LR Predict Request Received ---'); // Log Entry
@@ -336,13 +506,36 @@ app.post('/api/lr_predict', (req, res) =>{
 // POST /api/nn_train_predict (MODIFIED for Streaming and Final Results)
 app.post('/api/nn_train_predict', (req, res) => {
     const { x_values, y_values, layers, learning_rate, epochs } = req.body;
+    // Optional race mode: { targetMse, deadlineMs, strategies } trains several
+    // seeds/learning rates in parallel and keeps the first to reach targetMse
+    const race = req.body.race;
 
     // --- Input Validation (no changes) ---
     if (!Array.isArray(x_values) || /* ... */ !Number.isInteger(epochs) || epochs <= 0) {
          return res.status(400).json({ error: 'Invalid input data...' }); // Add specific error messages
     }
+    if (race !== undefined && (race === null || typeof race !== 'object' ||
+        ['targetMse', 'deadlineMs', 'strategies'].some((key) => race[key] !== undefined &&
+                                                              !(typeof race[key] === 'number' && race[key] > 0)))) {
+        return res.status(400).json({ error: 'race must be an object with positive targetMse, deadlineMs and strategies.' });
+    }
+    if (race && race.strategies !== undefined && !Number.isInteger(race.strategies)) {
+        return res.status(400).json({ error: 'race.strategies must be a whole number of strategies.' });
+    }
     // --- End Input Validation ---
 
+    // --- Coalesce with an identical running job ---
+    const { job, coalesced } = joinOrCreateJob('nn_train_predict', { layers, learning_rate, epochs, race },
+                                               datasetHash(x_values, y_values));
+    if (coalesced) {
+        // Progress and the final result are broadcast with this jobId; the
+        // loss updates sent before this request joined are returned here
+        return res.json({ status: 'Joined running training. Check WebSocket for updates.', jobId: job.id,
+                          coalesced: true, progress: job.progress });
+    }
+    const broadcastJob = (data) => broadcast({ ...data, jobId: job.id });
+    // --- End Coalesce ---
+
     // --- Scale Data (no changes) ---
     const { scaled: scaled_x, min: minX, range: rangeX } = scaleData(x_values);
     const { scaled: scaled_y, min: minY, range: rangeY } = scaleData(y_values);
@@ -355,21 +548,42 @@ app.post('/api/nn_train_predict', (req, res) => {
         'nn_train_predict', // Command for C++ main() to trigger train_for_epochs
         layers,
         String(learning_rate),
-        String(epochs)
+        String(epochs),
+        // Let the C++ cost model shrink oversized jobs instead of running into the timeout
+        '--max-ms', String(CPP_PROCESS_TIMEOUT_MS),
+        '--budget-policy', 'adjust'
     ];
+    if (race) {
+        args.push('--train-mode', 'race');
+        if (race.targetMse !== undefined) { args.push('--target-mse', String(race.targetMse)); }
+        if (race.deadlineMs !== undefined) { args.push('--deadline-ms', String(race.deadlineMs)); }
+        if (race.strategies !== undefined) { args.push('--race-strategies', String(race.strategies)); }
+    }
 
     console.log(`Spawning NN Train: ${cppExecutablePath} ${args.join(' ')}`);
     const cppProcess = spawn(cppExecutablePath, args);
     const stdinData = `${scaled_x_str}\n${scaled_y_str}\n`;
 
     // --- Immediately respond to HTTP request ---
-    res.json({ status: 'Training started. Check WebSocket for updates.' });
+    res.json({ status: 'Training started. Check WebSocket for updates.', jobId: job.id, coalesced: false });
     // --- End Immediate response ---
 
     let stdoutBuffer = '';
     let stderrData = '';
     const finalResults = {}; // Store final stats parsed from stdout (key-value pairs)
 
+    // Pre-flight cost estimate lines arrive before training starts; forward them
+    // as one message so the UI can warn about long or adjusted jobs.
+    const costEstimate = {};
+    let costEstimateSent = false;
+    const isCostEstimateKey = (key) => key.startsWith('estimated_') || key.startsWith('adjusted_') || key === 'budget_adjusted';
+    const flushCostEstimate = () => {
+        if (!costEstimateSent && Object.keys(costEstimate).length > 0) {
+            costEstimateSent = true;
+            broadcastJob({ type: 'cost_estimate', ...costEstimate });
+        }
+    };
+
     cppProcess.stdin.write(stdinData);
     cppProcess.stdin.end();
 
@@ -386,8 +600,14 @@ app.post('/api/nn_train_predict', (req, res) => {
                 const parsedData = parseCppLine(line); // parseCppLine handles trimming
                 if (parsedData) {
                     // console.log("Parsed data:", parsedData); // Debug parsed data
+                    if (parsedData.type === 'final_stat' && isCostEstimateKey(parsedData.key)) {
+                        costEstimate[parsedData.key] = parsedData.value;
+                        continue;
+                    }
+                    flushCostEstimate();
                     if (parsedData.type === 'loss_update') {
-                        broadcast(parsedData); // Send loss update via WebSocket
+                        job.progress.push(parsedData);
+                        broadcastJob(parsedData); // Send loss update via WebSocket
                     } else if (parsedData.type === 'final_stat') {
                         // Store final stats as they arrive (overwriting if key repeats, shouldn't happen for final stats)
                         finalResults[parsedData.key] = parsedData.value;
@@ -408,6 +628,8 @@ app.post('/api/nn_train_predict', (req, res) => {
     // --- Handle C++ Process Exit ---
     cppProcess.on('close', (code) => {
         console.log(`C++ process (nn_train_predict) exited with code ${code}`);
+        finishJob(job);
+        flushCostEstimate();
         if (stderrData) { console.error(`C++ Stderr (NN Train): ${stderrData}`); }
 
         // Process any remaining data in the stdout buffer
@@ -427,7 +649,7 @@ app.post('/api/nn_train_predict', (req, res) => {
 
         if (code !== 0) {
             const errorMsg = stderrData.trim() || `C++ process failed with exit code ${code}`;
-            broadcast({ type: 'error', message: `NN Training failed: ${errorMsg}` });
+            broadcastJob({ type: 'error', message: `NN Training failed: ${errorMsg}` });
             return; // Don't send final results on error
         }
 
@@ -439,13 +661,13 @@ app.post('/api/nn_train_predict', (req, res) => {
             finalResults.final_mse === undefined || isNaN(finalResults.final_mse) ||
             !Array.isArray(finalResults.nn_predictions) ) {
              console.error('Error: Missing or invalid final C++ NN stats:', finalResults);
-             broadcast({ type: 'error', message: 'Failed to parse expected final NN results (time, mse, predictions) from C++.' });
+             broadcastJob({ type: 'error', message: 'Failed to parse expected final NN results (time, mse, predictions) from C++.' });
              return;
         }
          // Check prediction length consistency (allow empty input case if needed)
          if (x_values.length > 0 && finalResults.nn_predictions.length !== x_values.length) {
              console.error(`Error: Mismatched prediction count. Expected ${x_values.length}, got ${finalResults.nn_predictions.length}. Results:`, finalResults);
-             broadcast({ type: 'error', message: `Prediction length mismatch from C++. Expected ${x_values.length}, got ${finalResults.nn_predictions.length}.` });
+             broadcastJob({ type: 'error', message: `Prediction length mismatch from C++. Expected ${x_values.length}, got ${finalResults.nn_predictions.length}.` });
              return;
          }
 
@@ -454,11 +676,18 @@ app.post('/api/nn_train_predict', (req, res) => {
         const originalScalePredictions = inverseScaleData(finalResults.nn_predictions, minY, rangeY);
 
         // Broadcast final results via WebSocket
-        broadcast({
+        broadcastJob({
             type: 'final_result',
             trainingTimeMs: finalResults.training_time_ms,
             finalMse: finalResults.final_mse,
-            predictions: originalScalePredictions
+            predictions: originalScalePredictions,
+            // 'diverged': stopped at stoppedEpoch, predictions are from the last healthy epoch
+            stoppedReason: finalResults.stopped_reason,
+            stoppedEpoch: finalResults.stopped_epoch,
+            // Race mode: which strategy won, and whether by target or deadline
+            raceWinner: finalResults.race_winner_strategy,
+            raceDecidedBy: finalResults.race_decided_by,
+            timeToFitMs: finalResults.time_to_fit_ms
         });
         // --- End Validate and Send Final Results ---
     });
@@ -466,8 +695,20 @@ app.post('/api/nn_train_predict', (req, res) => {
 
     cppProcess.on('error', (err) => {
         console.error(`Failed to start NN C++ subprocess: ${err.message}`);
-        broadcast({ type: 'error', message: `Server error: Failed to execute NN process. Path: ${cppExecutablePath}` });
+        finishJob(job);
+        broadcastJob({ type: 'error', message: `Server error: Failed to execute NN process. Path: ${cppExecutablePath}` });
+    });
+});
+
+
+// GET /api/stats: request coalescing counters per operation
+app.get('/api/stats', (req, res) => {
+    const coalescing = {};
+    Object.keys(coalescingStats).forEach(operation => {
+        coalescing[operation] = { ...coalescingStats[operation], inFlight: 0 };
     });
+    inFlightJobs.forEach(job => { coalescing[job.operation].inFlight++; });
+    res.json({ coalescing });
 });
 
 